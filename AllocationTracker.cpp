@@ -0,0 +1,522 @@
+#include "AllocationTracker.h"
+#include "ImGui/imgui.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace AllocationTracker
+{
+	// Annonymous namespace to hold variables
+	// only accessible in this file
+	namespace
+	{
+		// Everything here is constant-initialized, since operator
+		// new runs during other files' static initialization
+
+		struct AtomicCounts
+		{
+			std::atomic<uint64_t> Allocations;
+			std::atomic<uint64_t> Frees;
+			std::atomic<uint64_t> Bytes;
+		};
+
+		// Where Ignore sends counts, never read
+		constexpr unsigned int Ignored = MaxTags;
+
+		// The frame being counted, by tag
+		AtomicCounts current[MaxTags + 1];
+
+		// Names are written under tagMutex before tagCount is
+		// raised past them, so readers only need tagCount
+		std::mutex tagMutex;
+		const char* tagNames[MaxTags] = { "Untagged" };
+		std::atomic<unsigned int> tagCount{ 1 };
+
+		// The tag open on each thread
+		thread_local unsigned int currentTag = Untagged;
+
+		// Finished frames, guarded by historyMutex
+		std::mutex historyMutex;
+		Frame lastFrame = {};
+		Frame worstFrame = {};
+		Counts lifetime = {};
+		uint64_t totals[HistoryFrames] = {};	// Allocations only
+		unsigned int next = 0;
+		unsigned int count = 0;
+		uint64_t framesEnded = 0;
+		uint64_t budget = NoBudget;
+		uint64_t framesOverBudget = 0;
+
+		// Main thread only
+		float graph[HistoryFrames];
+		int budgetInput = 0;
+
+		void CountAllocation(size_t size)
+		{
+			AtomicCounts& counts = current[currentTag];
+			counts.Allocations.fetch_add(1, std::memory_order_relaxed);
+			counts.Bytes.fetch_add(size, std::memory_order_relaxed);
+		}
+
+		void CountFree()
+		{
+			current[currentTag].Frees.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		// malloc() with operator new's rules: never null, retrying
+		// for as long as there's a new_handler to free something up
+		void* AllocateOrThrow(size_t size)
+		{
+			while (true)
+			{
+				void* memory = malloc(size ? size : 1);
+				if (memory)
+				{
+					CountAllocation(size);
+					return memory;
+				}
+
+				std::new_handler handler = std::get_new_handler();
+				if (!handler)
+					throw std::bad_alloc();
+				handler();
+			}
+		}
+
+		void* AllocateAligned(size_t size, size_t alignment)
+		{
+			if (size == 0)
+				size = 1;
+#ifdef _MSC_VER
+			void* memory = _aligned_malloc(size, alignment);
+#else
+			void* memory = aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+			if (memory)
+				CountAllocation(size);
+			return memory;
+		}
+
+		void FreeAligned(void* memory)
+		{
+			if (!memory)
+				return;
+			CountFree();
+#ifdef _MSC_VER
+			_aligned_free(memory);
+#else
+			free(memory);
+#endif
+		}
+
+		void* AllocateAlignedOrThrow(size_t size, size_t alignment)
+		{
+			while (true)
+			{
+				void* memory = AllocateAligned(size, alignment);
+				if (memory)
+					return memory;
+
+				std::new_handler handler = std::get_new_handler();
+				if (!handler)
+					throw std::bad_alloc();
+				handler();
+			}
+		}
+
+		void AddCounts(Counts& total, const Counts& more)
+		{
+			total.Allocations += more.Allocations;
+			total.Frees += more.Frees;
+			total.Bytes += more.Bytes;
+		}
+
+		void FormatBytes(char* text, size_t size, uint64_t bytes)
+		{
+			if (bytes < 1024)
+				snprintf(text, size, "%llu B", (unsigned long long)bytes);
+			else if (bytes < 1024 * 1024)
+				snprintf(text, size, "%.1f KB", bytes / 1024.0);
+			else
+				snprintf(text, size, "%.1f MB", bytes / (1024.0 * 1024.0));
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Moves this frame's counts into the history, checks them
+// against the budget and starts the next frame from zero
+// --------------------------------------------------------
+void AllocationTracker::EndFrame()
+{
+	Frame frame = {};
+	unsigned int tags = tagCount.load(std::memory_order_acquire);
+	for (unsigned int t = 0; t < tags; t++)
+	{
+		Counts& counts = frame.Tags[t];
+		counts.Allocations = current[t].Allocations.exchange(0, std::memory_order_relaxed);
+		counts.Frees = current[t].Frees.exchange(0, std::memory_order_relaxed);
+		counts.Bytes = current[t].Bytes.exchange(0, std::memory_order_relaxed);
+		AddCounts(frame.Total, counts);
+	}
+
+	std::lock_guard<std::mutex> lock(historyMutex);
+	frame.Number = framesEnded++;
+	AddCounts(lifetime, frame.Total);
+	totals[next] = frame.Total.Allocations;
+	next = (next + 1) % HistoryFrames;
+	if (count < HistoryFrames)
+		count++;
+
+	if (budget != NoBudget && frame.Total.Allocations > budget)
+	{
+		framesOverBudget++;
+		if (frame.Total.Allocations > worstFrame.Total.Allocations)
+			worstFrame = frame;
+	}
+	lastFrame = frame;
+}
+
+AllocationTracker::Frame AllocationTracker::GetLastFrame()
+{
+	std::lock_guard<std::mutex> lock(historyMutex);
+	return lastFrame;
+}
+
+AllocationTracker::Counts AllocationTracker::GetLifetime()
+{
+	Counts total;
+	{
+		std::lock_guard<std::mutex> lock(historyMutex);
+		total = lifetime;
+	}
+
+	unsigned int tags = tagCount.load(std::memory_order_acquire);
+	for (unsigned int t = 0; t < tags; t++)
+	{
+		total.Allocations += current[t].Allocations.load(std::memory_order_relaxed);
+		total.Frees += current[t].Frees.load(std::memory_order_relaxed);
+		total.Bytes += current[t].Bytes.load(std::memory_order_relaxed);
+	}
+	return total;
+}
+
+// --------------------------------------------------------
+// Finds or adds a tag by name
+//
+// name - Kept as a pointer for as long as the program runs
+//
+// Returns the tag's id, or Untagged once every id is taken
+// --------------------------------------------------------
+unsigned int AllocationTracker::RegisterTag(const char* name)
+{
+	unsigned int tags = tagCount.load(std::memory_order_acquire);
+	for (unsigned int t = 0; t < tags; t++)
+		if (strcmp(tagNames[t], name) == 0)
+			return t;
+
+	// Someone else may have added it since
+	std::lock_guard<std::mutex> lock(tagMutex);
+	tags = tagCount.load(std::memory_order_relaxed);
+	for (unsigned int t = 0; t < tags; t++)
+		if (strcmp(tagNames[t], name) == 0)
+			return t;
+	if (tags == MaxTags)
+		return Untagged;
+
+	tagNames[tags] = name;
+	tagCount.store(tags + 1, std::memory_order_release);
+	return tags;
+}
+
+unsigned int AllocationTracker::GetTagCount()
+{
+	return tagCount.load(std::memory_order_acquire);
+}
+
+const char* AllocationTracker::GetTagName(unsigned int tag)
+{
+	return tag < GetTagCount() ? tagNames[tag] : "Unknown";
+}
+
+unsigned int AllocationTracker::GetCurrentTag()
+{
+	return currentTag < MaxTags ? currentTag : Untagged;
+}
+
+void AllocationTracker::SetBudget(uint64_t allocationsPerFrame)
+{
+	std::lock_guard<std::mutex> lock(historyMutex);
+	budget = allocationsPerFrame;
+	framesOverBudget = 0;
+	worstFrame = {};
+}
+
+uint64_t AllocationTracker::GetBudget()
+{
+	std::lock_guard<std::mutex> lock(historyMutex);
+	return budget;
+}
+
+uint64_t AllocationTracker::GetFramesOverBudget()
+{
+	std::lock_guard<std::mutex> lock(historyMutex);
+	return framesOverBudget;
+}
+
+AllocationTracker::Frame AllocationTracker::GetWorstFrame()
+{
+	std::lock_guard<std::mutex> lock(historyMutex);
+	return worstFrame;
+}
+
+void* AllocationTracker::Allocate(size_t size)
+{
+	void* memory = malloc(size ? size : 1);
+	if (memory)
+		CountAllocation(size);
+	return memory;
+}
+
+void AllocationTracker::Free(void* memory)
+{
+	if (!memory)
+		return;
+	CountFree();
+	free(memory);
+}
+
+AllocationTracker::Tag::Tag(unsigned int tag)
+	: previous(currentTag)
+{
+	currentTag = tag < MaxTags ? tag : Untagged;
+}
+
+AllocationTracker::Tag::~Tag()
+{
+	currentTag = previous;
+}
+
+AllocationTracker::Ignore::Ignore()
+	: previous(currentTag)
+{
+	currentTag = Ignored;
+}
+
+AllocationTracker::Ignore::~Ignore()
+{
+	currentTag = previous;
+}
+
+// --------------------------------------------------------
+// Last frame's totals, a graph of recent frames against the
+// budget, and every tag that allocated, most first
+// --------------------------------------------------------
+void AllocationTracker::BuildUI()
+{
+	Frame last;
+	Counts total;
+	uint64_t currentBudget;
+	uint64_t over;
+	int frames = 0;
+	float average = 0;
+	float highest = 1;
+	{
+		std::lock_guard<std::mutex> lock(historyMutex);
+		last = lastFrame;
+		total = lifetime;
+		currentBudget = budget;
+		over = framesOverBudget;
+
+		unsigned int first = count == HistoryFrames ? next : 0;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			graph[i] = (float)totals[(first + i) % HistoryFrames];
+			average += graph[i];
+			highest = std::max(highest, graph[i]);
+		}
+		frames = (int)count;
+	}
+	if (frames > 0)
+		average /= frames;
+
+	ImGui::Begin("Allocations");
+
+	char bytes[32];
+	FormatBytes(bytes, sizeof(bytes), last.Total.Bytes);
+	ImGui::Text("Last frame: %llu allocations, %llu frees, %s",
+		(unsigned long long)last.Total.Allocations, (unsigned long long)last.Total.Frees, bytes);
+	ImGui::Text("Average over %d frames: %.1f allocations", frames, average);
+	FormatBytes(bytes, sizeof(bytes), total.Bytes);
+	ImGui::Text("Since startup: %llu allocations, %s", (unsigned long long)total.Allocations, bytes);
+
+	float scale = currentBudget == NoBudget ? highest : std::max(highest, (float)currentBudget * 2.0f);
+	ImGui::PlotHistogram("##AllocationGraph", graph, frames, 0, 0, 0.0f, scale, ImVec2(ImGui::GetContentRegionAvail().x, 60.0f));
+
+	// Budget
+	bool budgetOn = currentBudget != NoBudget;
+	if (ImGui::Checkbox("Budget", &budgetOn))
+		SetBudget(budgetOn ? (uint64_t)budgetInput : NoBudget);
+	ImGui::SameLine();
+	ImGui::SetNextItemWidth(100.0f);
+	if (ImGui::InputInt("per frame", &budgetInput) && budgetOn)
+	{
+		budgetInput = std::max(budgetInput, 0);
+		SetBudget((uint64_t)budgetInput);
+	}
+	if (budgetOn)
+	{
+		ImVec4 color = over > 0 ? ImVec4(1.0f, 0.4f, 0.4f, 1.0f) : ImVec4(0.4f, 1.0f, 0.4f, 1.0f);
+		ImGui::TextColored(color, "Frames over budget: %llu", (unsigned long long)over);
+	}
+
+	// Tags that allocated last frame, most allocations first
+	unsigned int order[MaxTags];
+	unsigned int used = 0;
+	unsigned int tags = GetTagCount();
+	for (unsigned int t = 0; t < tags; t++)
+		if (last.Tags[t].Allocations > 0 || last.Tags[t].Frees > 0)
+			order[used++] = t;
+	std::sort(order, order + used, [&](unsigned int a, unsigned int b)
+		{ return last.Tags[a].Allocations > last.Tags[b].Allocations; });
+
+	if (ImGui::BeginTable("AllocationTags", 4, ImGuiTableFlags_RowBg))
+	{
+		ImGui::TableSetupColumn("Tag");
+		ImGui::TableSetupColumn("Allocations");
+		ImGui::TableSetupColumn("Frees");
+		ImGui::TableSetupColumn("Bytes");
+		ImGui::TableHeadersRow();
+		for (unsigned int i = 0; i < used; i++)
+		{
+			const Counts& counts = last.Tags[order[i]];
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(tagNames[order[i]]);
+			ImGui::TableNextColumn();
+			ImGui::Text("%llu", (unsigned long long)counts.Allocations);
+			ImGui::TableNextColumn();
+			ImGui::Text("%llu", (unsigned long long)counts.Frees);
+			ImGui::TableNextColumn();
+			FormatBytes(bytes, sizeof(bytes), counts.Bytes);
+			ImGui::TextUnformatted(bytes);
+		}
+		ImGui::EndTable();
+	}
+
+	ImGui::End();
+}
+
+#if ALLOCATION_TRACKING_ENABLED
+
+// --------------------------------------------------------
+// The program's global allocation functions, every form of
+// them, all counted.  The aligned forms only pair with each
+// other, since _aligned_malloc() memory needs _aligned_free().
+// --------------------------------------------------------
+
+void* operator new(size_t size)
+{
+	return AllocationTracker::AllocateOrThrow(size);
+}
+
+void* operator new[](size_t size)
+{
+	return AllocationTracker::AllocateOrThrow(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return AllocationTracker::Allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return AllocationTracker::Allocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+	AllocationTracker::Free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	AllocationTracker::Free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	AllocationTracker::Free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	AllocationTracker::Free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	AllocationTracker::Free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	AllocationTracker::Free(memory);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	return AllocationTracker::AllocateAlignedOrThrow(size, (size_t)alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+	return AllocationTracker::AllocateAlignedOrThrow(size, (size_t)alignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return AllocationTracker::AllocateAligned(size, (size_t)alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return AllocationTracker::AllocateAligned(size, (size_t)alignment);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+	AllocationTracker::FreeAligned(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept
+{
+	AllocationTracker::FreeAligned(memory);
+}
+
+void operator delete(void* memory, size_t, std::align_val_t) noexcept
+{
+	AllocationTracker::FreeAligned(memory);
+}
+
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept
+{
+	AllocationTracker::FreeAligned(memory);
+}
+
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	AllocationTracker::FreeAligned(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	AllocationTracker::FreeAligned(memory);
+}
+
+#endif
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Set to 0 to leave operator new/delete alone and compile every
+// ALLOCATION_TAG away
+#ifndef ALLOCATION_TRACKING_ENABLED
+#define ALLOCATION_TRACKING_ENABLED 1
+#endif
+
+#define ALLOCATION_CONCAT_INNER(a, b) a##b
+#define ALLOCATION_CONCAT(a, b) ALLOCATION_CONCAT_INNER(a, b)
+
+// Charges heap allocations made on this thread, for the rest of
+// the enclosing scope, to the named tag.  The name is kept as a
+// pointer, so it must outlive the tracker (string literals do).
+#if ALLOCATION_TRACKING_ENABLED
+#define ALLOCATION_TAG(name) \
+	static const unsigned int ALLOCATION_CONCAT(allocationTagId, __LINE__) = AllocationTracker::RegisterTag(name); \
+	AllocationTracker::Tag ALLOCATION_CONCAT(allocationTag, __LINE__)(ALLOCATION_CONCAT(allocationTagId, __LINE__))
+#else
+#define ALLOCATION_TAG(name)
+#endif
+
+// --------------------------------------------------------
+// Heap allocation counting
+//
+// The program's global operator new and delete (every form,
+// see AllocationTracker.cpp) count each call, and the bytes
+// asked for, against whichever tag is open on the calling
+// thread - frame graph tasks open one named after themselves.
+// EndFrame() closes the books on a frame, so the counts read
+// as "allocations per frame", which in steady state should be
+// zero or very close to it.
+//
+// Counting is a relaxed atomic add, next to a malloc() that
+// costs far more.  Bytes are counted as they're allocated only;
+// delete isn't told sizes reliably enough to track what's live.
+//
+// A budget, once set, marks every frame that allocates more
+// than it - benchmarks use this to fail a run.
+// --------------------------------------------------------
+namespace AllocationTracker
+{
+	// Tag 0 is everything allocated outside any tag
+	static constexpr unsigned int MaxTags = 64;
+	static constexpr unsigned int Untagged = 0;
+
+	// Frames of totals kept for the UI's graph
+	static constexpr unsigned int HistoryFrames = 256;
+
+	// No budget set
+	static constexpr uint64_t NoBudget = ~0ull;
+
+	struct Counts
+	{
+		uint64_t Allocations;
+		uint64_t Frees;
+		uint64_t Bytes;
+	};
+
+	struct Frame
+	{
+		uint64_t Number;			// EndFrame() calls before this frame's
+		Counts Total;
+		Counts Tags[MaxTags];		// By tag id
+	};
+
+	// Main thread, once per frame: starts counting the next frame
+	void EndFrame();
+
+	// The frame most recently ended
+	Frame GetLastFrame();
+
+	// Everything since the program started, this frame included
+	Counts GetLifetime();
+
+	// Tag ids are handed out in order, so ids below GetTagCount()
+	// are valid.  The same name always gets the same id; past
+	// MaxTags, new names all share Untagged.
+	unsigned int RegisterTag(const char* name);
+	unsigned int GetTagCount();
+	const char* GetTagName(unsigned int tag);
+
+	// The tag open on the calling thread, so work handed to
+	// another thread (jobs) can be charged to it there too
+	unsigned int GetCurrentTag();
+
+	// Allocations a frame may make before it counts as over
+	// budget.  Setting it (or NoBudget) restarts the count of
+	// frames over.
+	void SetBudget(uint64_t allocationsPerFrame);
+	uint64_t GetBudget();
+	uint64_t GetFramesOverBudget();
+
+	// The frame that went furthest over the budget since it was
+	// set (Total.Allocations of 0 if none has)
+	Frame GetWorstFrame();
+
+	// For allocators that bypass operator new (ImGui's), so their
+	// memory is counted too.  Free() takes null.
+	void* Allocate(size_t size);
+	void Free(void* memory);
+
+	// Budget, last frame's totals and graph, and the tags that
+	// allocated in it
+	void BuildUI();
+
+	// Use ALLOCATION_TAG instead of this directly
+	class Tag
+	{
+	public:
+		explicit Tag(unsigned int tag);
+		~Tag();
+		Tag(const Tag&) = delete;
+		Tag& operator=(const Tag&) = delete;
+
+	private:
+		unsigned int previous;
+	};
+
+	// Allocations on this thread while one of these is open
+	// aren't counted at all - for measuring code's own
+	// bookkeeping, which would otherwise land in the frames
+	// it measures
+	class Ignore
+	{
+	public:
+		Ignore();
+		~Ignore();
+		Ignore(const Ignore&) = delete;
+		Ignore& operator=(const Ignore&) = delete;
+
+	private:
+		unsigned int previous;
+	};
+}
@@ -0,0 +1,720 @@
+#include "Benchmark.h"
+#include "AllocationTracker.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+
+using namespace DirectX;
+
+namespace
+{
+	const char* modelFiles[Benchmark::ModelCount] =
+	{
+		"sphere.obj",
+		"cylinder.obj",
+		"cube.obj",
+		"helix.obj",
+		"quad_double_sided.obj",
+		"quad.obj",
+		"torus.obj",
+	};
+
+	const char* usage =
+		"--benchmark           Run a benchmark instead of the game\n"
+		"--headless            Benchmark without a window or graphics device\n"
+		"--allocators          Headless: compare frame memory with the heap instead\n"
+		"--handles             Headless: compare resource handles with shared_ptr instead\n"
+		"--entities            Headless: compare the EntitySystem with heap entities instead\n"
+		"--jobs                Headless: time the job system on more and more threads instead\n"
+		"--arena               Headless: time the constant upload ring arena instead\n"
+		"--wvp                 Headless: time batched world-view-projection matrices instead\n"
+		"--dirty-flags         Headless: time cached world matrices, still and moving, instead\n"
+		"--transform-update    Headless: time transform updates at 10k, 100k and 1M instead\n"
+		"--basis               Headless: time right, up and forward queries instead\n"
+		"--scaling             Headless: run the scene on 1, 2, 4... threads in turn\n"
+		"--frame-times         Headless: time recording frame times and their stats instead\n"
+		"--hierarchy           Headless: time sparse updates of a 100k transform hierarchy instead\n"
+		"--tests               Headless: run the self-checks instead\n"
+		"--scene NAME          default, grid or hierarchy\n"
+		"--objects N           Objects in the scene (0 for the scene's own count)\n"
+		"--moving FRACTION     Share of transforms --hierarchy moves each frame (0.01)\n"
+		"--frames N            Frames to measure\n"
+		"--warmup N            Frames to run before measuring\n"
+		"--dt SECONDS          Time step every frame is given\n"
+		"--camera PATH         static, orbit or flythrough\n"
+		"--report FILE         Where the JSON report goes\n"
+		"--commands FILE       Headless only: dump the last frame's device commands\n"
+		"--workers N           Job system workers (0 for one per core)\n"
+		"--allocation-budget N Fail if a measured frame makes more than N heap allocations\n"
+		"--render-thread MODE  on (draw on a thread of its own) or off (draw inline)\n"
+		"--width N             Window width (or projection, headless)\n"
+		"--height N            Window height\n"
+		"--assets DIR          Folder holding the .obj models\n"
+		"--help, -h            Print this and exit\n";
+
+	// Options that take a value, so a typo is reported as unknown
+	// rather than as missing its value
+	const char* valueOptions[] =
+	{
+		"--scene", "--objects", "--moving", "--frames", "--warmup", "--dt", "--camera", "--report",
+		"--commands", "--workers", "--allocation-budget", "--render-thread", "--width", "--height",
+		"--assets",
+	};
+
+	bool TakesValue(const std::string& name)
+	{
+		for (const char* option : valueOptions)
+		{
+			if (name == option)
+				return true;
+		}
+		return false;
+	}
+
+	// Every camera path loops in this many seconds
+	constexpr float PathSeconds = 20.0f;
+
+	bool ParseUnsigned(const std::string& text, unsigned int& value)
+	{
+		char* end = 0;
+		unsigned long parsed = strtoul(text.c_str(), &end, 10);
+		if (text.empty() || *end != 0 || text[0] == '-')
+			return false;
+		value = (unsigned int)parsed;
+		return true;
+	}
+
+	bool ParseFloat(const std::string& text, float& value)
+	{
+		char* end = 0;
+		float parsed = strtof(text.c_str(), &end);
+		if (text.empty() || *end != 0)
+			return false;
+		value = parsed;
+		return true;
+	}
+
+	// Pitch and yaw that point the camera from position at target
+	Benchmark::CameraPose LookAt(XMFLOAT3 position, XMFLOAT3 target)
+	{
+		XMVECTOR direction = XMVector3Normalize(XMVectorSubtract(XMLoadFloat3(&target), XMLoadFloat3(&position)));
+		XMFLOAT3 d;
+		XMStoreFloat3(&d, direction);
+
+		Benchmark::CameraPose pose;
+		pose.Position = position;
+		pose.PitchYawRoll = XMFLOAT3(asinf(-d.y), atan2f(d.x, d.z), 0.0f);
+		return pose;
+	}
+
+	Benchmark::SceneObject MakeObject(XMFLOAT3 position, XMFLOAT3 spin, int parent, unsigned int index)
+	{
+		Benchmark::SceneObject o;
+		o.Position = position;
+		o.PitchYawRoll = XMFLOAT3(0, 0, 0);
+		o.Scale = XMFLOAT3(1, 1, 1);
+		o.Spin = spin;
+		o.Parent = parent;
+		o.Shape = (Benchmark::Model)(index % Benchmark::ModelCount);
+		o.Material = index % Benchmark::MaterialCount;
+		return o;
+	}
+
+	void AppendEscaped(std::ostream& out, const std::string& text)
+	{
+		out << '"';
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\')
+				out << '\\';
+			out << c;
+		}
+		out << '"';
+	}
+
+	double Percentile(std::vector<double>& sorted, double p)
+	{
+		size_t index = (size_t)(p * (sorted.size() - 1) + 0.5);
+		std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+		return sorted[index];
+	}
+}
+
+// --------------------------------------------------------
+// Reads "--name value" pairs and "--flag" switches
+//
+// arguments - Everything after the program name
+// options   - Changed only for what's given
+// error     - Set when false is returned
+// --------------------------------------------------------
+bool Benchmark::ParseArguments(const std::vector<std::string>& arguments, Options& options, std::string& error)
+{
+	for (size_t i = 0; i < arguments.size(); i++)
+	{
+		const std::string& name = arguments[i];
+		if (name == "--help" || name == "-h")
+		{
+			options.Help = true;
+			return true;
+		}
+		if (name == "--benchmark")
+		{
+			options.Enabled = true;
+			continue;
+		}
+		if (name == "--headless")
+		{
+			options.Enabled = true;
+			options.Headless = true;
+			continue;
+		}
+		if (name == "--allocators")
+		{
+			options.Enabled = true;
+			options.Headless = true;
+			options.Allocators = true;
+			continue;
+		}
+		if (name == "--handles")
+		{
+			options.Enabled = true;
+			options.Headless = true;
+			options.Handles = true;
+			continue;
+		}
+		if (name == "--entities")
+		{
+			options.Enabled = true;
+			options.Headless = true;
+			options.Entities = true;
+			continue;
+		}
+		if (name == "--jobs")
+		{
+			options.Enabled = true;
+			options.Headless = true;
+			options.Jobs = true;
+			continue;
+		}
+		if (name == "--arena")
+		{
+			options.Enabled = true;
+			options.Headless = true;
+			options.Arena = true;
+			continue;
+		}
+		if (name == "--wvp")
+		{
+			options.Enabled = true;
+			options.Headless = true;
+			options.WorldViewProjection = true;
+			continue;
+		}
+		if (name == "--dirty-flags")
+		{
+			options.Enabled = true;
+			options.Headless = true;
+			options.DirtyFlags = true;
+			continue;
+		}
+		if (name == "--transform-update")
+		{
+			options.Enabled = true;
+			options.Headless = true;
+			options.TransformUpdate = true;
+			continue;
+		}
+		if (name == "--basis")
+		{
+			options.Enabled = true;
+			options.Headless = true;
+			options.Basis = true;
+			continue;
+		}
+		if (name == "--scaling")
+		{
+			options.Enabled = true;
+			options.Headless = true;
+			options.Scaling = true;
+			continue;
+		}
+		if (name == "--frame-times")
+		{
+			options.Enabled = true;
+			options.Headless = true;
+			options.FrameTimes = true;
+			continue;
+		}
+		if (name == "--hierarchy")
+		{
+			options.Enabled = true;
+			options.Headless = true;
+			options.Hierarchy = true;
+			continue;
+		}
+		if (name == "--tests")
+		{
+			options.Enabled = true;
+			options.Headless = true;
+			options.Tests = true;
+			continue;
+		}
+
+		// Everything else takes a value
+		if (!TakesValue(name))
+		{
+			error = "Unknown option " + name;
+			return false;
+		}
+		if (i + 1 >= arguments.size())
+		{
+			error = name + " needs a value";
+			return false;
+		}
+		const std::string& value = arguments[++i];
+
+		bool valid = true;
+		if (name == "--scene")
+			options.Scene = value;
+		else if (name == "--objects")
+			valid = ParseUnsigned(value, options.Objects);
+		else if (name == "--moving")
+			valid = ParseFloat(value, options.Moving) && options.Moving >= 0.0f && options.Moving <= 1.0f;
+		else if (name == "--frames")
+			valid = ParseUnsigned(value, options.Frames) && options.Frames > 0;
+		else if (name == "--warmup")
+			valid = ParseUnsigned(value, options.Warmup);
+		else if (name == "--dt")
+			valid = ParseFloat(value, options.DeltaTime) && options.DeltaTime > 0.0f;
+		else if (name == "--camera")
+			options.CameraPath = value;
+		else if (name == "--report")
+			options.ReportPath = value;
+		else if (name == "--commands")
+			options.CommandsPath = value;
+		else if (name == "--workers")
+			valid = ParseUnsigned(value, options.Workers);
+		else if (name == "--allocation-budget")
+		{
+			unsigned int budget = 0;
+			valid = ParseUnsigned(value, budget) && budget <= 0x7fffffff;
+			options.AllocationBudget = (int)budget;
+		}
+		else if (name == "--render-thread")
+		{
+			valid = value == "on" || value == "off";
+			options.RenderThread = value == "on";
+		}
+		else if (name == "--width")
+			valid = ParseUnsigned(value, options.Width) && options.Width > 0;
+		else if (name == "--height")
+			valid = ParseUnsigned(value, options.Height) && options.Height > 0;
+		else if (name == "--assets")
+			options.AssetPath = value;
+
+		if (!valid)
+		{
+			error = "Bad value for " + name + ": " + value;
+			return false;
+		}
+	}
+
+	// Catch typos now rather than after loading everything
+	std::vector<SceneObject> scene;
+	CameraPose pose;
+	if (options.Enabled && !BuildScene(options.Scene, 1, scene))
+	{
+		error = "Unknown scene " + options.Scene;
+		return false;
+	}
+	if (options.Enabled && !GetCameraPose(options.CameraPath, 0.0f, 1.0f, pose))
+	{
+		error = "Unknown camera path " + options.CameraPath;
+		return false;
+	}
+
+	// Keep folder joins simple
+	if (!options.AssetPath.empty() && options.AssetPath.back() != '/' && options.AssetPath.back() != '\\')
+		options.AssetPath += '/';
+	return true;
+}
+
+bool Benchmark::ParseCommandLine(const char* commandLine, Options& options, std::string& error)
+{
+	std::vector<std::string> arguments;
+	std::string current;
+	bool quoted = false;
+	bool started = false;
+	for (const char* c = commandLine ? commandLine : ""; *c; c++)
+	{
+		if (*c == '"')
+		{
+			quoted = !quoted;
+			started = true;
+		}
+		else if ((*c == ' ' || *c == '\t') && !quoted)
+		{
+			if (started)
+				arguments.push_back(current);
+			current.clear();
+			started = false;
+		}
+		else
+		{
+			current += *c;
+			started = true;
+		}
+	}
+	if (started)
+		arguments.push_back(current);
+
+	return ParseArguments(arguments, options, error);
+}
+
+const char* Benchmark::GetUsage()
+{
+	return usage;
+}
+
+const char* Benchmark::GetModelFile(Model model)
+{
+	return modelFiles[model];
+}
+
+// --------------------------------------------------------
+// Lays out a scene
+//
+// name    - Which scene
+// objects - How many objects, or 0 for the scene's usual count
+// scene   - Replaced with the scene's objects
+//
+// Returns false for a name that isn't a scene
+// --------------------------------------------------------
+bool Benchmark::BuildScene(const std::string& name, unsigned int objects, std::vector<SceneObject>& scene)
+{
+	scene.clear();
+
+	if (name == "default")
+	{
+		// The game's row of models, turning slowly
+		if (objects == 0)
+			objects = ModelCount;
+		for (unsigned int i = 0; i < objects; i++)
+		{
+			SceneObject o = MakeObject(XMFLOAT3(-12.0f + (i % ModelCount) * 4.0f, 4.0f, (i / ModelCount) * 4.0f), XMFLOAT3(0, 0.5f, 0), -1, i);
+			o.Material = 0;
+			scene.push_back(o);
+		}
+		return true;
+	}
+
+	if (name == "grid")
+	{
+		// A square field, every object spinning at one of a few speeds
+		if (objects == 0)
+			objects = 10000;
+		unsigned int side = (unsigned int)ceil(sqrt((double)objects));
+		float half = (side - 1) * 0.5f;
+		for (unsigned int i = 0; i < objects; i++)
+		{
+			float x = ((i % side) - half) * 3.0f;
+			float z = ((i / side) - half) * 3.0f;
+			scene.push_back(MakeObject(XMFLOAT3(x, 0, z), XMFLOAT3(0, 0.5f + 0.1f * (i % 5), 0), -1, i));
+		}
+		return true;
+	}
+
+	if (name == "hierarchy")
+	{
+		// Chains of eight, each link a child of the one before, so
+		// every parent's spin moves everything above it
+		const unsigned int chainLength = 8;
+		if (objects == 0)
+			objects = 4096;
+		unsigned int chains = (objects + chainLength - 1) / chainLength;
+		unsigned int side = (unsigned int)ceil(sqrt((double)chains));
+		float half = (side - 1) * 0.5f;
+		for (unsigned int i = 0; i < objects; i++)
+		{
+			unsigned int chain = i / chainLength;
+			if (i % chainLength == 0)
+			{
+				float x = ((chain % side) - half) * 6.0f;
+				float z = ((chain / side) - half) * 6.0f;
+				scene.push_back(MakeObject(XMFLOAT3(x, 0, z), XMFLOAT3(0, 0.4f, 0), -1, i));
+			}
+			else
+			{
+				SceneObject o = MakeObject(XMFLOAT3(0, 1.5f, 0), XMFLOAT3(0, 0, 0.3f), (int)i - 1, i);
+				o.Scale = XMFLOAT3(0.9f, 0.9f, 0.9f);
+				scene.push_back(o);
+			}
+		}
+		return true;
+	}
+
+	return false;
+}
+
+XMFLOAT3 Benchmark::GetRotation(const SceneObject& object, float time)
+{
+	return XMFLOAT3(
+		object.PitchYawRoll.x + object.Spin.x * time,
+		object.PitchYawRoll.y + object.Spin.y * time,
+		object.PitchYawRoll.z + object.Spin.z * time);
+}
+
+float Benchmark::GetSceneRadius(const std::vector<SceneObject>& scene)
+{
+	// Children stay close to their roots, so the roots are enough
+	float radius = 5.0f;
+	for (const SceneObject& o : scene)
+		if (o.Parent < 0)
+			radius = std::max(radius, sqrtf(o.Position.x * o.Position.x + o.Position.z * o.Position.z) + 2.0f);
+	return radius;
+}
+
+// --------------------------------------------------------
+// Where the camera is at a point along a path
+//
+// path        - "static", "orbit" or "flythrough"
+// time        - Seconds since the run started
+// sceneRadius - From GetSceneRadius(), so the path fits
+// pose        - Set to the camera's position and rotation
+// --------------------------------------------------------
+bool Benchmark::GetCameraPose(const std::string& path, float time, float sceneRadius, CameraPose& pose)
+{
+	float distance = sceneRadius + 10.0f;
+	float height = sceneRadius * 0.5f + 6.0f;
+	float angle = XM_2PI * time / PathSeconds;
+
+	if (path == "static")
+	{
+		// Above and behind the scene, looking at all of it
+		pose = LookAt(XMFLOAT3(0, height, -distance), XMFLOAT3(0, 0, 0));
+		return true;
+	}
+
+	if (path == "orbit")
+	{
+		// Circles the scene, always looking at its middle
+		pose = LookAt(XMFLOAT3(sinf(angle) * distance, height, -cosf(angle) * distance), XMFLOAT3(0, 0, 0));
+		return true;
+	}
+
+	if (path == "flythrough")
+	{
+		// Low pass from one side to the other, weaving and looking
+		// around, so most of the scene is behind or beside it
+		float along = fmodf(time / PathSeconds, 1.0f);
+		XMFLOAT3 position(sinf(angle) * sceneRadius * 0.25f, 4.0f, -sceneRadius + along * 2.0f * sceneRadius);
+		XMFLOAT3 target(position.x + sinf(time) * 0.3f, position.y - 0.1f, position.z + 1.0f);
+		pose = LookAt(position, target);
+		return true;
+	}
+
+	return false;
+}
+
+XMMATRIX Benchmark::GetProjection(const Options& options)
+{
+	return XMMatrixPerspectiveFovLH(XM_PIDIV2, (float)options.Width / options.Height, 0.05f, 900.0f);
+}
+
+// Same as Camera::UpdateViewMatrix() for an unscaled transform
+XMMATRIX Benchmark::GetView(const CameraPose& pose)
+{
+	XMVECTOR rotation = XMQuaternionRotationRollPitchYaw(pose.PitchYawRoll.x, pose.PitchYawRoll.y, pose.PitchYawRoll.z);
+	XMVECTOR forward = XMVector3Rotate(XMVectorSet(0, 0, 1, 0), rotation);
+	return XMMatrixLookToLH(XMLoadFloat3(&pose.Position), forward, XMVectorSet(0, 1, 0, 0));
+}
+
+// FNV-1a over which objects were drawn, at what detail, in order
+uint64_t Benchmark::HashItems(const RenderQueue::ItemList& items, uint64_t hash)
+{
+	const uint64_t prime = 1099511628211ull;
+	for (const RenderQueue::Item& item : items)
+	{
+		uint32_t values[2] = { item.Entity, item.Lod };
+		const unsigned char* bytes = (const unsigned char*)values;
+		for (size_t b = 0; b < sizeof(values); b++)
+			hash = (hash ^ bytes[b]) * prime;
+	}
+	return (hash ^ items.size()) * prime;
+}
+
+std::vector<double>& Benchmark::Report::Find(SeriesList& list, const std::string& name)
+{
+	for (auto& series : list)
+		if (series.first == name)
+			return series.second;
+
+	list.emplace_back(name, std::vector<double>());
+	return list.back().second;
+}
+
+void Benchmark::Report::AddSample(const std::string& stage, double milliseconds)
+{
+	Find(stages, stage).push_back(milliseconds);
+}
+
+void Benchmark::Report::AddCount(const std::string& counter, double value)
+{
+	Find(counters, counter).push_back(value);
+}
+
+// --------------------------------------------------------
+// Writes the run's settings and summaries
+//
+// path    - File to create
+// options - What the run was asked to do
+// mode    - "headless" or "windowed"
+// objects - Objects actually in the scene
+// threads - Threads the job system ran on
+//
+// Returns false if the file couldn't be written
+// --------------------------------------------------------
+bool Benchmark::Report::WriteJson(const char* path, const Options& options, const char* mode, unsigned int objects, unsigned int threads)
+{
+	std::ofstream out(path);
+	if (!out)
+		return false;
+
+	out << std::setprecision(6) << std::fixed;
+	out << "{\n";
+	out << "  \"mode\": \"" << mode << "\",\n";
+	out << "  \"scene\": ";
+	AppendEscaped(out, options.Scene);
+	out << ",\n";
+	out << "  \"objects\": " << objects << ",\n";
+	out << "  \"camera\": ";
+	AppendEscaped(out, options.CameraPath);
+	out << ",\n";
+	out << "  \"frames\": " << options.Frames << ",\n";
+	out << "  \"warmup\": " << options.Warmup << ",\n";
+	out << "  \"delta_time\": " << options.DeltaTime << ",\n";
+	out << "  \"width\": " << options.Width << ",\n";
+	out << "  \"height\": " << options.Height << ",\n";
+	out << "  \"threads\": " << threads << ",\n";
+	out << "  \"render_thread\": " << (options.RenderThread ? "true" : "false") << ",\n";
+	out << "  \"load_ms\": " << loadMilliseconds << ",\n";
+	out << "  \"checksum\": \"" << std::hex << std::setw(16) << std::setfill('0') << checksum << std::dec << std::setfill(' ') << "\",\n";
+	if (options.AllocationBudget >= 0)
+	{
+		out << "  \"allocation_budget\": " << options.AllocationBudget << ",\n";
+		out << "  \"frames_over_budget\": " << framesOverBudget << ",\n";
+	}
+
+	out << "  \"stages\": {";
+	for (size_t s = 0; s < stages.size(); s++)
+	{
+		std::vector<double> sorted = stages[s].second;
+		double total = 0;
+		for (double v : sorted)
+			total += v;
+		double mean = sorted.empty() ? 0 : total / sorted.size();
+		double p50 = sorted.empty() ? 0 : Percentile(sorted, 0.50);
+		double p95 = sorted.empty() ? 0 : Percentile(sorted, 0.95);
+		double p99 = sorted.empty() ? 0 : Percentile(sorted, 0.99);
+		double max = sorted.empty() ? 0 : *std::max_element(sorted.begin(), sorted.end());
+
+		out << (s == 0 ? "\n    " : ",\n    ");
+		AppendEscaped(out, stages[s].first);
+		out << ": { \"mean\": " << mean << ", \"p50\": " << p50 << ", \"p95\": " << p95
+			<< ", \"p99\": " << p99 << ", \"max\": " << max << ", \"total\": " << total << " }";
+	}
+	out << "\n  },\n";
+
+	out << "  \"counters\": {";
+	for (size_t c = 0; c < counters.size(); c++)
+	{
+		const std::vector<double>& values = counters[c].second;
+		double total = 0;
+		double max = 0;
+		for (double v : values)
+		{
+			total += v;
+			max = std::max(max, v);
+		}
+
+		out << (c == 0 ? "\n    " : ",\n    ");
+		AppendEscaped(out, counters[c].first);
+		out << ": { \"mean\": " << (values.empty() ? 0 : total / values.size())
+			<< ", \"max\": " << max << ", \"total\": " << total << " }";
+	}
+	out << "\n  }\n";
+	out << "}\n";
+	return (bool)out;
+}
+
+double Benchmark::MillisecondsSince(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+bool Benchmark::SameObjects(const std::vector<RenderQueue::Object>& a, const std::vector<RenderQueue::Object>& b)
+{
+	if (a.size() != b.size())
+		return false;
+
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		const RenderQueue::Object& x = a[i];
+		const RenderQueue::Object& y = b[i];
+		if (x.BoundsCenter.x != y.BoundsCenter.x || x.BoundsCenter.y != y.BoundsCenter.y || x.BoundsCenter.z != y.BoundsCenter.z ||
+			x.BoundsExtents.x != y.BoundsExtents.x || x.BoundsExtents.y != y.BoundsExtents.y || x.BoundsExtents.z != y.BoundsExtents.z ||
+			x.MaterialId != y.MaterialId || x.LodCount != y.LodCount)
+			return false;
+
+		for (uint32_t lod = 0; lod < x.LodCount && lod < RenderQueue::MaxLods; lod++)
+			if (x.MeshIds[lod] != y.MeshIds[lod])
+				return false;
+	}
+	return true;
+}
+
+std::vector<unsigned int> Benchmark::GetScalingThreadCounts(const Options& options)
+{
+	unsigned int most = options.Workers > 0 ? options.Workers + 1 : std::thread::hardware_concurrency();
+	if (most < 1)
+		most = 1;
+
+	std::vector<unsigned int> counts;
+	for (unsigned int threads = 1; threads < most; threads *= 2)
+		counts.push_back(threads);
+	counts.push_back(most);
+	return counts;
+}
+
+void Benchmark::StartAllocationBudget(const Options& options)
+{
+	AllocationTracker::SetBudget(options.AllocationBudget >= 0 ? (uint64_t)options.AllocationBudget : AllocationTracker::NoBudget);
+}
+
+// --------------------------------------------------------
+// Says whether the run kept to its allocation budget, and
+// if not, which tags allocated in its worst frame
+// --------------------------------------------------------
+bool Benchmark::CheckAllocationBudget(const Options& options)
+{
+	uint64_t over = AllocationTracker::GetFramesOverBudget();
+	if (options.AllocationBudget < 0 || over == 0)
+		return true;
+
+	AllocationTracker::Frame worst = AllocationTracker::GetWorstFrame();
+	fprintf(stderr, "%llu of %u frames went over the budget of %d allocations\n",
+		(unsigned long long)over, options.Frames, options.AllocationBudget);
+	fprintf(stderr, "Worst was frame %llu, with %llu allocations (%llu bytes):\n",
+		(unsigned long long)worst.Number, (unsigned long long)worst.Total.Allocations, (unsigned long long)worst.Total.Bytes);
+	for (unsigned int t = 0; t < AllocationTracker::GetTagCount(); t++)
+	{
+		if (worst.Tags[t].Allocations > 0)
+			fprintf(stderr, "  %-24s %8llu allocations %10llu bytes\n", AllocationTracker::GetTagName(t),
+				(unsigned long long)worst.Tags[t].Allocations, (unsigned long long)worst.Tags[t].Bytes);
+	}
+	return false;
+}
@@ -0,0 +1,280 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <chrono>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+#include "AllocationTracker.h"
+#include "RenderQueue.h"
+
+// --------------------------------------------------------
+// Repeatable performance runs
+//
+// A run loads a named scene, steps it a fixed number of
+// frames with a fixed time step while the camera follows a
+// scripted path, and writes a JSON report of how long each
+// stage of the frame took plus per-frame counters.  Nothing
+// depends on the wall clock except the timings themselves,
+// so two runs of the same build see exactly the same frames
+// (the report's checksum of the visible draws shows this).
+//
+// Runs start from the command line, e.g.
+//   --benchmark --scene grid --frames 2000 --camera orbit
+// and --headless skips the window and graphics device
+// entirely, which also works on machines without Direct3D.
+// With --allocation-budget N, a run fails (exits non-zero)
+// if any measured frame makes more than N heap allocations.
+// --scaling runs the same frames on more and more threads,
+// with 100000 objects unless --objects says otherwise.
+// --------------------------------------------------------
+namespace Benchmark
+{
+	struct Options
+	{
+		bool Help = false;						// Only print the usage
+		bool Enabled = false;
+		bool Headless = false;					// CPU stages only, with draws counted but not made
+		bool Allocators = false;				// Frame memory against the heap instead of a scene
+		bool Handles = false;					// Resource handles against shared_ptr instead of a scene
+		bool Entities = false;					// EntitySystem against heap entities instead of a scene
+		bool Jobs = false;						// Job system overhead and scaling instead of a scene
+		bool Arena = false;						// Constant upload ring arena throughput instead of a scene
+		bool WorldViewProjection = false;		// Batched WVP matrices instead of a scene
+		bool DirtyFlags = false;				// Cached world matrices instead of a scene
+		bool TransformUpdate = false;			// Matrices a second at 10k, 100k and 1M transforms
+		bool Basis = false;						// Right, up and forward queries instead of a scene
+		bool Scaling = false;					// The scene on 1, 2, 4... threads in turn
+		bool FrameTimes = false;				// FrameTimes' per-frame cost instead of a scene
+		bool Hierarchy = false;					// Sparse updates of a random hierarchy instead of a scene
+		bool Tests = false;						// Self-checks of the CPU-side code instead of a scene
+		std::string Scene = "default";
+		unsigned int Objects = 0;				// 0 for the scene's own count
+		float Moving = 0.01f;					// Share of transforms --hierarchy moves each frame
+		unsigned int Frames = 1000;				// Measured frames
+		unsigned int Warmup = 10;				// Frames run before measuring starts
+		float DeltaTime = 1.0f / 60.0f;			// Seconds every frame is said to take
+		std::string CameraPath = "orbit";
+		std::string ReportPath = "benchmark.json";
+		std::string CommandsPath;				// Headless: last frame's device commands, if set
+		unsigned int Workers = 0;				// Job system workers, 0 for one per core
+		int AllocationBudget = -1;				// Heap allocations a measured frame may make, -1 for any
+		bool RenderThread = true;				// Draw on a thread of its own, rather than inline
+		unsigned int Width = 1280;				// Window (or, headless, projection) size
+		unsigned int Height = 720;
+		std::string AssetPath = "../../Assets/Models/";
+	};
+
+	// Fills options from command line arguments, leaving anything
+	// not mentioned at its default.  False, with an explanation in
+	// error, if an argument isn't understood.  --help stops at
+	// setting Help, since nothing else will run.
+	bool ParseArguments(const std::vector<std::string>& arguments, Options& options, std::string& error);
+
+	// Same, for a whole command line as one string (WinMain's),
+	// split at spaces except inside double quotes
+	bool ParseCommandLine(const char* commandLine, Options& options, std::string& error);
+
+	// Usage text listing every option
+	const char* GetUsage();
+
+	// Models every scene draws from, in Assets/Models
+	enum Model
+	{
+		Sphere,
+		Cylinder,
+		Cube,
+		Helix,
+		DoubleSidedQuad,
+		Quad,
+		Torus,
+		ModelCount
+	};
+	const char* GetModelFile(Model model);
+
+	// Scenes pick from this many materials (white, red, blue, yellow)
+	static constexpr unsigned int MaterialCount = 4;
+
+	// One object in a scene.  Its rotation at time t is
+	// PitchYawRoll + Spin * t, so any frame can be placed
+	// without stepping through the ones before it.
+	struct SceneObject
+	{
+		DirectX::XMFLOAT3 Position;		// Relative to the parent
+		DirectX::XMFLOAT3 PitchYawRoll;
+		DirectX::XMFLOAT3 Scale;
+		DirectX::XMFLOAT3 Spin;			// Radians per second on each axis
+		int Parent;						// Earlier object's index, or -1
+		Model Shape;
+		unsigned int Material;
+	};
+
+	// "default" (the game's own row of models), "grid" (a big flat
+	// field) or "hierarchy" (chains of children under spinning parents).
+	// objects of 0 uses the scene's usual size.
+	bool BuildScene(const std::string& name, unsigned int objects, std::vector<SceneObject>& scene);
+
+	// Rotation of one scene object at a point in time
+	DirectX::XMFLOAT3 GetRotation(const SceneObject& object, float time);
+
+	// Radius, around the origin, that the camera paths keep to
+	float GetSceneRadius(const std::vector<SceneObject>& scene);
+
+	struct CameraPose
+	{
+		DirectX::XMFLOAT3 Position;
+		DirectX::XMFLOAT3 PitchYawRoll;
+	};
+
+	// "static", "orbit" or "flythrough", for a scene of the given
+	// radius.  False if the path name isn't one of these.
+	bool GetCameraPose(const std::string& path, float time, float sceneRadius, CameraPose& pose);
+
+	// The projection every run uses, matching the game's first camera
+	DirectX::XMMATRIX GetProjection(const Options& options);
+	DirectX::XMMATRIX GetView(const CameraPose& pose);
+
+	// Folds the sorted draws into a running hash
+	uint64_t HashItems(const RenderQueue::ItemList& items, uint64_t hash);
+	static constexpr uint64_t HashSeed = 14695981039346656037ull;
+
+	// --------------------------------------------------------
+	// Per-frame samples of every stage and counter in a run,
+	// in the order they were first added
+	// --------------------------------------------------------
+	class Report
+	{
+	public:
+		void AddSample(const std::string& stage, double milliseconds);
+		void AddCount(const std::string& counter, double value);
+		void SetLoadMilliseconds(double milliseconds) { loadMilliseconds = milliseconds; }
+		void SetChecksum(uint64_t checksum) { this->checksum = checksum; }
+		void SetFramesOverBudget(uint64_t frames) { framesOverBudget = frames; }
+
+		// Mean, percentiles, worst and total of each stage, and the
+		// mean, worst and total of each counter
+		bool WriteJson(const char* path, const Options& options, const char* mode, unsigned int objects, unsigned int threads);
+
+	private:
+		typedef std::vector<std::pair<std::string, std::vector<double>>> SeriesList;
+
+		static std::vector<double>& Find(SeriesList& list, const std::string& name);
+
+		SeriesList stages;
+		SeriesList counters;
+		double loadMilliseconds = 0;
+		uint64_t checksum = HashSeed;
+		uint64_t framesOverBudget = 0;
+	};
+
+	double MillisecondsSince(std::chrono::high_resolution_clock::time_point start);
+
+	// Times one way of doing something as a sample of stage, and
+	// if allocations is given, counts the heap allocations it made
+	// under that name.  Nothing is kept unless record is set, so
+	// warmup frames can go through the same code.
+	template<typename Work>
+	void Measure(Report& report, bool record, const char* stage, const char* allocations, const Work& work);
+
+	// True if two lists of objects, gathered different ways, have
+	// the same bounds, material and meshes for every object.
+	// Transform handles aren't compared, as each way owns its own.
+	bool SameObjects(const std::vector<RenderQueue::Object>& a, const std::vector<RenderQueue::Object>& b);
+
+	// Start of the first measured frame: from here on, frames
+	// are held to the options' allocation budget, if any
+	void StartAllocationBudget(const Options& options);
+
+	// End of the run: true if no measured frame went over the
+	// budget, otherwise prints the worst one and returns false
+	bool CheckAllocationBudget(const Options& options);
+
+	// The whole run without a window or graphics device: draws
+	// every frame into a NullRenderDevice, which records the calls
+	// instead of making them.  Returns a process exit code (2 if
+	// it went over the allocation budget).
+	int RunHeadless(const Options& options);
+
+	// Times frame memory (FrameAllocator.h) against std::vector
+	// and new for the same transient data, instead of a scene.
+	// RunHeadless() hands over to this for --allocators.
+	int RunAllocatorComparison(const Options& options);
+
+	// Times entities reaching their meshes and materials through
+	// ResourcePool handles against through shared_ptr, instead of
+	// a scene.  RunHeadless() hands over to this for --handles.
+	int RunHandleComparison(const Options& options);
+
+	// Times gathering, creating and destroying entities in the
+	// EntitySystem against entities allocated one by one, instead
+	// of a scene.  RunHeadless() hands over to this for --entities.
+	int RunEntityComparison(const Options& options);
+
+	// Times the job system's scheduling overhead, and flat and
+	// nested parallel loops on more and more threads, instead of
+	// a scene.  RunHeadless() hands over to this for --jobs.
+	int RunJobBenchmark(const Options& options);
+
+	// Times sub-allocating constant buffer blocks from a RingArena,
+	// frame after frame with frames in flight, instead of a scene.
+	// RunHeadless() hands over to this for --arena.
+	int RunArenaBenchmark(const Options& options);
+
+	// Times building world-view-projection matrices one object at a
+	// time against MatrixBatch's batches, instead of a scene.
+	// RunHeadless() hands over to this for --wvp.
+	int RunWorldViewProjectionBenchmark(const Options& options);
+
+	// Times Transform::GetWorldMatrix() on still and moving transforms
+	// against rebuilding the matrix on every call, instead of a scene.
+	// RunHeadless() hands over to this for --dirty-flags.
+	int RunDirtyFlagBenchmark(const Options& options);
+
+	// Measures the world matrices TransformSystem::Update() builds a
+	// second at 10k, 100k and 1M transforms, instead of a scene.
+	// RunHeadless() hands over to this for --transform-update.
+	int RunTransformUpdateBenchmark(const Options& options);
+
+	// Times asking transforms for their right, up and forward axes,
+	// cached and from Euler angles, instead of a scene.
+	// RunHeadless() hands over to this for --basis.
+	int RunBasisBenchmark(const Options& options);
+
+	// Times FrameTimes::Record() and GetStats() over a long run of
+	// synthetic frames, instead of a scene.
+	// RunHeadless() hands over to this for --frame-times.
+	int RunFrameTimesBenchmark(const Options& options);
+
+	// Times TransformSystem::Update() and Interpolate() when only
+	// --moving of a random 100k transform hierarchy moves each frame,
+	// instead of a scene.  RunHeadless() hands over to this for
+	// --hierarchy.
+	int RunHierarchyBenchmark(const Options& options);
+
+	// Checks the CPU-side code that can be checked without a GPU,
+	// printing each test as it goes.  Returns 0 if every one
+	// passed.  RunHeadless() hands over to this for --tests.
+	int RunTests(const Options& options);
+
+	// Thread counts a scaling run measures: 1, 2, 4 and so on up
+	// to a thread per core, or to --workers plus one if given
+	std::vector<unsigned int> GetScalingThreadCounts(const Options& options);
+}
+
+template<typename Work>
+void Benchmark::Measure(Report& report, bool record, const char* stage, const char* allocations, const Work& work)
+{
+	uint64_t allocationsBefore = AllocationTracker::GetLifetime().Allocations;
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	work();
+	double milliseconds = MillisecondsSince(start);
+	uint64_t allocationsMade = AllocationTracker::GetLifetime().Allocations - allocationsBefore;
+
+	if (!record)
+		return;
+	AllocationTracker::Ignore ignore;
+	report.AddSample(stage, milliseconds);
+	if (allocations)
+		report.AddCount(allocations, (double)allocationsMade);
+}
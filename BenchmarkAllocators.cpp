@@ -0,0 +1,133 @@
+#include "Benchmark.h"
+#include "AllocationTracker.h"
+#include "FrameAllocator.h"
+#include "JobSystem.h"
+#include <new>
+#include <stdio.h>
+
+namespace
+{
+	// Same grain as the render queue's culling
+	constexpr uint32_t ItemsPerBatch = 512;
+
+	// Bytes in each of the small allocations
+	constexpr size_t SmallBlockSize = 64;
+
+	typedef RenderQueue::Item Item;
+
+	// Two of every three items are kept, like a culling pass
+	// that sees most of the scene
+	template<typename List>
+	void FillLists(std::vector<List>& lists, uint32_t count)
+	{
+		JobSystem::ParallelFor(count, ItemsPerBatch, [&](uint32_t begin, uint32_t end)
+		{
+			unsigned int thread = JobSystem::GetThreadIndex();
+			List& list = lists[thread < lists.size() ? thread : 0];
+			for (uint32_t i = begin; i < end; i++)
+			{
+				if (i % 3 == 0)
+					continue;
+				Item item = { (uint64_t)i * 2654435761u, i, 0 };
+				list.push_back(item);
+			}
+		});
+	}
+}
+
+// --------------------------------------------------------
+// Compares frame memory with the heap for the two kinds of
+// transient data a frame makes
+//
+// Lists: every thread appends what it keeps of a range of
+// items to its own list, as culling does - with a new
+// std::vector each frame, with std::vectors that keep their
+// capacity from frame to frame, and with FrameAllocator::Vector.
+//
+// Small blocks: a 64 byte block per item, written to and
+// let go at the end of the frame - new and delete (malloc()
+// and free() underneath, plus the allocation counting every
+// new in the program pays), or FrameAllocator::Allocate() and
+// nothing.
+//
+// --objects sets the items per frame (100000 by default).
+// --------------------------------------------------------
+int Benchmark::RunAllocatorComparison(const Options& options)
+{
+	uint32_t count = options.Objects > 0 ? options.Objects : 100000;
+	JobSystem::Initialize(options.Workers);
+	unsigned int threads = JobSystem::GetThreadCount();
+	Report report;
+
+	std::vector<std::vector<Item>> keptLists(threads);
+	std::vector<void*> blocks(count);
+
+	for (unsigned int frame = 0; frame < options.Warmup + options.Frames; frame++)
+	{
+		bool record = frame >= options.Warmup;
+
+		Measure(report, record, "std::vector, new each frame", "std::vector, new each frame allocations", [&]()
+		{
+			std::vector<std::vector<Item>> lists(threads);
+			FillLists(lists, count);
+		});
+
+		Measure(report, record, "std::vector, kept", "std::vector, kept allocations", [&]()
+		{
+			for (std::vector<Item>& list : keptLists)
+				list.clear();
+			FillLists(keptLists, count);
+		});
+
+		Measure(report, record, "FrameAllocator::Vector", "FrameAllocator::Vector allocations", [&]()
+		{
+			std::vector<FrameAllocator::Vector<Item>> lists(threads);
+			FillLists(lists, count);
+		});
+
+		Measure(report, record, "new and delete", "new and delete allocations", [&]()
+		{
+			JobSystem::ParallelFor(count, ItemsPerBatch, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; i++)
+				{
+					blocks[i] = ::operator new(SmallBlockSize);
+					*(uint32_t*)blocks[i] = i;
+				}
+			});
+			JobSystem::ParallelFor(count, ItemsPerBatch, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; i++)
+					::operator delete(blocks[i]);
+			});
+		});
+
+		Measure(report, record, "FrameAllocator::Allocate", "FrameAllocator::Allocate allocations", [&]()
+		{
+			JobSystem::ParallelFor(count, ItemsPerBatch, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; i++)
+				{
+					blocks[i] = FrameAllocator::Allocate(SmallBlockSize);
+					*(uint32_t*)blocks[i] = i;
+				}
+			});
+		});
+
+		FrameAllocator::EndFrame();
+	}
+
+	FrameAllocator::Stats frameStats = FrameAllocator::GetStats();
+	printf("Frame memory: %zu bytes a frame, %zu reserved, %llu blocks added\n",
+		frameStats.FrameBytes, frameStats.ReservedBytes, (unsigned long long)frameStats.BlocksAdded);
+
+	bool written = report.WriteJson(options.ReportPath.c_str(), options, "allocators", count, threads);
+	if (written)
+		printf("Wrote %s\n", options.ReportPath.c_str());
+	else
+		fprintf(stderr, "Couldn't write %s\n", options.ReportPath.c_str());
+
+	JobSystem::ShutDown();
+	FrameAllocator::ShutDown();
+	return written ? 0 : 1;
+}
@@ -0,0 +1,232 @@
+#include "Benchmark.h"
+#include "AllocationTracker.h"
+#include "EntitySystem.h"
+#include "JobSystem.h"
+#include "Mesh.h"
+#include "NullRenderDevice.h"
+#include "ResourcePool.h"
+#include "Transform.h"
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <stdio.h>
+
+using namespace DirectX;
+
+namespace
+{
+	// Same grain as Game::BuildVisibility()
+	constexpr uint32_t EntitiesPerBatch = 512;
+
+	// Meshes the entities share between them
+	constexpr uint32_t TestMeshCount = 64;
+
+	// How GameEntity kept its data before the EntitySystem: each
+	// one on its own, wherever the heap put it
+	struct HeapEntity
+	{
+		Transform EntityTransform;
+		MeshHandle EntityMesh;
+		MaterialHandle EntityMaterial;
+		std::vector<MeshHandle> LodMeshes;
+	};
+
+	// A triangle whose bounds differ from every other mesh's
+	void MakeTriangle(uint32_t index, Vertex* vertices, unsigned int* indices)
+	{
+		float size = 1.0f + index;
+		vertices[0] = { XMFLOAT3(0, 0, 0), XMFLOAT3(0, 0, -1), XMFLOAT2(0, 0) };
+		vertices[1] = { XMFLOAT3(0, size, 0), XMFLOAT3(0, 0, -1), XMFLOAT2(0, 1) };
+		vertices[2] = { XMFLOAT3(size, 0, 0), XMFLOAT3(0, 0, -1), XMFLOAT2(1, 0) };
+		indices[0] = 0;
+		indices[1] = 1;
+		indices[2] = 2;
+	}
+
+	// Real materials need Direct3D, and only their handles are
+	// stored, so these stand in for them (and their ids)
+	MaterialHandle MakeMaterial(uint32_t entity)
+	{
+		MaterialHandle material;
+		material.Value = 1 + (uint32_t)(((uint64_t)entity * 2654435761u >> 8) % Benchmark::MaterialCount);
+		return material;
+	}
+}
+
+// --------------------------------------------------------
+// Compares the EntitySystem with entities that each live on
+// the heap, as Game's did
+//
+// Each frame:
+//  - Gathers every entity's transform, bounds, material and
+//    mesh for culling, as Game::BuildVisibility() does, across
+//    every core.  Heap entities look their bounds up through
+//    the mesh; the EntitySystem keeps them alongside.
+//  - Creates as many entities again, with a mesh and material,
+//    then destroys them in a shuffled order, both ways.
+//
+// --objects sets the entity count (100000 by default).
+// --------------------------------------------------------
+int Benchmark::RunEntityComparison(const Options& options)
+{
+	uint32_t count = options.Objects > 0 ? options.Objects : 100000;
+	JobSystem::Initialize(options.Workers);
+	unsigned int threads = JobSystem::GetThreadCount();
+	Report report;
+
+	NullRenderDevice device;
+	RenderDevice::Active = &device;
+
+	std::unique_ptr<ResourcePool<Mesh>> meshPool = std::make_unique<ResourcePool<Mesh>>();
+	std::vector<MeshHandle> meshes;
+	std::vector<EntitySystem::Bounds> meshBounds;
+	for (uint32_t m = 0; m < TestMeshCount; m++)
+	{
+		Vertex vertices[3];
+		unsigned int indices[3];
+		MakeTriangle(m, vertices, indices);
+		meshes.push_back(meshPool->Create(vertices, 3u, indices, 3u));
+		Mesh* mesh = meshPool->Get(meshes.back());
+		meshBounds.push_back({ mesh->GetBoundsCenter(), mesh->GetBoundsExtents() });
+	}
+
+	// The entities gathered each frame, the same both ways
+	std::vector<std::shared_ptr<HeapEntity>> heapEntities(count);
+	std::vector<EntitySystem::Entity> systemEntities(count);
+	EntitySystem::Reserve(2 * count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t mesh = i % TestMeshCount;
+		heapEntities[i] = std::make_shared<HeapEntity>();
+		heapEntities[i]->EntityMesh = meshes[mesh];
+		heapEntities[i]->EntityMaterial = MakeMaterial(i);
+
+		systemEntities[i] = EntitySystem::Create();
+		EntitySystem::SetMesh(systemEntities[i], meshes[mesh], meshBounds[mesh]);
+		EntitySystem::SetMaterial(systemEntities[i], MakeMaterial(i));
+	}
+
+	// The same entities again, made and destroyed every frame, in
+	// an order that leaves holes all over
+	std::vector<std::shared_ptr<HeapEntity>> heapChurn(count);
+	std::vector<EntitySystem::Entity> systemChurn(count);
+	std::vector<uint32_t> destroyOrder(count);
+	for (uint32_t i = 0; i < count; i++)
+		destroyOrder[i] = i;
+	std::shuffle(destroyOrder.begin(), destroyOrder.end(), std::mt19937(12345));
+
+	std::vector<RenderQueue::Object> heapObjects(count);
+	std::vector<RenderQueue::Object> systemObjects(count);
+	TransformSystem::Update();
+
+	for (unsigned int frame = 0; frame < options.Warmup + options.Frames; frame++)
+	{
+		bool record = frame >= options.Warmup;
+
+		Measure(report, record, "Heap entities, gather", 0, [&]()
+		{
+			JobSystem::ParallelFor(count, EntitiesPerBatch, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; i++)
+				{
+					HeapEntity* e = heapEntities[i].get();
+					RenderQueue::Object& o = heapObjects[i];
+					Mesh* mesh = meshPool->Get(e->EntityMesh);
+					o.Transform = e->EntityTransform.GetHandle();
+					o.BoundsCenter = mesh->GetBoundsCenter();
+					o.BoundsExtents = mesh->GetBoundsExtents();
+					o.MaterialId = e->EntityMaterial.Value;
+					o.LodCount = 1;
+					o.MeshIds[0] = mesh->GetId();
+				}
+			});
+		});
+
+		Measure(report, record, "EntitySystem, gather", 0, [&]()
+		{
+			EntitySystem::Components entity = EntitySystem::GetComponents();
+			JobSystem::ParallelFor(entity.Count, EntitiesPerBatch, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; i++)
+				{
+					RenderQueue::Object& o = systemObjects[i];
+					o.Transform = entity.Transforms[i];
+					o.BoundsCenter = entity.LocalBounds[i].Center;
+					o.BoundsExtents = entity.LocalBounds[i].Extents;
+					o.MaterialId = entity.Materials[i].Value;
+					o.LodCount = entity.Meshes[i].Count;
+					o.MeshIds[0] = meshPool->Get(entity.Meshes[i].Meshes[0])->GetId();
+				}
+			});
+		});
+
+		Measure(report, record, "Heap entities, create", "Heap entities, create allocations", [&]()
+		{
+			for (uint32_t i = 0; i < count; i++)
+			{
+				heapChurn[i] = std::make_shared<HeapEntity>();
+				heapChurn[i]->EntityMesh = meshes[i % TestMeshCount];
+				heapChurn[i]->EntityMaterial = MakeMaterial(i);
+			}
+		});
+
+		Measure(report, record, "Heap entities, destroy", 0, [&]()
+		{
+			for (uint32_t i : destroyOrder)
+				heapChurn[i].reset();
+		});
+
+		Measure(report, record, "EntitySystem, create", "EntitySystem, create allocations", [&]()
+		{
+			for (uint32_t i = 0; i < count; i++)
+			{
+				uint32_t mesh = i % TestMeshCount;
+				systemChurn[i] = EntitySystem::Create();
+				EntitySystem::SetMesh(systemChurn[i], meshes[mesh], meshBounds[mesh]);
+				EntitySystem::SetMaterial(systemChurn[i], MakeMaterial(i));
+			}
+		});
+
+		Measure(report, record, "EntitySystem, destroy", 0, [&]()
+		{
+			for (uint32_t i : destroyOrder)
+				EntitySystem::Destroy(systemChurn[i]);
+		});
+
+		// Both ways' transforms were released, and get compacted here
+		Measure(report, record, "Transform update", 0, [&]()
+		{
+			TransformSystem::Update();
+		});
+	}
+
+	// The survivors were shuffled by the churn, so compare them
+	// through their ids rather than in order
+	std::vector<RenderQueue::Object> systemInOrder(count);
+	for (uint32_t i = 0; i < count; i++)
+		systemInOrder[i] = systemObjects[EntitySystem::GetIndex(systemEntities[i])];
+	bool same = SameObjects(heapObjects, systemInOrder);
+	if (!same)
+		fprintf(stderr, "The EntitySystem and heap entities gathered different objects\n");
+
+	EntitySystem::Stats entityStats = EntitySystem::GetStats();
+	printf("Bytes per entity: %zu on the heap (plus the shared_ptr and its count), %zu in the EntitySystem's arrays\n",
+		sizeof(HeapEntity), sizeof(EntitySystem::Entity) + sizeof(TransformSystem::Handle) + sizeof(EntitySystem::MeshLods) +
+		sizeof(MaterialHandle) + sizeof(EntitySystem::Bounds) + sizeof(uint32_t));
+	printf("EntitySystem: %u live, %u slots, %llu created, %llu destroyed\n", entityStats.Count, entityStats.Slots,
+		(unsigned long long)entityStats.Created, (unsigned long long)entityStats.Destroyed);
+
+	bool written = report.WriteJson(options.ReportPath.c_str(), options, "entities", count, threads);
+	if (written)
+		printf("Wrote %s\n", options.ReportPath.c_str());
+	else
+		fprintf(stderr, "Couldn't write %s\n", options.ReportPath.c_str());
+
+	JobSystem::ShutDown();
+	for (EntitySystem::Entity entity : systemEntities)
+		EntitySystem::Destroy(entity);
+	heapEntities.clear();
+	meshPool.reset();
+	RenderDevice::Active = 0;
+	return written && same ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+#include "Benchmark.h"
+#include "FrameTimes.h"
+#include <stdio.h>
+
+namespace
+{
+	// Frames recorded per measured sample, as a long session would
+	constexpr unsigned int FramesPerSample = 100000;
+
+	// What "costs nothing measurable" is held to, per frame -
+	// a hundredth of a percent of a 60fps frame
+	constexpr double BudgetNanoseconds = 1700.0;
+
+	// A steady 60fps with a slow frame every so often
+	float FrameMilliseconds(unsigned int frame)
+	{
+		if (frame % 97 == 0)
+			return 40.0f;
+		return 16.0f + (float)(frame % 7) * 0.1f;
+	}
+}
+
+// --------------------------------------------------------
+// Times what FrameTimes costs the game each frame:
+//  - Record: the one store Main.cpp makes every frame
+//  - Record and GetStats: plus the stats the Frame Times
+//    window asks for every frame, whose percentiles are
+//    only worked out again every few frames
+// with the cost per frame of each as a counter.
+//
+// Fails if a frame costs more than BudgetNanoseconds.
+// --------------------------------------------------------
+int Benchmark::RunFrameTimesBenchmark(const Options& options)
+{
+	Report report;
+	FrameTimes::Reset();
+
+	double recordTotal = 0;
+	double withStatsTotal = 0;
+	float p99 = 0;
+	for (unsigned int frame = 0; frame < options.Warmup + options.Frames; frame++)
+	{
+		bool record = frame >= options.Warmup;
+
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		Measure(report, record, "Record", 0, [&]()
+		{
+			for (unsigned int f = 0; f < FramesPerSample; f++)
+				FrameTimes::Record(FrameMilliseconds(f));
+		});
+		double recordNanoseconds = MillisecondsSince(start) * 1000000.0 / FramesPerSample;
+
+		start = std::chrono::high_resolution_clock::now();
+		Measure(report, record, "Record and GetStats", "Record and GetStats allocations", [&]()
+		{
+			for (unsigned int f = 0; f < FramesPerSample; f++)
+			{
+				FrameTimes::Record(FrameMilliseconds(f));
+				p99 += FrameTimes::GetStats().P99Milliseconds;
+			}
+		});
+		double withStatsNanoseconds = MillisecondsSince(start) * 1000000.0 / FramesPerSample;
+
+		if (record)
+		{
+			report.AddCount("Record nanoseconds per frame", recordNanoseconds);
+			report.AddCount("Record and GetStats nanoseconds per frame", withStatsNanoseconds);
+			recordTotal += recordNanoseconds;
+			withStatsTotal += withStatsNanoseconds;
+		}
+	}
+
+	double recordAverage = options.Frames > 0 ? recordTotal / options.Frames : 0;
+	double withStatsAverage = options.Frames > 0 ? withStatsTotal / options.Frames : 0;
+	printf("Frame times: Record %.1f ns, with GetStats %.1f ns per frame (budget %.0f ns), p99 %.2f ms\n",
+		recordAverage, withStatsAverage, BudgetNanoseconds, FrameTimes::GetStats().P99Milliseconds);
+	bool withinBudget = withStatsAverage <= BudgetNanoseconds && p99 > 0;
+	if (!withinBudget)
+		fprintf(stderr, "Recording frame times costs more than %.0f ns a frame\n", BudgetNanoseconds);
+	FrameTimes::Reset();
+
+	bool written = report.WriteJson(options.ReportPath.c_str(), options, "frame-times", FramesPerSample, 1);
+	if (written)
+		printf("Wrote %s\n", options.ReportPath.c_str());
+	else
+		fprintf(stderr, "Couldn't write %s\n", options.ReportPath.c_str());
+	return written && withinBudget ? 0 : 1;
+}
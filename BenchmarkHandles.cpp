@@ -0,0 +1,242 @@
+#include "Benchmark.h"
+#include "AllocationTracker.h"
+#include "JobSystem.h"
+#include "Mesh.h"
+#include "NullRenderDevice.h"
+#include "ResourcePool.h"
+#include <memory>
+#include <stdio.h>
+
+using namespace DirectX;
+
+namespace
+{
+	// Same grain as Game::BuildVisibility()
+	constexpr uint32_t EntitiesPerBatch = 512;
+
+	// Resources the entities share between them
+	constexpr uint32_t TestMeshCount = 64;
+	constexpr uint32_t TestMaterialCount = 16;
+
+	// Materials made and released each frame, per this many entities
+	constexpr uint32_t EntitiesPerChurn = 100;
+
+	// Stands in for Material, which needs Direct3D for its shaders
+	struct TestMaterial
+	{
+		XMFLOAT4 ColorTint;
+		float Roughness;
+		unsigned int Id;
+	};
+
+	// How GameEntity held its mesh and material before handles
+	struct SharedEntity
+	{
+		std::shared_ptr<Mesh> EntityMesh;
+		std::shared_ptr<TestMaterial> EntityMaterial;
+
+		std::shared_ptr<Mesh> GetMeshCopy() { return EntityMesh; }
+		std::shared_ptr<TestMaterial> GetMaterialCopy() { return EntityMaterial; }
+		const std::shared_ptr<Mesh>& GetMesh() { return EntityMesh; }
+		const std::shared_ptr<TestMaterial>& GetMaterial() { return EntityMaterial; }
+	};
+
+	// And how it holds them now
+	struct HandleEntity
+	{
+		MeshHandle EntityMesh;
+		ResourcePool<TestMaterial>::Handle EntityMaterial;
+	};
+
+	// A triangle whose bounds differ from every other mesh's
+	void MakeTriangle(uint32_t index, Vertex* vertices, unsigned int* indices)
+	{
+		float size = 1.0f + index;
+		vertices[0] = { XMFLOAT3(0, 0, 0), XMFLOAT3(0, 0, -1), XMFLOAT2(0, 0) };
+		vertices[1] = { XMFLOAT3(0, size, 0), XMFLOAT3(0, 0, -1), XMFLOAT2(0, 1) };
+		vertices[2] = { XMFLOAT3(size, 0, 0), XMFLOAT3(0, 0, -1), XMFLOAT2(1, 0) };
+		indices[0] = 0;
+		indices[1] = 1;
+		indices[2] = 2;
+	}
+
+	// Spreads entities over the resources in no particular order,
+	// as a real scene would
+	uint32_t Scatter(uint32_t entity, uint32_t count)
+	{
+		return (uint32_t)(((uint64_t)entity * 2654435761u >> 8) % count);
+	}
+}
+
+// --------------------------------------------------------
+// Compares the two ways an entity can refer to the meshes
+// and materials it shares with others
+//
+// Each frame every entity's bounds and material id are
+// gathered, as Game::BuildVisibility() does, across every
+// core:
+//  - through shared_ptr getters that return copies, so each
+//    call is an atomic increment and decrement on a count
+//    that every core is also changing
+//  - through the same getters returning references
+//  - through ResourcePool handles, which are looked up
+//
+// Then a few materials are made and let go both ways, to
+// show what handles' deferred destruction costs.
+//
+// --objects sets the entity count (100000 by default).
+// --------------------------------------------------------
+int Benchmark::RunHandleComparison(const Options& options)
+{
+	uint32_t count = options.Objects > 0 ? options.Objects : 100000;
+	JobSystem::Initialize(options.Workers);
+	unsigned int threads = JobSystem::GetThreadCount();
+	Report report;
+
+	NullRenderDevice device;
+	RenderDevice::Active = &device;
+
+	// The same meshes and materials twice - owned by shared_ptr,
+	// and owned by pools.  The meshes' shared_ptrs point into the
+	// pool, so both ways gather the same mesh ids, but keep their
+	// own counts as ever.
+	std::unique_ptr<ResourcePool<Mesh>> meshPool = std::make_unique<ResourcePool<Mesh>>();
+	std::unique_ptr<ResourcePool<TestMaterial>> materialPool = std::make_unique<ResourcePool<TestMaterial>>();
+	std::vector<std::shared_ptr<Mesh>> sharedMeshes;
+	std::vector<MeshHandle> meshHandles;
+	for (uint32_t m = 0; m < TestMeshCount; m++)
+	{
+		Vertex vertices[3];
+		unsigned int indices[3];
+		MakeTriangle(m, vertices, indices);
+		meshHandles.push_back(meshPool->Create(vertices, 3u, indices, 3u));
+		sharedMeshes.push_back(std::shared_ptr<Mesh>(meshPool->Get(meshHandles.back()), [](Mesh*) {}));
+	}
+
+	std::vector<std::shared_ptr<TestMaterial>> sharedMaterials;
+	std::vector<ResourcePool<TestMaterial>::Handle> materialHandles;
+	for (uint32_t m = 0; m < TestMaterialCount; m++)
+	{
+		TestMaterial material = { XMFLOAT4(1, 1, 1, 1), 0.5f, m };
+		sharedMaterials.push_back(std::make_shared<TestMaterial>(material));
+		materialHandles.push_back(materialPool->Create(material));
+	}
+
+	// Entities live on the heap, one by one, like Game's
+	std::vector<std::shared_ptr<SharedEntity>> sharedEntities(count);
+	std::vector<std::shared_ptr<HandleEntity>> handleEntities(count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t mesh = Scatter(i, TestMeshCount);
+		uint32_t material = Scatter(i * 7 + 3, TestMaterialCount);
+		sharedEntities[i] = std::make_shared<SharedEntity>(SharedEntity{ sharedMeshes[mesh], sharedMaterials[material] });
+		handleEntities[i] = std::make_shared<HandleEntity>(HandleEntity{ meshHandles[mesh], materialHandles[material] });
+	}
+
+	std::vector<RenderQueue::Object> sharedObjects(count);
+	std::vector<RenderQueue::Object> handleObjects(count);
+	uint32_t churn = count / EntitiesPerChurn > 0 ? count / EntitiesPerChurn : 1;
+	std::vector<std::shared_ptr<TestMaterial>> churnShared(churn);
+	std::vector<ResourcePool<TestMaterial>::Handle> churnHandles(churn);
+
+	for (unsigned int frame = 0; frame < options.Warmup + options.Frames; frame++)
+	{
+		bool record = frame >= options.Warmup;
+
+		Measure(report, record, "shared_ptr, copied", 0, [&]()
+		{
+			JobSystem::ParallelFor(count, EntitiesPerBatch, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; i++)
+				{
+					SharedEntity* e = sharedEntities[i].get();
+					RenderQueue::Object& o = sharedObjects[i];
+					o.BoundsCenter = e->GetMeshCopy()->GetBoundsCenter();
+					o.BoundsExtents = e->GetMeshCopy()->GetBoundsExtents();
+					o.MaterialId = e->GetMaterialCopy()->Id;
+					o.LodCount = 1;
+					o.MeshIds[0] = e->GetMeshCopy()->GetId();
+				}
+			});
+		});
+
+		Measure(report, record, "shared_ptr, by reference", 0, [&]()
+		{
+			JobSystem::ParallelFor(count, EntitiesPerBatch, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; i++)
+				{
+					SharedEntity* e = sharedEntities[i].get();
+					RenderQueue::Object& o = sharedObjects[i];
+					o.BoundsCenter = e->GetMesh()->GetBoundsCenter();
+					o.BoundsExtents = e->GetMesh()->GetBoundsExtents();
+					o.MaterialId = e->GetMaterial()->Id;
+					o.LodCount = 1;
+					o.MeshIds[0] = e->GetMesh()->GetId();
+				}
+			});
+		});
+
+		Measure(report, record, "Handles", 0, [&]()
+		{
+			JobSystem::ParallelFor(count, EntitiesPerBatch, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; i++)
+				{
+					HandleEntity* e = handleEntities[i].get();
+					RenderQueue::Object& o = handleObjects[i];
+					Mesh* mesh = meshPool->Get(e->EntityMesh);
+					o.BoundsCenter = mesh->GetBoundsCenter();
+					o.BoundsExtents = mesh->GetBoundsExtents();
+					o.MaterialId = materialPool->Get(e->EntityMaterial)->Id;
+					o.LodCount = 1;
+					o.MeshIds[0] = mesh->GetId();
+				}
+			});
+		});
+
+		Measure(report, record, "shared_ptr, make and release", "shared_ptr, make and release allocations", [&]()
+		{
+			for (uint32_t c = 0; c < churn; c++)
+				churnShared[c] = std::make_shared<TestMaterial>(TestMaterial{ XMFLOAT4(1, 0, 0, 1), 0.5f, TestMaterialCount + c });
+			for (uint32_t c = 0; c < churn; c++)
+				churnShared[c].reset();
+		});
+
+		Measure(report, record, "Handles, make and release", "Handles, make and release allocations", [&]()
+		{
+			for (uint32_t c = 0; c < churn; c++)
+				churnHandles[c] = materialPool->Create(TestMaterial{ XMFLOAT4(1, 0, 0, 1), 0.5f, TestMaterialCount + c });
+			for (uint32_t c = 0; c < churn; c++)
+				materialPool->Release(churnHandles[c]);
+			materialPool->EndFrame();
+		});
+	}
+
+	bool same = SameObjects(sharedObjects, handleObjects);
+	if (!same)
+		fprintf(stderr, "Handles and shared_ptr gathered different objects\n");
+
+	ResourcePool<TestMaterial>::Stats materialStats = materialPool->GetStats();
+	printf("References per entity: %zu bytes with shared_ptr, %zu with handles\n",
+		sizeof(SharedEntity), sizeof(HandleEntity));
+	printf("Material pool: %u live, %u waiting to be destroyed, %u slots\n",
+		materialStats.Live, materialStats.Pending, materialStats.Slots);
+
+	bool written = report.WriteJson(options.ReportPath.c_str(), options, "handles", count, threads);
+	if (written)
+		printf("Wrote %s\n", options.ReportPath.c_str());
+	else
+		fprintf(stderr, "Couldn't write %s\n", options.ReportPath.c_str());
+
+	// Entities first, then what they refer to, while the device
+	// is still there for the meshes' buffers
+	JobSystem::ShutDown();
+	sharedEntities.clear();
+	handleEntities.clear();
+	sharedMeshes.clear();
+	meshPool.reset();
+	materialPool.reset();
+	RenderDevice::Active = 0;
+	return written && same ? 0 : 1;
+}
@@ -0,0 +1,483 @@
+#include "Benchmark.h"
+#include "AllocationTracker.h"
+#include "DrawSubmission.h"
+#include "FrameAllocator.h"
+#include "JobSystem.h"
+#include "Lights.h"
+#include "Mesh.h"
+#include "MeshData.h"
+#include "NullRenderDevice.h"
+#include "RenderStats.h"
+#include "RenderThread.h"
+#include "Transform.h"
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <string.h>
+
+using namespace DirectX;
+
+namespace
+{
+	const RenderStats::Counter submitCounters[] =
+	{
+		RenderStats::DrawCalls,
+		RenderStats::Triangles,
+		RenderStats::ShaderBinds,
+		RenderStats::BufferBinds,
+		RenderStats::ConstantBufferUploads,
+		RenderStats::ConstantBufferBytes,
+	};
+
+	// The game's constant buffers (see the .hlsl files)
+	struct PerFrameData
+	{
+		XMFLOAT3 CameraPosition;
+		float Padding0;
+		XMFLOAT3 Ambient;
+		float Padding1;
+		Light Lights[5];
+	};
+
+	struct PerMaterialData
+	{
+		XMFLOAT4 ColorTint;
+		float Roughness;
+		float Padding[3];
+	};
+
+	struct PerObjectData
+	{
+		XMFLOAT4X4 World;
+		XMFLOAT4X4 WorldInvTranspose;
+		XMFLOAT4X4 WorldViewProjection;
+	};
+
+	// Register each buffer is bound to
+	const uint32_t perFrameSlot = 0;
+	const uint32_t perMaterialSlot = 1;
+	const uint32_t perObjectSlot = 2;
+	const uint32_t pixelSlots[] = { perFrameSlot, perMaterialSlot };
+	const uint32_t vertexSlots[] = { perObjectSlot };
+
+	// Scene size --scaling measures, unless --objects says otherwise
+	constexpr unsigned int ScalingObjects = 100000;
+
+	// What a shader's constant buffer copy costs and counts
+	void UploadConstants(RenderDevice* device, RenderDevice::Handle buffer, const void* data, uint32_t size)
+	{
+		device->UpdateBuffer(buffer, data, size);
+		RenderStats::Add(RenderStats::ConstantBufferUploads);
+		RenderStats::Add(RenderStats::ConstantBufferBytes, size);
+	}
+
+	// Makes the same calls as SimpleShader::SetShader() for a
+	// shader with the given constant buffers
+	void BindShader(RenderDevice* device, RenderDevice::ShaderStage stage, RenderDevice::Handle shader, const uint32_t* slots, const RenderDevice::Handle* buffers, uint32_t bufferCount)
+	{
+		device->SetShader(stage, shader);
+		for (uint32_t b = 0; b < bufferCount; b++)
+			device->SetConstantBuffer(stage, slots[b], buffers[b]);
+		RenderStats::Add(RenderStats::ShaderBinds);
+		RenderStats::Add(RenderStats::BufferBinds, bufferCount);
+	}
+
+	// A frame's snapshotted draws, as SubmitDraws() asks for them,
+	// making the same calls the game's shaders would
+	struct SnapshotDraws
+	{
+		RenderDevice* Device;
+		const std::vector<DrawCommand>& Draws;
+		RenderDevice::Handle VertexShader;
+		RenderDevice::Handle PixelShader;
+		const RenderDevice::Handle* VertexBuffers;
+		const RenderDevice::Handle* PixelBuffers;
+
+		// The scene's materials only differ by tint
+		bool SameMaterial(size_t a, size_t b) const
+		{
+			return memcmp(&Draws[a].ColorTint, &Draws[b].ColorTint, sizeof(XMFLOAT4)) == 0 && Draws[a].Roughness == Draws[b].Roughness;
+		}
+
+		void SetMaterial(size_t i) const
+		{
+			PerMaterialData perMaterial = { Draws[i].ColorTint, Draws[i].Roughness, {} };
+			UploadConstants(Device, PixelBuffers[1], &perMaterial, sizeof(perMaterial));
+		}
+
+		void SetObject(size_t i) const
+		{
+			PerObjectData perObject;
+			perObject.World = Draws[i].World;
+			perObject.WorldInvTranspose = Draws[i].WorldInvTranspose;
+			perObject.WorldViewProjection = Draws[i].WorldViewProjection;
+			UploadConstants(Device, VertexBuffers[0], &perObject, sizeof(perObject));
+		}
+
+		void SetShaders(size_t) const
+		{
+			BindShader(Device, RenderDevice::VertexStage, VertexShader, vertexSlots, VertexBuffers, 1);
+			BindShader(Device, RenderDevice::PixelStage, PixelShader, pixelSlots, PixelBuffers, 2);
+		}
+
+		void Draw(size_t i) const { Draws[i].Geometry->Draw(); }
+	};
+
+	// What drawing one frame took and counted
+	struct DrawnFrame
+	{
+		double SubmitMilliseconds;
+		size_t Commands;
+		RenderStats::Frame Counts;
+	};
+
+	// What DrawSnapshot() draws with, since RenderThread only takes
+	// a plain function.  Frames is reserved for the whole run before
+	// drawing starts, and only read once RenderThread::Flush() says
+	// every frame has been drawn.
+	struct Renderer
+	{
+		NullRenderDevice* Device;
+		RenderDevice::Handle VertexShader;
+		RenderDevice::Handle PixelShader;
+		const RenderDevice::Handle* VertexBuffers;
+		const RenderDevice::Handle* PixelBuffers;
+		std::vector<DrawnFrame> Frames;
+	};
+	Renderer* renderer = 0;
+
+	// Submits one frame the way Game::Render() does, on the render
+	// thread with --render-thread on, otherwise inside Submit()
+	void DrawSnapshot(const FrameSnapshot& frame)
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		NullRenderDevice& device = *renderer->Device;
+		device.Reset();
+		device.Clear(frame.ClearColor, 1.0f);
+
+		PerFrameData perFrame = {};
+		perFrame.CameraPosition = frame.CameraPosition;
+		UploadConstants(&device, renderer->PixelBuffers[0], &perFrame, sizeof(perFrame));
+
+		SnapshotDraws draws = { &device, frame.Draws, renderer->VertexShader, renderer->PixelShader, renderer->VertexBuffers, renderer->PixelBuffers };
+		SubmitDraws(draws, frame.Draws.size());
+
+		device.DrawUI(0);
+		device.Present(false);
+		RenderStats::EndFrame();
+
+		DrawnFrame drawn;
+		drawn.SubmitMilliseconds = Benchmark::MillisecondsSince(start);
+		drawn.Commands = device.GetCommands().size();
+		drawn.Counts = RenderStats::GetLastFrame();
+		renderer->Frames.push_back(drawn);
+	}
+}
+
+// --------------------------------------------------------
+// Runs a benchmark on the CPU alone
+//
+// Each frame places every object for its point in time,
+// rebuilds the transforms, culls and sorts with the same
+// RenderQueue the game uses, then snapshots the sorted draws
+// and submits them the way Game::Render() does, to a
+// NullRenderDevice that records the commands instead of
+// drawing.  As in the game, the submit runs on RenderThread
+// while the next frame is prepared, or inline with
+// --render-thread off, so the two reports' Frame times show
+// what the overlap is worth.
+// --------------------------------------------------------
+int Benchmark::RunHeadless(const Options& options)
+{
+	if (options.Allocators)
+		return RunAllocatorComparison(options);
+	if (options.Handles)
+		return RunHandleComparison(options);
+	if (options.Entities)
+		return RunEntityComparison(options);
+	if (options.Jobs)
+		return RunJobBenchmark(options);
+	if (options.Arena)
+		return RunArenaBenchmark(options);
+	if (options.WorldViewProjection)
+		return RunWorldViewProjectionBenchmark(options);
+	if (options.DirtyFlags)
+		return RunDirtyFlagBenchmark(options);
+	if (options.TransformUpdate)
+		return RunTransformUpdateBenchmark(options);
+	if (options.Basis)
+		return RunBasisBenchmark(options);
+	if (options.FrameTimes)
+		return RunFrameTimesBenchmark(options);
+	if (options.Hierarchy)
+		return RunHierarchyBenchmark(options);
+	if (options.Tests)
+		return RunTests(options);
+
+	std::vector<SceneObject> scene;
+	unsigned int objectCount = options.Objects == 0 && options.Scaling ? ScalingObjects : options.Objects;
+	if (!BuildScene(options.Scene, objectCount, scene))
+	{
+		fprintf(stderr, "Unknown scene %s\n", options.Scene.c_str());
+		return 1;
+	}
+
+	JobSystem::Initialize(options.Workers);
+	Report report;
+
+	// Everything draws into this instead of a GPU.  Long runs
+	// only keep the last frame's commands.
+	NullRenderDevice device;
+	RenderDevice::Active = &device;
+
+	// Models, in parallel like the game's - the file is read
+	// here, rather than by Mesh, to find out if it was there
+	std::chrono::high_resolution_clock::time_point loadStart = std::chrono::high_resolution_clock::now();
+	std::unique_ptr<Mesh> models[ModelCount];
+	double modelMilliseconds[ModelCount] = {};
+	JobSystem::ParallelFor(ModelCount, 1, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t m = begin; m < end; m++)
+		{
+			std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+			std::string path = options.AssetPath + GetModelFile((Model)m);
+			MeshData data;
+			if (data.LoadObj(path.c_str()))
+				models[m] = std::make_unique<Mesh>(data.Vertices.data(), (unsigned int)data.Vertices.size(), data.Indices.data(), (unsigned int)data.Indices.size());
+			modelMilliseconds[m] = MillisecondsSince(start);
+		}
+	});
+
+	for (int m = 0; m < ModelCount; m++)
+	{
+		if (!models[m])
+		{
+			fprintf(stderr, "Couldn't load %s%s\n", options.AssetPath.c_str(), GetModelFile((Model)m));
+			for (std::unique_ptr<Mesh>& model : models)
+				model.reset();
+			RenderDevice::Active = 0;
+			JobSystem::ShutDown();
+			return 1;
+		}
+		report.AddSample("Mesh load", modelMilliseconds[m]);
+	}
+
+	// One vertex and one pixel shader, as every game material
+	// uses, with the same constant buffers
+	char bytecode[4] = {};
+	RenderDevice::Handle vertexShader = device.CreateShader(RenderDevice::VertexStage, bytecode, sizeof(bytecode));
+	RenderDevice::Handle pixelShader = device.CreateShader(RenderDevice::PixelStage, bytecode, sizeof(bytecode));
+	RenderDevice::Handle pixelBuffers[] =
+	{
+		device.CreateBuffer(RenderDevice::ConstantBuffer, 0, sizeof(PerFrameData)),
+		device.CreateBuffer(RenderDevice::ConstantBuffer, 0, sizeof(PerMaterialData)),
+	};
+	RenderDevice::Handle vertexBuffers[] =
+	{
+		device.CreateBuffer(RenderDevice::ConstantBuffer, 0, sizeof(PerObjectData)),
+	};
+	const XMFLOAT4 materialTints[MaterialCount] =
+	{
+		XMFLOAT4(1, 1, 1, 1),
+		XMFLOAT4(1, 0, 0, 1),
+		XMFLOAT4(0, 0, 1, 1),
+		XMFLOAT4(1, 1, 0, 1),
+	};
+	const float clearColor[4] = { 0.4f, 0.6f, 0.75f, 1.0f };
+
+	// One transform per object, children after their parents
+	TransformSystem::Reserve(scene.size());
+	std::vector<std::unique_ptr<Transform>> transforms(scene.size());
+	std::vector<RenderQueue::Object> objects(scene.size());
+	for (size_t i = 0; i < scene.size(); i++)
+	{
+		const SceneObject& s = scene[i];
+		transforms[i] = std::make_unique<Transform>();
+		transforms[i]->SetPosition(s.Position);
+		transforms[i]->SetRotation(s.PitchYawRoll);
+		transforms[i]->SetScale(s.Scale);
+		if (s.Parent >= 0)
+			transforms[i]->SetParent(transforms[s.Parent].get());
+
+		RenderQueue::Object& o = objects[i];
+		o.Transform = transforms[i]->GetHandle();
+		o.BoundsCenter = models[s.Shape]->GetBoundsCenter();
+		o.BoundsExtents = models[s.Shape]->GetBoundsExtents();
+		o.MaterialId = s.Material;
+		o.LodCount = 1;
+		o.MeshIds[0] = (uint32_t)s.Shape;
+	}
+	report.SetLoadMilliseconds(MillisecondsSince(loadStart));
+
+	RenderQueue queue;
+	XMMATRIX projection = GetProjection(options);
+	float radius = GetSceneRadius(scene);
+
+	// Every frame once, or with --scaling, once on each thread
+	// count in turn - the same frames, so the same checksum
+	std::vector<unsigned int> threadCounts = { JobSystem::GetThreadCount() };
+	if (options.Scaling)
+		threadCounts = GetScalingThreadCounts(options);
+	uint64_t firstChecksum = HashSeed;
+	bool sameChecksums = true;
+
+	// Drawing, on its own thread unless --render-thread off
+	Renderer draws = { &device, vertexShader, pixelShader, vertexBuffers, pixelBuffers, {} };
+	renderer = &draws;
+	RenderThread::Start(DrawSnapshot, options.RenderThread);
+
+	for (unsigned int threads : threadCounts)
+	{
+		std::string suffix;
+		if (options.Scaling)
+		{
+			suffix = ", " + std::to_string(threads) + (threads == 1 ? " thread" : " threads");
+			JobSystem::ShutDown();
+			if (threads > 1)
+				JobSystem::Initialize(threads - 1);
+		}
+		uint64_t checksum = HashSeed;
+		double frameTotal = 0;
+		double gameTotal = 0;
+		draws.Frames.clear();
+		draws.Frames.reserve(options.Warmup + options.Frames);
+
+		// Loading (or starting threads) isn't part of the first frame
+		AllocationTracker::EndFrame();
+
+		for (unsigned int frame = 0; frame < options.Warmup + options.Frames; frame++)
+		{
+			if (frame == options.Warmup)
+				StartAllocationBudget(options);
+
+			std::chrono::high_resolution_clock::time_point frameStart = std::chrono::high_resolution_clock::now();
+			float time = frame * options.DeltaTime;
+
+			// Scene update - one step per frame, drawn exactly at it
+			{
+				ALLOCATION_TAG("Scene update");
+				TransformSystem::BeginStep();
+				for (size_t i = 0; i < scene.size(); i++)
+					transforms[i]->SetRotation(GetRotation(scene[i], time));
+				TransformSystem::Interpolate(1.0f);
+			}
+			double updateMilliseconds = MillisecondsSince(frameStart);
+
+			// Culling and sorting
+			CameraPose pose;
+			GetCameraPose(options.CameraPath, time, radius, pose);
+			{
+				ALLOCATION_TAG("Render queue");
+				queue.Build(objects.data(), (uint32_t)objects.size(), GetView(pose), projection);
+			}
+
+			// Hand the sorted draws over, copied as Game::FillSnapshot()
+			// does, so the game thread can move on while they're drawn
+			std::chrono::high_resolution_clock::time_point snapshotStart = std::chrono::high_resolution_clock::now();
+			const RenderQueue::ItemList& items = queue.GetItems();
+			{
+				ALLOCATION_TAG("Snapshot");
+				FrameSnapshot& snapshot = RenderThread::BeginFrame();
+				memcpy(snapshot.ClearColor, clearColor, sizeof(snapshot.ClearColor));
+				snapshot.CameraPosition = pose.Position;
+				snapshot.Draws.resize(items.size());
+				for (size_t d = 0; d < items.size(); d++)
+				{
+					uint32_t i = items[d].Entity;
+					DrawCommand& draw = snapshot.Draws[d];
+					draw.World = queue.GetWorldMatrix(i);
+					draw.WorldInvTranspose = queue.GetWorldInverseTransposeMatrix(i);
+					draw.WorldViewProjection = queue.GetWorldViewProjectionMatrix(i);
+					draw.Geometry = models[objects[i].MeshIds[items[d].Lod]].get();
+					draw.Source = 0;
+					draw.VertexShader = 0;
+					draw.PixelShader = 0;
+					draw.ColorTint = materialTints[objects[i].MaterialId];
+					draw.Roughness = 0.0f;
+				}
+			}
+			double snapshotMilliseconds = MillisecondsSince(snapshotStart);
+
+			// Drawn inline, this is the whole submit; on the render
+			// thread, it's only waiting for the last frame to be taken
+			std::chrono::high_resolution_clock::time_point handOffStart = std::chrono::high_resolution_clock::now();
+			RenderThread::Submit();
+			double handOffMilliseconds = MillisecondsSince(handOffStart);
+
+			AllocationTracker::EndFrame();
+			FrameAllocator::EndFrame();
+			double frameMilliseconds = MillisecondsSince(frameStart);
+
+			if (frame < options.Warmup)
+				continue;
+
+			// The report's own growth isn't part of the next frame
+			AllocationTracker::Ignore ignore;
+			AllocationTracker::Frame allocations = AllocationTracker::GetLastFrame();
+			RenderQueue::Stats queueStats = queue.GetStats();
+			report.AddSample("Frame" + suffix, frameMilliseconds);
+			report.AddSample("Game" + suffix, frameMilliseconds - handOffMilliseconds);
+			frameTotal += frameMilliseconds;
+			gameTotal += frameMilliseconds - handOffMilliseconds;
+			report.AddSample("Scene update" + suffix, updateMilliseconds);
+			report.AddSample("Culling" + suffix, queueStats.CullMilliseconds);
+			report.AddSample("Sorting" + suffix, queueStats.SortMilliseconds);
+			report.AddSample("Snapshot" + suffix, snapshotMilliseconds);
+			if (options.RenderThread)
+				report.AddSample("Render wait" + suffix, handOffMilliseconds);
+
+			report.AddCount("Visible" + suffix, queueStats.Visible);
+			report.AddCount("Allocations" + suffix, (double)allocations.Total.Allocations);
+			report.AddCount("Allocated bytes" + suffix, (double)allocations.Total.Bytes);
+			report.AddCount("Frame memory bytes" + suffix, (double)FrameAllocator::GetStats().FrameBytes);
+			checksum = HashItems(items, checksum);
+		}
+
+		// What the drawing measured, once it's all drawn
+		RenderThread::Flush();
+		double submitTotal = 0;
+		for (size_t f = options.Warmup; f < draws.Frames.size(); f++)
+		{
+			const DrawnFrame& drawn = draws.Frames[f];
+			report.AddSample("Submit" + suffix, drawn.SubmitMilliseconds);
+			report.AddCount("Device commands" + suffix, (double)drawn.Commands);
+			for (RenderStats::Counter c : submitCounters)
+				report.AddCount(RenderStats::GetName(c) + suffix, (double)drawn.Counts.Values[c]);
+			submitTotal += drawn.SubmitMilliseconds;
+		}
+		printf("Render thread %s%s: frame %.3f ms, game %.3f ms, submit %.3f ms\n",
+			options.RenderThread ? "on" : "off", suffix.c_str(),
+			frameTotal / options.Frames, gameTotal / options.Frames, submitTotal / options.Frames);
+
+		if (threads == threadCounts.front())
+			firstChecksum = checksum;
+		sameChecksums = sameChecksums && checksum == firstChecksum;
+	}
+	report.SetChecksum(firstChecksum);
+	if (!sameChecksums)
+		fprintf(stderr, "Some thread counts drew different frames from others\n");
+	report.SetFramesOverBudget(AllocationTracker::GetFramesOverBudget());
+	bool withinBudget = CheckAllocationBudget(options);
+
+	RenderThread::Stop();
+	renderer = 0;
+
+	if (!options.CommandsPath.empty() && !device.WriteText(options.CommandsPath.c_str()))
+		fprintf(stderr, "Couldn't write %s\n", options.CommandsPath.c_str());
+
+	bool written = report.WriteJson(options.ReportPath.c_str(), options, options.Scaling ? "scaling" : "headless", (unsigned int)scene.size(), threadCounts.back());
+	if (written)
+		printf("Wrote %s\n", options.ReportPath.c_str());
+	else
+		fprintf(stderr, "Couldn't write %s\n", options.ReportPath.c_str());
+
+	transforms.clear();
+	for (std::unique_ptr<Mesh>& model : models)
+		model.reset();
+	RenderDevice::Active = 0;
+	JobSystem::ShutDown();
+	FrameAllocator::ShutDown();
+	if (!written || !sameChecksums)
+		return 1;
+	return withinBudget ? 0 : 2;
+}
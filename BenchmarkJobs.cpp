@@ -0,0 +1,149 @@
+#include "Benchmark.h"
+#include "JobSystem.h"
+#include <math.h>
+#include <stdio.h>
+#include <string>
+
+namespace
+{
+	// Overhead: empty jobs, queued this many at a time and waited on
+	constexpr uint32_t EmptyJobs = 10000;
+	constexpr uint32_t JobsPerWait = 256;
+
+	// Embarrassingly parallel: the same small sum on every item
+	constexpr uint32_t FlatItems = 1 << 18;
+	constexpr uint32_t FlatBatch = 1024;
+
+	// Nested: each outer item runs a ParallelFor of its own
+	constexpr uint32_t OuterItems = 1000;
+	constexpr uint32_t InnerItems = 100;
+
+	void EmptyJob(void*, uint32_t, uint32_t)
+	{
+	}
+
+	// A few dozen dependent flops, about what placing one object costs
+	float Work(uint32_t item)
+	{
+		float x = (float)(item & 1023) * 0.001f;
+		for (int k = 0; k < 16; k++)
+			x = sqrtf(x * x + 0.5f) * 0.75f;
+		return x;
+	}
+
+	struct Stages
+	{
+		std::string Empty;
+		std::string Flat;
+		std::string Nested;
+		std::string Stolen;
+	};
+}
+
+// --------------------------------------------------------
+// Measures the job system on 1, 2, 4... threads
+//
+// Each frame, on each thread count:
+//  - Empty jobs: Run() and Wait() with nothing to do, so the
+//    time is all queuing, stealing and counting
+//  - Flat: one ParallelFor over a quarter million items
+//  - Nested: a ParallelFor whose every item is a ParallelFor
+//    of its own, as frame graph tasks calling into systems are
+// plus the flat and nested work run serially, to compare with.
+//
+// One thread is the job system shut down, which runs every
+// job inline as a thread it doesn't know would.
+// --------------------------------------------------------
+int Benchmark::RunJobBenchmark(const Options& options)
+{
+	std::vector<unsigned int> threadCounts = GetScalingThreadCounts(options);
+	Report report;
+
+	std::vector<float> serial(FlatItems);
+	std::vector<float> flat(FlatItems);
+	std::vector<float> serialNested(OuterItems * InnerItems);
+	std::vector<float> nested(OuterItems * InnerItems);
+	bool same = true;
+
+	for (unsigned int frame = 0; frame < options.Warmup + options.Frames; frame++)
+	{
+		bool record = frame >= options.Warmup;
+		Measure(report, record, "Serial, flat", 0, [&]()
+		{
+			for (uint32_t i = 0; i < FlatItems; i++)
+				serial[i] = Work(i);
+		});
+		Measure(report, record, "Serial, nested", 0, [&]()
+		{
+			for (uint32_t i = 0; i < OuterItems * InnerItems; i++)
+				serialNested[i] = Work(i);
+		});
+	}
+
+	for (unsigned int threads : threadCounts)
+	{
+		std::string suffix = ", " + std::to_string(threads) + (threads == 1 ? " thread" : " threads");
+		Stages stages = { "Empty jobs" + suffix, "Flat" + suffix, "Nested" + suffix, "Jobs stolen" + suffix };
+		if (threads > 1)
+			JobSystem::Initialize(threads - 1);
+
+		for (unsigned int frame = 0; frame < options.Warmup + options.Frames; frame++)
+		{
+			bool record = frame >= options.Warmup;
+			JobSystem::ResetStats();
+
+			Measure(report, record, stages.Empty.c_str(), 0, [&]()
+			{
+				for (uint32_t queued = 0; queued < EmptyJobs; queued += JobsPerWait)
+				{
+					JobSystem::Counter counter;
+					for (uint32_t j = 0; j < JobsPerWait; j++)
+						JobSystem::Run(EmptyJob, 0, &counter);
+					JobSystem::Wait(&counter);
+				}
+			});
+
+			Measure(report, record, stages.Flat.c_str(), 0, [&]()
+			{
+				JobSystem::ParallelFor(FlatItems, FlatBatch, [&](uint32_t begin, uint32_t end)
+				{
+					for (uint32_t i = begin; i < end; i++)
+						flat[i] = Work(i);
+				});
+			});
+
+			Measure(report, record, stages.Nested.c_str(), 0, [&]()
+			{
+				JobSystem::ParallelFor(OuterItems, 1, [&](uint32_t begin, uint32_t end)
+				{
+					for (uint32_t outer = begin; outer < end; outer++)
+					{
+						float* row = &nested[outer * InnerItems];
+						JobSystem::ParallelFor(InnerItems, 1, [&](uint32_t innerBegin, uint32_t innerEnd)
+						{
+							for (uint32_t inner = innerBegin; inner < innerEnd; inner++)
+								row[inner] = Work(outer * InnerItems + inner);
+						});
+					}
+				});
+			});
+
+			if (record)
+				report.AddCount(stages.Stolen, (double)JobSystem::GetStats().Stolen);
+		}
+
+		same = same && flat == serial && nested == serialNested;
+		if (threads > 1)
+			JobSystem::ShutDown();
+	}
+
+	if (!same)
+		fprintf(stderr, "Parallel loops gave different results from serial ones\n");
+
+	bool written = report.WriteJson(options.ReportPath.c_str(), options, "jobs", FlatItems, threadCounts.back());
+	if (written)
+		printf("Wrote %s\n", options.ReportPath.c_str());
+	else
+		fprintf(stderr, "Couldn't write %s\n", options.ReportPath.c_str());
+	return written && same ? 0 : 1;
+}
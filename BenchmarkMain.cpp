@@ -0,0 +1,51 @@
+// --------------------------------------------------------
+// Entry point for the headless benchmark on platforms
+// without Direct3D (Windows uses WinMain in Main.cpp, which
+// takes the same options)
+//
+// Only the CPU side of the engine is needed, e.g. with
+// DirectXMath (and its sal.h) on the include path:
+//   g++ -O2 -std=c++17 -pthread BenchmarkMain.cpp Benchmark.cpp
+//     BenchmarkHeadless.cpp BenchmarkAllocators.cpp BenchmarkHandles.cpp
+//     BenchmarkEntities.cpp BenchmarkJobs.cpp BenchmarkRingArena.cpp
+//     BenchmarkTransforms.cpp BenchmarkFrameTimes.cpp BenchmarkTests.cpp
+//     AllocationTracker.cpp EntitySystem.cpp FrameAllocator.cpp
+//     FrameGraph.cpp FrameTimes.cpp InputElementDescs.cpp Mesh.cpp
+//     MeshData.cpp NullRenderDevice.cpp Profiler.cpp RenderQueue.cpp
+//     RenderStats.cpp RenderThread.cpp RingArena.cpp
+//     ShaderReflectionCache.cpp Transform.cpp TransformSystem.cpp
+//     MatrixBatch.cpp JobSystem.cpp ImGui/imgui.cpp ImGui/imgui_draw.cpp
+//     ImGui/imgui_tables.cpp ImGui/imgui_widgets.cpp
+//   ./a.out --scene grid --frames 2000 --assets Assets/Models
+//   ./a.out --tests
+// --------------------------------------------------------
+#if !defined(_WIN32)
+
+#include "Benchmark.h"
+#include <stdio.h>
+
+int main(int argc, char** argv)
+{
+	// There's nothing else to run here
+	Benchmark::Options options;
+	options.Enabled = true;
+	options.Headless = true;
+	options.AssetPath = "Assets/Models/";
+
+	std::string error;
+	std::vector<std::string> arguments(argv + 1, argv + argc);
+	if (!Benchmark::ParseArguments(arguments, options, error))
+	{
+		fprintf(stderr, "%s\n\n%s", error.c_str(), Benchmark::GetUsage());
+		return 1;
+	}
+	if (options.Help)
+	{
+		printf("%s", Benchmark::GetUsage());
+		return 0;
+	}
+
+	return Benchmark::RunHeadless(options);
+}
+
+#endif
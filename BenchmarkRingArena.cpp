@@ -0,0 +1,108 @@
+#include "Benchmark.h"
+#include "RingArena.h"
+#include <stdio.h>
+#include <string.h>
+
+namespace
+{
+	// Same as ConstantUploadArena's blocks
+	constexpr uint32_t BlockAlignment = 256;
+
+	// Frames the GPU is assumed to run behind the CPU
+	constexpr uint64_t FramesInFlight = 3;
+
+	// Sizes of the game's per-frame, per-material and per-object
+	// constant buffers, uploaded in about the game's proportions
+	constexpr uint32_t PerFrameBytes = 352;
+	constexpr uint32_t PerMaterialBytes = 32;
+	constexpr uint32_t PerObjectBytes = 192;
+	constexpr uint32_t ObjectsPerMaterial = 16;
+
+	uint32_t UploadSize(uint32_t upload)
+	{
+		if (upload == 0)
+			return PerFrameBytes;
+		return upload % ObjectsPerMaterial == 0 ? PerMaterialBytes : PerObjectBytes;
+	}
+}
+
+// --------------------------------------------------------
+// Times the constant upload ring arena without a GPU
+//
+// Each frame allocates a block for every upload a frame of
+// that many objects would make, and retires the frame from
+// FramesInFlight frames ago, as the GPU's fence would:
+//  - Allocate: the arena alone
+//  - Allocate and copy: plus copying each upload into plain
+//    memory standing in for the mapped buffer, as
+//    ConstantUploadArena::Upload() does
+//
+// --objects sets the uploads per frame (100000 by default).
+// The arena is sized to just hold every frame in flight.
+// --------------------------------------------------------
+int Benchmark::RunArenaBenchmark(const Options& options)
+{
+	uint32_t count = options.Objects > 0 ? options.Objects : 100000;
+	Report report;
+
+	uint64_t frameBytes = 0;
+	for (uint32_t u = 0; u < count; u++)
+		frameBytes += RingArena::AlignUp(UploadSize(u), BlockAlignment);
+	uint64_t capacity = frameBytes * (FramesInFlight + 1);
+	if (capacity > 0xFFFFFF00ull)
+	{
+		fprintf(stderr, "%u uploads a frame need more than 4GB in flight\n", count);
+		return 1;
+	}
+
+	RingArena allocateOnly((uint32_t)capacity, BlockAlignment);
+	RingArena allocateAndCopy((uint32_t)capacity, BlockAlignment);
+	std::vector<unsigned char> mapped(allocateAndCopy.GetCapacity());
+	unsigned char upload[PerFrameBytes] = {};
+
+	for (unsigned int frame = 0; frame < options.Warmup + options.Frames; frame++)
+	{
+		bool record = frame >= options.Warmup;
+		uint64_t fence = frame + 1;
+
+		Measure(report, record, "Allocate", "Allocate allocations", [&]()
+		{
+			allocateOnly.BeginFrame(fence);
+			for (uint32_t u = 0; u < count; u++)
+				allocateOnly.Allocate(UploadSize(u));
+			allocateOnly.EndFrame();
+			if (fence > FramesInFlight)
+				allocateOnly.Retire(fence - FramesInFlight);
+		});
+
+		Measure(report, record, "Allocate and copy", "Allocate and copy allocations", [&]()
+		{
+			allocateAndCopy.BeginFrame(fence);
+			for (uint32_t u = 0; u < count; u++)
+			{
+				upload[0] = (unsigned char)u;
+				uint32_t size = UploadSize(u);
+				uint32_t offset = allocateAndCopy.Allocate(size);
+				if (offset != RingArena::InvalidOffset)
+					memcpy(&mapped[offset], upload, size);
+			}
+			allocateAndCopy.EndFrame();
+			if (fence > FramesInFlight)
+				allocateAndCopy.Retire(fence - FramesInFlight);
+		});
+	}
+
+	uint64_t failed = allocateOnly.GetFailedAllocationCount() + allocateAndCopy.GetFailedAllocationCount();
+	printf("Arena: %u bytes, %llu allocations, %llu failed, %llu bytes lost to wrapping\n",
+		allocateOnly.GetCapacity(), (unsigned long long)allocateOnly.GetAllocationCount(),
+		(unsigned long long)failed, (unsigned long long)allocateOnly.GetWastedBytes());
+	if (failed > 0)
+		fprintf(stderr, "Some allocations failed, though every frame in flight should fit\n");
+
+	bool written = report.WriteJson(options.ReportPath.c_str(), options, "arena", count, 1);
+	if (written)
+		printf("Wrote %s\n", options.ReportPath.c_str());
+	else
+		fprintf(stderr, "Couldn't write %s\n", options.ReportPath.c_str());
+	return written && failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,1184 @@
+#include "Benchmark.h"
+#include "DrawSubmission.h"
+#include "EntitySystem.h"
+#include "FrameGraph.h"
+#include "FrameTimes.h"
+#include "InputElementDescs.h"
+#include "JobSystem.h"
+#include "NullRenderDevice.h"
+#include "ResourcePool.h"
+#include "RingArena.h"
+#include "ShaderReflectionCache.h"
+#include "TransformSystem.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <math.h>
+#include <memory>
+#include <random>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+// Counts a failed check and says where it was, without stopping
+// the test, so one run shows everything that's wrong
+#define TEST_CHECK(condition) Check((condition), #condition, __FILE__, __LINE__)
+
+namespace
+{
+	// Failed checks in the test running now
+	unsigned int failedChecks = 0;
+
+	void Check(bool passed, const char* condition, const char* file, int line)
+	{
+		if (passed)
+			return;
+		fprintf(stderr, "  %s(%d): %s\n", file, line, condition);
+		failedChecks++;
+	}
+
+	// Job system tests run with each of these - more threads than
+	// cores is fine, and races even more
+	const unsigned int jobWorkerCounts[] = { 1, 3, 7 };
+
+	// Longest a test waits on jobs that should already be done,
+	// so a lost job fails the test instead of hanging the run
+	constexpr double JobTimeoutMilliseconds = 5000;
+
+	template<typename Body>
+	void WithWorkers(const Body& body)
+	{
+		for (unsigned int workers : jobWorkerCounts)
+		{
+			JobSystem::Initialize(workers);
+			body();
+			JobSystem::ShutDown();
+		}
+	}
+
+	// Like JobSystem::Wait(), but gives up after a while
+	bool WaitAtMost(JobSystem::Counter* counter, double milliseconds)
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		while (counter->Pending.load(std::memory_order_acquire) > 0)
+		{
+			if (Benchmark::MillisecondsSince(start) > milliseconds)
+				return false;
+			if (!JobSystem::TryRunJob())
+				std::this_thread::yield();
+		}
+		return true;
+	}
+
+	// --------------------------------------------------------
+	// Job system
+	// --------------------------------------------------------
+	void ParallelForRunsEveryIndexOnce()
+	{
+		const uint32_t counts[] = { 1, 7, 1000, 100000 };
+		const uint32_t batches[] = { 1, 64 };
+		WithWorkers([&]()
+		{
+			for (uint32_t count : counts)
+			{
+				for (uint32_t minBatch : batches)
+				{
+					std::unique_ptr<std::atomic<uint32_t>[]> runs(new std::atomic<uint32_t>[count]());
+					JobSystem::ParallelFor(count, minBatch, [&](uint32_t begin, uint32_t end)
+					{
+						for (uint32_t i = begin; i < end; i++)
+							runs[i].fetch_add(1, std::memory_order_relaxed);
+					});
+
+					uint32_t wrong = 0;
+					for (uint32_t i = 0; i < count; i++)
+						wrong += runs[i].load() != 1;
+					TEST_CHECK(wrong == 0);
+				}
+			}
+		});
+	}
+
+	// Every inner loop has to be done by the time its ParallelFor
+	// returns, since its body lives on the outer loop's stack
+	void NestedParallelForFinishesBeforeReturning()
+	{
+		const uint32_t repeats = 200;
+		const uint32_t outer = 1000;
+		const uint32_t inner = 100;
+		WithWorkers([&]()
+		{
+			std::atomic<uint64_t> total{ 0 };
+			std::atomic<uint32_t> unfinished{ 0 };
+			for (uint32_t r = 0; r < repeats; r++)
+			{
+				JobSystem::ParallelFor(outer, 1, [&](uint32_t begin, uint32_t end)
+				{
+					for (uint32_t i = begin; i < end; i++)
+					{
+						std::atomic<uint32_t> done{ 0 };
+						JobSystem::ParallelFor(inner, 1, [&](uint32_t innerBegin, uint32_t innerEnd)
+						{
+							done.fetch_add(innerEnd - innerBegin, std::memory_order_relaxed);
+						});
+						if (done.load() != inner)
+							unfinished.fetch_add(1);
+						total.fetch_add(done.load(), std::memory_order_relaxed);
+					}
+				});
+			}
+			TEST_CHECK(unfinished.load() == 0);
+			TEST_CHECK(total.load() == (uint64_t)repeats * outer * inner);
+		});
+	}
+
+	// The owner takes its newest job first, so an old one can stay
+	// queued while far more jobs than the pool has slots come and
+	// go below it - and must still run, once
+	void OldJobOutlivesNewerOnes()
+	{
+		const uint32_t newerJobs = 10000;
+		WithWorkers([&]()
+		{
+			// Keeps one worker busy (if one steals it) so it can't
+			// steal the old job either
+			std::atomic<bool> release{ false };
+			JobSystem::Counter blockerDone;
+			JobSystem::Run([](void* data, uint32_t, uint32_t)
+			{
+				while (!((std::atomic<bool>*)data)->load())
+					std::this_thread::yield();
+			}, &release, &blockerDone);
+
+			std::atomic<uint32_t> oldRuns{ 0 };
+			JobSystem::Counter oldDone;
+			JobSystem::Run([](void* data, uint32_t, uint32_t)
+			{
+				((std::atomic<uint32_t>*)data)->fetch_add(1);
+			}, &oldRuns, &oldDone);
+
+			std::atomic<uint32_t> newerRuns{ 0 };
+			for (uint32_t j = 0; j < newerJobs; j++)
+			{
+				JobSystem::Counter newerDone;
+				JobSystem::Run([](void* data, uint32_t, uint32_t)
+				{
+					((std::atomic<uint32_t>*)data)->fetch_add(1);
+				}, &newerRuns, &newerDone);
+				JobSystem::Wait(&newerDone);
+			}
+
+			release.store(true);
+			TEST_CHECK(WaitAtMost(&oldDone, JobTimeoutMilliseconds));
+			TEST_CHECK(WaitAtMost(&blockerDone, JobTimeoutMilliseconds));
+			TEST_CHECK(oldRuns.load() == 1);
+			TEST_CHECK(newerRuns.load() == newerJobs);
+		});
+	}
+
+	// Each job forks two more and waits for them, down to a depth
+	struct ForkData
+	{
+		std::atomic<uint32_t>* Leaves;
+		uint32_t Depth;
+	};
+
+	void ForkJob(void* data, uint32_t, uint32_t)
+	{
+		ForkData& fork = *(ForkData*)data;
+		if (fork.Depth == 0)
+		{
+			fork.Leaves->fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		ForkData children[2] = { { fork.Leaves, fork.Depth - 1 }, { fork.Leaves, fork.Depth - 1 } };
+		JobSystem::Counter counter;
+		JobSystem::Run(ForkJob, &children[0], &counter);
+		JobSystem::Run(ForkJob, &children[1], &counter);
+		JobSystem::Wait(&counter);
+	}
+
+	void ForkJoinWaitsForEveryJob()
+	{
+		const uint32_t depth = 12;
+		WithWorkers([&]()
+		{
+			std::atomic<uint32_t> leaves{ 0 };
+			ForkData root = { &leaves, depth };
+			JobSystem::Counter counter;
+			JobSystem::Run(ForkJob, &root, &counter);
+			JobSystem::Wait(&counter);
+			TEST_CHECK(leaves.load() == 1u << depth);
+			TEST_CHECK(counter.Pending.load() == 0);
+		});
+	}
+
+	// More jobs at once than a deque holds - the rest run inline
+	void FullDequeRunsJobsInline()
+	{
+		const uint32_t jobs = 5000;
+		WithWorkers([&]()
+		{
+			std::unique_ptr<std::atomic<uint32_t>[]> runs(new std::atomic<uint32_t>[jobs]());
+			JobSystem::Counter counter;
+			for (uint32_t j = 0; j < jobs; j++)
+			{
+				JobSystem::Run([](void* data, uint32_t begin, uint32_t)
+				{
+					((std::atomic<uint32_t>*)data)[begin].fetch_add(1, std::memory_order_relaxed);
+				}, runs.get(), &counter, j, j + 1);
+			}
+			JobSystem::Wait(&counter);
+
+			uint32_t wrong = 0;
+			for (uint32_t j = 0; j < jobs; j++)
+				wrong += runs[j].load() != 1;
+			TEST_CHECK(wrong == 0);
+		});
+	}
+
+	// --------------------------------------------------------
+	// RingArena
+	// --------------------------------------------------------
+	void RingArenaAlignsEveryBlock()
+	{
+		RingArena arena(4096, 256);
+		TEST_CHECK(arena.GetAlignment() == 256);
+		TEST_CHECK(RingArena::AlignUp(1, 256) == 256);
+		TEST_CHECK(RingArena::AlignUp(256, 256) == 256);
+		TEST_CHECK(RingArena::AlignUp(257, 256) == 512);
+
+		arena.BeginFrame(1);
+		TEST_CHECK(arena.Allocate(20) == 0);
+		TEST_CHECK(arena.Allocate(300) == 256);
+		TEST_CHECK(arena.Allocate(0) == 768);
+		TEST_CHECK(arena.GetBytesInUse() == 1024);
+
+		// Not a power of two, so blocks are only byte aligned
+		RingArena unaligned(1000, 48);
+		TEST_CHECK(unaligned.GetAlignment() == 1);
+		TEST_CHECK(unaligned.GetCapacity() == 1000);
+
+		// Capacity is rounded down to the alignment
+		RingArena rounded(1000, 256);
+		TEST_CHECK(rounded.GetCapacity() == 768);
+	}
+
+	void RingArenaFailsWhenFull()
+	{
+		RingArena arena(1024, 256);
+		arena.BeginFrame(1);
+		for (int i = 0; i < 4; i++)
+			TEST_CHECK(arena.Allocate(256) == (uint32_t)i * 256);
+		TEST_CHECK(arena.Allocate(1) == RingArena::InvalidOffset);
+		TEST_CHECK(arena.Allocate(2048) == RingArena::InvalidOffset);
+		TEST_CHECK(arena.GetFailedAllocationCount() == 2);
+		TEST_CHECK(arena.GetAllocationCount() == 4);
+	}
+
+	// A frame's blocks stay in use until its fence is retired
+	void RingArenaReclaimsRetiredFrames()
+	{
+		RingArena arena(1024, 256);
+		arena.BeginFrame(1);
+		arena.Allocate(512);
+		arena.EndFrame();
+		arena.BeginFrame(2);
+		arena.Allocate(512);
+		arena.EndFrame();
+		TEST_CHECK(arena.GetFramesInFlight() == 2);
+		TEST_CHECK(arena.GetOldestFenceInFlight() == 1);
+
+		arena.BeginFrame(3);
+		TEST_CHECK(arena.Allocate(256) == RingArena::InvalidOffset);
+
+		arena.Retire(1);
+		TEST_CHECK(arena.GetBytesInUse() == 512);
+		TEST_CHECK(arena.GetOldestFenceInFlight() == 2);
+		TEST_CHECK(arena.Allocate(256) == 0);
+		arena.EndFrame();
+
+		arena.Retire(3);
+		TEST_CHECK(arena.GetBytesInUse() == 0);
+		TEST_CHECK(arena.GetFramesInFlight() == 0);
+		TEST_CHECK(arena.GetOldestFenceInFlight() == 0);
+	}
+
+	// A block that doesn't fit before the end starts over at 0,
+	// and the skipped tail comes back with the frame
+	void RingArenaWrapsAround()
+	{
+		RingArena arena(1024, 256);
+		arena.BeginFrame(1);
+		arena.Allocate(768);
+		arena.EndFrame();
+		arena.Retire(1);
+
+		arena.BeginFrame(2);
+		TEST_CHECK(arena.Allocate(512) == 0);
+		TEST_CHECK(arena.GetWastedBytes() == 256);
+		TEST_CHECK(arena.GetBytesInUse() == 768);
+		TEST_CHECK(arena.Allocate(256) == 512);
+		TEST_CHECK(arena.Allocate(256) == RingArena::InvalidOffset);
+		arena.EndFrame();
+
+		arena.Retire(2);
+		TEST_CHECK(arena.GetBytesInUse() == 0);
+	}
+
+	// What's allocated between frames goes with the next one,
+	// rather than holding its bytes forever
+	void RingArenaReleasesBlocksBetweenFrames()
+	{
+		RingArena arena(1024, 256);
+		for (uint64_t fence = 1; fence <= 100; fence++)
+		{
+			TEST_CHECK(arena.Allocate(256) != RingArena::InvalidOffset);
+			arena.BeginFrame(fence);
+			TEST_CHECK(arena.Allocate(256) != RingArena::InvalidOffset);
+			arena.EndFrame();
+			arena.Retire(fence);
+			TEST_CHECK(arena.GetBytesInUse() == 0);
+		}
+	}
+
+	// --------------------------------------------------------
+	// Many frames of random allocations, retired a random number
+	// of frames late as a GPU would, checked against a model
+	// that knows which frame owns every 256-byte unit:
+	//  - No block overlaps one still in use
+	//  - Bytes in use never fall below what the model holds
+	//  - Everything comes back once every frame is retired
+	// --------------------------------------------------------
+	void RingArenaRandomFrames()
+	{
+		const uint32_t unit = 256;
+		const uint32_t units = 64;
+		const uint64_t frames = 100000;
+		RingArena arena(units * unit, unit);
+
+		// Fence of the frame holding each unit, 0 if free
+		std::vector<uint64_t> owner(units, 0);
+		std::mt19937 random(1234);
+		uint64_t completed = 0;
+		uint32_t overlaps = 0;
+		uint32_t undercounts = 0;
+
+		// Blocks made between frames belong to the next one
+		auto allocate = [&](uint64_t fence)
+		{
+			uint32_t size = 1 + random() % (unit * 6);
+			uint32_t offset = arena.Allocate(size);
+			if (offset == RingArena::InvalidOffset)
+				return;
+
+			for (uint32_t u = offset / unit; u < (offset + RingArena::AlignUp(size, unit)) / unit; u++)
+			{
+				overlaps += owner[u] != 0;
+				owner[u] = fence;
+			}
+		};
+
+		for (uint64_t fence = 1; fence <= frames; fence++)
+		{
+			if (random() % 4 == 0)
+				allocate(fence);
+
+			arena.BeginFrame(fence);
+			uint32_t blocks = random() % 8;
+			for (uint32_t b = 0; b < blocks; b++)
+				allocate(fence);
+			arena.EndFrame();
+
+			// The GPU is up to three frames behind
+			uint64_t lag = random() % 4;
+			if (fence > lag && fence - lag > completed)
+			{
+				completed = fence - lag;
+				arena.Retire(completed);
+				for (uint64_t& o : owner)
+					if (o != 0 && o <= completed)
+						o = 0;
+			}
+
+			uint32_t held = 0;
+			for (uint64_t o : owner)
+				held += o != 0 ? unit : 0;
+			undercounts += arena.GetBytesInUse() < held;
+		}
+
+		arena.Retire(frames);
+		TEST_CHECK(overlaps == 0);
+		TEST_CHECK(undercounts == 0);
+		TEST_CHECK(arena.GetBytesInUse() == 0);
+		TEST_CHECK(arena.GetFramesInFlight() == 0);
+		TEST_CHECK(arena.GetAllocationCount() > frames);
+	}
+
+	// --------------------------------------------------------
+	// ShaderReflectionCache
+	// --------------------------------------------------------
+	ShaderReflectionData MakeReflection()
+	{
+		ShaderReflectionData data;
+		ReflectedConstantBuffer perFrame;
+		perFrame.Name = "perFrame";
+		perFrame.Size = 352;
+		perFrame.Variables = { { "view", 0, 64 }, { "projection", 64, 64 }, { "lights", 128, 224 } };
+		ReflectedConstantBuffer perObject;
+		perObject.Name = "perObject";
+		perObject.Type = 1;
+		perObject.Size = 192;
+		perObject.BindIndex = 2;
+		perObject.Variables = { { "world", 0, 64 }, { "worldInverseTranspose", 64, 64 }, { "", 128, 4 } };
+		data.ConstantBuffers = { perFrame, perObject };
+		data.ShaderResourceViews = { { "albedo", 0 }, { "normalMap", 3 } };
+		data.Samplers = { { "basicSampler", 1 } };
+		data.InputParameters = { { "POSITION", 0, 7, 3 }, { "TEXCOORD", 1, 3, 3 }, { "BLENDINDICES", 0, 15, 1 } };
+		return data;
+	}
+
+	bool SameReflection(const ShaderReflectionData& a, const ShaderReflectionData& b)
+	{
+		auto sameResources = [](const std::vector<ReflectedResource>& x, const std::vector<ReflectedResource>& y)
+		{
+			if (x.size() != y.size())
+				return false;
+			for (size_t i = 0; i < x.size(); i++)
+				if (x[i].Name != y[i].Name || x[i].BindIndex != y[i].BindIndex)
+					return false;
+			return true;
+		};
+
+		if (a.ConstantBuffers.size() != b.ConstantBuffers.size() ||
+			a.InputParameters.size() != b.InputParameters.size() ||
+			!sameResources(a.ShaderResourceViews, b.ShaderResourceViews) ||
+			!sameResources(a.Samplers, b.Samplers))
+			return false;
+
+		for (size_t c = 0; c < a.ConstantBuffers.size(); c++)
+		{
+			const ReflectedConstantBuffer& x = a.ConstantBuffers[c];
+			const ReflectedConstantBuffer& y = b.ConstantBuffers[c];
+			if (x.Name != y.Name || x.Type != y.Type || x.Size != y.Size ||
+				x.BindIndex != y.BindIndex || x.Variables.size() != y.Variables.size())
+				return false;
+			for (size_t v = 0; v < x.Variables.size(); v++)
+				if (x.Variables[v].Name != y.Variables[v].Name ||
+					x.Variables[v].ByteOffset != y.Variables[v].ByteOffset ||
+					x.Variables[v].Size != y.Variables[v].Size)
+					return false;
+		}
+
+		for (size_t i = 0; i < a.InputParameters.size(); i++)
+		{
+			const ReflectedInputParameter& x = a.InputParameters[i];
+			const ReflectedInputParameter& y = b.InputParameters[i];
+			if (x.SemanticName != y.SemanticName || x.SemanticIndex != y.SemanticIndex ||
+				x.Mask != y.Mask || x.ComponentType != y.ComponentType)
+				return false;
+		}
+		return true;
+	}
+
+	void ReflectionRoundTrips()
+	{
+		const uint64_t hash = 0x0123456789ABCDEFull;
+		ShaderReflectionData data = MakeReflection();
+		std::vector<unsigned char> bytes;
+		ShaderReflectionCache::Serialize(data, hash, bytes);
+
+		ShaderReflectionData loaded;
+		TEST_CHECK(ShaderReflectionCache::Deserialize(bytes.data(), bytes.size(), hash, loaded));
+		TEST_CHECK(SameReflection(data, loaded));
+
+		// Nothing at all is still a valid shader
+		ShaderReflectionData empty;
+		std::vector<unsigned char> emptyBytes;
+		ShaderReflectionCache::Serialize(empty, hash, emptyBytes);
+		TEST_CHECK(ShaderReflectionCache::Deserialize(emptyBytes.data(), emptyBytes.size(), hash, loaded));
+		TEST_CHECK(SameReflection(empty, loaded));
+	}
+
+	void ReflectionRejectsTruncatedData()
+	{
+		const uint64_t hash = 42;
+		ShaderReflectionData data = MakeReflection();
+		std::vector<unsigned char> bytes;
+		ShaderReflectionCache::Serialize(data, hash, bytes);
+
+		// Every shorter prefix fails, and leaves the output alone
+		unsigned int accepted = 0;
+		unsigned int changed = 0;
+		for (size_t size = 0; size < bytes.size(); size++)
+		{
+			ShaderReflectionData loaded = data;
+			accepted += ShaderReflectionCache::Deserialize(bytes.data(), size, hash, loaded);
+			changed += !SameReflection(data, loaded);
+		}
+		TEST_CHECK(accepted == 0);
+		TEST_CHECK(changed == 0);
+	}
+
+	void ReflectionRejectsWrongHash()
+	{
+		ShaderReflectionData data = MakeReflection();
+		std::vector<unsigned char> bytes;
+		ShaderReflectionCache::Serialize(data, 1, bytes);
+
+		ShaderReflectionData loaded;
+		TEST_CHECK(!ShaderReflectionCache::Deserialize(bytes.data(), bytes.size(), 2, loaded));
+		TEST_CHECK(loaded.ConstantBuffers.empty());
+
+		// As does a different version, or something else entirely
+		std::vector<unsigned char> otherVersion = bytes;
+		otherVersion[4]++;
+		TEST_CHECK(!ShaderReflectionCache::Deserialize(otherVersion.data(), otherVersion.size(), 1, loaded));
+		std::vector<unsigned char> otherMagic = bytes;
+		otherMagic[0]++;
+		TEST_CHECK(!ShaderReflectionCache::Deserialize(otherMagic.data(), otherMagic.size(), 1, loaded));
+
+		TEST_CHECK(ShaderReflectionCache::HashBytecode(bytes.data(), bytes.size()) ==
+			ShaderReflectionCache::HashBytecode(bytes.data(), bytes.size()));
+		TEST_CHECK(ShaderReflectionCache::HashBytecode(bytes.data(), bytes.size()) !=
+			ShaderReflectionCache::HashBytecode(otherVersion.data(), otherVersion.size()));
+	}
+
+	void ReflectionRejectsTrailingBytes()
+	{
+		ShaderReflectionData data = MakeReflection();
+		std::vector<unsigned char> bytes;
+		ShaderReflectionCache::Serialize(data, 7, bytes);
+
+		ShaderReflectionData loaded;
+		for (size_t extra = 1; extra <= 16; extra++)
+		{
+			std::vector<unsigned char> padded = bytes;
+			padded.resize(bytes.size() + extra, 0);
+			TEST_CHECK(!ShaderReflectionCache::Deserialize(padded.data(), padded.size(), 7, loaded));
+		}
+
+		// A count far past the end fails before anything is made for it
+		std::vector<unsigned char> huge = bytes;
+		huge[16] = huge[17] = huge[18] = huge[19] = 0xFF;
+		TEST_CHECK(!ShaderReflectionCache::Deserialize(huge.data(), huge.size(), 7, loaded));
+		TEST_CHECK(loaded.ConstantBuffers.empty());
+	}
+
+	void ReflectionSidecarRoundTrips()
+	{
+		std::filesystem::path shader = std::filesystem::temp_directory_path() / "BenchmarkTests.cso";
+		std::filesystem::path sidecar = ShaderReflectionCache::SidecarPath(shader);
+		TEST_CHECK(sidecar.filename() == "BenchmarkTests.cso.refl");
+
+		ShaderReflectionData data = MakeReflection();
+		ShaderReflectionData loaded;
+		TEST_CHECK(ShaderReflectionCache::Save(sidecar, 99, data));
+		TEST_CHECK(ShaderReflectionCache::Load(sidecar, 99, loaded));
+		TEST_CHECK(SameReflection(data, loaded));
+		TEST_CHECK(!ShaderReflectionCache::Load(sidecar, 100, loaded));
+
+		std::error_code error;
+		std::filesystem::remove(sidecar, error);
+		TEST_CHECK(!ShaderReflectionCache::Load(sidecar, 99, loaded));
+	}
+
+	// --------------------------------------------------------
+	// InputLayoutCache
+	// --------------------------------------------------------
+	void InputElementFormatsFollowMaskAndType()
+	{
+		struct Case
+		{
+			uint32_t Mask;
+			uint32_t ComponentType;
+			DXGI_FORMAT Format;
+		};
+		const Case cases[] =
+		{
+			{ 1, D3D_REGISTER_COMPONENT_UINT32, DXGI_FORMAT_R32_UINT },
+			{ 1, D3D_REGISTER_COMPONENT_SINT32, DXGI_FORMAT_R32_SINT },
+			{ 1, D3D_REGISTER_COMPONENT_FLOAT32, DXGI_FORMAT_R32_FLOAT },
+			{ 3, D3D_REGISTER_COMPONENT_UINT32, DXGI_FORMAT_R32G32_UINT },
+			{ 3, D3D_REGISTER_COMPONENT_SINT32, DXGI_FORMAT_R32G32_SINT },
+			{ 3, D3D_REGISTER_COMPONENT_FLOAT32, DXGI_FORMAT_R32G32_FLOAT },
+			{ 7, D3D_REGISTER_COMPONENT_UINT32, DXGI_FORMAT_R32G32B32_UINT },
+			{ 7, D3D_REGISTER_COMPONENT_SINT32, DXGI_FORMAT_R32G32B32_SINT },
+			{ 7, D3D_REGISTER_COMPONENT_FLOAT32, DXGI_FORMAT_R32G32B32_FLOAT },
+			{ 15, D3D_REGISTER_COMPONENT_UINT32, DXGI_FORMAT_R32G32B32A32_UINT },
+			{ 15, D3D_REGISTER_COMPONENT_SINT32, DXGI_FORMAT_R32G32B32A32_SINT },
+			{ 15, D3D_REGISTER_COMPONENT_FLOAT32, DXGI_FORMAT_R32G32B32A32_FLOAT },
+
+			// The highest component used decides the width
+			{ 2, D3D_REGISTER_COMPONENT_FLOAT32, DXGI_FORMAT_R32G32_FLOAT },
+			{ 4, D3D_REGISTER_COMPONENT_FLOAT32, DXGI_FORMAT_R32G32B32_FLOAT },
+			{ 8, D3D_REGISTER_COMPONENT_UINT32, DXGI_FORMAT_R32G32B32A32_UINT },
+			{ 1, D3D_REGISTER_COMPONENT_UNKNOWN, DXGI_FORMAT_UNKNOWN },
+		};
+
+		std::vector<ReflectedInputParameter> signature;
+		for (const Case& c : cases)
+			signature.push_back({ "TEXCOORD", (uint32_t)signature.size(), c.Mask, c.ComponentType });
+
+		bool perInstance = false;
+		std::vector<D3D11_INPUT_ELEMENT_DESC> descs = InputLayoutCache::BuildInputElementDescs(signature, &perInstance);
+		TEST_CHECK(descs.size() == signature.size());
+		TEST_CHECK(!perInstance);
+
+		unsigned int wrong = 0;
+		for (size_t i = 0; i < descs.size() && i < signature.size(); i++)
+		{
+			wrong += descs[i].Format != cases[i].Format;
+			wrong += descs[i].SemanticName != signature[i].SemanticName.c_str();
+			wrong += descs[i].SemanticIndex != signature[i].SemanticIndex;
+			wrong += descs[i].AlignedByteOffset != D3D11_APPEND_ALIGNED_ELEMENT;
+		}
+		TEST_CHECK(wrong == 0);
+	}
+
+	void InputElementsPerInstanceBySemantic()
+	{
+		std::vector<ReflectedInputParameter> signature =
+		{
+			{ "POSITION", 0, 7, D3D_REGISTER_COMPONENT_FLOAT32 },
+			{ "WORLD_PER_INSTANCE", 2, 15, D3D_REGISTER_COMPONENT_FLOAT32 },
+			{ "_PER_INSTANCE", 0, 1, D3D_REGISTER_COMPONENT_UINT32 },
+			{ "PER_INSTANCE", 0, 1, D3D_REGISTER_COMPONENT_UINT32 },
+			{ "COLOR_PER_INSTANCE_", 0, 15, D3D_REGISTER_COMPONENT_FLOAT32 },
+			{ "color_per_instance", 0, 15, D3D_REGISTER_COMPONENT_FLOAT32 },
+		};
+		const bool expected[] = { false, true, true, false, false, false };
+
+		bool perInstance = false;
+		std::vector<D3D11_INPUT_ELEMENT_DESC> descs = InputLayoutCache::BuildInputElementDescs(signature, &perInstance);
+		TEST_CHECK(descs.size() == signature.size());
+		TEST_CHECK(perInstance);
+
+		unsigned int wrong = 0;
+		for (size_t i = 0; i < descs.size() && i < signature.size(); i++)
+		{
+			wrong += descs[i].InputSlot != (expected[i] ? 1u : 0u);
+			wrong += descs[i].InputSlotClass != (expected[i] ? D3D11_INPUT_PER_INSTANCE_DATA : D3D11_INPUT_PER_VERTEX_DATA);
+			wrong += descs[i].InstanceDataStepRate != (expected[i] ? 1u : 0u);
+		}
+		TEST_CHECK(wrong == 0);
+
+		// Only per-vertex elements leave the flag alone, and it's optional
+		perInstance = false;
+		signature.erase(signature.begin() + 1, signature.begin() + 3);
+		InputLayoutCache::BuildInputElementDescs(signature, &perInstance);
+		TEST_CHECK(!perInstance);
+		TEST_CHECK(InputLayoutCache::BuildInputElementDescs(signature, 0).size() == signature.size());
+	}
+
+	void InputElementHashesByValue()
+	{
+		std::vector<ReflectedInputParameter> signature =
+		{
+			{ "POSITION", 0, 7, D3D_REGISTER_COMPONENT_FLOAT32 },
+			{ "NORMAL", 0, 7, D3D_REGISTER_COMPONENT_FLOAT32 },
+			{ "TEXCOORD", 0, 3, D3D_REGISTER_COMPONENT_FLOAT32 },
+		};
+		std::vector<ReflectedInputParameter> copy = signature;
+		std::vector<D3D11_INPUT_ELEMENT_DESC> a = InputLayoutCache::BuildInputElementDescs(signature, 0);
+		std::vector<D3D11_INPUT_ELEMENT_DESC> b = InputLayoutCache::BuildInputElementDescs(copy, 0);
+
+		// Same names at different addresses hash the same
+		TEST_CHECK(a[0].SemanticName != b[0].SemanticName);
+		TEST_CHECK(InputLayoutCache::HashInputElementDescs(a) == InputLayoutCache::HashInputElementDescs(b));
+
+		char name[] = "NORMAL";
+		b[1].SemanticName = name;
+		TEST_CHECK(InputLayoutCache::HashInputElementDescs(a) == InputLayoutCache::HashInputElementDescs(b));
+
+		// Any other difference changes the hash
+		uint64_t hash = InputLayoutCache::HashInputElementDescs(a);
+		name[0] = 'M';
+		TEST_CHECK(InputLayoutCache::HashInputElementDescs(b) != hash);
+		name[0] = 'N';
+
+		std::vector<D3D11_INPUT_ELEMENT_DESC> changed = b;
+		changed[2].SemanticIndex = 1;
+		TEST_CHECK(InputLayoutCache::HashInputElementDescs(changed) != hash);
+		changed = b;
+		changed[2].Format = DXGI_FORMAT_R32G32_UINT;
+		TEST_CHECK(InputLayoutCache::HashInputElementDescs(changed) != hash);
+		changed = b;
+		changed[1].InputSlot = 1;
+		TEST_CHECK(InputLayoutCache::HashInputElementDescs(changed) != hash);
+		changed = b;
+		changed.pop_back();
+		TEST_CHECK(InputLayoutCache::HashInputElementDescs(changed) != hash);
+		std::swap(changed[0], changed[1]);
+		TEST_CHECK(InputLayoutCache::HashInputElementDescs(changed) != InputLayoutCache::HashInputElementDescs(b));
+	}
+
+	// --------------------------------------------------------
+	// FrameGraph
+	// --------------------------------------------------------
+	void NoWork(void*)
+	{
+	}
+
+	void CountRun(void* data)
+	{
+		(*(unsigned int*)data)++;
+	}
+
+	// Spins rather than sleeps, so the time is the task's own
+	void BusyWork(void* data)
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		while (Benchmark::MillisecondsSince(start) < *(double*)data)
+		{
+		}
+	}
+
+	bool DependsOn(const FrameGraph& graph, FrameGraph::TaskId task, FrameGraph::TaskId dependency)
+	{
+		const std::vector<FrameGraph::TaskId>& dependencies = graph.GetDependencies(task);
+		return std::find(dependencies.begin(), dependencies.end(), dependency) != dependencies.end();
+	}
+
+	void FrameGraphOrdersReadsAfterWrites()
+	{
+		FrameGraph graph;
+		FrameGraph::TaskId write = graph.AddTask("Write", NoWork, 0, {}, { "State" });
+		FrameGraph::TaskId read = graph.AddTask("Read", NoWork, 0, { "State" }, {});
+		FrameGraph::TaskId other = graph.AddTask("Other", NoWork, 0, { "Other state" }, {});
+		FrameGraph::TaskId rewrite = graph.AddTask("Rewrite", NoWork, 0, {}, { "State" });
+		TEST_CHECK(graph.Compile());
+
+		TEST_CHECK(DependsOn(graph, read, write));
+		TEST_CHECK(graph.GetDependencies(write).empty());
+		TEST_CHECK(graph.GetDependencies(other).empty());
+
+		// A later writer waits for the readers before it, too
+		TEST_CHECK(DependsOn(graph, rewrite, read) && DependsOn(graph, rewrite, write));
+		TEST_CHECK(!DependsOn(graph, rewrite, other));
+	}
+
+	void FrameGraphRejectsRunAfterLoops()
+	{
+		unsigned int runs = 0;
+		FrameGraph graph;
+		FrameGraph::TaskId first = graph.AddTask("First", CountRun, &runs, {}, {});
+		FrameGraph::TaskId second = graph.AddTask("Second", CountRun, &runs, {}, {});
+		FrameGraph::TaskId third = graph.AddTask("Third", CountRun, &runs, {}, {});
+		graph.RunAfter(second, first);
+		graph.RunAfter(third, second);
+		TEST_CHECK(graph.Compile());
+		TEST_CHECK(graph.GetError().empty());
+
+		graph.RunAfter(first, third);
+		TEST_CHECK(!graph.Compile());
+		TEST_CHECK(graph.GetError() == "Frame graph cycle: First waits on Third waits on Second waits on First");
+
+		// Nothing runs from a graph that didn't compile
+		graph.Execute();
+		TEST_CHECK(runs == 0);
+	}
+
+	void FrameGraphCriticalPathTakesLongerBranch()
+	{
+		// Start -> Long -> End and Start -> Short -> End
+		double longMilliseconds = 5.0;
+		FrameGraph graph;
+		FrameGraph::TaskId start = graph.AddTask("Start", NoWork, 0, {}, { "A", "B" });
+		FrameGraph::TaskId shorter = graph.AddTask("Short", NoWork, 0, { "A" }, { "C" });
+		FrameGraph::TaskId longer = graph.AddTask("Long", BusyWork, &longMilliseconds, { "B" }, { "D" });
+		FrameGraph::TaskId end = graph.AddTask("End", NoWork, 0, { "C", "D" }, {});
+		TEST_CHECK(graph.Compile());
+		TEST_CHECK(DependsOn(graph, end, shorter) && DependsOn(graph, end, longer));
+
+		// With the job system shut down, every task runs on this thread
+		graph.Execute();
+		FrameGraph::Stats stats = graph.GetStats();
+		TEST_CHECK(stats.Tasks == 4);
+		TEST_CHECK(stats.CriticalPathTasks == 3);
+		TEST_CHECK(graph.IsCritical(start) && graph.IsCritical(longer) && graph.IsCritical(end));
+		TEST_CHECK(!graph.IsCritical(shorter));
+		TEST_CHECK(graph.GetTaskMilliseconds(longer) >= longMilliseconds);
+	}
+
+	// --------------------------------------------------------
+	// FrameTimes
+	// --------------------------------------------------------
+	void FrameTimesFindsSpikes()
+	{
+		float budget = FrameTimes::GetBudget();
+		FrameTimes::Reset();
+		FrameTimes::SetBudget(20.0f);
+
+		// 1000 frames: 10 ms, but 40 ms every 50th, so 2% are spikes
+		for (unsigned int f = 0; f < 1000; f++)
+			FrameTimes::Record(f % 50 == 49 ? 40.0f : 10.0f);
+
+		FrameTimes::Stats stats = FrameTimes::GetStats();
+		TEST_CHECK(stats.Frames == 1000 && stats.TotalFrames == 1000);
+		TEST_CHECK(stats.P50Milliseconds == 10.0f);
+		TEST_CHECK(stats.P95Milliseconds == 10.0f);
+		TEST_CHECK(stats.P99Milliseconds == 40.0f);
+		TEST_CHECK(stats.MaxMilliseconds == 40.0f);
+		TEST_CHECK(fabsf(stats.AverageMilliseconds - 10.6f) < 1e-4f);
+		TEST_CHECK(stats.OverBudget == 20 && stats.OverBudgetTotal == 20);
+
+		// Half as many spikes drops them below p99 but not the max
+		FrameTimes::Reset();
+		for (unsigned int f = 0; f < 1000; f++)
+			FrameTimes::Record(f % 100 == 99 ? 40.0f : 10.0f);
+		stats = FrameTimes::GetStats();
+		TEST_CHECK(stats.P99Milliseconds == 10.0f && stats.MaxMilliseconds == 40.0f);
+
+		// Once the ring has turned over, only the total remembers them
+		for (unsigned int f = 0; f < FrameTimes::HistoryFrames; f++)
+			FrameTimes::Record(5.0f);
+		stats = FrameTimes::GetStats();
+		TEST_CHECK(stats.Frames == FrameTimes::HistoryFrames);
+		TEST_CHECK(stats.MaxMilliseconds == 5.0f && stats.P99Milliseconds == 5.0f);
+		TEST_CHECK(stats.OverBudget == 0 && stats.OverBudgetTotal == 10);
+		TEST_CHECK(stats.TotalFrames == 1000 + FrameTimes::HistoryFrames);
+
+		// A new budget recounts the kept frames straight away
+		FrameTimes::SetBudget(4.0f);
+		TEST_CHECK(FrameTimes::GetStats().OverBudget == FrameTimes::HistoryFrames);
+
+		FrameTimes::Reset();
+		FrameTimes::SetBudget(budget);
+	}
+
+	// --------------------------------------------------------
+	// NullRenderDevice
+	// --------------------------------------------------------
+
+	// A few draws straight to a device, as SubmitDraws() asks for them
+	struct RecordedDraws
+	{
+		RenderDevice* Device;
+		const uint32_t* Materials;
+		RenderDevice::Handle MaterialBuffer;
+		RenderDevice::Handle ObjectBuffer;
+		RenderDevice::Handle VertexShader;
+		RenderDevice::Handle PixelShader;
+
+		bool SameMaterial(size_t a, size_t b) const { return Materials[a] == Materials[b]; }
+		void SetMaterial(size_t i) const { Device->UpdateBuffer(MaterialBuffer, &Materials[i], sizeof(uint32_t)); }
+
+		void SetObject(size_t i) const
+		{
+			uint32_t object = (uint32_t)i;
+			Device->UpdateBuffer(ObjectBuffer, &object, sizeof(object));
+		}
+
+		void SetShaders(size_t) const
+		{
+			Device->SetShader(RenderDevice::VertexStage, VertexShader);
+			Device->SetShader(RenderDevice::PixelStage, PixelShader);
+		}
+
+		void Draw(size_t i) const { Device->DrawIndexed(36 + (uint32_t)i, 0, 0); }
+	};
+
+	void NullDeviceRecordsSubmittedDraws()
+	{
+		NullRenderDevice device;
+		const uint32_t materials[] = { 3, 3, 5 };
+		RecordedDraws draws = { &device, materials,
+			device.CreateBuffer(RenderDevice::ConstantBuffer, 0, 16),
+			device.CreateBuffer(RenderDevice::ConstantBuffer, 0, 16),
+			device.CreateShader(RenderDevice::VertexStage, 0, 0),
+			device.CreateShader(RenderDevice::PixelStage, 0, 0) };
+		SubmitDraws(draws, 3);
+
+		// Material uploads only when the material changes
+		typedef NullRenderDevice Null;
+		struct Expected
+		{
+			Null::CommandType Type;
+			uint8_t Stage;
+			RenderDevice::Handle Resource;
+			uint32_t A;
+		};
+		const Expected expected[] =
+		{
+			{ Null::UpdateBufferCommand, 0, draws.MaterialBuffer, 4 },
+			{ Null::UpdateBufferCommand, 0, draws.ObjectBuffer, 4 },
+			{ Null::SetShaderCommand, RenderDevice::VertexStage, draws.VertexShader, 0 },
+			{ Null::SetShaderCommand, RenderDevice::PixelStage, draws.PixelShader, 0 },
+			{ Null::DrawIndexedCommand, 0, RenderDevice::NullHandle, 36 },
+			{ Null::UpdateBufferCommand, 0, draws.ObjectBuffer, 4 },
+			{ Null::SetShaderCommand, RenderDevice::VertexStage, draws.VertexShader, 0 },
+			{ Null::SetShaderCommand, RenderDevice::PixelStage, draws.PixelShader, 0 },
+			{ Null::DrawIndexedCommand, 0, RenderDevice::NullHandle, 37 },
+			{ Null::UpdateBufferCommand, 0, draws.MaterialBuffer, 4 },
+			{ Null::UpdateBufferCommand, 0, draws.ObjectBuffer, 4 },
+			{ Null::SetShaderCommand, RenderDevice::VertexStage, draws.VertexShader, 0 },
+			{ Null::SetShaderCommand, RenderDevice::PixelStage, draws.PixelShader, 0 },
+			{ Null::DrawIndexedCommand, 0, RenderDevice::NullHandle, 38 },
+		};
+		const std::vector<Null::Command>& commands = device.GetCommands();
+		TEST_CHECK(commands.size() == sizeof(expected) / sizeof(expected[0]));
+
+		unsigned int wrong = 0;
+		for (size_t i = 0; i < commands.size() && i < sizeof(expected) / sizeof(expected[0]); i++)
+		{
+			wrong += commands[i].Type != expected[i].Type;
+			wrong += commands[i].Stage != expected[i].Stage;
+			wrong += commands[i].Resource != expected[i].Resource;
+			wrong += commands[i].A != expected[i].A;
+		}
+		TEST_CHECK(wrong == 0);
+		TEST_CHECK(device.GetCount(Null::UpdateBufferCommand) == 5);
+		TEST_CHECK(device.GetCount(Null::DrawIndexedCommand) == 3);
+
+		// Uploads record a hash of their data, so the same data matches
+		if (commands.size() == sizeof(expected) / sizeof(expected[0]))
+		{
+			TEST_CHECK(commands[0].B != commands[9].B);
+			TEST_CHECK(commands[1].B != commands[5].B);
+			uint32_t material = 5;
+			device.UpdateBuffer(draws.MaterialBuffer, &material, sizeof(material));
+			TEST_CHECK(device.GetCommands().back().B == commands[9].B);
+		}
+
+		// Not recording still counts
+		device.Reset();
+		device.SetRecording(false);
+		SubmitDraws(draws, 3);
+		TEST_CHECK(device.GetCommands().empty());
+		TEST_CHECK(device.GetCount(Null::DrawIndexedCommand) == 3);
+	}
+
+	void NullDevicePacksClears()
+	{
+		NullRenderDevice device;
+		const float red[4] = { 1.0f, 0.0f, 0.0f, 1.0f };
+		const float mixed[4] = { 0.5f, 0.25f, 0.0f, 0.0f };
+		const float outOfRange[4] = { -1.0f, 2.0f, 1.0f, 0.0f };
+		device.Clear(red, 1.0f);
+		device.Clear(mixed, 0.5f);
+		device.Clear(outOfRange, -1.0f);
+		device.Clear(outOfRange, 2.0f);
+
+		// RGBA, 8 bits each from the top, and depth in 24 bits
+		const std::vector<NullRenderDevice::Command>& commands = device.GetCommands();
+		TEST_CHECK(commands.size() == 4);
+		if (commands.size() != 4)
+			return;
+		TEST_CHECK(commands[0].Type == NullRenderDevice::ClearCommand);
+		TEST_CHECK(commands[0].A == 0xFF0000FFu && commands[0].B == 0xFFFFFFu);
+		TEST_CHECK(commands[1].A == 0x80400000u && commands[1].B == 0x800000u);
+		TEST_CHECK(commands[2].A == 0x00FFFF00u && commands[2].B == 0);
+		TEST_CHECK(commands[3].B == 0xFFFFFFu);
+	}
+
+	void NullDeviceCountsLiveResources()
+	{
+		NullRenderDevice device;
+		RenderDevice::Handle vertices = device.CreateBuffer(RenderDevice::VertexBuffer, 0, 1024);
+		RenderDevice::Handle constants = device.CreateBuffer(RenderDevice::ConstantBuffer, 0, 256);
+		RenderDevice::Handle shader = device.CreateShader(RenderDevice::PixelStage, 0, 0);
+		TEST_CHECK(vertices != RenderDevice::NullHandle && constants != RenderDevice::NullHandle && shader != RenderDevice::NullHandle);
+		TEST_CHECK(vertices != constants && constants != shader && vertices != shader);
+
+		NullRenderDevice::ResourceStats stats = device.GetResourceStats();
+		TEST_CHECK(stats.LiveBuffers == 2 && stats.LiveShaders == 1);
+		TEST_CHECK(stats.LiveBufferBytes == 1280);
+		TEST_CHECK(stats.Created == 3 && stats.Released == 0);
+
+		// Releasing twice, or a handle never made, changes nothing
+		device.Release(vertices);
+		device.Release(vertices);
+		device.Release(RenderDevice::NullHandle);
+		device.Release(1000);
+		device.Release(shader);
+		stats = device.GetResourceStats();
+		TEST_CHECK(stats.LiveBuffers == 1 && stats.LiveShaders == 0);
+		TEST_CHECK(stats.LiveBufferBytes == 256);
+		TEST_CHECK(stats.Released == 2);
+
+		// Handles are reused once released
+		RenderDevice::Handle reused = device.CreateBuffer(RenderDevice::IndexBuffer, 0, 64);
+		TEST_CHECK(reused == vertices || reused == shader);
+		stats = device.GetResourceStats();
+		TEST_CHECK(stats.LiveBuffers == 2 && stats.LiveBufferBytes == 320 && stats.Created == 4);
+
+		// Resources aren't commands
+		TEST_CHECK(device.GetCommands().empty());
+	}
+
+	// --------------------------------------------------------
+	// ResourcePool
+	// --------------------------------------------------------
+	void PoolCreateFailsWhenOutOfSlots()
+	{
+		constexpr uint32_t MaxObjects = ResourcePool<uint32_t>::IndexMask + 1;
+		std::unique_ptr<ResourcePool<uint32_t>> pool = std::make_unique<ResourcePool<uint32_t>>();
+		std::vector<ResourcePool<uint32_t>::Handle> created(MaxObjects);
+		for (uint32_t i = 0; i < MaxObjects; i++)
+			created[i] = pool->Create(i);
+
+		TEST_CHECK(pool->GetStats().Slots == MaxObjects);
+		TEST_CHECK(pool->Get(created.back()) && *pool->Get(created.back()) == MaxObjects - 1);
+		TEST_CHECK(pool->Create(0u).IsNull());
+
+		// A slot is only free again once its object is destroyed
+		pool->Release(created[0]);
+		TEST_CHECK(pool->Create(0u).IsNull());
+		for (uint32_t frame = 0; frame < ResourcePool<uint32_t>::DestroyDelay; frame++)
+			pool->EndFrame();
+		ResourcePool<uint32_t>::Handle reused = pool->Create(7u);
+		TEST_CHECK(!reused.IsNull() && reused != created[0]);
+		TEST_CHECK(pool->Get(reused) && *pool->Get(reused) == 7 && !pool->Get(created[0]));
+	}
+
+	// --------------------------------------------------------
+	// EntitySystem
+	// --------------------------------------------------------
+	void EntityCreateFailsWhenOutOfSlots()
+	{
+		// Fill every slot not already used, then ask for one more
+		constexpr uint32_t MaxEntities = 1u << 20;
+		uint32_t count = MaxEntities - EntitySystem::GetStats().Count;
+		std::vector<EntitySystem::Entity> created;
+		created.reserve(count);
+		EntitySystem::Reserve(MaxEntities);
+		for (uint32_t i = 0; i < count; i++)
+			created.push_back(EntitySystem::Create());
+
+		TEST_CHECK(EntitySystem::GetStats().Slots == MaxEntities);
+		TEST_CHECK(EntitySystem::IsAlive(created.back()));
+		TEST_CHECK(EntitySystem::Create() == EntitySystem::NullEntity);
+
+		// A freed slot is usable again, and ids still round trip
+		EntitySystem::Entity last = created.back();
+		EntitySystem::Destroy(last);
+		EntitySystem::Entity reused = EntitySystem::Create();
+		TEST_CHECK(reused != EntitySystem::NullEntity && reused != last);
+		TEST_CHECK(EntitySystem::IsAlive(reused) && !EntitySystem::IsAlive(last));
+		created.back() = reused;
+
+		for (EntitySystem::Entity entity : created)
+			EntitySystem::Destroy(entity);
+	}
+
+	// --------------------------------------------------------
+	// TransformSystem
+	// --------------------------------------------------------
+	void InverseTransposeMatchesGeneralInverse()
+	{
+		unsigned int before = TransformSystem::GetStats().Count;
+		float maxError = TransformSystem::ValidateInverseTranspose(1000);
+		TEST_CHECK(maxError <= 1e-4f);
+		TEST_CHECK(TransformSystem::GetStats().Count == before);
+		if (maxError > 1e-4f)
+			printf("  Max relative error %g\n", maxError);
+	}
+
+	void UpdateRebuildsOnlyWhatMoved()
+	{
+		using namespace TransformSystem;
+		Handle root = Create(nullptr);
+		Handle child = Create(nullptr);
+		Handle grandchild = Create(nullptr);
+		Handle other = Create(nullptr);
+		SetParent(child, root, false);
+		SetParent(grandchild, child, false);
+		SetPosition(root, DirectX::XMFLOAT3(1, 0, 0));
+		SetPosition(child, DirectX::XMFLOAT3(2, 0, 0));
+		SetPosition(grandchild, DirectX::XMFLOAT3(4, 0, 0));
+		Update();
+		unsigned int rootVersion = GetVersion(root);
+		unsigned int otherVersion = GetVersion(other);
+
+		// The child and everything under it, and nothing else
+		SetPosition(child, DirectX::XMFLOAT3(8, 0, 0));
+		Update();
+		TEST_CHECK(GetStats().LastUpdateCount == 2);
+		TEST_CHECK(GetWorldMatrix(grandchild)._41 == 13.0f);
+		TEST_CHECK(GetVersion(root) == rootVersion && GetVersion(other) == otherVersion);
+
+		// Only what moved during the step is blended...
+		BeginStep();
+		SetPosition(other, DirectX::XMFLOAT3(0, 2, 0));
+		Interpolate(0.5f);
+		TEST_CHECK(GetStats().Interpolated == 1);
+		TEST_CHECK(GetRenderWorldMatrix(other)._42 == 1.0f);
+		TEST_CHECK(GetRenderWorldMatrix(grandchild)._41 == 13.0f);
+
+		// ...and goes back to its world matrix once it stops
+		BeginStep();
+		Interpolate(0.5f);
+		TEST_CHECK(GetStats().Interpolated == 0);
+		TEST_CHECK(GetRenderWorldMatrix(other)._42 == 2.0f);
+
+		Release(grandchild);
+		Release(child);
+		Release(root);
+		Release(other);
+		Update();
+	}
+
+	struct Test
+	{
+		const char* Name;
+		void (*Run)();
+	};
+
+	const Test tests[] =
+	{
+		{ "JobSystem: ParallelFor runs every index once", ParallelForRunsEveryIndexOnce },
+		{ "JobSystem: nested ParallelFor finishes before returning", NestedParallelForFinishesBeforeReturning },
+		{ "JobSystem: an old job outlives newer ones", OldJobOutlivesNewerOnes },
+		{ "JobSystem: fork-join waits for every job", ForkJoinWaitsForEveryJob },
+		{ "JobSystem: a full deque runs jobs inline", FullDequeRunsJobsInline },
+		{ "RingArena: every block is aligned", RingArenaAlignsEveryBlock },
+		{ "RingArena: allocations fail when full", RingArenaFailsWhenFull },
+		{ "RingArena: retired frames are reclaimed", RingArenaReclaimsRetiredFrames },
+		{ "RingArena: wraps around to the start", RingArenaWrapsAround },
+		{ "RingArena: blocks between frames are released", RingArenaReleasesBlocksBetweenFrames },
+		{ "RingArena: 100000 random frames", RingArenaRandomFrames },
+		{ "ShaderReflectionCache: round trips", ReflectionRoundTrips },
+		{ "ShaderReflectionCache: rejects truncated data", ReflectionRejectsTruncatedData },
+		{ "ShaderReflectionCache: rejects another shader's hash", ReflectionRejectsWrongHash },
+		{ "ShaderReflectionCache: rejects trailing bytes", ReflectionRejectsTrailingBytes },
+		{ "ShaderReflectionCache: sidecar files round trip", ReflectionSidecarRoundTrips },
+		{ "InputLayoutCache: formats follow mask and component type", InputElementFormatsFollowMaskAndType },
+		{ "InputLayoutCache: _PER_INSTANCE semantics are per instance", InputElementsPerInstanceBySemantic },
+		{ "InputLayoutCache: descs hash by value", InputElementHashesByValue },
+		{ "FrameGraph: a reader waits for the writer before it", FrameGraphOrdersReadsAfterWrites },
+		{ "FrameGraph: a RunAfter loop fails to compile", FrameGraphRejectsRunAfterLoops },
+		{ "FrameGraph: the critical path takes the longer branch", FrameGraphCriticalPathTakesLongerBranch },
+		{ "FrameTimes: percentiles and budget count find spikes", FrameTimesFindsSpikes },
+		{ "NullRenderDevice: records a SubmitDraws frame in order", NullDeviceRecordsSubmittedDraws },
+		{ "NullRenderDevice: packs clear color and depth", NullDevicePacksClears },
+		{ "NullRenderDevice: counts live buffers and shaders", NullDeviceCountsLiveResources },
+		{ "ResourcePool: Create fails once every slot is taken", PoolCreateFailsWhenOutOfSlots },
+		{ "EntitySystem: Create fails once every slot is taken", EntityCreateFailsWhenOutOfSlots },
+		{ "TransformSystem: inverse-transpose matches a general inverse", InverseTransposeMatchesGeneralInverse },
+		{ "TransformSystem: Update rebuilds only what moved and below", UpdateRebuildsOnlyWhatMoved },
+	};
+}
+
+// --------------------------------------------------------
+// Runs every test, in order, and says which failed (and
+// which of their checks)
+// --------------------------------------------------------
+int Benchmark::RunTests(const Options&)
+{
+	unsigned int failedTests = 0;
+	for (const Test& test : tests)
+	{
+		failedChecks = 0;
+		test.Run();
+		printf("%-64s %s\n", test.Name, failedChecks == 0 ? "passed" : "FAILED");
+		if (failedChecks > 0)
+			failedTests++;
+	}
+
+	unsigned int testCount = (unsigned int)(sizeof(tests) / sizeof(tests[0]));
+	printf("%u of %u tests passed\n", testCount - failedTests, testCount);
+	return failedTests == 0 ? 0 : 1;
+}
@@ -0,0 +1,586 @@
+#include "Benchmark.h"
+#include "JobSystem.h"
+#include "MatrixBatch.h"
+#include "Transform.h"
+#include <math.h>
+#include <memory>
+#include <random>
+#include <stdio.h>
+#include <string>
+
+using namespace DirectX;
+
+namespace
+{
+	// Same grain as RenderQueue::Build()
+	constexpr uint32_t MatricesPerBatch = 512;
+
+	// Random placements, as a big scene's world matrices would be
+	void MakeWorldMatrices(uint32_t count, std::vector<XMFLOAT4X4A>& world)
+	{
+		std::mt19937 rng(count);
+		std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+		std::uniform_real_distribution<float> angle(-XM_PI, XM_PI);
+		std::uniform_real_distribution<float> scale(0.25f, 4.0f);
+
+		world.resize(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			XMMATRIX m =
+				XMMatrixScaling(scale(rng), scale(rng), scale(rng)) *
+				XMMatrixRotationRollPitchYaw(angle(rng), angle(rng), angle(rng)) *
+				XMMatrixTranslation(position(rng), position(rng), position(rng));
+			XMStoreFloat4x4A(&world[i], m);
+		}
+	}
+
+	// What GetWorldMatrix() cost before Transform cached anything:
+	// the whole matrix and its inverse transpose, on every call
+	XMMATRIX RecalculateWorldMatrix(const XMFLOAT3& position, const XMFLOAT3& pitchYawRoll, const XMFLOAT3& scale, XMFLOAT4X4& inverseTranspose)
+	{
+		XMMATRIX world =
+			XMMatrixScaling(scale.x, scale.y, scale.z) *
+			XMMatrixRotationRollPitchYaw(pitchYawRoll.x, pitchYawRoll.y, pitchYawRoll.z) *
+			XMMatrixTranslation(position.x, position.y, position.z);
+		XMStoreFloat4x4(&inverseTranspose, XMMatrixInverse(0, XMMatrixTranspose(world)));
+		return world;
+	}
+
+	// What GetRight(), GetUp() and GetForward() cost before the
+	// axes were cached: a quaternion from the angles on every call
+	XMFLOAT3 RotateFromEuler(const XMFLOAT3& pitchYawRoll, FXMVECTOR axis)
+	{
+		XMFLOAT3 result;
+		XMVECTOR rotation = XMQuaternionRotationRollPitchYaw(pitchYawRoll.x, pitchYawRoll.y, pitchYawRoll.z);
+		XMStoreFloat3(&result, XMVector3Rotate(axis, rotation));
+		return result;
+	}
+
+	float MaxDifference(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return fmaxf(fabsf(a.x - b.x), fmaxf(fabsf(a.y - b.y), fabsf(a.z - b.z)));
+	}
+
+	// What --hierarchy allows Update() a frame, on average
+	constexpr double HierarchyBudgetMilliseconds = 1.0;
+
+	// Largest difference between two sets of matrices, relative
+	// to each one's largest element
+	float MaxRelativeError(const std::vector<XMFLOAT4X4A>& a, const std::vector<XMFLOAT4X4A>& b)
+	{
+		float worst = 0.0f;
+		for (size_t i = 0; i < a.size(); i++)
+		{
+			float largest = 1.0f;
+			float error = 0.0f;
+			for (int r = 0; r < 4; r++)
+			{
+				for (int c = 0; c < 4; c++)
+				{
+					largest = fmaxf(largest, fabsf(a[i].m[r][c]));
+					error = fmaxf(error, fabsf(a[i].m[r][c] - b[i].m[r][c]));
+				}
+			}
+			worst = fmaxf(worst, error / largest);
+		}
+		return worst;
+	}
+}
+
+// --------------------------------------------------------
+// Times building every object's world-view-projection matrix
+// on the CPU, as RenderQueue::Build() does, so the vertex
+// shader doesn't multiply view and projection per vertex
+//
+// Each frame, over the same world matrices:
+//  - Per object: XMMatrixMultiply() one object at a time
+//  - Batched: MatrixBatch::ComputeWorldViewProjection() over
+//    the whole array, on one thread
+//  - Batched, parallel: the same in RenderQueue's batches
+//    across every core
+//
+// --objects sets the transform count (100000 by default).
+// --------------------------------------------------------
+int Benchmark::RunWorldViewProjectionBenchmark(const Options& options)
+{
+	uint32_t count = options.Objects > 0 ? options.Objects : 100000;
+	JobSystem::Initialize(options.Workers);
+	unsigned int threads = JobSystem::GetThreadCount();
+	Report report;
+
+	std::vector<XMFLOAT4X4A> world;
+	MakeWorldMatrices(count, world);
+	std::vector<XMFLOAT4X4A> perObject(count);
+	std::vector<XMFLOAT4X4A> batched(count);
+	std::vector<XMFLOAT4X4A> parallel(count);
+
+	XMMATRIX projection = GetProjection(options);
+	float error = 0.0f;
+
+	for (unsigned int frame = 0; frame < options.Warmup + options.Frames; frame++)
+	{
+		bool record = frame >= options.Warmup;
+
+		// The camera moves every frame, as it would in the game
+		CameraPose pose;
+		GetCameraPose(options.CameraPath, frame * options.DeltaTime, 500.0f, pose);
+		XMMATRIX viewProjection = XMMatrixMultiply(GetView(pose), projection);
+
+		Measure(report, record, "Per object", 0, [&]()
+		{
+			for (uint32_t i = 0; i < count; i++)
+				XMStoreFloat4x4A(&perObject[i], XMMatrixMultiply(XMLoadFloat4x4A(&world[i]), viewProjection));
+		});
+
+		Measure(report, record, "Batched", 0, [&]()
+		{
+			MatrixBatch::ComputeWorldViewProjection(world.data(), batched.data(), count, viewProjection);
+		});
+
+		Measure(report, record, "Batched, parallel", 0, [&]()
+		{
+			JobSystem::ParallelFor(count, MatricesPerBatch, [&](uint32_t begin, uint32_t end)
+			{
+				MatrixBatch::ComputeWorldViewProjection(&world[begin], &parallel[begin], end - begin, viewProjection);
+			});
+		});
+
+		error = fmaxf(error, fmaxf(MaxRelativeError(perObject, batched), MaxRelativeError(perObject, parallel)));
+	}
+
+	// The batch multiplies and adds in its own order, so the last
+	// bits can differ from XMMatrixMultiply()'s
+	bool same = error <= 1e-5f;
+	printf("World-view-projection: %u matrices, max relative error %g\n", count, error);
+	if (!same)
+		fprintf(stderr, "Batched matrices differ from XMMatrixMultiply()'s\n");
+
+	bool written = report.WriteJson(options.ReportPath.c_str(), options, "wvp", count, threads);
+	if (written)
+		printf("Wrote %s\n", options.ReportPath.c_str());
+	else
+		fprintf(stderr, "Couldn't write %s\n", options.ReportPath.c_str());
+
+	JobSystem::ShutDown();
+	return written && same ? 0 : 1;
+}
+
+// --------------------------------------------------------
+// Times Transform::GetWorldMatrix() on transforms that stay
+// still against ones that move, to show what the dirty flags
+// and cached matrices save
+//
+// Each frame, over the same transforms:
+//  - Recalculated: what every call cost before the cache,
+//    rebuilding the matrix and a general inverse
+//  - Static: every matrix read, nothing having changed
+//  - Moving: every transform moved, then every matrix read
+//    (the first read rebuilds all of them at once)
+//  - Moving, read after each move: one rebuild per read, the
+//    worst case for the dirty flags
+//
+// --objects sets the transform count (10000 by default).
+// --------------------------------------------------------
+int Benchmark::RunDirtyFlagBenchmark(const Options& options)
+{
+	uint32_t count = options.Objects > 0 ? options.Objects : 10000;
+	Report report;
+
+	std::vector<XMFLOAT3> positions(count);
+	std::vector<XMFLOAT3> rotations(count);
+	std::vector<XMFLOAT3> scales(count);
+	std::mt19937 rng(count);
+	std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+	std::uniform_real_distribution<float> angle(-XM_PI, XM_PI);
+	std::uniform_real_distribution<float> scale(0.25f, 4.0f);
+
+	TransformSystem::Reserve(TransformSystem::GetStats().Count + count);
+	std::vector<std::unique_ptr<Transform>> transforms(count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		positions[i] = XMFLOAT3(position(rng), position(rng), position(rng));
+		rotations[i] = XMFLOAT3(angle(rng), angle(rng), angle(rng));
+		scales[i] = XMFLOAT3(scale(rng), scale(rng), scale(rng));
+		transforms[i] = std::make_unique<Transform>();
+		transforms[i]->SetPosition(positions[i]);
+		transforms[i]->SetRotation(rotations[i]);
+		transforms[i]->SetScale(scales[i]);
+	}
+	TransformSystem::Update();
+
+	std::vector<unsigned int> versions(count);
+	float checksum = 0.0f;
+	bool versionsRight = true;
+
+	for (unsigned int frame = 0; frame < options.Warmup + options.Frames; frame++)
+	{
+		bool record = frame >= options.Warmup;
+		float step = (frame + 1) * options.DeltaTime;
+
+		Measure(report, record, "Recalculated", 0, [&]()
+		{
+			for (uint32_t i = 0; i < count; i++)
+			{
+				XMFLOAT4X4 inverseTranspose;
+				XMFLOAT4X4 world;
+				XMStoreFloat4x4(&world, RecalculateWorldMatrix(positions[i], rotations[i], scales[i], inverseTranspose));
+				checksum += world._41 + inverseTranspose._11;
+			}
+		});
+
+		for (uint32_t i = 0; i < count; i++)
+			versions[i] = transforms[i]->GetVersion();
+
+		Measure(report, record, "Static", 0, [&]()
+		{
+			for (uint32_t i = 0; i < count; i++)
+				checksum += transforms[i]->GetWorldMatrix()._41;
+		});
+
+		// Reading never changes a transform
+		for (uint32_t i = 0; i < count; i++)
+			versionsRight = versionsRight && transforms[i]->GetVersion() == versions[i];
+
+		Measure(report, record, "Moving", 0, [&]()
+		{
+			for (uint32_t i = 0; i < count; i++)
+				transforms[i]->SetPosition(positions[i].x + step, positions[i].y, positions[i].z);
+			for (uint32_t i = 0; i < count; i++)
+				checksum += transforms[i]->GetWorldMatrix()._41;
+		});
+		if (record)
+			report.AddCount("Moving, matrices rebuilt", (double)TransformSystem::GetStats().LastUpdateCount);
+
+		// ...but moving one always does
+		for (uint32_t i = 0; i < count; i++)
+			versionsRight = versionsRight && transforms[i]->GetVersion() != versions[i];
+
+		Measure(report, record, "Moving, read after each move", 0, [&]()
+		{
+			for (uint32_t i = 0; i < count; i++)
+			{
+				transforms[i]->SetPosition(positions[i]);
+				checksum += transforms[i]->GetWorldMatrix()._41;
+			}
+		});
+	}
+
+	printf("Dirty flags: %u transforms (checksum %g)\n", count, checksum);
+	if (!versionsRight)
+		fprintf(stderr, "Transform versions changed without a move, or didn't change with one\n");
+
+	bool written = report.WriteJson(options.ReportPath.c_str(), options, "dirty-flags", count, 1);
+	if (written)
+		printf("Wrote %s\n", options.ReportPath.c_str());
+	else
+		fprintf(stderr, "Couldn't write %s\n", options.ReportPath.c_str());
+
+	transforms.clear();
+	return written && versionsRight ? 0 : 1;
+}
+
+// --------------------------------------------------------
+// Measures how many world matrices TransformSystem::Update()
+// builds a second, at 10k, 100k and 1M transforms
+//
+// Each frame every transform turns, so all of them are
+// dirty, then:
+//  - Set: the new rotations going into the arrays
+//  - Update: rebuilding every local, world and inverse
+//    transpose matrix, across every core
+// with the matrices per second Update() managed counted.
+//
+// --objects measures that one count instead.
+// --------------------------------------------------------
+int Benchmark::RunTransformUpdateBenchmark(const Options& options)
+{
+	std::vector<uint32_t> counts = { 10000, 100000, 1000000 };
+	if (options.Objects > 0)
+		counts = { options.Objects };
+
+	JobSystem::Initialize(options.Workers);
+	unsigned int threads = JobSystem::GetThreadCount();
+	Report report;
+	bool allUpdated = true;
+
+	for (uint32_t count : counts)
+	{
+		std::string suffix = ", " + std::to_string(count) + " transforms";
+		std::string setStage = "Set" + suffix;
+		std::string updateStage = "Update" + suffix;
+		std::string rateCounter = "Matrices per second" + suffix;
+
+		TransformSystem::Reserve(TransformSystem::GetStats().Count + count);
+		std::vector<TransformSystem::Handle> handles(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			handles[i] = TransformSystem::Create(nullptr);
+			TransformSystem::SetPosition(handles[i], XMFLOAT3((float)(i % 1000), 0.0f, (float)(i / 1000)));
+		}
+		TransformSystem::Update();
+
+		for (unsigned int frame = 0; frame < options.Warmup + options.Frames; frame++)
+		{
+			bool record = frame >= options.Warmup;
+			float angle = frame * options.DeltaTime;
+
+			Measure(report, record, setStage.c_str(), 0, [&]()
+			{
+				for (uint32_t i = 0; i < count; i++)
+					TransformSystem::SetPitchYawRoll(handles[i], XMFLOAT3(0.0f, angle + i * 0.001f, 0.0f));
+			});
+
+			std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+			TransformSystem::Update();
+			double milliseconds = MillisecondsSince(start);
+			unsigned int updated = TransformSystem::GetStats().LastUpdateCount;
+			allUpdated = allUpdated && updated == count;
+
+			if (record)
+			{
+				AllocationTracker::Ignore ignore;
+				report.AddSample(updateStage, milliseconds);
+				report.AddCount(rateCounter, milliseconds > 0.0 ? updated * 1000.0 / milliseconds : 0.0);
+			}
+		}
+
+		for (TransformSystem::Handle handle : handles)
+			TransformSystem::Release(handle);
+		TransformSystem::Update();
+	}
+
+	if (!allUpdated)
+		fprintf(stderr, "Update() didn't rebuild every transform that turned\n");
+
+	bool written = report.WriteJson(options.ReportPath.c_str(), options, "transform-update", counts.back(), threads);
+	if (written)
+		printf("Wrote %s\n", options.ReportPath.c_str());
+	else
+		fprintf(stderr, "Couldn't write %s\n", options.ReportPath.c_str());
+
+	JobSystem::ShutDown();
+	return written && allUpdated ? 0 : 1;
+}
+
+// --------------------------------------------------------
+// Times asking transforms for their right, up and forward
+// axes, as Camera::Update() and MoveRelative() do
+//
+// Each frame, over the same transforms:
+//  - From angles: converting pitch, yaw and roll to a
+//    quaternion for every axis, as before the cache
+//  - Cached: GetRight(), GetUp() and GetForward()
+//  - Cached, after turning: every transform rotated first,
+//    so each one's axes are rebuilt once
+//
+// --objects sets the transform count (10000 by default).
+// --------------------------------------------------------
+int Benchmark::RunBasisBenchmark(const Options& options)
+{
+	uint32_t count = options.Objects > 0 ? options.Objects : 10000;
+	Report report;
+
+	std::mt19937 rng(count);
+	std::uniform_real_distribution<float> angle(-XM_PIDIV2 * 0.9f, XM_PIDIV2 * 0.9f);
+	std::vector<XMFLOAT3> rotations(count);
+	TransformSystem::Reserve(TransformSystem::GetStats().Count + count);
+	std::vector<std::unique_ptr<Transform>> transforms(count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		rotations[i] = XMFLOAT3(angle(rng), angle(rng) * 2.0f, angle(rng));
+		transforms[i] = std::make_unique<Transform>();
+		transforms[i]->SetRotation(rotations[i]);
+	}
+
+	std::vector<XMFLOAT3> fromAngles(count * 3);
+	std::vector<XMFLOAT3> cached(count * 3);
+	const float turn = 0.001f;
+	float error = 0.0f;
+
+	for (unsigned int frame = 0; frame < options.Warmup + options.Frames; frame++)
+	{
+		bool record = frame >= options.Warmup;
+
+		Measure(report, record, "From angles", 0, [&]()
+		{
+			for (uint32_t i = 0; i < count; i++)
+			{
+				fromAngles[i * 3 + 0] = RotateFromEuler(rotations[i], XMVectorSet(1, 0, 0, 0));
+				fromAngles[i * 3 + 1] = RotateFromEuler(rotations[i], XMVectorSet(0, 1, 0, 0));
+				fromAngles[i * 3 + 2] = RotateFromEuler(rotations[i], XMVectorSet(0, 0, 1, 0));
+			}
+		});
+
+		Measure(report, record, "Cached", 0, [&]()
+		{
+			for (uint32_t i = 0; i < count; i++)
+			{
+				cached[i * 3 + 0] = transforms[i]->GetRight();
+				cached[i * 3 + 1] = transforms[i]->GetUp();
+				cached[i * 3 + 2] = transforms[i]->GetForward();
+			}
+		});
+
+		// Every other frame the turns below have cancelled out
+		if (frame % 2 == 0)
+		{
+			for (uint32_t a = 0; a < count * 3; a++)
+				error = fmaxf(error, MaxDifference(fromAngles[a], cached[a]));
+		}
+
+		// Turned one way, then back the next frame
+		Measure(report, record, "Cached, after turning", 0, [&]()
+		{
+			float yaw = frame % 2 == 0 ? turn : -turn;
+			for (uint32_t i = 0; i < count; i++)
+			{
+				transforms[i]->Rotate(0.0f, yaw, 0.0f);
+				cached[i * 3 + 0] = transforms[i]->GetRight();
+				cached[i * 3 + 1] = transforms[i]->GetUp();
+				cached[i * 3 + 2] = transforms[i]->GetForward();
+			}
+		});
+	}
+
+	// The cache is built from a quaternion that's been turned
+	// back and forth, so allow for some drift
+	bool same = error <= 1e-4f;
+	printf("Basis vectors: %u transforms, max difference %g\n", count, error);
+	if (!same)
+		fprintf(stderr, "Cached axes differ from the ones worked out from the angles\n");
+
+	bool written = report.WriteJson(options.ReportPath.c_str(), options, "basis", count, 1);
+	if (written)
+		printf("Wrote %s\n", options.ReportPath.c_str());
+	else
+		fprintf(stderr, "Couldn't write %s\n", options.ReportPath.c_str());
+
+	transforms.clear();
+	return written && same ? 0 : 1;
+}
+
+// --------------------------------------------------------
+// Times TransformSystem::Update() on a large hierarchy where
+// only a few transforms move each frame, as in a level where
+// most things stand still
+//
+// Every transform but the first few hangs off a random earlier
+// one.  Each frame --moving of them (1% by default) get new
+// positions, then:
+//  - Update: rebuilding what moved and everything below it
+//  - Interpolate: blending the same subtrees for rendering
+// with the matrices each rebuilt counted.
+//
+// --objects sets the transform count (100000 by default).
+// Fails if Update() averages over HierarchyBudgetMilliseconds,
+// or if its matrices differ from ones built from scratch.
+// --------------------------------------------------------
+int Benchmark::RunHierarchyBenchmark(const Options& options)
+{
+	uint32_t count = options.Objects > 0 ? options.Objects : 100000;
+	uint32_t moving = (uint32_t)(count * options.Moving + 0.5f);
+	JobSystem::Initialize(options.Workers);
+	unsigned int threads = JobSystem::GetThreadCount();
+	Report report;
+
+	std::mt19937 rng(count);
+	std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+	std::uniform_real_distribution<float> angle(-XM_PI, XM_PI);
+	std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+
+	TransformSystem::Reserve(TransformSystem::GetStats().Count + count);
+	std::vector<TransformSystem::Handle> handles(count);
+	std::vector<int> parents(count, -1);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		handles[i] = TransformSystem::Create(nullptr);
+		TransformSystem::SetPosition(handles[i], XMFLOAT3(position(rng), position(rng), position(rng)));
+		TransformSystem::SetPitchYawRoll(handles[i], XMFLOAT3(angle(rng), angle(rng), angle(rng)));
+		TransformSystem::SetScale(handles[i], XMFLOAT3(scale(rng), scale(rng), scale(rng)));
+		if (i >= 16)
+		{
+			parents[i] = (int)(rng() % i);
+			TransformSystem::SetParent(handles[i], handles[parents[i]], false);
+		}
+	}
+	TransformSystem::Update();
+
+	std::vector<uint32_t> moves(moving);
+	double updateTotal = 0;
+	double rebuiltTotal = 0;
+	for (unsigned int frame = 0; frame < options.Warmup + options.Frames; frame++)
+	{
+		bool record = frame >= options.Warmup;
+
+		TransformSystem::BeginStep();
+		for (uint32_t m = 0; m < moving; m++)
+		{
+			moves[m] = rng() % count;
+			TransformSystem::SetPosition(handles[moves[m]], XMFLOAT3(position(rng), position(rng), position(rng)));
+		}
+
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		Measure(report, record, "Update", "Update allocations", [&]()
+		{
+			TransformSystem::Update();
+		});
+		double milliseconds = MillisecondsSince(start);
+		unsigned int rebuilt = TransformSystem::GetStats().LastUpdateCount;
+
+		Measure(report, record, "Interpolate", "Interpolate allocations", [&]()
+		{
+			TransformSystem::Interpolate(0.5f);
+		});
+
+		if (record)
+		{
+			report.AddCount("Matrices rebuilt", (double)rebuilt);
+			report.AddCount("Matrices blended", (double)TransformSystem::GetStats().Interpolated);
+			updateTotal += milliseconds;
+			rebuiltTotal += rebuilt;
+		}
+	}
+
+	// The same matrices built from scratch, parents first
+	std::vector<XMFLOAT4X4A> expected(count);
+	std::vector<XMFLOAT4X4A> actual(count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		XMFLOAT3 p = TransformSystem::GetPosition(handles[i]);
+		XMFLOAT4 q = TransformSystem::GetRotation(handles[i]);
+		XMFLOAT3 s = TransformSystem::GetScale(handles[i]);
+		XMMATRIX world =
+			XMMatrixScaling(s.x, s.y, s.z) *
+			XMMatrixRotationQuaternion(XMLoadFloat4(&q)) *
+			XMMatrixTranslation(p.x, p.y, p.z);
+		if (parents[i] >= 0)
+			world = world * XMLoadFloat4x4A(&expected[parents[i]]);
+		XMStoreFloat4x4A(&expected[i], world);
+		actual[i] = TransformSystem::GetWorldMatrix(handles[i]);
+	}
+	float error = MaxRelativeError(expected, actual);
+
+	double updateAverage = options.Frames > 0 ? updateTotal / options.Frames : 0;
+	double rebuiltAverage = options.Frames > 0 ? rebuiltTotal / options.Frames : 0;
+	printf("Hierarchy: %u transforms, %u moving, Update %.3f ms (budget %.1f ms) rebuilding %.0f, max relative error %g\n",
+		count, moving, updateAverage, HierarchyBudgetMilliseconds, rebuiltAverage, error);
+	bool withinBudget = updateAverage <= HierarchyBudgetMilliseconds;
+	if (!withinBudget)
+		fprintf(stderr, "Update() took more than %.1f ms a frame\n", HierarchyBudgetMilliseconds);
+	bool same = error <= 1e-4f;
+	if (!same)
+		fprintf(stderr, "Updated world matrices differ from ones built from scratch\n");
+
+	bool written = report.WriteJson(options.ReportPath.c_str(), options, "hierarchy", count, threads);
+	if (written)
+		printf("Wrote %s\n", options.ReportPath.c_str());
+	else
+		fprintf(stderr, "Couldn't write %s\n", options.ReportPath.c_str());
+
+	for (size_t i = handles.size(); i > 0; i--)
+		TransformSystem::Release(handles[i - 1]);
+	TransformSystem::Update();
+
+	JobSystem::ShutDown();
+	return written && withinBudget && same ? 0 : 1;
+}
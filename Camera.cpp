@@ -1,5 +1,6 @@
 #include "Camera.h"
 #include "Input.h"
+#include "TransformSystem.h"
 
 Camera::Camera(DirectX::XMFLOAT3 initPosition, float fov, float movespeed)
 {
@@ -44,11 +45,24 @@ void Camera::UpdateProjectionMatrix(float aspectRatio)
 	DirectX::XMStoreFloat4x4(&projectionMatrix, DirectX::XMMatrixPerspectiveFovLH(fov, aspectRatio, 0.05f, 900.0f));
 }
 
+//uses the interpolated matrix, so call after TransformSystem::Interpolate()
 void Camera::UpdateViewMatrix()
 {
-	DirectX::XMFLOAT3 posStore = transform.GetPosition();
-	DirectX::XMFLOAT3 forStore = transform.GetForward();
-	DirectX::XMStoreFloat4x4(&viewMatrix, DirectX::XMMatrixLookToLH(DirectX::XMLoadFloat3(&posStore), DirectX::XMLoadFloat3(&forStore), DirectX::XMVECTOR{ 0,1,0 }));
+	const DirectX::XMFLOAT4X4A& world = TransformSystem::GetRenderWorldMatrix(transform.GetHandle());
+	DirectX::XMVECTOR pos = DirectX::XMVectorSet(world._41, world._42, world._43, 1.0f);
+	DirectX::XMVECTOR forward = DirectX::XMVector3Normalize(DirectX::XMVectorSet(world._31, world._32, world._33, 0.0f));
+	DirectX::XMStoreFloat4x4(&viewMatrix, DirectX::XMMatrixLookToLH(pos, forward, DirectX::XMVECTOR{ 0,1,0 }));
+}
+
+//mouse deltas only last one frame, so collect them every frame
+//even if no simulation step runs
+void Camera::UpdateLook()
+{
+	if (Input::MouseLeftDown())
+	{
+		pendingLookX += Input::GetMouseXDelta();
+		pendingLookY += Input::GetMouseYDelta();
+	}
 }
 
 void Camera::Update(float dt)
@@ -68,12 +82,11 @@ void Camera::Update(float dt)
 		transform.MoveRelative(DirectX::XMFLOAT3{ 0,-movespeed * dt,0 });
 
 	//mouse movement
-	if(Input::MouseLeftDown())
+	if(pendingLookX != 0.0f || pendingLookY != 0.0f)
 	{
-		int cursorMovementX = Input::GetMouseXDelta();
-		int cursorMovementY = Input::GetMouseYDelta();
-		
-		transform.Rotate(DirectX::XMFLOAT3(cursorMovementY*0.025f, cursorMovementX*0.01f, 0));
+		transform.Rotate(DirectX::XMFLOAT3(pendingLookY*0.025f, pendingLookX*0.01f, 0));
+		pendingLookX = 0.0f;
+		pendingLookY = 0.0f;
 
 		if(transform.GetPitchYawRoll().x > DirectX::XM_PIDIV2)
 		{
@@ -84,8 +97,4 @@ void Camera::Update(float dt)
 			transform.SetRotation(-DirectX::XM_PIDIV2, transform.GetPitchYawRoll().y, transform.GetPitchYawRoll().z);
 		}
 	}
-
-
-	UpdateViewMatrix();
-
 }
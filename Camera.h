@@ -20,6 +20,7 @@ public:
 	//updaters
 	void UpdateProjectionMatrix(float aspectRatio);
 	void UpdateViewMatrix();
+	void UpdateLook();
 	void Update(float dt);
 
 private:
@@ -30,5 +31,9 @@ private:
 	//extras
 	float fov;
 	float movespeed;
+
+	//mouse movement gathered every frame, applied on the next fixed step
+	float pendingLookX = 0.0f;
+	float pendingLookY = 0.0f;
 };
 
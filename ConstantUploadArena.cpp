@@ -0,0 +1,183 @@
+#include "ConstantUploadArena.h"
+#include "Graphics.h"
+#include <string.h>
+
+// Bind offsets must be multiples of 16 constants (256 bytes)
+#define CONSTANT_BLOCK_ALIGNMENT 256
+
+// --------------------------------------------------------
+// Creates the backing dynamic constant buffer if the device
+// supports binding constant buffers by offset
+//
+// sizeInBytes - Size of the whole arena, shared by all frames in flight
+// --------------------------------------------------------
+ConstantUploadArena::ConstantUploadArena(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, unsigned int sizeInBytes)
+	: arena(sizeInBytes, CONSTANT_BLOCK_ALIGNMENT)
+{
+	this->device = device;
+	frameFence = 0;
+	supported = false;
+	discarded = false;
+	bufferHandle = RenderDevice::NullHandle;
+
+	// Need the 11.1 context for XXSetConstantBuffers1()
+	if (FAILED(context.As(&context1)))
+		return;
+
+	// Need both offset binding and no-overwrite maps on constant buffers
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+	device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options));
+	if (!options.ConstantBufferOffsetting || !options.MapNoOverwriteOnDynamicConstantBuffer)
+		return;
+
+	// Create the one big buffer
+	D3D11_BUFFER_DESC desc = {};
+	desc.Usage = D3D11_USAGE_DYNAMIC;
+	desc.ByteWidth = arena.GetCapacity();
+	desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	desc.MiscFlags = 0;
+	desc.StructureByteStride = 0;
+	if (FAILED(device->CreateBuffer(&desc, 0, buffer.GetAddressOf())))
+		return;
+
+	// Blocks are bound by offset through the render device
+	bufferHandle = Graphics::Renderer->AdoptBuffer(buffer, RenderDevice::ConstantBuffer, arena.GetCapacity());
+	supported = bufferHandle != RenderDevice::NullHandle;
+}
+
+ConstantUploadArena::~ConstantUploadArena()
+{
+	if (Graphics::Renderer)
+		Graphics::Renderer->Release(bufferHandle);
+}
+
+// --------------------------------------------------------
+// Starts a frame, giving back memory from any frames the
+// GPU has finished with
+// --------------------------------------------------------
+void ConstantUploadArena::BeginFrame()
+{
+	if (!supported) return;
+
+	PollFences(false);
+	arena.BeginFrame(++frameFence);
+}
+
+// --------------------------------------------------------
+// Ends a frame by closing it in the arena and inserting
+// an event query the GPU will signal once it gets there
+// --------------------------------------------------------
+void ConstantUploadArena::EndFrame()
+{
+	if (!supported) return;
+
+	FrameFence fence = {};
+	fence.Value = frameFence;
+	fence.Query = GetQuery();
+	if (fence.Query)
+		context1->End(fence.Query.Get());
+
+	pendingFences.push_back(fence);
+	arena.EndFrame();
+}
+
+// --------------------------------------------------------
+// Checks which frames the GPU has completed and retires
+// them in the arena
+//
+// waitForOldest - Block until at least the oldest frame is done
+// --------------------------------------------------------
+void ConstantUploadArena::PollFences(bool waitForOldest)
+{
+	UINT64 completed = 0;
+	while (!pendingFences.empty())
+	{
+		FrameFence& oldest = pendingFences.front();
+		if (oldest.Query)
+		{
+			BOOL done = FALSE;
+			UINT flags = waitForOldest ? 0 : D3D11_ASYNC_GETDATA_DONOTFLUSH;
+			HRESULT hr = context1->GetData(oldest.Query.Get(), &done, sizeof(done), flags);
+			while (waitForOldest && hr == S_FALSE)
+				hr = context1->GetData(oldest.Query.Get(), &done, sizeof(done), 0);
+
+			if (hr != S_OK || !done)
+				break;
+		}
+
+		completed = oldest.Value;
+		if (oldest.Query)
+			freeQueries.push_back(oldest.Query);
+		pendingFences.pop_front();
+		waitForOldest = false;
+	}
+
+	if (completed > 0)
+		arena.Retire(completed);
+}
+
+// --------------------------------------------------------
+// An event query for a frame's fence - one a finished frame
+// gave back if there is one, since only as many are ever
+// needed as there are frames in flight
+// --------------------------------------------------------
+Microsoft::WRL::ComPtr<ID3D11Query> ConstantUploadArena::GetQuery()
+{
+	Microsoft::WRL::ComPtr<ID3D11Query> query;
+	if (!freeQueries.empty())
+	{
+		query = freeQueries.back();
+		freeQueries.pop_back();
+		return query;
+	}
+
+	D3D11_QUERY_DESC queryDesc = {};
+	queryDesc.Query = D3D11_QUERY_EVENT;
+	device->CreateQuery(&queryDesc, query.GetAddressOf());
+	return query;
+}
+
+// --------------------------------------------------------
+// Copies a block of constant data into the arena
+//
+// data          - The data to copy
+// size          - Size of the data in bytes
+// firstConstant - Receives the block's offset in shader constants
+// numConstants  - Receives the block's size in shader constants
+//
+// Returns false if the data could not be placed, in which case
+// the caller should fall back to its own constant buffer
+// --------------------------------------------------------
+bool ConstantUploadArena::Upload(const void* data, unsigned int size, unsigned int* firstConstant, unsigned int* numConstants)
+{
+	if (!supported) return false;
+
+	unsigned int offset = arena.Allocate(size);
+
+	// Out of room?  The GPU is probably a few frames behind,
+	// so wait on the oldest frame and try once more
+	if (offset == RingArena::InvalidOffset && !pendingFences.empty())
+	{
+		PollFences(true);
+		offset = arena.Allocate(size);
+	}
+
+	if (offset == RingArena::InvalidOffset)
+		return false;
+
+	// The very first map must discard, everything after that
+	// writes to memory the fences guarantee is no longer in use
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	D3D11_MAP mapType = discarded ? D3D11_MAP_WRITE_NO_OVERWRITE : D3D11_MAP_WRITE_DISCARD;
+	if (FAILED(context1->Map(buffer.Get(), 0, mapType, 0, &mapped)))
+		return false;
+
+	memcpy((unsigned char*)mapped.pData + offset, data, size);
+	context1->Unmap(buffer.Get(), 0);
+	discarded = true;
+
+	*firstConstant = offset / 16;
+	*numConstants = RingArena::AlignUp(size, CONSTANT_BLOCK_ALIGNMENT) / 16;
+	return true;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <d3d11_1.h>
+#include <wrl/client.h>
+#include <deque>
+#include <vector>
+#include "RenderDevice.h"
+#include "RingArena.h"
+
+// --------------------------------------------------------
+// Per-frame upload heap for constant buffer data
+//
+// Owns one large dynamic constant buffer and sub-allocates
+// 256-byte aligned blocks from it with a RingArena.  Blocks
+// are written with WRITE_NO_OVERWRITE and bound by offset
+// (XXSetConstantBuffers1), so shaders no longer need their
+// own tiny buffers updated every draw.
+//
+// Requires D3D 11.1 constant buffer offsetting; check
+// IsSupported() and fall back to regular buffers otherwise.
+// --------------------------------------------------------
+class ConstantUploadArena
+{
+public:
+	ConstantUploadArena(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, unsigned int sizeInBytes);
+	~ConstantUploadArena();
+
+	bool IsSupported() { return supported; }
+
+	// Frame boundaries - call once at the start and end of each frame
+	void BeginFrame();
+	void EndFrame();
+
+	// Copies data into the arena.  On success, firstConstant and
+	// numConstants describe the block in 16-byte shader constants.
+	bool Upload(const void* data, unsigned int size, unsigned int* firstConstant, unsigned int* numConstants);
+
+	//getters
+	ID3D11Buffer* GetBuffer() { return buffer.Get(); }
+	RenderDevice::Handle GetBufferHandle() { return bufferHandle; }
+	RingArena* GetRingArena() { return &arena; }
+
+private:
+	// An event query issued after a frame's last draw, used as
+	// that frame's GPU fence
+	struct FrameFence
+	{
+		UINT64 Value;
+		Microsoft::WRL::ComPtr<ID3D11Query> Query;
+	};
+
+	void PollFences(bool waitForOldest);
+	Microsoft::WRL::ComPtr<ID3D11Query> GetQuery();
+
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext1> context1;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> buffer;
+	RenderDevice::Handle bufferHandle;
+
+	RingArena arena;
+	std::deque<FrameFence> pendingFences;
+	std::vector<Microsoft::WRL::ComPtr<ID3D11Query>> freeQueries;	// Of completed frames, for reuse
+	UINT64 frameFence;
+	bool supported;
+	bool discarded;
+};
@@ -0,0 +1,308 @@
+#include "D3D11RenderDevice.h"
+#include "Graphics.h"
+
+#include "ImGui/imgui.h"
+#include "ImGui/imgui_impl_dx11.h"
+
+D3D11RenderDevice::D3D11RenderDevice()
+{
+	for (uint32_t c = 0; c < MaxChunks; c++)
+		chunks[c].store(0, std::memory_order_relaxed);
+	entryCount = 0;
+
+	// Only needed for binding part of a constant buffer, and
+	// only asked for by those who checked it's available
+	Graphics::Context.As(&context1);
+}
+
+D3D11RenderDevice::~D3D11RenderDevice()
+{
+	for (uint32_t c = 0; c < MaxChunks; c++)
+		delete[] chunks[c].load(std::memory_order_relaxed);
+}
+
+// --------------------------------------------------------
+// Puts an object in the table and returns its handle, or
+// NullHandle if there's no object or no room
+// --------------------------------------------------------
+RenderDevice::Handle D3D11RenderDevice::Add(Microsoft::WRL::ComPtr<ID3D11DeviceChild> object, EntryKind kind, uint8_t subtype, uint32_t size)
+{
+	if (!object)
+		return NullHandle;
+
+	std::lock_guard<std::mutex> lock(tableMutex);
+
+	uint32_t index;
+	if (!freeEntries.empty())
+	{
+		index = freeEntries.back();
+		freeEntries.pop_back();
+	}
+	else
+	{
+		if (entryCount == ChunkSize * MaxChunks)
+			return NullHandle;
+
+		// First entry of a new chunk?  Publish the chunk before
+		// any handle into it can be handed out
+		index = entryCount++;
+		if (index % ChunkSize == 0)
+			chunks[index / ChunkSize].store(new Entry[ChunkSize](), std::memory_order_release);
+	}
+
+	Entry& entry = chunks[index / ChunkSize].load(std::memory_order_relaxed)[index % ChunkSize];
+	entry.Object = object;
+	entry.Size = size;
+	entry.Kind = kind;
+	entry.Subtype = subtype;
+	return index + 1;
+}
+
+D3D11RenderDevice::Entry* D3D11RenderDevice::Find(Handle resource)
+{
+	if (resource == NullHandle || resource > ChunkSize * MaxChunks)
+		return 0;
+
+	uint32_t index = resource - 1;
+	Entry* chunk = chunks[index / ChunkSize].load(std::memory_order_acquire);
+	return chunk ? &chunk[index % ChunkSize] : 0;
+}
+
+RenderDevice::Handle D3D11RenderDevice::CreateBuffer(BufferType type, const void* data, uint32_t size)
+{
+	D3D11_BUFFER_DESC desc = {};
+	desc.ByteWidth = size;
+	desc.CPUAccessFlags = 0;
+	desc.MiscFlags = 0;
+	desc.StructureByteStride = 0;
+	switch (type)
+	{
+	case VertexBuffer:
+		desc.Usage = D3D11_USAGE_IMMUTABLE;
+		desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		break;
+	case IndexBuffer:
+		desc.Usage = D3D11_USAGE_IMMUTABLE;
+		desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+		break;
+	case ConstantBuffer:
+		// Updated in place, and sized in whole 16-byte constants
+		desc.Usage = D3D11_USAGE_DEFAULT;
+		desc.ByteWidth = ((size + 15) / 16) * 16;
+		desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		break;
+	}
+
+	D3D11_SUBRESOURCE_DATA initialData = {};
+	initialData.pSysMem = data;
+
+	Microsoft::WRL::ComPtr<ID3D11Buffer> buffer;
+	{
+		std::lock_guard<std::mutex> lock(creationMutex);
+		if (FAILED(Graphics::Device->CreateBuffer(&desc, data ? &initialData : 0, buffer.GetAddressOf())))
+			return NullHandle;
+	}
+
+	return Add(buffer, BufferEntry, type, size);
+}
+
+RenderDevice::Handle D3D11RenderDevice::CreateShader(ShaderStage stage, const void* bytecode, size_t size)
+{
+	Microsoft::WRL::ComPtr<ID3D11DeviceChild> shader;
+	HRESULT hr = E_INVALIDARG;
+	std::unique_lock<std::mutex> lock(creationMutex);
+	switch (stage)
+	{
+	case VertexStage:
+		hr = Graphics::Device->CreateVertexShader(bytecode, size, 0, (ID3D11VertexShader**)shader.GetAddressOf());
+		break;
+	case PixelStage:
+		hr = Graphics::Device->CreatePixelShader(bytecode, size, 0, (ID3D11PixelShader**)shader.GetAddressOf());
+		break;
+	case DomainStage:
+		hr = Graphics::Device->CreateDomainShader(bytecode, size, 0, (ID3D11DomainShader**)shader.GetAddressOf());
+		break;
+	case HullStage:
+		hr = Graphics::Device->CreateHullShader(bytecode, size, 0, (ID3D11HullShader**)shader.GetAddressOf());
+		break;
+	case GeometryStage:
+		hr = Graphics::Device->CreateGeometryShader(bytecode, size, 0, (ID3D11GeometryShader**)shader.GetAddressOf());
+		break;
+	case ComputeStage:
+		hr = Graphics::Device->CreateComputeShader(bytecode, size, 0, (ID3D11ComputeShader**)shader.GetAddressOf());
+		break;
+	default:
+		break;
+	}
+	lock.unlock();
+
+	if (FAILED(hr))
+		return NullHandle;
+
+	return Add(shader, ShaderEntry, stage, 0);
+}
+
+RenderDevice::Handle D3D11RenderDevice::AdoptBuffer(Microsoft::WRL::ComPtr<ID3D11Buffer> buffer, BufferType type, uint32_t size)
+{
+	return Add(buffer, BufferEntry, type, size);
+}
+
+RenderDevice::Handle D3D11RenderDevice::AdoptShader(ShaderStage stage, Microsoft::WRL::ComPtr<ID3D11DeviceChild> shader)
+{
+	return Add(shader, ShaderEntry, stage, 0);
+}
+
+// --------------------------------------------------------
+// Drops the table's reference and recycles the handle.  The
+// context keeps its own reference to anything still bound.
+// --------------------------------------------------------
+void D3D11RenderDevice::Release(Handle resource)
+{
+	std::lock_guard<std::mutex> lock(tableMutex);
+
+	Entry* entry = Find(resource);
+	if (!entry || entry->Kind == FreeEntry)
+		return;
+
+	entry->Object.Reset();
+	entry->Kind = FreeEntry;
+	freeEntries.push_back(resource - 1);
+}
+
+ID3D11Buffer* D3D11RenderDevice::GetBuffer(Handle buffer)
+{
+	Entry* entry = Find(buffer);
+	if (!entry || entry->Kind != BufferEntry)
+		return 0;
+
+	return static_cast<ID3D11Buffer*>(entry->Object.Get());
+}
+
+ID3D11DeviceChild* D3D11RenderDevice::GetShader(Handle shader)
+{
+	Entry* entry = Find(shader);
+	if (!entry || entry->Kind != ShaderEntry)
+		return 0;
+
+	return entry->Object.Get();
+}
+
+void D3D11RenderDevice::UpdateBuffer(Handle buffer, const void* data, uint32_t size)
+{
+	ID3D11Buffer* native = GetBuffer(buffer);
+	if (!native)
+		return;
+
+	// Constant buffers can only be replaced whole
+	Graphics::Context->UpdateSubresource(native, 0, 0, data, 0, 0);
+}
+
+void D3D11RenderDevice::SetTopology(Topology topology)
+{
+	static const D3D11_PRIMITIVE_TOPOLOGY topologies[] =
+	{
+		D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST,
+		D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP,
+		D3D11_PRIMITIVE_TOPOLOGY_LINELIST,
+		D3D11_PRIMITIVE_TOPOLOGY_POINTLIST,
+	};
+	Graphics::Context->IASetPrimitiveTopology(topologies[topology]);
+}
+
+void D3D11RenderDevice::SetVertexBuffer(Handle buffer, uint32_t stride)
+{
+	ID3D11Buffer* native = GetBuffer(buffer);
+	UINT offset = 0;
+	Graphics::Context->IASetVertexBuffers(0, 1, &native, &stride, &offset);
+}
+
+void D3D11RenderDevice::SetIndexBuffer(Handle buffer)
+{
+	Graphics::Context->IASetIndexBuffer(GetBuffer(buffer), DXGI_FORMAT_R32_UINT, 0);
+}
+
+void D3D11RenderDevice::SetShader(ShaderStage stage, Handle shader)
+{
+	ID3D11DeviceChild* native = GetShader(shader);
+	switch (stage)
+	{
+	case VertexStage:	Graphics::Context->VSSetShader(static_cast<ID3D11VertexShader*>(native), 0, 0); break;
+	case PixelStage:	Graphics::Context->PSSetShader(static_cast<ID3D11PixelShader*>(native), 0, 0); break;
+	case DomainStage:	Graphics::Context->DSSetShader(static_cast<ID3D11DomainShader*>(native), 0, 0); break;
+	case HullStage:		Graphics::Context->HSSetShader(static_cast<ID3D11HullShader*>(native), 0, 0); break;
+	case GeometryStage:	Graphics::Context->GSSetShader(static_cast<ID3D11GeometryShader*>(native), 0, 0); break;
+	case ComputeStage:	Graphics::Context->CSSetShader(static_cast<ID3D11ComputeShader*>(native), 0, 0); break;
+	default: break;
+	}
+}
+
+void D3D11RenderDevice::SetConstantBuffer(ShaderStage stage, uint32_t slot, Handle buffer)
+{
+	ID3D11Buffer* native = GetBuffer(buffer);
+	switch (stage)
+	{
+	case VertexStage:	Graphics::Context->VSSetConstantBuffers(slot, 1, &native); break;
+	case PixelStage:	Graphics::Context->PSSetConstantBuffers(slot, 1, &native); break;
+	case DomainStage:	Graphics::Context->DSSetConstantBuffers(slot, 1, &native); break;
+	case HullStage:		Graphics::Context->HSSetConstantBuffers(slot, 1, &native); break;
+	case GeometryStage:	Graphics::Context->GSSetConstantBuffers(slot, 1, &native); break;
+	case ComputeStage:	Graphics::Context->CSSetConstantBuffers(slot, 1, &native); break;
+	default: break;
+	}
+}
+
+// --------------------------------------------------------
+// Binds by offset with the 11.1 context - only valid where
+// ConstantBufferOffsetting is supported
+// --------------------------------------------------------
+void D3D11RenderDevice::SetConstantBufferRange(ShaderStage stage, uint32_t slot, Handle buffer, uint32_t firstConstant, uint32_t constantCount)
+{
+	if (!context1)
+		return;
+
+	ID3D11Buffer* native = GetBuffer(buffer);
+	UINT first = firstConstant;
+	UINT count = constantCount;
+	switch (stage)
+	{
+	case VertexStage:	context1->VSSetConstantBuffers1(slot, 1, &native, &first, &count); break;
+	case PixelStage:	context1->PSSetConstantBuffers1(slot, 1, &native, &first, &count); break;
+	case DomainStage:	context1->DSSetConstantBuffers1(slot, 1, &native, &first, &count); break;
+	case HullStage:		context1->HSSetConstantBuffers1(slot, 1, &native, &first, &count); break;
+	case GeometryStage:	context1->GSSetConstantBuffers1(slot, 1, &native, &first, &count); break;
+	case ComputeStage:	context1->CSSetConstantBuffers1(slot, 1, &native, &first, &count); break;
+	default: break;
+	}
+}
+
+void D3D11RenderDevice::DrawIndexed(uint32_t indexCount, uint32_t firstIndex, int32_t baseVertex)
+{
+	Graphics::Context->DrawIndexed(indexCount, firstIndex, baseVertex);
+}
+
+void D3D11RenderDevice::Clear(const float color[4], float depth)
+{
+	Graphics::Context->ClearRenderTargetView(Graphics::BackBufferRTV.Get(), color);
+	Graphics::Context->ClearDepthStencilView(Graphics::DepthBufferDSV.Get(), D3D11_CLEAR_DEPTH, depth, 0);
+}
+
+void D3D11RenderDevice::DrawUI(const ImDrawData* drawData)
+{
+	ImGui_ImplDX11_RenderDrawData(const_cast<ImDrawData*>(drawData));
+}
+
+// --------------------------------------------------------
+// Shows the back buffer, then re-binds the back and depth
+// buffers, which the flip model unbinds
+// --------------------------------------------------------
+void D3D11RenderDevice::Present(bool vsync)
+{
+	Graphics::SwapChain->Present(
+		vsync ? 1 : 0,
+		vsync ? 0 : DXGI_PRESENT_ALLOW_TEARING);
+
+	Graphics::Context->OMSetRenderTargets(
+		1,
+		Graphics::BackBufferRTV.GetAddressOf(),
+		Graphics::DepthBufferDSV.Get());
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <d3d11_1.h>
+#include <wrl/client.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "RenderDevice.h"
+
+// --------------------------------------------------------
+// RenderDevice on top of the Graphics:: device, context and
+// swap chain
+//
+// Handles index a table of native objects.  The table grows
+// in fixed chunks that never move, so the drawing thread can
+// look handles up without taking the lock other threads use
+// to create and release resources.
+// --------------------------------------------------------
+class D3D11RenderDevice : public RenderDevice
+{
+public:
+	D3D11RenderDevice();
+	~D3D11RenderDevice();
+
+	Handle CreateBuffer(BufferType type, const void* data, uint32_t size) override;
+	Handle CreateShader(ShaderStage stage, const void* bytecode, size_t size) override;
+	void Release(Handle resource) override;
+
+	void UpdateBuffer(Handle buffer, const void* data, uint32_t size) override;
+	void SetTopology(Topology topology) override;
+	void SetVertexBuffer(Handle buffer, uint32_t stride) override;
+	void SetIndexBuffer(Handle buffer) override;
+	void SetShader(ShaderStage stage, Handle shader) override;
+	void SetConstantBuffer(ShaderStage stage, uint32_t slot, Handle buffer) override;
+	void SetConstantBufferRange(ShaderStage stage, uint32_t slot, Handle buffer, uint32_t firstConstant, uint32_t constantCount) override;
+	void DrawIndexed(uint32_t indexCount, uint32_t firstIndex, int32_t baseVertex) override;
+
+	void Clear(const float color[4], float depth) override;
+	void DrawUI(const ImDrawData* drawData) override;
+	void Present(bool vsync) override;
+
+	// Native objects behind handles, for code still talking to
+	// Direct3D directly (null for the wrong kind of handle)
+	ID3D11Buffer* GetBuffer(Handle buffer);
+	ID3D11DeviceChild* GetShader(Handle shader);
+
+	// Gives an existing native object a handle, keeping a reference
+	Handle AdoptBuffer(Microsoft::WRL::ComPtr<ID3D11Buffer> buffer, BufferType type, uint32_t size);
+	Handle AdoptShader(ShaderStage stage, Microsoft::WRL::ComPtr<ID3D11DeviceChild> shader);
+
+private:
+	enum EntryKind : uint8_t
+	{
+		FreeEntry,
+		BufferEntry,
+		ShaderEntry
+	};
+
+	struct Entry
+	{
+		Microsoft::WRL::ComPtr<ID3D11DeviceChild> Object;
+		uint32_t Size;
+		EntryKind Kind;
+		uint8_t Subtype;		// BufferType or ShaderStage
+	};
+
+	static constexpr uint32_t ChunkSize = 1024;
+	static constexpr uint32_t MaxChunks = 256;
+
+	Handle Add(Microsoft::WRL::ComPtr<ID3D11DeviceChild> object, EntryKind kind, uint8_t subtype, uint32_t size);
+	Entry* Find(Handle resource);
+
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext1> context1;
+
+	// Native object creation, one at a time.  The device would
+	// allow more, but drivers mostly lock internally anyway, and
+	// this way only the work around creation (file reads,
+	// parsing, reflection) runs in parallel at startup.
+	std::mutex creationMutex;
+
+	// Creation and release only - lookups just read the chunks
+	std::mutex tableMutex;
+	std::atomic<Entry*> chunks[MaxChunks];
+	uint32_t entryCount;
+	std::vector<uint32_t> freeEntries;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stddef.h>
+
+// --------------------------------------------------------
+// The draw loop Game::Render() and the headless benchmark
+// both submit with, so the headless run makes the game's
+// uploads, binds and draws in the game's order
+//
+// What each step costs isn't shared: the game sets its
+// SimpleShader variables by name and copies the buffers,
+// while the headless run uploads whole structs straight to
+// the device.  Anything SimpleShader does per draw (such as
+// allocating) only shows up in a windowed --benchmark run,
+// which checks --allocation-budget the same way.
+//
+// The draws are already sorted by material.  Draws supplies,
+// for draw i of count:
+//   SameMaterial(a, b) - whether two draws share material data
+//   SetMaterial(i)     - uploads its material's constants
+//   SetObject(i)       - uploads its per-object constants
+//   SetShaders(i)      - binds its shaders (and their buffers)
+//   Draw(i)            - draws its geometry
+// --------------------------------------------------------
+template<typename Draws>
+void SubmitDraws(const Draws& draws, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		// Material data only needs to go up when the material changes
+		if (i == 0 || !draws.SameMaterial(i - 1, i))
+			draws.SetMaterial(i);
+
+		// Object data is the only thing sent for every draw
+		draws.SetObject(i);
+		draws.SetShaders(i);
+		draws.Draw(i);
+	}
+}
@@ -0,0 +1,222 @@
+#include "EntitySystem.h"
+#include "Transform.h"
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace EntitySystem
+{
+	// Annonymous namespace to hold variables
+	// only accessible in this file
+	namespace
+	{
+		constexpr uint32_t IndexBits = 20;
+		constexpr uint32_t IndexMask = (1u << IndexBits) - 1;
+		constexpr uint32_t GenerationMask = (1u << (32 - IndexBits)) - 1;
+		constexpr uint32_t InvalidIndex = 0xFFFFFFFF;
+
+		// Transforms are kept in chunks of this many, by slot, so
+		// they never move while their entity lives
+		constexpr uint32_t TransformsPerChunk = 1024;
+
+		struct Slot
+		{
+			uint32_t Generation;		// Of the entity in it, or of the next one if free
+			uint32_t Index;				// Into the component arrays, or InvalidIndex if free
+		};
+
+		struct TransformChunk
+		{
+			alignas(Transform) unsigned char Storage[TransformsPerChunk][sizeof(Transform)];
+		};
+
+		// Components, dense - live entities are exactly the first
+		// entities.size() of each
+		std::vector<Entity> entities;
+		std::vector<TransformSystem::Handle> transforms;
+		std::vector<MeshLods> meshes;
+		std::vector<MaterialHandle> materials;
+		std::vector<Bounds> bounds;
+		std::vector<uint32_t> flags;
+
+		// Entity id -> dense index
+		std::vector<Slot> slots;
+		std::vector<uint32_t> freeSlots;
+		std::vector<std::unique_ptr<TransformChunk>> transformChunks;
+
+		uint64_t created = 0;
+		uint64_t destroyed = 0;
+
+		uint32_t SlotOf(Entity entity) { return entity & IndexMask; }
+		uint32_t GenerationOf(Entity entity) { return entity >> IndexBits; }
+
+		Transform* TransformAt(uint32_t slot)
+		{
+			return (Transform*)transformChunks[slot / TransformsPerChunk]->Storage[slot % TransformsPerChunk];
+		}
+
+		uint32_t IndexOf(Entity entity)
+		{
+			return slots[SlotOf(entity)].Index;
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Makes an entity at the end of the component arrays, with
+// a new root transform.  Fails with NullEntity when every
+// slot an id can name is taken, as a further slot's index
+// would run into the generation bits.
+// --------------------------------------------------------
+EntitySystem::Entity EntitySystem::Create()
+{
+	uint32_t slot;
+	if (!freeSlots.empty())
+	{
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else
+	{
+		if (slots.size() > IndexMask)
+			return NullEntity;
+
+		slot = (uint32_t)slots.size();
+		slots.push_back({ 1, InvalidIndex });
+		if (slot % TransformsPerChunk == 0)
+			transformChunks.push_back(std::make_unique<TransformChunk>());
+	}
+
+	Entity entity = (slots[slot].Generation << IndexBits) | slot;
+	slots[slot].Index = (uint32_t)entities.size();
+
+	Transform* transform = new (TransformAt(slot)) Transform();
+	entities.push_back(entity);
+	transforms.push_back(transform->GetHandle());
+	meshes.push_back({});
+	materials.push_back({});
+	bounds.push_back({});
+	flags.push_back(Visible);
+
+	created++;
+	return entity;
+}
+
+// --------------------------------------------------------
+// Destroys an entity and its transform (whose children stay
+// where they are in the world), moving the last entity into
+// its place.  Ids that aren't alive are ignored.
+// --------------------------------------------------------
+void EntitySystem::Destroy(Entity entity)
+{
+	if (!IsAlive(entity))
+		return;
+
+	uint32_t slot = SlotOf(entity);
+	uint32_t index = slots[slot].Index;
+	uint32_t last = (uint32_t)entities.size() - 1;
+	if (index != last)
+	{
+		entities[index] = entities[last];
+		transforms[index] = transforms[last];
+		meshes[index] = meshes[last];
+		materials[index] = materials[last];
+		bounds[index] = bounds[last];
+		flags[index] = flags[last];
+		slots[SlotOf(entities[index])].Index = index;
+	}
+	entities.pop_back();
+	transforms.pop_back();
+	meshes.pop_back();
+	materials.pop_back();
+	bounds.pop_back();
+	flags.pop_back();
+
+	TransformAt(slot)->~Transform();
+
+	// Generation 0 would let a null id match, so it's skipped
+	uint32_t generation = (slots[slot].Generation + 1) & GenerationMask;
+	slots[slot].Generation = generation == 0 ? 1 : generation;
+	slots[slot].Index = InvalidIndex;
+	freeSlots.push_back(slot);
+
+	destroyed++;
+}
+
+bool EntitySystem::IsAlive(Entity entity)
+{
+	uint32_t slot = SlotOf(entity);
+	return entity != NullEntity && slot < slots.size() &&
+		slots[slot].Index != InvalidIndex && slots[slot].Generation == GenerationOf(entity);
+}
+
+// --------------------------------------------------------
+// Makes room for this many entities in all, so creating
+// them doesn't grow the arrays (or the transforms') one
+// step at a time
+// --------------------------------------------------------
+void EntitySystem::Reserve(size_t count)
+{
+	entities.reserve(count);
+	transforms.reserve(count);
+	meshes.reserve(count);
+	materials.reserve(count);
+	bounds.reserve(count);
+	flags.reserve(count);
+	slots.reserve(count);
+	TransformSystem::Reserve(TransformSystem::GetStats().Count + (count > entities.size() ? count - entities.size() : 0));
+}
+
+Transform* EntitySystem::GetTransform(Entity entity)
+{
+	return TransformAt(SlotOf(entity));
+}
+
+void EntitySystem::SetMesh(Entity entity, MeshHandle mesh, const Bounds& localBounds)
+{
+	uint32_t index = IndexOf(entity);
+	meshes[index] = {};
+	meshes[index].Meshes[0] = mesh;
+	meshes[index].Count = 1;
+	bounds[index] = localBounds;
+}
+
+bool EntitySystem::AddLod(Entity entity, MeshHandle mesh)
+{
+	MeshLods& lods = meshes[IndexOf(entity)];
+	if (lods.Count == 0 || lods.Count >= MaxLods)
+		return false;
+	lods.Meshes[lods.Count++] = mesh;
+	return true;
+}
+
+const EntitySystem::MeshLods& EntitySystem::GetMeshes(Entity entity) { return meshes[IndexOf(entity)]; }
+void EntitySystem::SetMaterial(Entity entity, MaterialHandle material) { materials[IndexOf(entity)] = material; }
+MaterialHandle EntitySystem::GetMaterial(Entity entity) { return materials[IndexOf(entity)]; }
+const EntitySystem::Bounds& EntitySystem::GetBounds(Entity entity) { return bounds[IndexOf(entity)]; }
+void EntitySystem::SetFlags(Entity entity, uint32_t newFlags) { flags[IndexOf(entity)] = newFlags; }
+uint32_t EntitySystem::GetFlags(Entity entity) { return flags[IndexOf(entity)]; }
+uint32_t EntitySystem::GetIndex(Entity entity) { return IndexOf(entity); }
+
+EntitySystem::Components EntitySystem::GetComponents()
+{
+	Components components;
+	components.Count = (uint32_t)entities.size();
+	components.Entities = entities.data();
+	components.Transforms = transforms.data();
+	components.Meshes = meshes.data();
+	components.Materials = materials.data();
+	components.LocalBounds = bounds.data();
+	components.Flags = flags.data();
+	return components;
+}
+
+EntitySystem::Stats EntitySystem::GetStats()
+{
+	Stats stats;
+	stats.Count = (unsigned int)entities.size();
+	stats.Slots = (unsigned int)slots.size();
+	stats.Created = created;
+	stats.Destroyed = destroyed;
+	return stats;
+}
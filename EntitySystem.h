@@ -0,0 +1,111 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "RenderQueue.h"
+#include "ResourceHandles.h"
+#include "TransformSystem.h"
+
+class Transform;
+
+// --------------------------------------------------------
+// Owns the data behind every GameEntity
+//
+// Each component is its own tightly packed array - transform
+// handles, meshes (with their LODs), materials, local bounds
+// and flags - with live entities always at the front, so a
+// system walks just the arrays it needs from start to end.
+// Entities are stable ids into a sparse table of slots that
+// point at their place in the arrays.  Destroying one moves
+// the last entity into its place, so creating and destroying
+// are a handful of stores each, whatever the entity count.
+//
+// Ids are a 20-bit slot index and a 12-bit generation that
+// goes up each time the slot is freed, so the id of a
+// destroyed entity is no longer alive even once its slot is
+// reused.  0 is never alive, and is what Create() gives back
+// once every one of the 2^20 slots holds a live entity.
+//
+// Every entity has a Transform, which stays at the same
+// address for as long as the entity lives.
+//
+// Entities are created, destroyed and changed from one thread
+// at a time; any thread may read while none of that happens.
+// GameEntity is a thin owner of one of these ids, so most code
+// never needs to call in here directly.
+// --------------------------------------------------------
+namespace EntitySystem
+{
+	typedef uint32_t Entity;
+	constexpr Entity NullEntity = 0;
+
+	// Meshes an entity can have, full detail first
+	static constexpr uint32_t MaxLods = RenderQueue::MaxLods;
+
+	enum Flag : uint32_t
+	{
+		Visible = 1 << 0,		// Drawn, if in view.  Set on new entities.
+	};
+
+	// Local space, of the full detail mesh
+	struct Bounds
+	{
+		DirectX::XMFLOAT3 Center;
+		DirectX::XMFLOAT3 Extents;
+	};
+
+	struct MeshLods
+	{
+		MeshHandle Meshes[MaxLods];
+		uint32_t Count;					// 0 until a mesh is set
+	};
+
+	// Every component array, in the same order.  Valid until the
+	// next Create() or Destroy().
+	struct Components
+	{
+		uint32_t Count;
+		const Entity* Entities;
+		const TransformSystem::Handle* Transforms;
+		const MeshLods* Meshes;
+		const MaterialHandle* Materials;
+		const Bounds* LocalBounds;
+		const uint32_t* Flags;
+	};
+
+	struct Stats
+	{
+		unsigned int Count;				// Live entities
+		unsigned int Slots;				// Ever used, live or not
+		uint64_t Created;
+		uint64_t Destroyed;
+	};
+
+	// Lifetime - a new entity is visible, at the origin, with no
+	// mesh or material.  NullEntity if there's no slot left.
+	Entity Create();
+	void Destroy(Entity entity);
+	bool IsAlive(Entity entity);
+	void Reserve(size_t count);
+
+	// Components of one entity, which must be alive
+	Transform* GetTransform(Entity entity);
+	void SetMesh(Entity entity, MeshHandle mesh, const Bounds& bounds);		// Full detail, dropping any LODs
+	bool AddLod(Entity entity, MeshHandle mesh);							// False if there are MaxLods already
+	const MeshLods& GetMeshes(Entity entity);
+	void SetMaterial(Entity entity, MaterialHandle material);
+	MaterialHandle GetMaterial(Entity entity);
+	const Bounds& GetBounds(Entity entity);
+	void SetFlags(Entity entity, uint32_t flags);
+	uint32_t GetFlags(Entity entity);
+
+	// Where the entity is in the component arrays, until the next
+	// Destroy()
+	uint32_t GetIndex(Entity entity);
+
+	// For systems walking every entity
+	Components GetComponents();
+
+	Stats GetStats();
+}
@@ -0,0 +1,147 @@
+#include "FrameAllocator.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace FrameAllocator
+{
+	// Annonymous namespace to hold variables
+	// only accessible in this file
+	namespace
+	{
+		struct Block
+		{
+			std::unique_ptr<char[]> Memory;
+			size_t Size;
+		};
+
+		// Blocks are kept when the arena is reset, so once a frame's
+		// worth exist nothing is allocated again
+		struct Arena
+		{
+			std::vector<Block> Blocks;
+			size_t Current = 0;		// Block being bumped through
+			size_t Offset = 0;		// Into that block
+			size_t Used = 0;		// Bytes handed out since the reset
+
+			void Reset()
+			{
+				Current = 0;
+				Offset = 0;
+				Used = 0;
+			}
+		};
+
+		// Only the owning thread allocates from these
+		struct ThreadArenas
+		{
+			Arena Buffers[2];
+		};
+
+		std::mutex threadMutex;
+		std::vector<std::unique_ptr<ThreadArenas>> threads;
+		thread_local ThreadArenas* localArenas = 0;
+
+		// Which of each thread's two arenas this frame uses
+		std::atomic<unsigned int> currentBuffer{ 0 };
+
+		std::atomic<size_t> reservedBytes{ 0 };
+		std::atomic<uint64_t> blocksAdded{ 0 };
+
+		// Main thread only
+		size_t lastFrameBytes = 0;
+		size_t peakFrameBytes = 0;
+
+		ThreadArenas* RegisterThread()
+		{
+			std::lock_guard<std::mutex> lock(threadMutex);
+			threads.push_back(std::make_unique<ThreadArenas>());
+			localArenas = threads.back().get();
+			return localArenas;
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Bumps through the calling thread's arena for this frame,
+// adding a block if what's left is too small
+//
+// size      - Bytes needed
+// alignment - A power of two
+// --------------------------------------------------------
+void* FrameAllocator::Allocate(size_t size, size_t alignment)
+{
+	ThreadArenas* arenas = localArenas ? localArenas : RegisterThread();
+	Arena& arena = arenas->Buffers[currentBuffer.load(std::memory_order_relaxed)];
+
+	while (true)
+	{
+		// Whatever's left of each block in turn
+		while (arena.Current < arena.Blocks.size())
+		{
+			Block& block = arena.Blocks[arena.Current];
+			uintptr_t base = (uintptr_t)block.Memory.get();
+			size_t start = (size_t)(((base + arena.Offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base);
+			if (start + size <= block.Size)
+			{
+				arena.Offset = start + size;
+				arena.Used += size;
+				return block.Memory.get() + start;
+			}
+
+			arena.Current++;
+			arena.Offset = 0;
+		}
+
+		// Out of room - grow by a block big enough for this at least
+		size_t blockSize = std::max(BlockSize, size + alignment);
+		arena.Blocks.push_back({ std::unique_ptr<char[]>(new char[blockSize]), blockSize });
+		reservedBytes.fetch_add(blockSize, std::memory_order_relaxed);
+		blocksAdded.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+// --------------------------------------------------------
+// Notes what this frame used, then switches every thread to
+// its other arena - the one from the frame before - and
+// resets it, so memory from this frame lives one frame more
+// --------------------------------------------------------
+void FrameAllocator::EndFrame()
+{
+	unsigned int finished = currentBuffer.load(std::memory_order_relaxed);
+	unsigned int next = 1 - finished;
+
+	std::lock_guard<std::mutex> lock(threadMutex);
+	size_t used = 0;
+	for (auto& thread : threads)
+	{
+		used += thread->Buffers[finished].Used;
+		thread->Buffers[next].Reset();
+	}
+	lastFrameBytes = used;
+	peakFrameBytes = std::max(peakFrameBytes, used);
+
+	currentBuffer.store(next, std::memory_order_relaxed);
+}
+
+void FrameAllocator::ShutDown()
+{
+	std::lock_guard<std::mutex> lock(threadMutex);
+	threads.clear();
+	localArenas = 0;
+	reservedBytes.store(0);
+	lastFrameBytes = 0;
+}
+
+FrameAllocator::Stats FrameAllocator::GetStats()
+{
+	std::lock_guard<std::mutex> lock(threadMutex);
+	Stats stats = {};
+	stats.FrameBytes = lastFrameBytes;
+	stats.PeakFrameBytes = peakFrameBytes;
+	stats.ReservedBytes = reservedBytes.load(std::memory_order_relaxed);
+	stats.Threads = (unsigned int)threads.size();
+	stats.BlocksAdded = blocksAdded.load(std::memory_order_relaxed);
+	return stats;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// --------------------------------------------------------
+// Scratch memory that lasts a frame or two
+//
+// Each thread bumps a pointer through its own arena, so
+// allocating is a few instructions and never locks or calls
+// the heap once the arenas have grown to fit a frame.
+// Nothing is freed individually: EndFrame() takes everything
+// back at once.
+//
+// Arenas are double-buffered.  Memory allocated during a
+// frame stays valid through the next one as well, and is
+// reused at the end of that - so results one frame builds
+// can still be read while the next is under way (the
+// benchmark's recording does exactly this).
+//
+// Any thread may allocate, but not at the same time as
+// EndFrame(), which the main thread calls between frames.
+// --------------------------------------------------------
+namespace FrameAllocator
+{
+	// Each arena grows in blocks of at least this many bytes
+	static constexpr size_t BlockSize = 256 * 1024;
+
+	struct Stats
+	{
+		size_t FrameBytes;			// Handed out during the last frame, all threads
+		size_t PeakFrameBytes;		// Most in any frame so far
+		size_t ReservedBytes;		// Held in blocks, both buffers, all threads
+		unsigned int Threads;		// That have allocated at least once
+		uint64_t BlocksAdded;		// Times an arena had to grow
+	};
+
+	// Memory from the calling thread's arena, good until the
+	// end of the frame after this one
+	void* Allocate(size_t size, size_t alignment = 16);
+
+	template<typename T>
+	T* Allocate(size_t count) { return (T*)Allocate(count * sizeof(T), alignof(T)); }
+
+	// Main thread, once per frame: the oldest buffer becomes
+	// the one to allocate from
+	void EndFrame();
+
+	// Frees every arena, once no other thread will allocate.
+	// Nothing from them may be used after.
+	void ShutDown();
+
+	Stats GetStats();
+
+	// --------------------------------------------------------
+	// Lets standard containers use the frame's memory
+	//
+	// A container using it has to be rebuilt each frame
+	// (assigning a new, empty one is enough), since its memory
+	// is taken back underneath it; deallocation does nothing.
+	// --------------------------------------------------------
+	template<typename T>
+	struct Allocator
+	{
+		typedef T value_type;
+
+		Allocator() = default;
+		template<typename U> Allocator(const Allocator<U>&) {}
+
+		T* allocate(size_t count) { return FrameAllocator::Allocate<T>(count); }
+		void deallocate(T*, size_t) {}
+
+		template<typename U> bool operator==(const Allocator<U>&) const { return true; }
+		template<typename U> bool operator!=(const Allocator<U>&) const { return false; }
+	};
+
+	template<typename T>
+	using Vector = std::vector<T, Allocator<T>>;
+}
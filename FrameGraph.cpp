@@ -0,0 +1,390 @@
+#include "FrameGraph.h"
+#include "AllocationTracker.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "ImGui/imgui.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace
+{
+	constexpr uint32_t NoTask = ~0u;
+
+	// How quickly the averages follow new frames
+	constexpr double Smoothing = 0.05;
+
+	double NowMilliseconds()
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void AddUnique(std::vector<FrameGraph::TaskId>& list, FrameGraph::TaskId task)
+	{
+		if (std::find(list.begin(), list.end(), task) == list.end())
+			list.push_back(task);
+	}
+}
+
+// --------------------------------------------------------
+// Adds a task to the graph
+//
+// name     - Shown in the UI and in errors
+// function - The work, called with data
+// reads    - Names of the state the task only looks at
+// writes   - Names of the state the task changes
+// flags    - MainThread if it can't run on a worker
+// --------------------------------------------------------
+FrameGraph::TaskId FrameGraph::AddTask(
+	const char* name,
+	TaskFunction function,
+	void* data,
+	std::initializer_list<const char*> reads,
+	std::initializer_list<const char*> writes,
+	TaskFlags flags)
+{
+	Task task = {};
+	task.Name = name;
+	task.Function = function;
+	task.Data = data;
+	task.Flags = flags;
+	task.AllocationTag = AllocationTracker::RegisterTag(name);
+	for (const char* r : reads)
+		task.Reads.push_back(GetResource(r));
+	for (const char* w : writes)
+		task.Writes.push_back(GetResource(w));
+
+	tasks.push_back(task);
+	compiled = false;
+	return (TaskId)(tasks.size() - 1);
+}
+
+void FrameGraph::RunAfter(TaskId task, TaskId dependency)
+{
+	AddUnique(tasks[task].After, dependency);
+	compiled = false;
+}
+
+uint32_t FrameGraph::GetResource(const char* name)
+{
+	for (uint32_t i = 0; i < resources.size(); i++)
+		if (resources[i] == name)
+			return i;
+
+	resources.push_back(name);
+	return (uint32_t)(resources.size() - 1);
+}
+
+// --------------------------------------------------------
+// Works out every task's dependencies and an order to
+// run them in, failing if they loop back on themselves
+// --------------------------------------------------------
+bool FrameGraph::Compile()
+{
+	compiled = false;
+	error.clear();
+	order.clear();
+
+	for (Task& task : tasks)
+	{
+		task.Dependencies = task.After;
+		task.Dependents.clear();
+	}
+
+	// Walk the tasks in the order they were added, tracking
+	// who last wrote each resource and who has read it since
+	std::vector<TaskId> lastWriter(resources.size(), NoTask);
+	std::vector<std::vector<TaskId>> readers(resources.size());
+	for (TaskId t = 0; t < tasks.size(); t++)
+	{
+		Task& task = tasks[t];
+		for (uint32_t r : task.Reads)
+		{
+			if (lastWriter[r] != NoTask)
+				AddUnique(task.Dependencies, lastWriter[r]);
+			readers[r].push_back(t);
+		}
+
+		for (uint32_t w : task.Writes)
+		{
+			if (lastWriter[w] != NoTask && lastWriter[w] != t)
+				AddUnique(task.Dependencies, lastWriter[w]);
+			for (TaskId reader : readers[w])
+				if (reader != t)
+					AddUnique(task.Dependencies, reader);
+			lastWriter[w] = t;
+			readers[w].clear();
+		}
+	}
+
+	for (TaskId t = 0; t < tasks.size(); t++)
+		for (TaskId d : tasks[t].Dependencies)
+			tasks[d].Dependents.push_back(t);
+
+	// Kahn's algorithm - anything never freed up is part of a loop
+	std::vector<uint32_t> waiting(tasks.size());
+	for (TaskId t = 0; t < tasks.size(); t++)
+	{
+		waiting[t] = (uint32_t)tasks[t].Dependencies.size();
+		if (waiting[t] == 0)
+			order.push_back(t);
+	}
+	for (size_t i = 0; i < order.size(); i++)
+		for (TaskId d : tasks[order[i]].Dependents)
+			if (--waiting[d] == 0)
+				order.push_back(d);
+
+	if (order.size() != tasks.size())
+	{
+		// Every stuck task waits on another stuck task, so following
+		// those from any of them has to come back around
+		TaskId t = 0;
+		while (waiting[t] == 0)
+			t++;
+
+		std::vector<TaskId> path;
+		while (std::find(path.begin(), path.end(), t) == path.end())
+		{
+			path.push_back(t);
+			for (TaskId d : tasks[t].Dependencies)
+			{
+				if (waiting[d] != 0)
+				{
+					t = d;
+					break;
+				}
+			}
+		}
+
+		error = "Frame graph cycle: ";
+		for (auto it = std::find(path.begin(), path.end(), t); it != path.end(); ++it)
+			error += tasks[*it].Name + " waits on ";
+		error += tasks[t].Name;
+
+		order.clear();
+		return false;
+	}
+
+	remaining.reset(new std::atomic<int>[tasks.size()]);
+	for (Task& task : tasks)
+	{
+		task.AverageMilliseconds = 0;
+		task.Critical = false;
+	}
+	stats = {};
+	stats.Tasks = (unsigned int)tasks.size();
+	compiled = true;
+	return true;
+}
+
+// --------------------------------------------------------
+// Runs the whole graph once
+//
+// Tasks with nothing left to wait on are queued as jobs, or
+// for this thread if they're main-thread only.  This thread
+// runs its own tasks as they come up and helps with jobs
+// the rest of the time.
+// --------------------------------------------------------
+void FrameGraph::Execute()
+{
+	if (!compiled)
+		return;
+
+	frameStart = NowMilliseconds();
+	finished.store(0, std::memory_order_relaxed);
+	for (TaskId t = 0; t < tasks.size(); t++)
+		remaining[t].store((int)tasks[t].Dependencies.size(), std::memory_order_relaxed);
+
+	for (TaskId t : order)
+		if (tasks[t].Dependencies.empty())
+			Schedule(t);
+
+	while (finished.load(std::memory_order_acquire) < tasks.size())
+	{
+		TaskId next = NoTask;
+		{
+			// Earliest added first, so the main thread's order is stable
+			std::lock_guard<std::mutex> lock(mainQueueMutex);
+			if (!mainQueue.empty())
+			{
+				auto first = std::min_element(mainQueue.begin(), mainQueue.end());
+				next = *first;
+				mainQueue.erase(first);
+			}
+		}
+
+		if (next != NoTask)
+			RunTask(next);
+		else if (!JobSystem::TryRunJob())
+			std::this_thread::yield();
+	}
+
+	stats.FrameMilliseconds = NowMilliseconds() - frameStart;
+	for (Task& task : tasks)
+	{
+		task.Last = task.Current;
+		double elapsed = task.Last.End - task.Last.Start;
+		task.AverageMilliseconds += (elapsed - task.AverageMilliseconds) * Smoothing;
+	}
+	FindCriticalPath();
+}
+
+void FrameGraph::Schedule(TaskId task)
+{
+	if (tasks[task].Flags & MainThread)
+	{
+		std::lock_guard<std::mutex> lock(mainQueueMutex);
+		mainQueue.push_back(task);
+	}
+	else
+	{
+		JobSystem::Run(TaskJob, this, 0, task);
+	}
+}
+
+void FrameGraph::TaskJob(void* data, uint32_t begin, uint32_t)
+{
+	((FrameGraph*)data)->RunTask(begin);
+}
+
+void FrameGraph::RunTask(TaskId id)
+{
+	Task& task = tasks[id];
+	task.Current.Thread = JobSystem::GetThreadIndex();
+	task.Current.Start = NowMilliseconds() - frameStart;
+	{
+		Profiler::Zone zone(task.Name.c_str());
+		AllocationTracker::Tag tag(task.AllocationTag);
+		task.Function(task.Data);
+	}
+	task.Current.End = NowMilliseconds() - frameStart;
+
+	for (TaskId d : task.Dependents)
+		if (remaining[d].fetch_sub(1, std::memory_order_acq_rel) == 1)
+			Schedule(d);
+
+	finished.fetch_add(1, std::memory_order_release);
+}
+
+// --------------------------------------------------------
+// Longest chain through the dependencies, by average task
+// time.  The frame can't be shorter than this however many
+// threads there are, so these are the tasks worth speeding up.
+// --------------------------------------------------------
+void FrameGraph::FindCriticalPath()
+{
+	std::vector<double> finish(tasks.size(), 0.0);
+	std::vector<TaskId> previous(tasks.size(), NoTask);
+	TaskId last = NoTask;
+	for (TaskId t : order)
+	{
+		double start = 0;
+		for (TaskId d : tasks[t].Dependencies)
+		{
+			if (finish[d] > start)
+			{
+				start = finish[d];
+				previous[t] = d;
+			}
+		}
+		finish[t] = start + tasks[t].AverageMilliseconds;
+		if (last == NoTask || finish[t] > finish[last])
+			last = t;
+		tasks[t].Critical = false;
+	}
+
+	stats.CriticalPathMilliseconds = last == NoTask ? 0 : finish[last];
+	stats.CriticalPathTasks = 0;
+	for (TaskId t = last; t != NoTask; t = previous[t])
+	{
+		tasks[t].Critical = true;
+		stats.CriticalPathTasks++;
+	}
+}
+
+// --------------------------------------------------------
+// Shows the last frame as one lane per thread, plus every
+// task's average time and what it waits on.  Critical path
+// tasks are highlighted.
+// --------------------------------------------------------
+void FrameGraph::BuildUI()
+{
+	ImGui::Begin("Frame Graph");
+
+	if (!compiled)
+	{
+		ImGui::TextUnformatted(error.empty() ? "Not compiled" : error.c_str());
+		ImGui::End();
+		return;
+	}
+
+	ImGui::Text("Frame: %.3f ms", stats.FrameMilliseconds);
+	ImGui::Text("Critical path: %.3f ms over %u of %u tasks",
+		stats.CriticalPathMilliseconds, stats.CriticalPathTasks, stats.Tasks);
+
+	// Timeline
+	const ImU32 criticalColor = IM_COL32(220, 90, 60, 255);
+	const ImU32 taskColor = IM_COL32(70, 130, 200, 255);
+	unsigned int lanes = JobSystem::GetThreadCount();
+	float laneHeight = ImGui::GetTextLineHeightWithSpacing();
+	float width = ImGui::GetContentRegionAvail().x;
+	double scale = width / std::max(stats.FrameMilliseconds, 0.001);
+	ImVec2 origin = ImGui::GetCursorScreenPos();
+	ImDrawList* drawList = ImGui::GetWindowDrawList();
+	for (const Task& task : tasks)
+	{
+		const Timing& timing = task.Last;
+		unsigned int lane = timing.Thread < lanes ? timing.Thread : 0;
+		ImVec2 min(origin.x + (float)(timing.Start * scale), origin.y + lane * laneHeight);
+		ImVec2 max(std::max(origin.x + (float)(timing.End * scale), min.x + 1.0f), min.y + laneHeight - 1.0f);
+		drawList->AddRectFilled(min, max, task.Critical ? criticalColor : taskColor);
+
+		// Only label bars that have room for it
+		if (ImGui::CalcTextSize(task.Name.c_str()).x < max.x - min.x)
+			drawList->AddText(min, IM_COL32_WHITE, task.Name.c_str());
+
+		if (ImGui::IsMouseHoveringRect(min, max))
+			ImGui::SetTooltip("%s\n%.3f ms on thread %u", task.Name.c_str(), timing.End - timing.Start, timing.Thread);
+	}
+	ImGui::Dummy(ImVec2(width, lanes * laneHeight));
+
+	// Every task in the order it can run
+	if (ImGui::BeginTable("FrameGraphTasks", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+	{
+		ImGui::TableSetupColumn("Task");
+		ImGui::TableSetupColumn("Thread");
+		ImGui::TableSetupColumn("Average ms");
+		ImGui::TableSetupColumn("Waits on");
+		ImGui::TableHeadersRow();
+
+		for (TaskId t : order)
+		{
+			const Task& task = tasks[t];
+			ImGui::TableNextRow();
+
+			ImGui::TableNextColumn();
+			if (task.Critical)
+				ImGui::TextColored(ImVec4(0.86f, 0.35f, 0.24f, 1.0f), "%s", task.Name.c_str());
+			else
+				ImGui::TextUnformatted(task.Name.c_str());
+
+			ImGui::TableNextColumn();
+			if (task.Flags & MainThread)
+				ImGui::Text("%u (main only)", task.Last.Thread);
+			else
+				ImGui::Text("%u", task.Last.Thread);
+
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3f", task.AverageMilliseconds);
+
+			ImGui::TableNextColumn();
+			std::string waits;
+			for (TaskId d : task.Dependencies)
+				waits += (waits.empty() ? "" : ", ") + tasks[d].Name;
+			ImGui::TextUnformatted(waits.c_str());
+		}
+		ImGui::EndTable();
+	}
+
+	ImGui::End();
+}
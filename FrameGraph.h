@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// A frame's CPU work as a graph of tasks
+//
+// Each task names the state it reads and the state it writes.
+// Compile() turns those into dependencies in the order tasks
+// were added: a reader waits for the last writer before it,
+// and a writer waits for everything before it that touched
+// the same state.  Anything left unordered may run at the
+// same time, on the job system's threads.
+//
+// Tasks that must stay on the main thread (window messages,
+// input, ImGui's frame) are flagged, and Execute() runs them
+// itself while the workers take the rest.
+//
+// Each task's time is recorded so BuildUI() can show where
+// the frame went and which chain of tasks limits it, and each
+// task's heap allocations are counted under its name (see
+// AllocationTracker.h), so names should be string literals.
+// --------------------------------------------------------
+class FrameGraph
+{
+public:
+	typedef void (*TaskFunction)(void* data);
+	typedef uint32_t TaskId;
+
+	enum TaskFlags
+	{
+		AnyThread = 0,
+		MainThread = 1,
+	};
+
+	struct Stats
+	{
+		double FrameMilliseconds;			// Execute() start to finish
+		double CriticalPathMilliseconds;	// Longest chain of dependent tasks
+		unsigned int Tasks;
+		unsigned int CriticalPathTasks;
+	};
+
+	FrameGraph() = default;
+	FrameGraph(const FrameGraph&) = delete;
+	FrameGraph& operator=(const FrameGraph&) = delete;
+
+	TaskId AddTask(
+		const char* name,
+		TaskFunction function,
+		void* data,
+		std::initializer_list<const char*> reads,
+		std::initializer_list<const char*> writes,
+		TaskFlags flags = AnyThread);
+
+	// An extra ordering the resources don't capture
+	void RunAfter(TaskId task, TaskId dependency);
+
+	// False if the dependencies loop - see GetError()
+	bool Compile();
+	const std::string& GetError() const { return error; }
+
+	// Runs every task once, in dependency order.  Call on the
+	// thread that initialized the job system.
+	void Execute();
+
+	Stats GetStats() const { return stats; }
+
+	// Every task's time in the last frame, in the order they were added
+	unsigned int GetTaskCount() const { return (unsigned int)tasks.size(); }
+	const std::string& GetTaskName(TaskId task) const { return tasks[task].Name; }
+	double GetTaskMilliseconds(TaskId task) const { return tasks[task].Last.End - tasks[task].Last.Start; }
+
+	// What Compile() decided, and whether the last frame's critical path ran through a task
+	const std::vector<TaskId>& GetDependencies(TaskId task) const { return tasks[task].Dependencies; }
+	bool IsCritical(TaskId task) const { return tasks[task].Critical; }
+
+	// Task table, timeline and critical path of the last frame
+	void BuildUI();
+
+private:
+	struct Timing
+	{
+		double Start;		// Milliseconds into the frame
+		double End;
+		unsigned int Thread;
+	};
+
+	struct Task
+	{
+		std::string Name;
+		TaskFunction Function;
+		void* Data;
+		TaskFlags Flags;
+		unsigned int AllocationTag;
+		std::vector<uint32_t> Reads;
+		std::vector<uint32_t> Writes;
+		std::vector<TaskId> After;			// From RunAfter()
+		std::vector<TaskId> Dependencies;
+		std::vector<TaskId> Dependents;
+
+		// Written by whichever thread runs the task, and copied to
+		// Last once the frame is done, since the UI is built mid-frame
+		Timing Current;
+		Timing Last;
+
+		// Updated once the frame is done
+		double AverageMilliseconds;
+		bool Critical;
+	};
+
+	uint32_t GetResource(const char* name);
+	void Schedule(TaskId task);
+	void RunTask(TaskId task);
+	void FindCriticalPath();
+	static void TaskJob(void* data, uint32_t begin, uint32_t end);
+
+	std::vector<Task> tasks;
+	std::vector<std::string> resources;
+	std::vector<TaskId> order;		// Topological, from Compile()
+	bool compiled = false;
+	std::string error;
+
+	// Per Execute()
+	std::unique_ptr<std::atomic<int>[]> remaining;
+	std::atomic<uint32_t> finished{ 0 };
+	std::mutex mainQueueMutex;
+	std::vector<TaskId> mainQueue;	// Ready tasks for the main thread
+	double frameStart = 0;
+
+	Stats stats = {};
+};
@@ -0,0 +1,209 @@
+#include "FrameTimes.h"
+#include "ImGui/imgui.h"
+#include <algorithm>
+#include <float.h>
+#include <fstream>
+#include <string>
+
+namespace FrameTimes
+{
+	// Annonymous namespace to hold variables
+	// only accessible in this file
+	namespace
+	{
+		// Frames between percentile refreshes
+		constexpr unsigned int RefreshInterval = 16;
+
+		// Bars in the distribution plot
+		constexpr int HistogramBins = 48;
+
+		float history[HistoryFrames] = {};
+		unsigned int next = 0;			// Where the next frame goes
+		unsigned int count = 0;
+		double sum = 0;					// Of everything in the ring
+		unsigned int overBudget = 0;	// Of everything in the ring
+		uint64_t overBudgetTotal = 0;
+		uint64_t totalFrames = 0;
+		float budget = 1000.0f / 60.0f;
+
+		Stats stats = {};
+		unsigned int framesSinceRefresh = RefreshInterval;
+		float sorted[HistoryFrames];
+		float histogram[HistogramBins];
+		float histogramMax = 0;
+		std::string exportStatus;
+
+		// Value at fraction p of the way through the sorted frames.
+		// Everything before from is already no bigger than anything
+		// after it, so only the rest needs partitioning.
+		float Percentile(unsigned int frames, unsigned int& from, float p)
+		{
+			unsigned int index = (unsigned int)(p * (frames - 1) + 0.5f);
+			std::nth_element(sorted + from, sorted + index, sorted + frames);
+			from = index;
+			return sorted[index];
+		}
+
+		void Refresh()
+		{
+			framesSinceRefresh = 0;
+			stats.Frames = count;
+			stats.OverBudget = overBudget;
+			stats.OverBudgetTotal = overBudgetTotal;
+			stats.TotalFrames = totalFrames;
+			if (count == 0)
+				return;
+
+			// Each percentile only partitions what's above the last
+			std::copy(history, history + count, sorted);
+			unsigned int from = 0;
+			stats.AverageMilliseconds = (float)(sum / count);
+			stats.P50Milliseconds = Percentile(count, from, 0.50f);
+			stats.P95Milliseconds = Percentile(count, from, 0.95f);
+			stats.P99Milliseconds = Percentile(count, from, 0.99f);
+			stats.MaxMilliseconds = *std::max_element(sorted + from, sorted + count);
+
+			// Distribution from zero up to just past the worst frame
+			histogramMax = stats.MaxMilliseconds * 1.05f;
+			std::fill(histogram, histogram + HistogramBins, 0.0f);
+			for (unsigned int i = 0; i < count; i++)
+			{
+				int bin = (int)(history[i] / histogramMax * HistogramBins);
+				histogram[std::min(bin, HistogramBins - 1)]++;
+			}
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Adds one frame, replacing the oldest once the ring is full
+// --------------------------------------------------------
+void FrameTimes::Record(float milliseconds)
+{
+	if (count == HistoryFrames)
+	{
+		float oldest = history[next];
+		sum -= oldest;
+		if (oldest > budget)
+			overBudget--;
+	}
+	else
+	{
+		count++;
+	}
+
+	history[next] = milliseconds;
+	next = (next + 1) % HistoryFrames;
+	sum += milliseconds;
+	totalFrames++;
+	if (milliseconds > budget)
+	{
+		overBudget++;
+		overBudgetTotal++;
+	}
+
+	framesSinceRefresh++;
+}
+
+void FrameTimes::Reset()
+{
+	next = 0;
+	count = 0;
+	sum = 0;
+	overBudget = 0;
+	overBudgetTotal = 0;
+	totalFrames = 0;
+	stats = {};
+	framesSinceRefresh = RefreshInterval;
+}
+
+// --------------------------------------------------------
+// Changes the budget, recounting the frames already kept
+// --------------------------------------------------------
+void FrameTimes::SetBudget(float milliseconds)
+{
+	budget = milliseconds;
+	overBudget = 0;
+	for (unsigned int i = 0; i < count; i++)
+		if (history[i] > budget)
+			overBudget++;
+	framesSinceRefresh = RefreshInterval;
+}
+
+float FrameTimes::GetBudget()
+{
+	return budget;
+}
+
+FrameTimes::Stats FrameTimes::GetStats()
+{
+	if (framesSinceRefresh >= RefreshInterval)
+		Refresh();
+	return stats;
+}
+
+// --------------------------------------------------------
+// Writes the kept frames as CSV
+//
+// path - File to create
+//
+// Returns false if the file couldn't be written
+// --------------------------------------------------------
+bool FrameTimes::WriteCsv(const char* path)
+{
+	std::ofstream out(path);
+	if (!out)
+		return false;
+
+	// Oldest is where the next frame would go, once the ring is full
+	unsigned int first = count == HistoryFrames ? next : 0;
+	uint64_t frameNumber = totalFrames - count;
+	out << "frame,milliseconds,over_budget\n";
+	for (unsigned int i = 0; i < count; i++)
+	{
+		float ms = history[(first + i) % HistoryFrames];
+		out << frameNumber + i << "," << ms << "," << (ms > budget ? 1 : 0) << "\n";
+	}
+	return (bool)out;
+}
+
+// --------------------------------------------------------
+// Percentiles, the recent history (oldest on the left) and
+// how the kept frames are distributed
+// --------------------------------------------------------
+void FrameTimes::BuildUI()
+{
+	Stats s = GetStats();
+
+	ImGui::Begin("Frame Times");
+
+	ImGui::Text("Last %u frames: avg %.2f ms", s.Frames, s.AverageMilliseconds);
+	ImGui::Text("p50 %.2f  p95 %.2f  p99 %.2f  max %.2f ms",
+		s.P50Milliseconds, s.P95Milliseconds, s.P99Milliseconds, s.MaxMilliseconds);
+	ImGui::Text("Over budget: %u recent, %llu of %llu total",
+		s.OverBudget, (unsigned long long)s.OverBudgetTotal, (unsigned long long)s.TotalFrames);
+
+	float budgetMilliseconds = budget;
+	if (ImGui::DragFloat("Budget (ms)", &budgetMilliseconds, 0.1f, 1.0f, 100.0f, "%.2f"))
+		SetBudget(budgetMilliseconds);
+
+	// The plot wraps around the ring by starting at the oldest frame
+	float plotMax = std::max(s.MaxMilliseconds, budget) * 1.1f;
+	unsigned int offset = count == HistoryFrames ? next : 0;
+	ImGui::PlotLines("History", history, (int)count, (int)offset, 0, 0.0f, plotMax, ImVec2(0, 80));
+	ImGui::PlotHistogram("Distribution", histogram, HistogramBins, 0, 0, 0.0f, FLT_MAX, ImVec2(0, 80));
+	ImGui::Text("0 to %.2f ms", histogramMax);
+
+	if (ImGui::Button("Save CSV"))
+		exportStatus = WriteCsv("frametimes.csv") ? "Saved frametimes.csv" : "Couldn't write frametimes.csv";
+	if (!exportStatus.empty())
+	{
+		ImGui::SameLine();
+		ImGui::TextUnformatted(exportStatus.c_str());
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Reset"))
+		Reset();
+
+	ImGui::End();
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+
+// --------------------------------------------------------
+// Rolling record of recent frame times
+//
+// Window::UpdateStats shows a once-a-second average, which
+// hides single slow frames.  This keeps every frame time in
+// a ring so the distribution survives: percentiles, the
+// worst frame and how many frames missed the budget.
+//
+// Recording is one store per frame.  Percentiles need a
+// partial sort, so they're only refreshed every few frames.
+// --------------------------------------------------------
+namespace FrameTimes
+{
+	// Frames kept in the ring
+	constexpr unsigned int HistoryFrames = 1024;
+
+	struct Stats
+	{
+		unsigned int Frames;			// In the ring, up to HistoryFrames
+		float AverageMilliseconds;
+		float P50Milliseconds;
+		float P95Milliseconds;
+		float P99Milliseconds;
+		float MaxMilliseconds;
+		unsigned int OverBudget;		// Frames in the ring over the budget
+		uint64_t OverBudgetTotal;		// ...and since the last Reset()
+		uint64_t TotalFrames;
+	};
+
+	void Record(float milliseconds);
+	void Reset();
+
+	// Frames slower than this count as over budget (default 60fps)
+	void SetBudget(float milliseconds);
+	float GetBudget();
+
+	Stats GetStats();
+
+	// Oldest first, one frame per line
+	bool WriteCsv(const char* path);
+
+	// History plot, distribution and CSV export
+	void BuildUI();
+}
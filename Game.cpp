@@ -5,6 +5,15 @@
 #include "PathHelpers.h"
 #include "Window.h"
 #include "Material.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "RenderStats.h"
+#include "InputLayoutCache.h"
+#include "Startup.h"
+#include "AllocationTracker.h"
+#include "Resources.h"
+#include "EntitySystem.h"
+#include "DrawSubmission.h"
 
 #include "ImGui/imgui.h"
 #include "ImGui/imgui_impl_dx11.h"
@@ -13,6 +22,7 @@
 #include <DirectXMath.h>
 #include <memory>
 #include <math.h>
+#include <string.h>
 
 // Needed for a helper function to load pre-compiled shader files
 #pragma comment(lib, "d3dcompiler.lib")
@@ -21,50 +31,109 @@
 // For the DirectX Math library
 using namespace DirectX;
 
+namespace
+{
+	// Shader variables set on every draw.  Made once, since a name
+	// past the small string buffer (15 characters on MSVC and
+	// libstdc++), like "worldInvTranspose", allocates when a literal
+	// is turned into a std::string.
+	const std::string ColorTintName = "colorTint";
+	const std::string RoughnessName = "roughness";
+	const std::string PerMaterialName = "PerMaterial";
+	const std::string WorldName = "world";
+	const std::string WorldInvTransposeName = "worldInvTranspose";
+	const std::string WorldViewProjectionName = "wvp";
+	const std::string PerObjectName = "PerObject";
+
+	// A snapshot's draws, as SubmitDraws() asks for them
+	struct SnapshotDraws
+	{
+		const std::vector<DrawCommand>& Draws;
+
+		bool SameMaterial(size_t a, size_t b) const { return Draws[a].Source == Draws[b].Source; }
+
+		void SetMaterial(size_t i) const
+		{
+			SimplePixelShader* ps = Draws[i].PixelShader;
+			ps->SetFloat4(ColorTintName, Draws[i].ColorTint);
+			ps->SetFloat(RoughnessName, Draws[i].Roughness);
+			ps->CopyBufferData(PerMaterialName);
+		}
+
+		void SetObject(size_t i) const
+		{
+			SimpleVertexShader* vs = Draws[i].VertexShader;
+			vs->SetMatrix4x4(WorldName, Draws[i].World);
+			vs->SetMatrix4x4(WorldInvTransposeName, Draws[i].WorldInvTranspose);
+			vs->SetMatrix4x4(WorldViewProjectionName, Draws[i].WorldViewProjection);
+			vs->CopyBufferData(PerObjectName);
+		}
+
+		void SetShaders(size_t i) const
+		{
+			Draws[i].VertexShader->SetShader();
+			Draws[i].PixelShader->SetShader();
+		}
+
+		void Draw(size_t i) const { Draws[i].Geometry->Draw(); }
+	};
+}
+
 // --------------------------------------------------------
 // Called once per program, after the window and graphics API
 // are initialized but before the game loop begins
 // --------------------------------------------------------
 void Game::Initialize()
 {
-	// Helper methods for loading shaders, creating some basic
-	// geometry to draw and some simple camera matrices.
-	//  - You'll be expanding and/or replacing these later
-	LoadShaders();
+	// ImGui's context has to exist before its font atlas can be
+	// built alongside everything else.  Its memory is counted
+	// with everything else's, though it doesn't use new.
+	IMGUI_CHECKVERSION();
+	ImGui::SetAllocatorFunctions(
+		[](size_t size, void*) { return AllocationTracker::Allocate(size); },
+		[](void* memory, void*) { AllocationTracker::Free(memory); });
+	ImGui::CreateContext();
+
+	// Shaders, models and the font atlas, all at once
+	LoadAssets();
+
+	// One big arena for every shader's constant data, if the
+	// device can bind constant buffers by offset
+	uploadArena = std::make_shared<ConstantUploadArena>(Graphics::Device, Graphics::Context, 4 * 1024 * 1024);
+	if (uploadArena->IsSupported())
+		ISimpleShader::UploadArena = uploadArena;
+
 	cameras.push_back(std::make_shared<Camera>(DirectX::XMFLOAT3{ 0,6.0,-10.0 }, XM_PIDIV2, 5.0));
 	cameras.push_back(std::make_shared<Camera>(DirectX::XMFLOAT3{ 0,1.0,-1.0 }, XMConvertToRadians(45), 2.0));
 	for (auto& c : cameras)
 	{
 		c->UpdateProjectionMatrix((float)Window::Width() / Window::Height());
 	}
-	
+
 	//materials
-	mat0White = std::make_shared<Material>(XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), 0.5, vertexShader, pixelShader);
-	mat1Red = std::make_shared<Material>(XMFLOAT4(1.0f, 0.0f, 0.0f, 1.0f), 0.5, vertexShader, pixelShader);
-	mat2Blue = std::make_shared<Material>(XMFLOAT4(0.0f, 0.0f, 1.0f, 1.0f), 0.5, vertexShader, pixelShader);
-	mat3Yellow = std::make_shared<Material>(XMFLOAT4(1.0f, 1.0f, 0.0f, 1.0f), 0.5, vertexShader, pixelShader);
-	UVMat = std::make_shared<Material>(XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), 0.5, vertexShader, UVShader);
-	normalMat = std::make_shared<Material>(XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), 0.5, vertexShader, normalShader);
-	fancyMat = std::make_shared<Material>(XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), 0.5, vertexShader, fancyShader);
+	mat0White = Resources::Materials.Create(XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), 0.5, vertexShader, pixelShader);
+	mat1Red = Resources::Materials.Create(XMFLOAT4(1.0f, 0.0f, 0.0f, 1.0f), 0.5, vertexShader, pixelShader);
+	mat2Blue = Resources::Materials.Create(XMFLOAT4(0.0f, 0.0f, 1.0f, 1.0f), 0.5, vertexShader, pixelShader);
+	mat3Yellow = Resources::Materials.Create(XMFLOAT4(1.0f, 1.0f, 0.0f, 1.0f), 0.5, vertexShader, pixelShader);
+	UVMat = Resources::Materials.Create(XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), 0.5, vertexShader, UVShader);
+	normalMat = Resources::Materials.Create(XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), 0.5, vertexShader, normalShader);
+	fancyMat = Resources::Materials.Create(XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), 0.5, vertexShader, fancyShader);
 
 	//lights
 	Light1.Type = LIGHT_TYPE_DIRECTIONAL;
 	Light1.Direction = XMFLOAT3(1.0, 0, 0);
 	Light1.Color = XMFLOAT3(1.0, 0, 0);
 	Light1.Intensity = 5.0;
-	pixelShader->SetData("Light1", &Light1, sizeof(Light));
 
 	Light2.Type = LIGHT_TYPE_DIRECTIONAL;
 	Light2.Direction = XMFLOAT3(-1.0, 0, 0);
 	Light2.Color = XMFLOAT3(0, 1.0, 0);
 	Light2.Intensity = 5.0;
-	pixelShader->SetData("Light2", &Light2, sizeof(Light)); 
 	
 	Light3.Type = LIGHT_TYPE_DIRECTIONAL;
 	Light3.Direction = XMFLOAT3(0, 1.0, 0);
 	Light3.Color = XMFLOAT3(0, 0, 1.0);
 	Light3.Intensity = 3.0;
-	pixelShader->SetData("Light3", &Light3, sizeof(Light));
 
 	PointLight1.Type = LIGHT_TYPE_POINT;
 	PointLight1.Direction = XMFLOAT3(1.0, 0, 0);
@@ -72,7 +141,6 @@ void Game::Initialize()
 	PointLight1.Color = XMFLOAT3(1.0, 1.0, 1.0);
 	PointLight1.Intensity = 8.0;
 	PointLight1.Range = 7.5;
-	pixelShader->SetData("PointLight1", &PointLight1, sizeof(Light));
 
 	PointLight2.Type = LIGHT_TYPE_POINT;
 	PointLight2.Direction = XMFLOAT3(-1.0, 0, 0);
@@ -80,16 +148,16 @@ void Game::Initialize()
 	PointLight2.Color = XMFLOAT3(1.0, 1.0, 1.0);
 	PointLight2.Intensity = 8.0;
 	PointLight2.Range = 7.5;
-	pixelShader->SetData("PointLight2", &PointLight2, sizeof(Light));
 
 	//make the 3d objects
 	CreateGeometry();
 
-	// Initialize ImGui itself & platform/renderer backends
-	IMGUI_CHECKVERSION();
-	ImGui::CreateContext();
-	ImGui_ImplWin32_Init(Window::Handle());
-	ImGui_ImplDX11_Init(Graphics::Device.Get(), Graphics::Context.Get());
+	// Initialize ImGui's platform/renderer backends
+	{
+		Startup::Phase imguiPhase("ImGui backends");
+		ImGui_ImplWin32_Init(Window::Handle());
+		ImGui_ImplDX11_Init(Graphics::Device.Get(), Graphics::Context.Get());
+	}
 	// Pick a style (uncomment one of these 3)
 	ImGui::StyleColorsDark();
 	//ImGui::StyleColorsLight();
@@ -104,8 +172,12 @@ void Game::Initialize()
 		// Tell the input assembler (IA) stage of the pipeline what kind of
 		// geometric primitives (points, lines or triangles) we want to draw.  
 		// Essentially: "What kind of shape should the GPU draw with our vertices?"
-		Graphics::Context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		RenderDevice::Active->SetTopology(RenderDevice::TriangleList);
 	}
+
+	// Everything starts where it was placed, rather than
+	// interpolating in from the origin on the first frame
+	TransformSystem::BeginStep();
 }
 
 
@@ -117,6 +189,11 @@ void Game::Initialize()
 // --------------------------------------------------------
 Game::~Game()
 {
+	// The statics would otherwise keep these alive past Graphics::ShutDown()
+	Resources::Clear();
+	ISimpleShader::UploadArena.reset();
+	InputLayoutCache::Clear();
+
 	// ImGui clean up
 	ImGui_ImplDX11_Shutdown();
 	ImGui_ImplWin32_Shutdown();
@@ -125,62 +202,122 @@ Game::~Game()
 
 
 // --------------------------------------------------------
-// Loads shaders from compiled shader object (.cso) files
-// and also created the Input Layout that describes our 
-// vertex data to the rendering pipeline. 
-// - Input Layout creation is done here because it must 
-//    be verified against vertex shader byte code
-// - We'll have that byte code already loaded below
+// Loads every shader and model and builds the UI's font
+// atlas, each as its own job, so startup waits on the
+// slowest of them rather than all of them in turn.
+// - File reads, reflection, OBJ parsing and rasterizing the
+//   fonts overlap; the render device still makes the GPU
+//   objects one at a time
+// - Input Layouts are made along with the vertex shader,
+//   since they must be verified against its byte code
 // --------------------------------------------------------
-void Game::LoadShaders()
+void Game::LoadAssets()
 {
-	vertexShader = std::make_shared<SimpleVertexShader>(Graphics::Device,
-		Graphics::Context, FixPath(L"VertexShader.cso").c_str());
-	pixelShader = std::make_shared<SimplePixelShader>(Graphics::Device,
-		Graphics::Context, FixPath(L"PixelShader.cso").c_str());
-	UVShader = std::make_shared<SimplePixelShader>(Graphics::Device,
-		Graphics::Context, FixPath(L"uvPS.cso").c_str());
-	normalShader = std::make_shared<SimplePixelShader>(Graphics::Device,
-		Graphics::Context, FixPath(L"normalPS.cso").c_str());
-	fancyShader = std::make_shared<SimplePixelShader>(Graphics::Device,
-		Graphics::Context, FixPath(L"fancyPS.cso").c_str());
+	Startup::Phase phase("Assets");
+
+	struct PixelShaderFile
+	{
+		PixelShaderHandle* Shader;
+		const wchar_t* File;
+		const char* Name;
+	};
+	const PixelShaderFile pixelShaderFiles[] =
+	{
+		{ &pixelShader, L"PixelShader.cso", "PixelShader.cso" },
+		{ &UVShader, L"uvPS.cso", "uvPS.cso" },
+		{ &normalShader, L"normalPS.cso", "normalPS.cso" },
+		{ &fancyShader, L"fancyPS.cso", "fancyPS.cso" },
+	};
+
+	struct ModelFile
+	{
+		MeshHandle* Mesh;
+		const char* File;
+	};
+	const ModelFile modelFiles[] =
+	{
+		{ &sphere, "sphere.obj" },
+		{ &cylinder, "cylinder.obj" },
+		{ &cube, "cube.obj" },
+		{ &helix, "helix.obj" },
+		{ &quad, "quad_double_sided.obj" },
+		{ &singleQuad, "quad.obj" },
+		{ &torus, "torus.obj" },
+	};
+
+	// Vertex shader, pixel shaders, models, then the font atlas
+	const uint32_t pixelShaderCount = sizeof(pixelShaderFiles) / sizeof(pixelShaderFiles[0]);
+	const uint32_t modelCount = sizeof(modelFiles) / sizeof(modelFiles[0]);
+	const uint32_t assetCount = 1 + pixelShaderCount + modelCount + 1;
+
+	JobSystem::ParallelFor(assetCount, 1, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			if (i == 0)
+			{
+				Startup::Phase shaderPhase("VertexShader.cso");
+				vertexShader = Resources::VertexShaders.Create(Graphics::Device,
+					Graphics::Context, FixPath(L"VertexShader.cso").c_str());
+			}
+			else if (i <= pixelShaderCount)
+			{
+				const PixelShaderFile& ps = pixelShaderFiles[i - 1];
+				Startup::Phase shaderPhase(ps.Name);
+				*ps.Shader = Resources::PixelShaders.Create(Graphics::Device,
+					Graphics::Context, FixPath(ps.File).c_str());
+			}
+			else if (i <= pixelShaderCount + modelCount)
+			{
+				const ModelFile& model = modelFiles[i - 1 - pixelShaderCount];
+				Startup::Phase modelPhase(model.File);
+				*model.Mesh = Resources::Meshes.Create(FixPath(std::string("../../Assets/Models/") + model.File).c_str());
+			}
+			else
+			{
+				// Rasterizes the fonts; the DX11 backend just uploads
+				// the result when it creates its objects
+				Startup::Phase fontPhase("Font atlas");
+				unsigned char* pixels;
+				int width, height;
+				ImGui::GetIO().Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+			}
+		}
+	});
+
+	// Keep track of every shader so per-frame data can be sent to each
+	pixelShaders = { pixelShader, UVShader, normalShader, fancyShader };
 }
 
 // --------------------------------------------------------
-// Creates the geometry we're going to draw
+// Creates the entities that draw the loaded meshes
 // --------------------------------------------------------
 void Game::CreateGeometry()
 {
+	Startup::Phase phase("Scene");
 	
-	// making the meshes
+	// placing the meshes LoadAssets() made
 	{
-		sphere = std::make_shared<Mesh>(FixPath("../../Assets/Models/sphere.obj").c_str());
-		entities.push_back(std::make_shared<GameEntity>(sphere, mat0White));
-		entities[0]->GetTransform()->SetPosition(-12.0f, 4.0f, 0.0f);
+		entities.emplace_back(sphere, mat0White);
+		entities[0].GetTransform()->SetPosition(-12.0f, 4.0f, 0.0f);
 
-		cylinder = std::make_shared<Mesh>(FixPath("../../Assets/Models/cylinder.obj").c_str());
-		entities.push_back(std::make_shared<GameEntity>(cylinder, mat0White));
-		entities[1]->GetTransform()->SetPosition(-8.0f, 4.0f, 0.0f);
+		entities.emplace_back(cylinder, mat0White);
+		entities[1].GetTransform()->SetPosition(-8.0f, 4.0f, 0.0f);
 
-		cube = std::make_shared<Mesh>(FixPath("../../Assets/Models/cube.obj").c_str());
-		entities.push_back(std::make_shared<GameEntity>(cube, mat0White));
-		entities[2]->GetTransform()->SetPosition(-4.0f, 4.0f, 0.0f);
+		entities.emplace_back(cube, mat0White);
+		entities[2].GetTransform()->SetPosition(-4.0f, 4.0f, 0.0f);
 
-		helix = std::make_shared<Mesh>(FixPath("../../Assets/Models/helix.obj").c_str());
-		entities.push_back(std::make_shared<GameEntity>(helix, mat0White));
-		entities[3]->GetTransform()->SetPosition(0.0f, 4.0f, 0.0f);
+		entities.emplace_back(helix, mat0White);
+		entities[3].GetTransform()->SetPosition(0.0f, 4.0f, 0.0f);
 
-		quad = std::make_shared<Mesh>(FixPath("../../Assets/Models/quad_double_sided.obj").c_str());
-		entities.push_back(std::make_shared<GameEntity>(quad, mat0White));
-		entities[4]->GetTransform()->SetPosition(4.0f, 4.0f, 0.0f);
+		entities.emplace_back(quad, mat0White);
+		entities[4].GetTransform()->SetPosition(4.0f, 4.0f, 0.0f);
 
-		singleQuad = std::make_shared<Mesh>(FixPath("../../Assets/Models/quad.obj").c_str());
-		entities.push_back(std::make_shared<GameEntity>(singleQuad, mat0White));
-		entities[5]->GetTransform()->SetPosition(8.0f, 4.0f, 0.0f);
+		entities.emplace_back(singleQuad, mat0White);
+		entities[5].GetTransform()->SetPosition(8.0f, 4.0f, 0.0f);
 
-		torus = std::make_shared<Mesh>(FixPath("../../Assets/Models/torus.obj").c_str());
-		entities.push_back(std::make_shared<GameEntity>(torus, mat0White));
-		entities[6]->GetTransform()->SetPosition(12.0f, 4.0f, 0.0f);
+		entities.emplace_back(torus, mat0White);
+		entities[6].GetTransform()->SetPosition(12.0f, 4.0f, 0.0f);
 	}
 
 	//entity declaration example
@@ -193,16 +330,60 @@ void Game::CreateGeometry()
 		//{ XMFLOAT3(+0.1f, +0.0f, +0.0f), red },
 	//};
 	//unsigned int mesh3indices[] = { 0, 2, 1, 2, 3, 1, 2, 4, 3 };
-	//hexagon = std::make_shared<Mesh>(mesh3vertices, 5, mesh3indices, 9);
+	//hexagon = Resources::Meshes.Create(mesh3vertices, 5, mesh3indices, 9);
 
-	//entities.push_back(std::make_shared<GameEntity>(hexagon, mat1Red));
-	//entities[4]->GetTransform()->SetPosition(0.6f, -0.7f, 0.0f);
+	//entities.emplace_back(hexagon, mat1Red);
+	//entities[4].GetTransform()->SetPosition(0.6f, -0.7f, 0.0f);
 
 }
 
 
 
 
+// --------------------------------------------------------
+// Replaces every entity with a benchmark scene's objects,
+// drawn with the meshes and plain colored materials the game
+// already loaded
+// --------------------------------------------------------
+void Game::LoadBenchmarkScene(const std::vector<Benchmark::SceneObject>& scene)
+{
+	MeshHandle models[Benchmark::ModelCount] = { sphere, cylinder, cube, helix, quad, singleQuad, torus };
+	MaterialHandle materials[Benchmark::MaterialCount] = { mat0White, mat1Red, mat2Blue, mat3Yellow };
+
+	entities.clear();
+	entities.reserve(scene.size());
+	EntitySystem::Reserve(scene.size());
+	for (const Benchmark::SceneObject& s : scene)
+	{
+		GameEntity& e = entities.emplace_back(models[s.Shape], materials[s.Material]);
+		e.GetTransform()->SetPosition(s.Position);
+		e.GetTransform()->SetRotation(s.PitchYawRoll);
+		e.GetTransform()->SetScale(s.Scale);
+		if (s.Parent >= 0)
+			e.GetTransform()->SetParent(entities[s.Parent].GetTransform());
+	}
+	benchmarkScene = scene;
+
+	// Start from where everything was placed
+	TransformSystem::BeginStep();
+}
+
+// --------------------------------------------------------
+// Puts the benchmark scene and the active camera where they
+// are at a point in the run.  Nothing depends on earlier
+// frames, so every run of the same build sees the same ones.
+// --------------------------------------------------------
+void Game::SetBenchmarkFrame(float time, const Benchmark::CameraPose& pose)
+{
+	for (size_t i = 0; i < entities.size() && i < benchmarkScene.size(); i++)
+		entities[i].GetTransform()->SetRotation(Benchmark::GetRotation(benchmarkScene[i], time));
+
+	Transform* camera = cameras[activeCamera]->GetTransform();
+	camera->SetPosition(pose.Position);
+	camera->SetRotation(pose.PitchYawRoll);
+}
+
+
 // --------------------------------------------------------
 // Handle resizing to match the new window size
 //  - Eventually, we'll want to update our 3D camera
@@ -218,18 +399,43 @@ void Game::OnResize()
 
 
 // --------------------------------------------------------
-// Update your game here - user input, move objects, AI, etc.
+// Once per rendered frame, before any simulation steps
+//  - Anything that reads per-frame input (mouse deltas, UI)
+//    goes here so it isn't lost on frames without a step
+// --------------------------------------------------------
+void Game::UpdateFrame(float deltaTime, float totalTime)
+{
+	PROFILE_SCOPE("Game::UpdateFrame");
+
+	cameras[activeCamera]->UpdateLook();
+	ImGuiUpdate(deltaTime);
+	BuildUI(deltaTime);
+
+	// Example input checking: Quit if the escape key is pressed
+	if (Input::KeyDown(VK_ESCAPE))
+		Window::Quit();
+}
+
+// --------------------------------------------------------
+// Update your game here - move objects, AI, etc.
+//  - Called at a fixed rate, zero or more times per frame,
+//    so deltaTime is always the same step length
 // --------------------------------------------------------
 void Game::Update(float deltaTime, float totalTime)
 {
+	PROFILE_SCOPE("Game::Update");
+
+	// Remember where everything was so UpdateRenderState() can blend
+	TransformSystem::BeginStep();
+
 	mover.x = mover.x + moveFactor * deltaTime;
 	mover.y = mover.y + moveFactor * deltaTime;
 	if (mover.x >= 1.0f)
 		moveFactor = -moveFactor;
 	else if (mover.x <= -1.0f)
 		moveFactor = -moveFactor;
-	//entities[0]->GetTransform()->SetPosition(mover.x,0.0f,0.0f);
-	//entities[1]->GetTransform()->SetPosition(0.0f, mover.y, 0.0f);
+	//entities[0].GetTransform()->SetPosition(mover.x,0.0f,0.0f);
+	//entities[1].GetTransform()->SetPosition(0.0f, mover.y, 0.0f);
 
 
 	scaler.x = scaler.x + scaleFactor * deltaTime;
@@ -238,22 +444,16 @@ void Game::Update(float deltaTime, float totalTime)
 		scaleFactor = -scaleFactor;
 	else if (scaler.x <= 0.0f)
 		scaleFactor = -scaleFactor;
-	//entities[2]->GetTransform()->SetScale(scaler);
-	//entities[3]->GetTransform()->SetScale(-scaler.x, -scaler.y, scaler.z);
+	//entities[2].GetTransform()->SetScale(scaler);
+	//entities[3].GetTransform()->SetScale(-scaler.x, -scaler.y, scaler.z);
 
 
 	rotator.z = rotator.z + rotateFactor * deltaTime;
 	if (rotator.z >= 6.28319f)
 		rotator.z = 0.0f;
-	//entities[4]->GetTransform()->SetRotation(rotator);
+	//entities[4].GetTransform()->SetRotation(rotator);
 
 	cameras[activeCamera]->Update(deltaTime);
-	ImGuiUpdate(deltaTime);
-	BuildUI(deltaTime);
-
-	// Example input checking: Quit if the escape key is pressed
-	if (Input::KeyDown(VK_ESCAPE))
-		Window::Quit();
 }
 
 // --------------------------------------------------------
@@ -311,26 +511,74 @@ void Game::BuildUI(float deltaTime)
 
 	if (ImGui::CollapsingHeader("Scene Entities")) 
 	{
+		TransformSystem::Stats transformStats = TransformSystem::GetStats();
+		ImGui::Text("Transforms: %u (%u rebuilt last update, %u interpolated)", transformStats.Count, transformStats.LastUpdateCount, transformStats.Interpolated);
+		RenderQueue::Stats queueStats = renderQueue.GetStats();
+		ImGui::Text("Visible: %u of %u (cull %.3f ms, sort %.3f ms on %u threads)",
+			queueStats.Visible, queueStats.Entities, queueStats.CullMilliseconds, queueStats.SortMilliseconds, JobSystem::GetThreadCount());
+
+		//with a render thread the frame should be close to the slower of
+		//the two halves rather than their sum
+		RenderThread::Stats renderStats = RenderThread::GetStats();
+		ImGui::Text("%s: game %.2f ms + render %.2f ms, frame %.2f ms (waited %.2f ms)",
+			renderStats.Threaded ? "Render thread" : "Inline rendering",
+			renderStats.GameMilliseconds, renderStats.RenderMilliseconds,
+			renderStats.FrameMilliseconds, renderStats.WaitMilliseconds);
+
 		for (int i = 0; i < entities.size(); i++)
 		{
 			ImGui::PushID(i);
 			if(ImGui::TreeNode("","Entity %d", i))
 			{
 				ImGui::PushID(i);
-				posi = entities[i]->GetTransform()->GetPosition();
+				posi = entities[i].GetTransform()->GetPosition();
 				if(ImGui::DragFloat3("Position",(&posi.x),0.01f))
 				{
-					entities[i]->GetTransform()->SetPosition(posi);
+					entities[i].GetTransform()->SetPosition(posi);
 				}
-				rota = entities[i]->GetTransform()->GetPitchYawRoll();
+				rota = entities[i].GetTransform()->GetPitchYawRoll();
 				if (ImGui::DragFloat3("Rotation", (&rota.x), 0.01f))
 				{
-					entities[i]->GetTransform()->SetRotation(rota);
+					entities[i].GetTransform()->SetRotation(rota);
 				}
-				scal = entities[i]->GetTransform()->GetScale();
+				scal = entities[i].GetTransform()->GetScale();
 				if (ImGui::DragFloat3("Scale", (&scal.x), 0.01f))
 				{
-					entities[i]->GetTransform()->SetScale(scal);
+					entities[i].GetTransform()->SetScale(scal);
+				}
+				bool visible = entities[i].IsVisible();
+				if (ImGui::Checkbox("Visible", &visible))
+				{
+					entities[i].SetVisible(visible);
+				}
+
+				//attach to another entity, staying where we are in the world
+				Transform* parent = entities[i].GetTransform()->GetParent();
+				int parentIndex = -1;
+				for (int j = 0; j < entities.size(); j++)
+				{
+					if (entities[j].GetTransform() == parent)
+						parentIndex = j;
+				}
+				char parentName[32] = "None";
+				if (parentIndex >= 0)
+					sprintf_s(parentName, "Entity %d", parentIndex);
+				if (ImGui::BeginCombo("Parent", parentName))
+				{
+					if (ImGui::Selectable("None", parentIndex < 0))
+						entities[i].GetTransform()->SetParent(nullptr, true);
+					for (int j = 0; j < entities.size(); j++)
+					{
+						//can't parent to ourselves or anything below us
+						Transform* candidate = entities[j].GetTransform();
+						if (j == i || entities[i].GetTransform()->IsAncestorOf(candidate))
+							continue;
+
+						sprintf_s(parentName, "Entity %d", j);
+						if (ImGui::Selectable(parentName, parentIndex == j))
+							entities[i].GetTransform()->SetParent(candidate, true);
+					}
+					ImGui::EndCombo();
 				}
 				ImGui::TreePop();
 				ImGui::PopID();
@@ -350,46 +598,53 @@ void Game::BuildUI(float deltaTime)
 	{
 		if (ImGui::TreeNode("Light 1"))
 		{
-			if (ImGui::ColorEdit4("Light 1 Color", lightcolor1))
-			{
-				pixelShader->SetData("Light1", &Light1, sizeof(Light));
-			}
+			ImGui::ColorEdit4("Light 1 Color", lightcolor1);
 			ImGui::TreePop();
 		}
 		if (ImGui::TreeNode("Light 2"))
 		{
-			if (ImGui::ColorEdit4("Light 2 Color", lightcolor2))
-			{
-				pixelShader->SetData("Light2", &Light2, sizeof(Light));
-			}
+			ImGui::ColorEdit4("Light 2 Color", lightcolor2);
 			ImGui::TreePop();
 		}
 		if (ImGui::TreeNode("Light 3"))
 		{
-			if (ImGui::ColorEdit4("Light 3 Color", lightcolor3))
-			{
-				pixelShader->SetData("Light3", &Light3, sizeof(Light));
-			}
+			ImGui::ColorEdit4("Light 3 Color", lightcolor3);
 			ImGui::TreePop();
 		}
 		if (ImGui::TreeNode("Light 4"))
 		{
-			if (ImGui::ColorEdit4("Light 4 Color", lightcolor4))
-			{
-				pixelShader->SetData("PointLight1", &PointLight1, sizeof(Light));
-			}
+			ImGui::ColorEdit4("Light 4 Color", lightcolor4);
 			ImGui::TreePop();
 		}
 		if (ImGui::TreeNode("Light 5"))
 		{
-			if (ImGui::ColorEdit4("Light 5 Color", lightcolor5))
-			{
-				pixelShader->SetData("PointLight2", &PointLight2, sizeof(Light));
-			}
+			ImGui::ColorEdit4("Light 5 Color", lightcolor5);
 			ImGui::TreePop();
 		}
 	}
 
+	if (ImGui::CollapsingHeader("Shader Caches"))
+	{
+		int cachedReflections = 0;
+		for (PixelShaderHandle ps : pixelShaders)
+			cachedReflections += Resources::PixelShaders.Get(ps)->IsReflectionCached() ? 1 : 0;
+		cachedReflections += Resources::VertexShaders.Get(vertexShader)->IsReflectionCached() ? 1 : 0;
+
+		InputLayoutCache::Stats layoutStats = InputLayoutCache::GetStats();
+		ImGui::Text("Reflection loaded from cache: %d / %d shaders", cachedReflections, (int)pixelShaders.size() + 1);
+		ImGui::SeparatorText("Input Layouts");
+		ImGui::BulletText("Unique layouts : %u", layoutStats.UniqueLayouts);
+		ImGui::BulletText("Cache hits : %u / %u", layoutStats.Hits, layoutStats.Requests);
+		ImGui::BulletText("Binds skipped : %u / %u", layoutStats.RedundantBinds, layoutStats.Binds);
+	}
+
+	if (ImGui::CollapsingHeader("Resources"))
+	{
+		Resources::BuildUI();
+		EntitySystem::Stats entityStats = EntitySystem::GetStats();
+		ImGui::BulletText("Entities : %u live, %u slots", entityStats.Count, entityStats.Slots);
+	}
+
 	if(ImGui::CollapsingHeader("Cameras"))
 	{
 		ImGui::Text("Current Camera: %i",activeCamera+1);
@@ -420,72 +675,198 @@ void Game::BuildUI(float deltaTime)
 
 
 // --------------------------------------------------------
-// Clear the screen, redraw everything, present to the user
+// Drawing a frame is split into stages so the frame graph
+// can overlap them: the UI's triangles only depend on the UI,
+// so they're built while visibility runs on the workers.
+// Once all of them are done, Main submits the snapshot.
+// --------------------------------------------------------
+
+// --------------------------------------------------------
+// Render state
+// - Rebuild everything that moved, then blend it between the
+//   last two simulation steps for this point in time
+// --------------------------------------------------------
+void Game::UpdateRenderState(float interpolation)
+{
+	PROFILE_SCOPE("Game::UpdateRenderState");
+
+	TransformSystem::Interpolate(interpolation);
+	cameras[activeCamera]->UpdateViewMatrix();
+}
+
+// --------------------------------------------------------
+// Visibility
+// - Gather matrices, cull, pick LODs and sort, spread across
+//   every core, leaving just a sorted list of draws
+// --------------------------------------------------------
+void Game::BuildVisibility()
+{
+	PROFILE_SCOPE("Game::BuildVisibility");
+
+	// Only entities that are visible and have something to draw -
+	// a quick walk over two packed arrays
+	EntitySystem::Components entity = EntitySystem::GetComponents();
+	renderEntities.clear();
+	for (uint32_t i = 0; i < entity.Count; i++)
+	{
+		if ((entity.Flags[i] & EntitySystem::Visible) && entity.Meshes[i].Count > 0)
+			renderEntities.push_back(i);
+	}
+
+	// The queue only sees ids, bounds and transforms
+	renderObjects.resize(renderEntities.size());
+	JobSystem::ParallelFor((uint32_t)renderEntities.size(), 512, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			uint32_t e = renderEntities[i];
+			const EntitySystem::MeshLods& lods = entity.Meshes[e];
+			RenderQueue::Object& o = renderObjects[i];
+			o.Transform = entity.Transforms[e];
+			o.BoundsCenter = entity.LocalBounds[e].Center;
+			o.BoundsExtents = entity.LocalBounds[e].Extents;
+			o.MaterialId = Resources::Materials.Get(entity.Materials[e])->GetId();
+			o.LodCount = lods.Count;
+			for (uint32_t lod = 0; lod < o.LodCount; lod++)
+				o.MeshIds[lod] = Resources::Meshes.Get(lods.Meshes[lod])->GetId();
+		}
+	});
+
+	XMFLOAT4X4 view = cameras[activeCamera]->GetViewMatrix();
+	XMFLOAT4X4 proj = cameras[activeCamera]->GetProjectionMatrix();
+	renderQueue.Build(renderObjects.data(), (uint32_t)renderObjects.size(), XMLoadFloat4x4(&view), XMLoadFloat4x4(&proj));
+}
+
+// --------------------------------------------------------
+// Snapshot
+// - Copy out everything Render() needs, since the game
+//   thread moves on to the next frame while it draws
+// --------------------------------------------------------
+void Game::FillSnapshot()
+{
+	PROFILE_SCOPE("Game::FillSnapshot");
+
+	FrameSnapshot& frame = RenderThread::BeginFrame();
+
+	memcpy(frame.ClearColor, color, sizeof(frame.ClearColor));
+	frame.ScreenWidth = (float)Window::Width();
+	frame.ScreenHeight = (float)Window::Height();
+	const XMFLOAT4X4A& cameraWorld = TransformSystem::GetRenderWorldMatrix(cameras[activeCamera]->GetTransform()->GetHandle());
+	frame.CameraPosition = XMFLOAT3(cameraWorld._41, cameraWorld._42, cameraWorld._43);
+	frame.AmbientColor = ambientColor;
+	frame.Light1 = Light1;
+	frame.Light2 = Light2;
+	frame.Light3 = Light3;
+	frame.PointLight1 = PointLight1;
+	frame.PointLight2 = PointLight2;
+
+	const RenderQueue::ItemList& items = renderQueue.GetItems();
+	EntitySystem::Components entity = EntitySystem::GetComponents();
+	frame.Draws.resize(items.size());
+	for (size_t d = 0; d < items.size(); d++)
+	{
+		uint32_t i = items[d].Entity;
+		uint32_t e = renderEntities[i];
+		Material* mat = Resources::Materials.Get(entity.Materials[e]);
+
+		DrawCommand& draw = frame.Draws[d];
+		draw.World = renderQueue.GetWorldMatrix(i);
+		draw.WorldInvTranspose = renderQueue.GetWorldInverseTransposeMatrix(i);
+		draw.WorldViewProjection = renderQueue.GetWorldViewProjectionMatrix(i);
+		draw.Geometry = Resources::Meshes.Get(entity.Meshes[e].Meshes[items[d].Lod]);
+		draw.Source = mat;
+		draw.VertexShader = mat->GetVertexShader();
+		draw.PixelShader = mat->GetPixelShader();
+		draw.ColorTint = mat->GetColorTint();
+		draw.Roughness = mat->GetRoughness();
+	}
+}
+
+// --------------------------------------------------------
+// Turns this frame's UI into renderable triangles and copies
+// them into the snapshot.  Must run on the ImGui thread.
 // --------------------------------------------------------
-void Game::Draw(float deltaTime, float totalTime)
+void Game::FinishUI()
 {
+	PROFILE_SCOPE("Game::FinishUI");
+
+	ImGui::Render();
+	RenderThread::BeginFrame().CopyUI(ImGui::GetDrawData());
+}
+
+// --------------------------------------------------------
+// Draws one frame from its snapshot
+//  - Called on the render thread, so everything here may only
+//    use the snapshot, the shaders and the graphics API
+// --------------------------------------------------------
+void Game::Render(const FrameSnapshot& frame)
+{
+	PROFILE_SCOPE("Game::Render");
+
 	// Frame START
 	// - These things should happen ONCE PER FRAME
-	// - At the beginning of Game::Draw() before drawing *anything*
+	// - At the beginning of Game::Render() before drawing *anything*
 	{
+		// Reclaim constant data from frames the GPU has finished
+		uploadArena->BeginFrame();
+
+		// Don't trust last frame's input layout to still be set
+		InputLayoutCache::InvalidateBoundLayout();
+
 		// Clear the back buffer (erase what's on screen) and depth buffer
-		Graphics::Context->ClearRenderTargetView(Graphics::BackBufferRTV.Get(),	color);
-		Graphics::Context->ClearDepthStencilView(Graphics::DepthBufferDSV.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
+		RenderDevice::Active->Clear(frame.ClearColor, 1.0f);
 	}
 
-	// DRAW geometry
-	// - These steps are generally repeated for EACH object you draw
-	// - Other Direct3D calls will also be necessary to do more complex things
+	// Per-frame data
+	// - Camera, lights and screen size are the same for every
+	//   object, so each shader gets them exactly once per frame
 	{
-		//goes through all entities
-		for(auto& e : entities)
+		for (PixelShaderHandle handle : pixelShaders)
 		{
-			//filling external data struct
-			// /this is the constant buffer!
-			std::shared_ptr<SimpleVertexShader> vs = e->GetMaterial()->GetVertexShader();
-			vs->SetMatrix4x4("world", e->GetTransform()->GetWorldMatrix()); 
-			vs->SetMatrix4x4("worldInvTranspose", e->GetTransform()->GetWorldInverseTransposeMatrix());
-			vs->SetMatrix4x4("view", cameras[activeCamera]->GetViewMatrix());
-			vs->SetMatrix4x4("projection", cameras[activeCamera]->GetProjectionMatrix());
-
-			std::shared_ptr<SimplePixelShader> ps = e->GetMaterial()->GetPixelShader();
-			ps->SetFloat4("colorTint", e->GetMaterial()->GetColorTint());
+			SimplePixelShader* ps = Resources::PixelShaders.Get(handle);
+
 			//Fancy Shader
-			ps->SetFloat("screenWidth", (float)Window::Width());
-			ps->SetFloat("screenHeight", (float)Window::Height());
+			ps->SetFloat("screenWidth", frame.ScreenWidth);
+			ps->SetFloat("screenHeight", frame.ScreenHeight);
 			//Lighting
-			ps->SetFloat("roughness", e->GetMaterial()->GetRoughness());
-			ps->SetFloat3("cameraPos", cameras[activeCamera]->GetTransform()->GetPosition());
-			ps->SetFloat3("ambient", ambientColor);
-
-			//Copy the data to the GPU
-			vs->CopyAllBufferData();
-			ps->CopyAllBufferData();
-
-			//draw the shape
-			e->Draw();
-
+			ps->SetFloat3("cameraPos", frame.CameraPosition);
+			ps->SetFloat3("ambient", frame.AmbientColor);
+			ps->SetData("Light1", &frame.Light1, sizeof(Light));
+			ps->SetData("Light2", &frame.Light2, sizeof(Light));
+			ps->SetData("Light3", &frame.Light3, sizeof(Light));
+			ps->SetData("PointLight1", &frame.PointLight1, sizeof(Light));
+			ps->SetData("PointLight2", &frame.PointLight2, sizeof(Light));
+			ps->CopyBufferData("PerFrame");
 		}
 	}
 
-	ImGui::Render(); // Turns this frames UI into renderable triangles
-	ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData()); // Draws it to the screen
+	// DRAW geometry
+	// - These steps are generally repeated for EACH object you draw
+	// - The visible entities are already sorted by material, and
+	//   the benchmark submits them with the same loop
+	SubmitDraws(SnapshotDraws{ frame.Draws }, frame.Draws.size());
+
+	// Draws the UI copied from this frame
+	RenderDevice::Active->DrawUI(&frame.UI);
 
 	// Frame END
 	// - These should happen exactly ONCE PER FRAME
 	// - At the very end of the frame (after drawing *everything*)
 	{
-		// Present at the end of the frame
-		bool vsync = Graphics::VsyncState();
-		Graphics::SwapChain->Present(
-			vsync ? 1 : 0,
-			vsync ? 0 : DXGI_PRESENT_ALLOW_TEARING);
-
-		// Re-bind back buffer and depth buffer after presenting
-		Graphics::Context->OMSetRenderTargets(
-			1,
-			Graphics::BackBufferRTV.GetAddressOf(),
-			Graphics::DepthBufferDSV.Get());
+		// Present at the end of the frame (this also re-binds
+		// the back buffer and depth buffer afterwards)
+		RenderDevice::Active->Present(Graphics::VsyncState());
+
+		// Fence this frame's constant data
+		uploadArena->EndFrame();
+
+#if defined(DEBUG) || defined(_DEBUG)
+		// Print any graphics debug messages that occurred this frame
+		Graphics::PrintDebugMessages();
+#endif
+
+		// Close off this frame's draw, bind and upload counts
+		RenderStats::EndFrame();
 	}
 }
 
@@ -8,7 +8,11 @@
 #include "GameEntity.h"
 #include "Camera.h"
 #include "SimpleShader.h"
+#include "ConstantUploadArena.h"
 #include "Lights.h"
+#include "RenderQueue.h"
+#include "RenderThread.h"
+#include "Benchmark.h"
 
 class Game
 {
@@ -21,16 +25,27 @@ public:
 
 	// Primary functions
 	void Initialize();
+	void UpdateFrame(float deltaTime, float totalTime);
 	void Update(float deltaTime, float totalTime);
 	void ImGuiUpdate(float deltaTime);
 	void BuildUI(float deltaTime);
-	void Draw(float deltaTime, float totalTime);
+	void UpdateRenderState(float interpolation);
+	void BuildVisibility();
+	void FillSnapshot();
+	void FinishUI();
+	void Render(const FrameSnapshot& frame);
 	void OnResize();
 
+	// Benchmark runs - swap the entities for a benchmark scene, then
+	// place it and the camera each frame from the run's clock
+	void LoadBenchmarkScene(const std::vector<Benchmark::SceneObject>& scene);
+	void SetBenchmarkFrame(float time, const Benchmark::CameraPose& pose);
+	const RenderQueue& GetRenderQueue() const { return renderQueue; }
+
 private:
 
 	// Initialization helper methods - feel free to customize, combine, remove, etc.
-	void LoadShaders();
+	void LoadAssets();
 	void CreateGeometry();
 
 	// Note the usage of ComPtr below
@@ -39,8 +54,9 @@ private:
 	//  - More info here: https://github.com/Microsoft/DirectXTK/wiki/ComPtr
 
 	// Shaders and shader-related constructs
-	std::shared_ptr<SimplePixelShader> pixelShader;
-	std::shared_ptr<SimpleVertexShader> vertexShader;
+	PixelShaderHandle pixelShader;
+	VertexShaderHandle vertexShader;
+	std::shared_ptr<ConstantUploadArena> uploadArena;
 
 	float color[4] = { 0.4f, 0.6f, 0.75f, 0.0f };
 	bool demoVis = false;
@@ -52,45 +68,56 @@ private:
 	float offset[3] = { 0.25f, 0.0f, 0.0f };
 	
 
-	//Meshes
-	std::shared_ptr<Mesh> sphere;
-	std::shared_ptr<Mesh> cylinder;
-	std::shared_ptr<Mesh> helix;
-	std::shared_ptr<Mesh> quad;
-	std::shared_ptr<Mesh> singleQuad;
-	std::shared_ptr<Mesh> cube;
-	std::shared_ptr<Mesh> torus; 
-	std::shared_ptr<Mesh> sphere2;
-	std::shared_ptr<Mesh> cylinder2;
-	std::shared_ptr<Mesh> helix2;
-	std::shared_ptr<Mesh> quad2;
-	std::shared_ptr<Mesh> singleQuad2;
-	std::shared_ptr<Mesh> cube2;
-	std::shared_ptr<Mesh> torus2; 
-	std::shared_ptr<Mesh> sphere3;
-	std::shared_ptr<Mesh> cylinder3;
-	std::shared_ptr<Mesh> helix3;
-	std::shared_ptr<Mesh> quad3;
-	std::shared_ptr<Mesh> singleQuad3;
-	std::shared_ptr<Mesh> cube3;
-	std::shared_ptr<Mesh> torus3;
+	//Meshes, shaders and materials - handles into Resources'
+	//pools, which own them
+	MeshHandle sphere;
+	MeshHandle cylinder;
+	MeshHandle helix;
+	MeshHandle quad;
+	MeshHandle singleQuad;
+	MeshHandle cube;
+	MeshHandle torus; 
+	MeshHandle sphere2;
+	MeshHandle cylinder2;
+	MeshHandle helix2;
+	MeshHandle quad2;
+	MeshHandle singleQuad2;
+	MeshHandle cube2;
+	MeshHandle torus2; 
+	MeshHandle sphere3;
+	MeshHandle cylinder3;
+	MeshHandle helix3;
+	MeshHandle quad3;
+	MeshHandle singleQuad3;
+	MeshHandle cube3;
+	MeshHandle torus3;
 
 	//shaders
-	std::shared_ptr<SimplePixelShader> UVShader;
-	std::shared_ptr<SimplePixelShader> normalShader;
-	std::shared_ptr<SimplePixelShader> fancyShader;
+	PixelShaderHandle UVShader;
+	PixelShaderHandle normalShader;
+	PixelShaderHandle fancyShader;
+	std::vector<PixelShaderHandle> pixelShaders;
 
 	//materials
-	std::shared_ptr<Material> mat0White;
-	std::shared_ptr<Material> mat1Red;
-	std::shared_ptr<Material> mat2Blue;
-	std::shared_ptr<Material> mat3Yellow;
-	std::shared_ptr<Material> UVMat;
-	std::shared_ptr<Material> normalMat;
-	std::shared_ptr<Material> fancyMat;
-
-	//entities
-	std::vector<std::shared_ptr<GameEntity>> entities;
+	MaterialHandle mat0White;
+	MaterialHandle mat1Red;
+	MaterialHandle mat2Blue;
+	MaterialHandle mat3Yellow;
+	MaterialHandle UVMat;
+	MaterialHandle normalMat;
+	MaterialHandle fancyMat;
+
+	//entities, in the order they were made - their data is in the EntitySystem
+	std::vector<GameEntity> entities;
+
+	//what each entity is doing, when a benchmark scene is loaded
+	std::vector<Benchmark::SceneObject> benchmarkScene;
+
+	//visible entities and their matrices, rebuilt each frame in BuildVisibility(),
+	//with where each one is in the EntitySystem's arrays
+	std::vector<RenderQueue::Object> renderObjects;
+	std::vector<uint32_t> renderEntities;
+	RenderQueue renderQueue;
 
 	//transform stuff
 	DirectX::XMFLOAT3 mover = { 0.0f, 0.0f, 0.0f };
@@ -1,38 +1,122 @@
 #include "GameEntity.h"
+#include "Resources.h"
 
-GameEntity::GameEntity(std::shared_ptr<Mesh> mesh,std::shared_ptr<Material> mat)
+//constructor - an entity with nothing to draw yet
+GameEntity::GameEntity()
 {
-    entityMesh = mesh;
-    entityMaterial = mat;
+    entity = EntitySystem::Create();
 }
 
+GameEntity::GameEntity(MeshHandle mesh, MaterialHandle mat)
+{
+    entity = EntitySystem::Create();
+
+    //culling reads the bounds straight from the entity
+    EntitySystem::Bounds bounds = {};
+    if (Mesh* m = Resources::Meshes.Get(mesh))
+    {
+        bounds.Center = m->GetBoundsCenter();
+        bounds.Extents = m->GetBoundsExtents();
+    }
+    EntitySystem::SetMesh(entity, mesh, bounds);
+    EntitySystem::SetMaterial(entity, mat);
+}
+
+//destructor - the entity (and its transform) goes too
 GameEntity::~GameEntity()
 {
+    EntitySystem::Destroy(entity);
 }
 
-std::shared_ptr<Mesh> GameEntity::GetMesh()
+GameEntity::GameEntity(GameEntity&& other) noexcept
 {
-    return entityMesh;
+    entity = other.entity;
+    other.entity = EntitySystem::NullEntity;
+}
+
+GameEntity& GameEntity::operator=(GameEntity&& other) noexcept
+{
+    if (this != &other)
+    {
+        EntitySystem::Destroy(entity);
+        entity = other.entity;
+        other.entity = EntitySystem::NullEntity;
+    }
+    return *this;
+}
+
+Mesh* GameEntity::GetMesh()
+{
+    return Resources::Meshes.Get(EntitySystem::GetMeshes(entity).Meshes[0]);
+}
+
+//lods past the last one fall back to the lowest detail mesh
+Mesh* GameEntity::GetMesh(unsigned int lod)
+{
+    const EntitySystem::MeshLods& lods = EntitySystem::GetMeshes(entity);
+    if (lods.Count == 0)
+        return 0;
+    if (lod >= lods.Count)
+        lod = lods.Count - 1;
+    return Resources::Meshes.Get(lods.Meshes[lod]);
+}
+
+unsigned int GameEntity::GetLodCount()
+{
+    unsigned int count = EntitySystem::GetMeshes(entity).Count;
+    return count > 0 ? count : 1;
 }
 
 Transform* GameEntity::GetTransform()
 {
-    return &entityTransform;
+    return EntitySystem::GetTransform(entity);
+}
+
+Material* GameEntity::GetMaterial()
+{
+    return Resources::Materials.Get(EntitySystem::GetMaterial(entity));
+}
+
+MeshHandle GameEntity::GetMeshHandle()
+{
+    return EntitySystem::GetMeshes(entity).Meshes[0];
+}
+
+MaterialHandle GameEntity::GetMaterialHandle()
+{
+    return EntitySystem::GetMaterial(entity);
+}
+
+EntitySystem::Entity GameEntity::GetEntity()
+{
+    return entity;
+}
+
+bool GameEntity::IsVisible()
+{
+    return (EntitySystem::GetFlags(entity) & EntitySystem::Visible) != 0;
+}
+
+void GameEntity::SetMaterial(MaterialHandle mat)
+{
+    EntitySystem::SetMaterial(entity, mat);
 }
 
-std::shared_ptr<Material> GameEntity::GetMaterial()
+void GameEntity::AddLod(MeshHandle mesh)
 {
-    return entityMaterial;
+    EntitySystem::AddLod(entity, mesh);
 }
 
-void GameEntity::SetMaterial(Material mat)
+void GameEntity::SetVisible(bool visible)
 {
-    entityMaterial = std::make_shared<Material>(mat);
+    uint32_t flags = EntitySystem::GetFlags(entity);
+    EntitySystem::SetFlags(entity, visible ? flags | EntitySystem::Visible : flags & ~(uint32_t)EntitySystem::Visible);
 }
 
-void GameEntity::Draw()
+void GameEntity::Draw(unsigned int lod)
 {
-    entityMaterial->GetVertexShader()->SetShader();
-    entityMaterial->GetPixelShader()->SetShader();
-    entityMesh.get()->Draw();
+    Material* mat = GetMaterial();
+    mat->GetVertexShader()->SetShader();
+    mat->GetPixelShader()->SetShader();
+    GetMesh(lod)->Draw();
 }
@@ -1,5 +1,5 @@
 #pragma once
-#include <memory>
+#include "EntitySystem.h"
 #include "Mesh.h"
 #include "Transform.h"
 #include "Material.h"
@@ -7,25 +7,39 @@
 class GameEntity
 {
 public:
-	GameEntity() = default;
-	GameEntity(std::shared_ptr<Mesh> mesh, std::shared_ptr<Material> mat);
+	//constructor(s) - the actual data lives in the EntitySystem,
+	//this just owns an entity there
+	GameEntity();
+	GameEntity(MeshHandle mesh, MaterialHandle mat);
 	~GameEntity();
 
-	//getters
-	std::shared_ptr<Mesh> GetMesh();
+	//ownership can be handed on, but not shared
+	GameEntity(GameEntity&& other) noexcept;
+	GameEntity& operator=(GameEntity&& other) noexcept;
+	GameEntity(const GameEntity&) = delete;
+	GameEntity& operator=(const GameEntity&) = delete;
+
+	//getters - null if the mesh or material has been released
+	Mesh* GetMesh();
+	Mesh* GetMesh(unsigned int lod);
+	unsigned int GetLodCount();
 	Transform* GetTransform();
-	std::shared_ptr<Material> GetMaterial();
+	Material* GetMaterial();
+	MeshHandle GetMeshHandle();
+	MaterialHandle GetMaterialHandle();
+	EntitySystem::Entity GetEntity();
+	bool IsVisible();
 
 	//setters
-	void SetMaterial(Material mat);
+	void SetMaterial(MaterialHandle mat);
+	void AddLod(MeshHandle mesh); // past EntitySystem::MaxLods meshes, ignored
+	void SetVisible(bool visible);
 
 	//other
-	void Draw();
+	void Draw(unsigned int lod = 0);
 	
 
 private:
-	Transform entityTransform;
-	std::shared_ptr<Mesh> entityMesh;
-	std::shared_ptr<Material> entityMaterial;
+	EntitySystem::Entity entity;
 };
 
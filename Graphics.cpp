@@ -125,6 +125,10 @@ HRESULT Graphics::Initialize(unsigned int windowWidth, unsigned int windowHeight
 	// We're set up
 	apiInitialized = true;
 
+	// Everything else draws through this
+	Renderer = std::make_unique<D3D11RenderDevice>();
+	RenderDevice::Active = Renderer.get();
+
 	// Call ResizeBuffers(), which will also set up the 
 	// render target view and depth stencil view for the
 	// various buffers we need for rendering. This call 
@@ -152,6 +156,11 @@ HRESULT Graphics::Initialize(unsigned int windowWidth, unsigned int windowHeight
 // --------------------------------------------------------
 void Graphics::ShutDown()
 {
+	// Handles outliving this are the caller's bug, but at
+	// least they'll find no device rather than a dead one
+	if (RenderDevice::Active == Renderer.get())
+		RenderDevice::Active = 0;
+	Renderer.reset();
 }
 
 
@@ -2,8 +2,10 @@
 
 #include <Windows.h>
 #include <d3d11.h>
+#include <memory>
 #include <string>
 #include <wrl/client.h>
+#include "D3D11RenderDevice.h"
 
 #pragma comment(lib, "d3d11.lib")
 #pragma comment(lib, "dxgi.lib")
@@ -21,6 +23,10 @@ namespace Graphics
 	inline Microsoft::WRL::ComPtr<ID3D11RenderTargetView> BackBufferRTV;
 	inline Microsoft::WRL::ComPtr<ID3D11DepthStencilView> DepthBufferDSV;
 
+	// The above behind the RenderDevice interface, and the
+	// RenderDevice::Active device once initialized
+	inline std::unique_ptr<D3D11RenderDevice> Renderer;
+
 	// --- FUNCTIONS ---
 
 	// Getters
@@ -37,6 +37,9 @@
 #ifndef IMGUI_DISABLE
 #include "imgui_impl_dx11.h"
 
+// Render counters
+#include "../RenderStats.h"
+
 // DirectX
 #include <stdio.h>
 #include <d3d11.h>
@@ -106,6 +109,8 @@ static void ImGui_ImplDX11_SetupRenderState(ImDrawData* draw_data, ID3D11DeviceC
     ctx->VSSetConstantBuffers(0, 1, &bd->pVertexConstantBuffer);
     ctx->PSSetShader(bd->pPixelShader, nullptr, 0);
     ctx->PSSetSamplers(0, 1, &bd->pFontSampler);
+    RenderStats::Add(RenderStats::ShaderBinds, 2);
+    RenderStats::Add(RenderStats::BufferBinds, 3);
     ctx->GSSetShader(nullptr, nullptr, 0);
     ctx->HSSetShader(nullptr, nullptr, 0); // In theory we should backup and restore this as well.. very infrequently used..
     ctx->DSSetShader(nullptr, nullptr, 0); // In theory we should backup and restore this as well.. very infrequently used..
@@ -196,6 +201,8 @@ void ImGui_ImplDX11_RenderDrawData(ImDrawData* draw_data)
         };
         memcpy(&constant_buffer->mvp, mvp, sizeof(mvp));
         ctx->Unmap(bd->pVertexConstantBuffer, 0);
+        RenderStats::Add(RenderStats::ConstantBufferUploads);
+        RenderStats::Add(RenderStats::ConstantBufferBytes, sizeof(VERTEX_CONSTANT_BUFFER_DX11));
     }
 
     // Backup DX state that will be modified to restore it afterwards (unfortunately this is very ugly looking and verbose. Close your eyes!)
@@ -282,6 +289,9 @@ void ImGui_ImplDX11_RenderDrawData(ImDrawData* draw_data)
                 ID3D11ShaderResourceView* texture_srv = (ID3D11ShaderResourceView*)pcmd->GetTexID();
                 ctx->PSSetShaderResources(0, 1, &texture_srv);
                 ctx->DrawIndexed(pcmd->ElemCount, pcmd->IdxOffset + global_idx_offset, pcmd->VtxOffset + global_vtx_offset);
+                RenderStats::Add(RenderStats::DrawCalls);
+                RenderStats::Add(RenderStats::UIDrawCalls);
+                RenderStats::Add(RenderStats::Triangles, pcmd->ElemCount / 3);
             }
         }
         global_idx_offset += cmd_list->IdxBuffer.Size;
@@ -306,6 +316,8 @@ void ImGui_ImplDX11_RenderDrawData(ImDrawData* draw_data)
     ctx->IASetIndexBuffer(old.IndexBuffer, old.IndexBufferFormat, old.IndexBufferOffset); if (old.IndexBuffer) old.IndexBuffer->Release();
     ctx->IASetVertexBuffers(0, 1, &old.VertexBuffer, &old.VertexBufferStride, &old.VertexBufferOffset); if (old.VertexBuffer) old.VertexBuffer->Release();
     ctx->IASetInputLayout(old.InputLayout); if (old.InputLayout) old.InputLayout->Release();
+    RenderStats::Add(RenderStats::ShaderBinds, 3);
+    RenderStats::Add(RenderStats::BufferBinds, 3);
 }
 
 static void ImGui_ImplDX11_CreateFontsTexture()
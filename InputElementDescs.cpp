@@ -0,0 +1,116 @@
+#include "InputElementDescs.h"
+#include <cstring>
+#include <string>
+
+namespace
+{
+	void HashBytes(uint64_t& hash, const void* data, size_t size)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ULL;
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Builds input element descs from a reflected input signature
+//
+// Semantics ending in "_PER_INSTANCE" are assumed to come from
+// input slot 1 with a step rate of one instance.  Code adapted from:
+// https://takinginitiative.wordpress.com/2011/12/11/directx-1011-basic-shader-reflection-automatic-input-layout-creation/
+//
+// signature          - The vertex shader's reflected input parameters
+// hasPerInstanceData - Set to true if any element is per-instance
+// --------------------------------------------------------
+std::vector<D3D11_INPUT_ELEMENT_DESC> InputLayoutCache::BuildInputElementDescs(
+	const std::vector<ReflectedInputParameter>& signature,
+	bool* hasPerInstanceData)
+{
+	std::vector<D3D11_INPUT_ELEMENT_DESC> descs;
+	descs.reserve(signature.size());
+
+	for (const ReflectedInputParameter& paramDesc : signature)
+	{
+		// Check the semantic name for "_PER_INSTANCE"
+		std::string perInstanceStr = "_PER_INSTANCE";
+		const std::string& sem = paramDesc.SemanticName;
+		int lenDiff = (int)sem.size() - (int)perInstanceStr.size();
+		bool isPerInstance =
+			lenDiff >= 0 &&
+			sem.compare(lenDiff, perInstanceStr.size(), perInstanceStr) == 0;
+
+		// Fill out input element desc
+		D3D11_INPUT_ELEMENT_DESC elementDesc = {};
+		elementDesc.SemanticName = paramDesc.SemanticName.c_str();
+		elementDesc.SemanticIndex = paramDesc.SemanticIndex;
+		elementDesc.InputSlot = 0;
+		elementDesc.AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
+		elementDesc.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+		elementDesc.InstanceDataStepRate = 0;
+
+		// Replace anything affected by "per instance" data
+		if (isPerInstance)
+		{
+			elementDesc.InputSlot = 1; // Assume per instance data comes from another input slot!
+			elementDesc.InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
+			elementDesc.InstanceDataStepRate = 1;
+
+			if (hasPerInstanceData)
+				*hasPerInstanceData = true;
+		}
+
+		// Determine DXGI format
+		if (paramDesc.Mask == 1)
+		{
+			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32_UINT;
+			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32_SINT;
+			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32_FLOAT;
+		}
+		else if (paramDesc.Mask <= 3)
+		{
+			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32G32_UINT;
+			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32G32_SINT;
+			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32G32_FLOAT;
+		}
+		else if (paramDesc.Mask <= 7)
+		{
+			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32_UINT;
+			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32_SINT;
+			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32G32B32_FLOAT;
+		}
+		else if (paramDesc.Mask <= 15)
+		{
+			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32A32_UINT;
+			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32A32_SINT;
+			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+		}
+
+		// Save element desc
+		descs.push_back(elementDesc);
+	}
+
+	return descs;
+}
+
+// --------------------------------------------------------
+// Hashes element descs by value (semantic names are hashed
+// by their characters, not their addresses)
+// --------------------------------------------------------
+uint64_t InputLayoutCache::HashInputElementDescs(const std::vector<D3D11_INPUT_ELEMENT_DESC>& descs)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (const D3D11_INPUT_ELEMENT_DESC& d : descs)
+	{
+		HashBytes(hash, d.SemanticName, strlen(d.SemanticName) + 1);
+		HashBytes(hash, &d.SemanticIndex, sizeof(d.SemanticIndex));
+		HashBytes(hash, &d.Format, sizeof(d.Format));
+		HashBytes(hash, &d.InputSlot, sizeof(d.InputSlot));
+		HashBytes(hash, &d.AlignedByteOffset, sizeof(d.AlignedByteOffset));
+		HashBytes(hash, &d.InputSlotClass, sizeof(d.InputSlotClass));
+		HashBytes(hash, &d.InstanceDataStepRate, sizeof(d.InstanceDataStepRate));
+	}
+	return hash;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "ShaderReflectionCache.h"
+
+// --------------------------------------------------------
+// The part of InputLayoutCache that is plain data in and out:
+// turning a reflected input signature into element descs and
+// hashing them
+//
+// Only the desc struct and a few enum values are needed, so
+// away from Windows (the headless build and its tests) they're
+// declared here instead of coming from d3d11.h, with the same
+// names, layout and values.
+// --------------------------------------------------------
+#if defined(_WIN32)
+#include <d3d11.h>
+#else
+enum DXGI_FORMAT
+{
+	DXGI_FORMAT_UNKNOWN = 0,
+	DXGI_FORMAT_R32G32B32A32_FLOAT = 2,
+	DXGI_FORMAT_R32G32B32A32_UINT = 3,
+	DXGI_FORMAT_R32G32B32A32_SINT = 4,
+	DXGI_FORMAT_R32G32B32_FLOAT = 6,
+	DXGI_FORMAT_R32G32B32_UINT = 7,
+	DXGI_FORMAT_R32G32B32_SINT = 8,
+	DXGI_FORMAT_R32G32_FLOAT = 16,
+	DXGI_FORMAT_R32G32_UINT = 17,
+	DXGI_FORMAT_R32G32_SINT = 18,
+	DXGI_FORMAT_R32_FLOAT = 41,
+	DXGI_FORMAT_R32_UINT = 42,
+	DXGI_FORMAT_R32_SINT = 43,
+};
+
+enum D3D_REGISTER_COMPONENT_TYPE
+{
+	D3D_REGISTER_COMPONENT_UNKNOWN = 0,
+	D3D_REGISTER_COMPONENT_UINT32 = 1,
+	D3D_REGISTER_COMPONENT_SINT32 = 2,
+	D3D_REGISTER_COMPONENT_FLOAT32 = 3,
+};
+
+enum D3D11_INPUT_CLASSIFICATION
+{
+	D3D11_INPUT_PER_VERTEX_DATA = 0,
+	D3D11_INPUT_PER_INSTANCE_DATA = 1,
+};
+
+#define D3D11_APPEND_ALIGNED_ELEMENT (0xffffffff)
+
+struct D3D11_INPUT_ELEMENT_DESC
+{
+	const char* SemanticName;
+	unsigned int SemanticIndex;
+	DXGI_FORMAT Format;
+	unsigned int InputSlot;
+	unsigned int AlignedByteOffset;
+	D3D11_INPUT_CLASSIFICATION InputSlotClass;
+	unsigned int InstanceDataStepRate;
+};
+#endif
+
+namespace InputLayoutCache
+{
+	// Maps a reflected input signature to element descs (no side effects).
+	// Semantic names point into the signature, which must outlive the result.
+	std::vector<D3D11_INPUT_ELEMENT_DESC> BuildInputElementDescs(
+		const std::vector<ReflectedInputParameter>& signature,
+		bool* hasPerInstanceData);
+
+	uint64_t HashInputElementDescs(const std::vector<D3D11_INPUT_ELEMENT_DESC>& descs);
+}
@@ -0,0 +1,179 @@
+#include "InputLayoutCache.h"
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace InputLayoutCache
+{
+	// Annonymous namespace to hold variables
+	// only accessible in this file
+	namespace
+	{
+		// A cached layout along with a private copy of the descs
+		// used to create it, for resolving hash collisions
+		struct Entry
+		{
+			std::vector<std::string> SemanticNames;
+			std::vector<D3D11_INPUT_ELEMENT_DESC> Descs;
+			Microsoft::WRL::ComPtr<ID3D11InputLayout> Layout;
+		};
+
+		// Stats, counted from whichever thread loads or binds and
+		// read by the UI, so each is atomic
+		struct Counters
+		{
+			std::atomic<unsigned int> Requests{ 0 };
+			std::atomic<unsigned int> Hits{ 0 };
+			std::atomic<unsigned int> UniqueLayouts{ 0 };
+			std::atomic<unsigned int> Binds{ 0 };
+			std::atomic<unsigned int> RedundantBinds{ 0 };
+		};
+
+		// Stands for "don't know what's set", since null is a
+		// layout that can be set like any other
+		ID3D11InputLayout* const UnknownLayout = (ID3D11InputLayout*)~(uintptr_t)0;
+
+		// Layouts are looked up by shaders loading on any thread
+		std::mutex layoutMutex;
+		std::unordered_map<uint64_t, std::vector<Entry>> layouts;
+		std::atomic<ID3D11InputLayout*> boundLayout{ UnknownLayout };
+		Counters stats;
+
+		bool SameDescs(const std::vector<D3D11_INPUT_ELEMENT_DESC>& a, const std::vector<D3D11_INPUT_ELEMENT_DESC>& b)
+		{
+			if (a.size() != b.size())
+				return false;
+
+			for (size_t i = 0; i < a.size(); i++)
+			{
+				if (strcmp(a[i].SemanticName, b[i].SemanticName) != 0 ||
+					a[i].SemanticIndex != b[i].SemanticIndex ||
+					a[i].Format != b[i].Format ||
+					a[i].InputSlot != b[i].InputSlot ||
+					a[i].AlignedByteOffset != b[i].AlignedByteOffset ||
+					a[i].InputSlotClass != b[i].InputSlotClass ||
+					a[i].InstanceDataStepRate != b[i].InstanceDataStepRate)
+					return false;
+			}
+			return true;
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Finds or creates the shared layout for a set of element descs
+//
+// device         - Device used if a new layout is needed
+// descs          - The element descs describing the vertex data
+// shaderBytecode - Vertex shader code the new layout is validated against
+// bytecodeSize   - Size of the vertex shader code
+// --------------------------------------------------------
+Microsoft::WRL::ComPtr<ID3D11InputLayout> InputLayoutCache::GetOrCreate(
+	ID3D11Device* device,
+	const std::vector<D3D11_INPUT_ELEMENT_DESC>& descs,
+	const void* shaderBytecode,
+	size_t bytecodeSize)
+{
+	std::lock_guard<std::mutex> lock(layoutMutex);
+	stats.Requests++;
+	if (descs.empty())
+		return 0;
+
+	// Already have one?
+	uint64_t hash = HashInputElementDescs(descs);
+	std::vector<Entry>& bucket = layouts[hash];
+	for (Entry& e : bucket)
+	{
+		if (SameDescs(e.Descs, descs))
+		{
+			stats.Hits++;
+			return e.Layout;
+		}
+	}
+
+	// Nope, make it
+	Entry entry;
+	HRESULT hr = device->CreateInputLayout(
+		descs.data(),
+		(unsigned int)descs.size(),
+		shaderBytecode,
+		bytecodeSize,
+		entry.Layout.GetAddressOf());
+	if (FAILED(hr))
+		return 0;
+
+	// Keep our own copy of the semantic names, since the
+	// caller's may not live as long as the cache
+	entry.Descs = descs;
+	entry.SemanticNames.reserve(descs.size());
+	for (size_t i = 0; i < descs.size(); i++)
+		entry.SemanticNames.push_back(descs[i].SemanticName);
+	for (size_t i = 0; i < descs.size(); i++)
+		entry.Descs[i].SemanticName = entry.SemanticNames[i].c_str();
+
+	stats.UniqueLayouts++;
+	bucket.push_back(std::move(entry));
+	return bucket.back().Layout;
+}
+
+// --------------------------------------------------------
+// Sets the input layout unless it's already the one set
+// --------------------------------------------------------
+void InputLayoutCache::Bind(ID3D11DeviceContext* context, ID3D11InputLayout* layout)
+{
+	stats.Binds++;
+	if (boundLayout.load(std::memory_order_relaxed) == layout)
+	{
+		stats.RedundantBinds++;
+		return;
+	}
+
+	context->IASetInputLayout(layout);
+	boundLayout.store(layout, std::memory_order_relaxed);
+}
+
+// --------------------------------------------------------
+// Forgets which layout is set, so the next Bind() always
+// reaches the context.  Call whenever other code may have
+// changed the input layout behind our back.
+// --------------------------------------------------------
+void InputLayoutCache::InvalidateBoundLayout()
+{
+	boundLayout.store(UnknownLayout, std::memory_order_relaxed);
+}
+
+// --------------------------------------------------------
+// Copies the counters, which may be changing on other threads,
+// so each is exact though they may not all agree
+// --------------------------------------------------------
+InputLayoutCache::Stats InputLayoutCache::GetStats()
+{
+	Stats copy;
+	copy.Requests = stats.Requests.load(std::memory_order_relaxed);
+	copy.Hits = stats.Hits.load(std::memory_order_relaxed);
+	copy.UniqueLayouts = stats.UniqueLayouts.load(std::memory_order_relaxed);
+	copy.Binds = stats.Binds.load(std::memory_order_relaxed);
+	copy.RedundantBinds = stats.RedundantBinds.load(std::memory_order_relaxed);
+	return copy;
+}
+
+void InputLayoutCache::ResetStats()
+{
+	stats.Requests = 0;
+	stats.Hits = 0;
+	stats.UniqueLayouts = 0;
+	stats.Binds = 0;
+	stats.RedundantBinds = 0;
+}
+
+// --------------------------------------------------------
+// Releases every cached layout
+// --------------------------------------------------------
+void InputLayoutCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(layoutMutex);
+	layouts.clear();
+	InvalidateBoundLayout();
+}
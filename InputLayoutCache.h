@@ -0,0 +1,46 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <cstdint>
+#include <vector>
+#include "InputElementDescs.h"
+
+// --------------------------------------------------------
+// Process-wide cache of input layouts
+//
+// Vertex shaders with identical input signatures share one
+// ID3D11InputLayout, keyed by a hash of the element descs, and
+// binding goes through here so repeated IASetInputLayout calls
+// with the same layout can be skipped.  Building and hashing
+// the descs is in InputElementDescs.h.
+// --------------------------------------------------------
+namespace InputLayoutCache
+{
+	struct Stats
+	{
+		unsigned int Requests;		// Calls to GetOrCreate()
+		unsigned int Hits;			// ...that found an existing layout
+		unsigned int UniqueLayouts;	// Layouts actually created
+		unsigned int Binds;			// Calls to Bind()
+		unsigned int RedundantBinds;// ...skipped since the layout was already set
+	};
+
+	// Returns a shared layout for these descs, creating it (validated
+	// against the given vertex shader bytecode) the first time
+	Microsoft::WRL::ComPtr<ID3D11InputLayout> GetOrCreate(
+		ID3D11Device* device,
+		const std::vector<D3D11_INPUT_ELEMENT_DESC>& descs,
+		const void* shaderBytecode,
+		size_t bytecodeSize);
+
+	// Redundant-state filtering for IASetInputLayout
+	void Bind(ID3D11DeviceContext* context, ID3D11InputLayout* layout);
+	void InvalidateBoundLayout();
+
+	Stats GetStats();
+	void ResetStats();
+
+	// Releases every cached layout - call before the device goes away
+	void Clear();
+}
@@ -0,0 +1,433 @@
+#include "JobSystem.h"
+#include "AllocationTracker.h"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace JobSystem
+{
+	// Annonymous namespace to hold variables
+	// only accessible in this file
+	namespace
+	{
+		constexpr unsigned int InvalidThread = ~0u;
+
+		// Both must be powers of two.  A job's slot in the pool is only
+		// reused once the job has left the deque, and the owner pops the
+		// newest job first, so an old one can sit at the top while any
+		// number of others come and go below it.  Slots in use are at most
+		// the deque's capacity plus one per thread taking a job, so a pool
+		// this much bigger than the deque rarely has to look past one.
+		constexpr uint32_t DequeCapacity = 1024;
+		constexpr uint32_t JobPoolSize = 4096;
+
+		struct Job
+		{
+			JobFunction Function;
+			void* Data;
+			Counter* Group;
+			uint32_t Begin;
+			uint32_t End;
+			unsigned int AllocationTag;		// Whoever queued the job's
+		};
+
+		// Where a queued job waits in its owner's pool.  Whoever takes
+		// the job out of the deque copies it and frees the slot before
+		// running it, so the owner never overwrites a job still queued.
+		struct JobSlot
+		{
+			Job Work;
+			std::atomic<bool> Queued{ false };
+		};
+
+		// --------------------------------------------------------
+		// Chase-Lev work-stealing deque with a fixed capacity
+		//  - Only the owning thread calls Push() and Pop()
+		//  - Any thread may call Steal()
+		// --------------------------------------------------------
+		class WorkDeque
+		{
+		public:
+			bool Push(JobSlot* job)
+			{
+				int64_t b = bottom.load(std::memory_order_relaxed);
+				int64_t t = top.load(std::memory_order_acquire);
+				if (b - t >= (int64_t)DequeCapacity)
+					return false;
+
+				buffer[b & (DequeCapacity - 1)].store(job, std::memory_order_relaxed);
+				bottom.store(b + 1, std::memory_order_release);
+				return true;
+			}
+
+			JobSlot* Pop()
+			{
+				int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+				bottom.store(b, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				int64_t t = top.load(std::memory_order_relaxed);
+
+				if (t > b)
+				{
+					// Empty
+					bottom.store(b + 1, std::memory_order_relaxed);
+					return 0;
+				}
+
+				JobSlot* job = buffer[b & (DequeCapacity - 1)].load(std::memory_order_relaxed);
+				if (t == b)
+				{
+					// Last job, so race any thieves for it
+					if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+						job = 0;
+					bottom.store(b + 1, std::memory_order_relaxed);
+				}
+				return job;
+			}
+
+			JobSlot* Steal()
+			{
+				int64_t t = top.load(std::memory_order_acquire);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				int64_t b = bottom.load(std::memory_order_acquire);
+				if (t >= b)
+					return 0;
+
+				JobSlot* job = buffer[t & (DequeCapacity - 1)].load(std::memory_order_relaxed);
+				if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+					return 0;
+				return job;
+			}
+
+		private:
+			// Separate cache lines, since thieves hammer top
+			alignas(64) std::atomic<int64_t> top{ 0 };
+			alignas(64) std::atomic<int64_t> bottom{ 0 };
+			alignas(64) std::atomic<JobSlot*> buffer[DequeCapacity] = {};
+		};
+
+		// Everything one thread owns
+		struct ThreadContext
+		{
+			WorkDeque Deque;
+			JobSlot Jobs[JobPoolSize];
+			uint32_t NextJob = 0;
+			uint32_t Random = 0;
+
+			// Only written by the owner, read by GetStats()
+			std::atomic<unsigned int> Executed{ 0 };
+			std::atomic<unsigned int> Stolen{ 0 };
+			std::atomic<unsigned int> RanInline{ 0 };
+		};
+
+		std::vector<std::unique_ptr<ThreadContext>> contexts;
+		std::vector<std::thread> workers;
+		std::atomic<bool> running{ false };
+
+		// Sleeping for idle workers.  queuedJobs and sleepers are only
+		// ever changed in the same order on both sides (seq_cst), so
+		// either the worker sees the new job or Run() sees the sleeper.
+		std::mutex sleepMutex;
+		std::condition_variable wakeUp;
+		std::atomic<int> queuedJobs{ 0 };
+		std::atomic<int> sleepers{ 0 };
+
+		thread_local unsigned int threadIndex = InvalidThread;
+
+		void Execute(const Job& job)
+		{
+			AllocationTracker::Tag tag(job.AllocationTag);
+			job.Function(job.Data, job.Begin, job.End);
+			if (job.Group)
+				job.Group->Pending.fetch_sub(1, std::memory_order_release);
+		}
+
+		// Copies a job out of its slot, which the owner may then reuse
+		Job Take(JobSlot* slot)
+		{
+			Job job = slot->Work;
+			slot->Queued.store(false, std::memory_order_release);
+			return job;
+		}
+
+		// xorshift - only used to pick which thread to steal from first
+		uint32_t NextRandom(uint32_t& state)
+		{
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			return state;
+		}
+
+		// Own deque first, then everyone else's starting somewhere random
+		bool FindJob(unsigned int index, Job& found)
+		{
+			ThreadContext& context = *contexts[index];
+			JobSlot* job = context.Deque.Pop();
+			if (job)
+			{
+				queuedJobs.fetch_sub(1);
+				found = Take(job);
+				return true;
+			}
+
+			unsigned int threadCount = (unsigned int)contexts.size();
+			unsigned int start = NextRandom(context.Random) % threadCount;
+			for (unsigned int i = 0; i < threadCount; i++)
+			{
+				unsigned int victim = (start + i) % threadCount;
+				if (victim == index)
+					continue;
+
+				job = contexts[victim]->Deque.Steal();
+				if (job)
+				{
+					queuedJobs.fetch_sub(1);
+					context.Stolen.fetch_add(1, std::memory_order_relaxed);
+					found = Take(job);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// The next slot in the owner's pool whose job has left the
+		// deque, or null if (somehow) every one is still queued
+		JobSlot* ClaimSlot(ThreadContext& context)
+		{
+			for (uint32_t i = 0; i < JobPoolSize; i++)
+			{
+				JobSlot* slot = &context.Jobs[context.NextJob++ & (JobPoolSize - 1)];
+				if (!slot->Queued.load(std::memory_order_acquire))
+					return slot;
+			}
+			return 0;
+		}
+
+		void WorkerMain(unsigned int index)
+		{
+			threadIndex = index;
+			ThreadContext& context = *contexts[index];
+
+			int idleSpins = 0;
+			while (running.load(std::memory_order_acquire))
+			{
+				Job job;
+				if (FindJob(index, job))
+				{
+					Execute(job);
+					context.Executed.fetch_add(1, std::memory_order_relaxed);
+					idleSpins = 0;
+					continue;
+				}
+
+				// Spin briefly in case more work is about to show up,
+				// then sleep until Run() queues something
+				if (++idleSpins < 64)
+				{
+					std::this_thread::yield();
+					continue;
+				}
+
+				std::unique_lock<std::mutex> lock(sleepMutex);
+				sleepers.fetch_add(1);
+				wakeUp.wait(lock, [] { return queuedJobs.load() > 0 || !running.load(); });
+				sleepers.fetch_sub(1);
+				idleSpins = 0;
+			}
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Starts the worker threads.  The calling thread becomes
+// thread 0 and takes part whenever it calls Wait().
+//
+// workerCount - Threads to start, or 0 for one per
+//               hardware thread beyond this one
+// --------------------------------------------------------
+void JobSystem::Initialize(unsigned int workerCount)
+{
+	if (running.load())
+		return;
+
+	if (workerCount == 0)
+	{
+		unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+	}
+
+	contexts.clear();
+	for (unsigned int i = 0; i < workerCount + 1; i++)
+	{
+		contexts.push_back(std::make_unique<ThreadContext>());
+		contexts[i]->Random = 0x9E3779B9u * (i + 1);
+	}
+
+	threadIndex = 0;
+	running.store(true);
+	for (unsigned int i = 1; i <= workerCount; i++)
+		workers.emplace_back(WorkerMain, i);
+}
+
+// --------------------------------------------------------
+// Stops and joins the workers.  Anything still queued is
+// dropped, so Wait() on outstanding work first.
+// --------------------------------------------------------
+void JobSystem::ShutDown()
+{
+	if (!running.load())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		running.store(false);
+	}
+	wakeUp.notify_all();
+
+	for (std::thread& t : workers)
+		t.join();
+
+	workers.clear();
+	contexts.clear();
+	queuedJobs.store(0);
+	threadIndex = InvalidThread;
+}
+
+// --------------------------------------------------------
+// Queues a job
+//
+// function   - What to run
+// data       - Passed through to the function
+// counter    - Decremented when the job finishes (may be null)
+// begin, end - Passed through to the function
+// --------------------------------------------------------
+void JobSystem::Run(JobFunction function, void* data, Counter* counter, uint32_t begin, uint32_t end)
+{
+	if (counter)
+		counter->Pending.fetch_add(1, std::memory_order_relaxed);
+
+	unsigned int index = threadIndex;
+	Job job = { function, data, counter, begin, end, AllocationTracker::GetCurrentTag() };
+	if (index == InvalidThread || !running.load(std::memory_order_relaxed))
+	{
+		Execute(job);
+		return;
+	}
+
+	ThreadContext& context = *contexts[index];
+	JobSlot* slot = ClaimSlot(context);
+	if (slot)
+	{
+		slot->Work = job;
+		slot->Queued.store(true, std::memory_order_relaxed);
+	}
+
+	if (!slot || !context.Deque.Push(slot))
+	{
+		// Deque is full, so there's plenty of parallel work already
+		if (slot)
+			slot->Queued.store(false, std::memory_order_relaxed);
+		context.RanInline.fetch_add(1, std::memory_order_relaxed);
+		Execute(job);
+		return;
+	}
+
+	queuedJobs.fetch_add(1);
+	if (sleepers.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		wakeUp.notify_one();
+	}
+}
+
+// --------------------------------------------------------
+// Blocks until every job added to the counter has finished,
+// running queued jobs (from any thread) in the meantime
+// --------------------------------------------------------
+void JobSystem::Wait(Counter* counter)
+{
+	while (counter->Pending.load(std::memory_order_acquire) > 0)
+	{
+		if (!TryRunJob())
+			std::this_thread::yield();
+	}
+}
+
+bool JobSystem::TryRunJob()
+{
+	unsigned int index = threadIndex;
+	if (index == InvalidThread)
+		return false;
+
+	Job job;
+	if (!FindJob(index, job))
+		return false;
+
+	Execute(job);
+	contexts[index]->Executed.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+unsigned int JobSystem::GetThreadCount()
+{
+	return contexts.empty() ? 1 : (unsigned int)contexts.size();
+}
+
+unsigned int JobSystem::GetThreadIndex()
+{
+	return threadIndex;
+}
+
+JobSystem::Stats JobSystem::GetStats()
+{
+	Stats stats = {};
+	stats.Threads = GetThreadCount();
+	for (auto& context : contexts)
+	{
+		stats.Executed += context->Executed.load(std::memory_order_relaxed);
+		stats.Stolen += context->Stolen.load(std::memory_order_relaxed);
+		stats.RanInline += context->RanInline.load(std::memory_order_relaxed);
+	}
+	return stats;
+}
+
+void JobSystem::ResetStats()
+{
+	for (auto& context : contexts)
+	{
+		context->Executed.store(0, std::memory_order_relaxed);
+		context->Stolen.store(0, std::memory_order_relaxed);
+		context->RanInline.store(0, std::memory_order_relaxed);
+	}
+}
+
+// --------------------------------------------------------
+// Runs a ParallelFor range, splitting off the upper half as
+// a new job until what's left is no bigger than the grain
+// --------------------------------------------------------
+namespace JobSystem
+{
+	namespace
+	{
+		void RangeJob(void* data, uint32_t begin, uint32_t end)
+		{
+			RangeData& range = *(RangeData*)data;
+			while (end - begin > range.Grain)
+			{
+				uint32_t middle = begin + (end - begin) / 2;
+				Run(RangeJob, data, range.Group, middle, end);
+				end = middle;
+			}
+			range.Invoke(range.Body, begin, end);
+		}
+	}
+}
+
+void JobSystem::RunRange(RangeData& range, uint32_t count)
+{
+	RangeJob(&range, 0, count);
+	Wait(range.Group);
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// --------------------------------------------------------
+// Work-stealing job system
+//
+// Each thread (workers plus the thread that called Initialize)
+// owns a Chase-Lev deque: it pushes and pops jobs at the bottom
+// while idle threads steal from the top of someone else's.
+// Fork-join goes through counters: Run() adds to a counter,
+// the job decrements it when it finishes, and Wait() keeps
+// executing other jobs until the counter reaches zero, so
+// waiting inside a job never deadlocks.
+//
+// Jobs are plain function pointers plus a data pointer and an
+// index range - nothing is allocated per job.
+// --------------------------------------------------------
+namespace JobSystem
+{
+	typedef void (*JobFunction)(void* data, uint32_t begin, uint32_t end);
+
+	// Number of jobs still outstanding for a fork-join group
+	struct Counter
+	{
+		std::atomic<int> Pending{ 0 };
+	};
+
+	struct Stats
+	{
+		unsigned int Threads;		// Workers plus the main thread
+		unsigned int Executed;		// Jobs run since the last ResetStats()
+		unsigned int Stolen;		// ...that came from another thread's deque
+		unsigned int RanInline;		// ...that were run inline because a deque was full
+	};
+
+	// workerCount of 0 uses one worker per extra hardware thread
+	void Initialize(unsigned int workerCount = 0);
+	void ShutDown();
+
+	// Queues a job on the calling thread's deque.  Threads the system
+	// doesn't own (not workers, not the main thread) run it inline.
+	// Its heap allocations count against the caller's allocation tag.
+	void Run(JobFunction function, void* data, Counter* counter, uint32_t begin = 0, uint32_t end = 0);
+
+	// Runs other jobs until the counter reaches zero
+	void Wait(Counter* counter);
+
+	// Runs one queued job if there is one, for threads that are
+	// waiting on something other than a counter
+	bool TryRunJob();
+
+	unsigned int GetThreadCount();
+	unsigned int GetThreadIndex();	// 0 is the main thread, ~0u for unknown threads
+
+	Stats GetStats();
+	void ResetStats();
+
+	// Calls body(begin, end) over [0, count) in parallel and returns
+	// once every range is done.  Ranges are split in half on demand,
+	// so idle threads steal big pieces and busy ones keep small ones.
+	// minBatch is the smallest range worth a job of its own.
+	template<typename Body>
+	void ParallelFor(uint32_t count, uint32_t minBatch, const Body& body);
+
+	// Type-erased half of ParallelFor, shared by every Body type
+	struct RangeData
+	{
+		void (*Invoke)(const void* body, uint32_t begin, uint32_t end);
+		const void* Body;
+		uint32_t Grain;
+		Counter* Group;
+	};
+	void RunRange(RangeData& range, uint32_t count);
+}
+
+template<typename Body>
+void JobSystem::ParallelFor(uint32_t count, uint32_t minBatch, const Body& body)
+{
+	if (count == 0)
+		return;
+
+	// Aim for a few ranges per thread so stealing can balance things out
+	uint32_t grain = count / (GetThreadCount() * 8);
+	if (grain < minBatch)
+		grain = minBatch;
+	if (grain < 1)
+		grain = 1;
+
+	if (count <= grain || GetThreadCount() == 1)
+	{
+		body(0u, count);
+		return;
+	}
+
+	Counter counter;
+	RangeData range;
+	range.Invoke = [](const void* b, uint32_t begin, uint32_t end) { (*(const Body*)b)(begin, end); };
+	range.Body = &body;
+	range.Grain = grain;
+	range.Group = &counter;
+	RunRange(range, count);
+}
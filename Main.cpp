@@ -1,11 +1,24 @@
 
 #include <Windows.h>
 #include <crtdbg.h>
+#include <math.h>
 
 #include "Window.h"
 #include "Graphics.h"
 #include "Game.h"
 #include "Input.h"
+#include "JobSystem.h"
+#include "RenderThread.h"
+#include "FrameGraph.h"
+#include "Profiler.h"
+#include "FrameTimes.h"
+#include "RenderStats.h"
+#include "Benchmark.h"
+#include "PathHelpers.h"
+#include "Startup.h"
+#include "AllocationTracker.h"
+#include "FrameAllocator.h"
+#include "Resources.h"
 
 // Annonymous namespace to hold variables
 // only accessible in this file
@@ -27,6 +40,199 @@ namespace
 		if(game)
 			game->OnResize();
 	}
+
+	// Timing shared by the frame's tasks, set before each frame
+	struct FrameTime
+	{
+		float DeltaTime;
+		float TotalTime;
+		double FixedTimeStep;
+		int MaxStepsPerFrame;
+		double Accumulator;
+		double SimulationTime;
+		float Interpolation;
+	};
+
+	// Runs as many fixed steps as fit in the elapsed time
+	void RunSimulation(void* data)
+	{
+		FrameTime& time = *(FrameTime*)data;
+		time.Accumulator += time.DeltaTime;
+		int steps = 0;
+		while (time.Accumulator >= time.FixedTimeStep && steps < time.MaxStepsPerFrame)
+		{
+			time.SimulationTime += time.FixedTimeStep;
+			game->Update((float)time.FixedTimeStep, (float)time.SimulationTime);
+			time.Accumulator -= time.FixedTimeStep;
+			steps++;
+		}
+
+		// Too far behind (breakpoint, window drag, slow machine), so
+		// drop the backlog rather than spiralling
+		if (steps == time.MaxStepsPerFrame)
+			time.Accumulator = fmod(time.Accumulator, time.FixedTimeStep);
+
+		// Draw between the last two steps
+		time.Interpolation = (float)(time.Accumulator / time.FixedTimeStep);
+	}
+
+	// A windowed benchmark run, stepped along by the frame graph
+	struct BenchmarkRun
+	{
+		Benchmark::Options Options;
+		std::vector<Benchmark::SceneObject> Scene;
+		float SceneRadius;
+		unsigned int Frame;			// Frames finished, warmup included
+		bool Finished;				// Report written, waiting for the window to close
+		bool WithinBudget;			// No measured frame allocated more than allowed
+		uint64_t Checksum;
+		Benchmark::Report Report;
+		FrameTime* Time;
+	};
+
+	// Puts the scene and camera where this frame's time says,
+	// after any simulation steps, and draws exactly that
+	void PlaceBenchmarkFrame(void* data)
+	{
+		BenchmarkRun& run = *(BenchmarkRun*)data;
+		float time = run.Frame * run.Options.DeltaTime;
+		Benchmark::CameraPose pose;
+		Benchmark::GetCameraPose(run.Options.CameraPath, time, run.SceneRadius, pose);
+		game->SetBenchmarkFrame(time, pose);
+		run.Time->Interpolation = 1.0f;
+	}
+
+	// --------------------------------------------------------
+	// Adds the frame that just finished to the report, and
+	// writes it out once every frame is in
+	//
+	// Returns true when the run is over
+	// --------------------------------------------------------
+	bool RecordBenchmarkFrame(BenchmarkRun& run, const FrameGraph& graph)
+	{
+		if (run.Finished)
+			return false;
+
+		// The report's own growth isn't part of the next frame
+		AllocationTracker::Ignore ignore;
+
+		run.Frame++;
+		if (run.Frame == run.Options.Warmup)
+			Benchmark::StartAllocationBudget(run.Options);
+		if (run.Frame <= run.Options.Warmup)
+			return false;
+
+		run.Report.AddSample("Frame", graph.GetStats().FrameMilliseconds);
+		for (FrameGraph::TaskId t = 0; t < graph.GetTaskCount(); t++)
+			run.Report.AddSample(graph.GetTaskName(t), graph.GetTaskMilliseconds(t));
+
+		const RenderQueue& queue = game->GetRenderQueue();
+		RenderQueue::Stats queueStats = queue.GetStats();
+		run.Report.AddSample("Culling", queueStats.CullMilliseconds);
+		run.Report.AddSample("Sorting", queueStats.SortMilliseconds);
+		run.Report.AddCount("Visible", queueStats.Visible);
+		run.Checksum = Benchmark::HashItems(queue.GetItems(), run.Checksum);
+
+		// Drawing runs a frame behind, so these are the last one drawn
+		RenderStats::Frame counts = RenderStats::GetLastFrame();
+		for (int c = 0; c < RenderStats::CounterCount; c++)
+			run.Report.AddCount(RenderStats::GetName((RenderStats::Counter)c), (double)counts.Values[c]);
+
+		AllocationTracker::Frame allocations = AllocationTracker::GetLastFrame();
+		run.Report.AddCount("Allocations", (double)allocations.Total.Allocations);
+		run.Report.AddCount("Allocated bytes", (double)allocations.Total.Bytes);
+		run.Report.AddCount("Frame memory bytes", (double)FrameAllocator::GetStats().FrameBytes);
+
+		if (run.Frame < run.Options.Warmup + run.Options.Frames)
+			return false;
+
+		RenderThread::Flush();
+		run.Finished = true;
+		run.Report.SetChecksum(run.Checksum);
+		run.Report.SetFramesOverBudget(AllocationTracker::GetFramesOverBudget());
+		run.WithinBudget = Benchmark::CheckAllocationBudget(run.Options);
+		if (!run.Report.WriteJson(run.Options.ReportPath.c_str(), run.Options, "windowed", (unsigned int)run.Scene.size(), JobSystem::GetThreadCount()))
+			printf("Couldn't write %s\n", run.Options.ReportPath.c_str());
+		return true;
+	}
+
+	// --------------------------------------------------------
+	// Describes one frame as tasks and the state each touches.
+	// Declaration order only matters between tasks sharing
+	// state; everything else is free to overlap.
+	// --------------------------------------------------------
+	void BuildFrameGraph(FrameGraph& graph, FrameTime& time, BenchmarkRun* benchmark)
+	{
+		graph.AddTask("Window stats",
+			[](void* data) { Window::UpdateStats(((FrameTime*)data)->TotalTime); }, &time,
+			{}, { "Title bar" }, FrameGraph::MainThread);
+
+		graph.AddTask("Input",
+			[](void* data) { Input::Update(); }, 0,
+			{}, { "Input" }, FrameGraph::MainThread);
+
+		// Per-frame work (mouse look, UI)
+		graph.AddTask("Frame update",
+			[](void* data) { FrameTime& t = *(FrameTime*)data; game->UpdateFrame(t.DeltaTime, t.TotalTime); }, &time,
+			{}, { "Input", "UI", "Camera", "Scene" }, FrameGraph::MainThread);
+
+		graph.AddTask("Frame graph UI",
+			[](void* data) { ((FrameGraph*)data)->BuildUI(); }, &graph,
+			{}, { "UI" }, FrameGraph::MainThread);
+
+		graph.AddTask("Profiler UI",
+			[](void* data) { Profiler::BuildUI(); }, 0,
+			{}, { "UI" }, FrameGraph::MainThread);
+
+		graph.AddTask("Frame times UI",
+			[](void* data) { FrameTimes::BuildUI(); }, 0,
+			{}, { "UI" }, FrameGraph::MainThread);
+
+		graph.AddTask("Render stats UI",
+			[](void* data) { RenderStats::BuildUI(); }, 0,
+			{}, { "UI" }, FrameGraph::MainThread);
+
+		graph.AddTask("Startup UI",
+			[](void* data) { Startup::BuildUI(); }, 0,
+			{}, { "UI" }, FrameGraph::MainThread);
+
+		graph.AddTask("Allocations UI",
+			[](void* data) { AllocationTracker::BuildUI(); }, 0,
+			{}, { "UI" }, FrameGraph::MainThread);
+
+		graph.AddTask("Simulation", RunSimulation, &time,
+			{ "Input" }, { "Scene", "Camera", "Interpolation" });
+
+		// Benchmarks override wherever the simulation left things
+		if (benchmark)
+			graph.AddTask("Benchmark placement", PlaceBenchmarkFrame, benchmark,
+				{}, { "Scene", "Camera", "Interpolation" });
+
+		graph.AddTask("Render state",
+			[](void* data) { game->UpdateRenderState(((FrameTime*)data)->Interpolation); }, &time,
+			{ "Interpolation" }, { "Scene", "Camera" });
+
+		graph.AddTask("Visibility",
+			[](void* data) { game->BuildVisibility(); }, 0,
+			{ "Scene", "Camera" }, { "Render queue" });
+
+		graph.AddTask("Snapshot",
+			[](void* data) { game->FillSnapshot(); }, 0,
+			{ "Scene", "Camera", "Render queue" }, { "Snapshot" });
+
+		graph.AddTask("UI render",
+			[](void* data) { game->FinishUI(); }, 0,
+			{}, { "UI", "Snapshot UI" }, FrameGraph::MainThread);
+
+		graph.AddTask("Submit",
+			[](void* data) { RenderThread::Submit(); }, 0,
+			{ "Snapshot", "Snapshot UI" }, { "Render thread" });
+
+		// Notify Input system about end of frame
+		graph.AddTask("End of frame",
+			[](void* data) { Input::EndOfFrame(); }, 0,
+			{}, { "Input" }, FrameGraph::MainThread);
+	}
 }
 
 
@@ -40,6 +246,9 @@ int WINAPI WinMain(
 	_In_ LPSTR lpCmdLine,				// Command line params
 	_In_ int nCmdShow)					// How the window should be shown (we ignore this)
 {
+	// Everything up to the first frame is timed from here
+	Startup::Initialize();
+
 #if defined(DEBUG) | defined(_DEBUG)
 	// Enable memory leak detection as a quick and dirty
 	// way of determining if we forgot to clean something up
@@ -50,41 +259,122 @@ int WINAPI WinMain(
 	printf("Console window created successfully.  Feel free to printf() here.\n");
 #endif
 
+	// Benchmark options, if any (see Benchmark.h)
+	BenchmarkRun benchmark = {};
+	std::string commandLineError;
+	if (!Benchmark::ParseCommandLine(lpCmdLine, benchmark.Options, commandLineError))
+	{
+		commandLineError += "\n\n";
+		commandLineError += Benchmark::GetUsage();
+		MessageBoxA(0, commandLineError.c_str(), "Command line", MB_OK | MB_ICONERROR);
+		return E_INVALIDARG;
+	}
+	if (benchmark.Options.Help)
+	{
+		MessageBoxA(0, Benchmark::GetUsage(), "Command line", MB_OK | MB_ICONINFORMATION);
+		return 0;
+	}
+
+	// Headless runs need nothing below
+	if (benchmark.Options.Headless)
+	{
+		benchmark.Options.AssetPath = FixPath(benchmark.Options.AssetPath);
+		return Benchmark::RunHeadless(benchmark.Options);
+	}
+
 	// Set up app initialization details
-	unsigned int windowWidth = 1280;
-	unsigned int windowHeight = 720;
+	unsigned int windowWidth = benchmark.Options.Width;
+	unsigned int windowHeight = benchmark.Options.Height;
 	const wchar_t* windowTitle = L"Direct3D11 Game";
 	bool statsInTitleBar = true;
 	bool vsync = false;
+	bool renderThread = benchmark.Options.RenderThread;	// Draw on a separate thread from the game
+
+	// Simulation runs in fixed steps, independent of the frame rate,
+	// and rendering blends between the last two steps
+	FrameTime frameTime = {};
+	frameTime.FixedTimeStep = 1.0 / 60.0;
+	frameTime.MaxStepsPerFrame = 5;	// Steps to catch up on before dropping time
 
 	// The main application object
 	game = new Game();
 
 	// Create the window and verify
-	HRESULT windowResult = Window::Create(
-		hInstance,
-		windowWidth,
-		windowHeight,
-		windowTitle,
-		statsInTitleBar,
-		WindowResizeCallback);
+	HRESULT windowResult;
+	{
+		Startup::Phase phase("Window");
+		windowResult = Window::Create(
+			hInstance,
+			windowWidth,
+			windowHeight,
+			windowTitle,
+			statsInTitleBar,
+			WindowResizeCallback);
+	}
 	if (FAILED(windowResult))
 		return windowResult;
 
 	// Initialize the graphics API and verify
-	HRESULT graphicsResult = Graphics::Initialize(
-		Window::Width(), 
-		Window::Height(), 
-		Window::Handle(),
-		vsync);
+	HRESULT graphicsResult;
+	{
+		Startup::Phase phase("Graphics device");
+		graphicsResult = Graphics::Initialize(
+			Window::Width(), 
+			Window::Height(), 
+			Window::Handle(),
+			vsync);
+	}
 	if (FAILED(graphicsResult))
 		return graphicsResult;
 
 	// Initalize the input system, which requires the window handle
 	Input::Initialize(Window::Handle());
 
+	// Profiling zones can be recorded from here on, by any thread
+	Profiler::Initialize();
+
+	// Start the worker threads - this thread joins in whenever it waits
+	{
+		Startup::Phase phase("Job system");
+		JobSystem::Initialize(benchmark.Options.Workers);
+	}
+
 	// Now the game itself can be initialzied
-	game->Initialize();
+	{
+		Startup::Phase phase("Game::Initialize");
+		game->Initialize();
+	}
+
+	// A benchmark replaces the game's scene with its own
+	if (benchmark.Options.Enabled)
+	{
+		Startup::Phase phase("Benchmark scene");
+		Benchmark::BuildScene(benchmark.Options.Scene, benchmark.Options.Objects, benchmark.Scene);
+		benchmark.SceneRadius = Benchmark::GetSceneRadius(benchmark.Scene);
+		benchmark.Checksum = Benchmark::HashSeed;
+		benchmark.Time = &frameTime;
+		game->LoadBenchmarkScene(benchmark.Scene);
+		if (benchmark.Options.Warmup == 0)
+			Benchmark::StartAllocationBudget(benchmark.Options);
+	}
+
+	// From here on, only the render thread touches the graphics context
+	RenderThread::Start([](const FrameSnapshot& frame) { game->Render(frame); }, renderThread);
+	Startup::Finish();
+
+	// Everything the game loop does each frame
+	FrameGraph frameGraph;
+	BuildFrameGraph(frameGraph, frameTime, benchmark.Options.Enabled ? &benchmark : 0);
+	if (!frameGraph.Compile())
+	{
+		MessageBoxA(Window::Handle(), frameGraph.GetError().c_str(), "Frame graph", MB_OK | MB_ICONERROR);
+		RenderThread::Stop();
+		delete game;
+		JobSystem::ShutDown();
+		Input::ShutDown();
+		Graphics::ShutDown();
+		return E_FAIL;
+	}
 
 	// Time tracking
 	LARGE_INTEGER perfFreq{};
@@ -102,6 +392,9 @@ int WINAPI WinMain(
 	currentTime = startTime;
 	previousTime = startTime;
 
+	// Loading isn't part of the first frame
+	AllocationTracker::EndFrame();
+
 	// Windows message loop (and our game loop)
 	MSG msg = {};
 	while (msg.message != WM_QUIT)
@@ -118,33 +411,45 @@ int WINAPI WinMain(
 		{
 			// Calculate up-to-date timing info
 			QueryPerformanceCounter((LARGE_INTEGER*)&currentTime);
-			float deltaTime = max((float)((currentTime - previousTime) * perfSeconds), 0.0f);
-			float totalTime = (float)((currentTime - startTime) * perfSeconds);
+			frameTime.DeltaTime = max((float)((currentTime - previousTime) * perfSeconds), 0.0f);
+			frameTime.TotalTime = (float)((currentTime - startTime) * perfSeconds);
 			previousTime = currentTime;
+			FrameTimes::Record(frameTime.DeltaTime * 1000.0f);
 
-			// Calculate basic fps
-			Window::UpdateStats(totalTime);
+			// Benchmarks step by the same amount every frame, however
+			// long the frame really took
+			if (benchmark.Options.Enabled)
+			{
+				frameTime.DeltaTime = benchmark.Options.DeltaTime;
+				frameTime.TotalTime = benchmark.Frame * benchmark.Options.DeltaTime;
+			}
 
-			// Input updating
-			Input::Update();
+			// Input, update, UI and drawing, in parallel where they can be
+			{
+				PROFILE_SCOPE("Frame");
+				frameGraph.Execute();
+			}
+			Profiler::EndFrame();
+			AllocationTracker::EndFrame();
+			FrameAllocator::EndFrame();
+			Resources::EndFrame();
 
-			// Update and draw
-			game->Update(deltaTime, totalTime);
-			game->Draw(deltaTime, totalTime);
-
-			// Notify Input system about end of frame
-			Input::EndOfFrame();
-
-#if defined(DEBUG) || defined(_DEBUG)
-			// Print any graphics debug messages that occurred this frame
-			Graphics::PrintDebugMessages();
-#endif
+			if (benchmark.Options.Enabled && RecordBenchmarkFrame(benchmark, frameGraph))
+				Window::Quit();
 		}
 	}
 
 	// Clean up
+	RenderThread::Stop();
 	delete game;
+	JobSystem::ShutDown();
+	FrameAllocator::ShutDown();
+	Profiler::ShutDown();
 	Input::ShutDown();
 	Graphics::ShutDown();
+
+	// Lets scripts running benchmarks tell a failed run apart
+	if (benchmark.Finished && !benchmark.WithinBudget)
+		return 2;
 	return (HRESULT)msg.wParam;
 }
@@ -1,10 +1,18 @@
 #include "Material.h"
+#include "Resources.h"
+#include <atomic>
 
-Material::Material(DirectX::XMFLOAT4 colorTint, float roughness, std::shared_ptr<SimpleVertexShader> verShader, std::shared_ptr<SimplePixelShader> pixShader)
+namespace
+{
+    std::atomic<unsigned int> nextMaterialId{ 0 };
+}
+
+Material::Material(DirectX::XMFLOAT4 colorTint, float roughness, VertexShaderHandle verShader, PixelShaderHandle pixShader)
 {
     this->colorTint = colorTint;
     this->verShader = verShader;
     this->pixShader = pixShader;
+    this->id = nextMaterialId++;
 
     //clamping roughness to 1-0
     if (roughness > 1.0)
@@ -19,17 +27,33 @@ Material::~Material()
 {
 }
 
+unsigned int Material::GetId()
+{
+    return id;
+}
+
 DirectX::XMFLOAT4 Material::GetColorTint()
 {
     return colorTint;
 }
 
-std::shared_ptr<SimpleVertexShader> Material::GetVertexShader()
+//null if the shader has been released
+SimpleVertexShader* Material::GetVertexShader()
+{
+    return Resources::VertexShaders.Get(verShader);
+}
+
+SimplePixelShader* Material::GetPixelShader()
+{
+    return Resources::PixelShaders.Get(pixShader);
+}
+
+VertexShaderHandle Material::GetVertexShaderHandle()
 {
     return verShader;
 }
 
-std::shared_ptr<SimplePixelShader> Material::GetPixelShader()
+PixelShaderHandle Material::GetPixelShaderHandle()
 {
     return pixShader;
 }
@@ -44,13 +68,13 @@ void Material::SetColorTint(DirectX::XMFLOAT4 colorTint)
     this->colorTint = colorTint;
 }
 
-void Material::SetVertexShader(SimpleVertexShader verShader)
+void Material::SetVertexShader(VertexShaderHandle verShader)
 {
-    this->verShader = std::make_shared<SimpleVertexShader>(verShader);
+    this->verShader = verShader;
 }
 
-void Material::SetPixelShader(SimplePixelShader pixShader)
+void Material::SetPixelShader(PixelShaderHandle pixShader)
 {
-    this->pixShader = std::make_shared<SimplePixelShader>(pixShader);
+    this->pixShader = pixShader;
 }
 
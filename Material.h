@@ -4,28 +4,35 @@
 #include <memory>
 #include <DirectXMath.h>
 #include "SimpleShader.h"
+#include "ResourceHandles.h"
 
 class Material
 {
 public:
-	Material(DirectX::XMFLOAT4 colorTint,float roughness, std::shared_ptr<SimpleVertexShader> verShader, std::shared_ptr<SimplePixelShader> pixShader);
+	Material(DirectX::XMFLOAT4 colorTint,float roughness, VertexShaderHandle verShader, PixelShaderHandle pixShader);
 	~Material();
 
 	//getters
 	DirectX::XMFLOAT4 GetColorTint();
-	std::shared_ptr<SimpleVertexShader> GetVertexShader();
-	std::shared_ptr<SimplePixelShader> GetPixelShader();
+	SimpleVertexShader* GetVertexShader();
+	SimplePixelShader* GetPixelShader();
+	VertexShaderHandle GetVertexShaderHandle();
+	PixelShaderHandle GetPixelShaderHandle();
 	float GetRoughness();
+	unsigned int GetId();
 
 	//setters
 	void SetColorTint(DirectX::XMFLOAT4 colorTint);
-	void SetVertexShader(SimpleVertexShader verShader);
-	void SetPixelShader(SimplePixelShader pixShader);
+	void SetVertexShader(VertexShaderHandle verShader);
+	void SetPixelShader(PixelShaderHandle pixShader);
 
 private:
 	DirectX::XMFLOAT4 colorTint;
 	float roughness;
-	std::shared_ptr<SimpleVertexShader> verShader;
-	std::shared_ptr<SimplePixelShader> pixShader;
+	VertexShaderHandle verShader;
+	PixelShaderHandle pixShader;
+
+	//small unique number for sorting draws by material
+	unsigned int id;
 };
 
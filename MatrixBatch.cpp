@@ -0,0 +1,50 @@
+#include "MatrixBatch.h"
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Multiplies every world matrix by the same view-projection
+// matrix, which stays in registers for the whole batch
+//
+// world          - Array of world matrices
+// out            - Array receiving world * viewProjection (may alias world)
+// count          - Number of matrices in each array
+// viewProjection - The camera's view * projection matrix
+// --------------------------------------------------------
+void MatrixBatch::ComputeWorldViewProjection(
+	const XMFLOAT4X4A* world,
+	XMFLOAT4X4A* out,
+	size_t count,
+	FXMMATRIX viewProjection)
+{
+	// Copy the shared matrix into locals so the compiler keeps it
+	// in registers rather than re-reading it through the reference
+	XMVECTOR vp0 = viewProjection.r[0];
+	XMVECTOR vp1 = viewProjection.r[1];
+	XMVECTOR vp2 = viewProjection.r[2];
+	XMVECTOR vp3 = viewProjection.r[3];
+
+	for (size_t i = 0; i < count; i++)
+	{
+		XMMATRIX w = XMLoadFloat4x4A(&world[i]);
+		XMMATRIX result;
+
+		// Each output row is the world row's components
+		// splatted across the view-projection rows
+		for (int r = 0; r < 4; r++)
+		{
+			XMVECTOR row = w.r[r];
+			XMVECTOR x = XMVectorSplatX(row);
+			XMVECTOR y = XMVectorSplatY(row);
+			XMVECTOR z = XMVectorSplatZ(row);
+			XMVECTOR wv = XMVectorSplatW(row);
+
+			XMVECTOR sum = XMVectorMultiply(x, vp0);
+			sum = XMVectorMultiplyAdd(y, vp1, sum);
+			sum = XMVectorMultiplyAdd(z, vp2, sum);
+			result.r[r] = XMVectorMultiplyAdd(wv, vp3, sum);
+		}
+
+		XMStoreFloat4x4A(&out[i], result);
+	}
+}
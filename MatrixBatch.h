@@ -0,0 +1,21 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <stddef.h>
+
+// --------------------------------------------------------
+// Batched matrix helpers for per-frame work over many objects
+//
+// These keep the shared matrices in SIMD registers for the
+// whole loop instead of reloading them per object, so they
+// work best on tightly packed, 16-byte aligned arrays.
+// --------------------------------------------------------
+namespace MatrixBatch
+{
+	// out[i] = world[i] * viewProjection
+	void ComputeWorldViewProjection(
+		const DirectX::XMFLOAT4X4A* world,
+		DirectX::XMFLOAT4X4A* out,
+		size_t count,
+		DirectX::FXMMATRIX viewProjection);
+}
@@ -1,21 +1,22 @@
 #pragma once
 
-#include <d3d11.h>
-#include <wrl/client.h>
 #include <DirectXMath.h>
 #include "Vertex.h"
-#include "Graphics.h"
-#include "Camera.h"
+#include "RenderDevice.h"
+#include "ResourceHandles.h"
 
 class Mesh
 {
 public:
 
 	//Method declaration
-	Microsoft::WRL::ComPtr<ID3D11Buffer> GetVertexBuffer();
-	Microsoft::WRL::ComPtr<ID3D11Buffer> GetIndexBuffer();
+	RenderDevice::Handle GetVertexBuffer();
+	RenderDevice::Handle GetIndexBuffer();
 	int GetIndexCount();
 	int GetVertexCount();
+	unsigned int GetId();
+	DirectX::XMFLOAT3 GetBoundsCenter();
+	DirectX::XMFLOAT3 GetBoundsExtents();
 	void Draw();
 
 	// Constructor(s)
@@ -24,15 +25,27 @@ public:
 	Mesh(const char* modelFile);
 	~Mesh();
 
+	// Each mesh owns its buffers
+	Mesh(const Mesh&) = delete;
+	Mesh& operator=(const Mesh&) = delete;
+
 private:
 
-	// The buffers for this mesh
-	Microsoft::WRL::ComPtr<ID3D11Buffer> vertexBuffer;
-	Microsoft::WRL::ComPtr<ID3D11Buffer> indexBuffer;
+	// The buffers for this mesh, from RenderDevice::Active
+	RenderDevice::Handle vertexBuffer = RenderDevice::NullHandle;
+	RenderDevice::Handle indexBuffer = RenderDevice::NullHandle;
 
 	// The amount of indices and vertices in the buffers
 	unsigned int indicesCount;
 	unsigned int vertexCount;
-	
+
+	// Local-space axis-aligned bounds, for culling
+	DirectX::XMFLOAT3 boundsCenter;
+	DirectX::XMFLOAT3 boundsExtents;
+
+	// Small unique number for sorting draws by mesh
+	unsigned int id;
+
+	void CreateBuffers(const Vertex* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indicesCount);
 };
 
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+#include "Vertex.h"
+
+// --------------------------------------------------------
+// Geometry on the CPU, before it becomes GPU buffers
+//
+// Kept apart from Mesh so models can be loaded and measured
+// without a graphics device (the headless benchmark does).
+// --------------------------------------------------------
+struct MeshData
+{
+	std::vector<Vertex> Vertices;
+	std::vector<unsigned int> Indices;
+
+	// Local-space axis-aligned bounds
+	DirectX::XMFLOAT3 BoundsCenter = { 0, 0, 0 };
+	DirectX::XMFLOAT3 BoundsExtents = { 0, 0, 0 };
+
+	// Replaces everything with the model in an .obj file,
+	// returning false if it couldn't be opened
+	bool LoadObj(const char* path);
+
+	void CalculateBounds();
+	static void CalculateBounds(const Vertex* vertices, unsigned int vertexCount,
+		DirectX::XMFLOAT3& center, DirectX::XMFLOAT3& extents);
+};
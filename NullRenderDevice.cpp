@@ -0,0 +1,234 @@
+#include "NullRenderDevice.h"
+#include "ImGui/imgui.h"
+#include <fstream>
+#include <string.h>
+
+namespace
+{
+	const char* commandNames[] =
+	{
+		"UpdateBuffer",
+		"SetTopology",
+		"SetVertexBuffer",
+		"SetIndexBuffer",
+		"SetShader",
+		"SetConstantBuffer",
+		"SetConstantBufferRange",
+		"DrawIndexed",
+		"Clear",
+		"DrawUI",
+		"Present",
+	};
+	static_assert(sizeof(commandNames) / sizeof(commandNames[0]) == NullRenderDevice::CommandTypeCount, "Every command needs a name");
+	static_assert(sizeof(NullRenderDevice::Command) == 16, "Commands should stay small");
+
+	// FNV-1a, so uploads of identical data record identically
+	uint32_t HashBytes(const void* data, uint32_t size)
+	{
+		uint32_t hash = 2166136261u;
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (uint32_t i = 0; bytes && i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
+	uint32_t PackColor(const float color[4])
+	{
+		uint32_t packed = 0;
+		for (int c = 0; c < 4; c++)
+		{
+			float v = color[c] < 0 ? 0 : (color[c] > 1 ? 1 : color[c]);
+			packed |= (uint32_t)(v * 255.0f + 0.5f) << (24 - c * 8);
+		}
+		return packed;
+	}
+
+	// Clear depth as the game's 24 bit depth buffer stores it.
+	// In double, as a float can't hold 16777215.5 and rounds 1 up.
+	uint32_t PackDepth(float depth)
+	{
+		float d = depth < 0 ? 0 : (depth > 1 ? 1 : depth);
+		return (uint32_t)(d * 16777215.0 + 0.5);
+	}
+}
+
+NullRenderDevice::NullRenderDevice()
+{
+	memset(counts, 0, sizeof(counts));
+	memset(&resourceStats, 0, sizeof(resourceStats));
+	recording = true;
+}
+
+void NullRenderDevice::Record(CommandType type, uint8_t stage, uint32_t slot, Handle resource, uint32_t a, uint32_t b)
+{
+	counts[type]++;
+	if (!recording)
+		return;
+
+	Command command = { type, stage, (uint16_t)slot, resource, a, b };
+	commands.push_back(command);
+}
+
+// --------------------------------------------------------
+// Forgets recorded commands and counts, keeping the memory
+// and leaving resources alone
+// --------------------------------------------------------
+void NullRenderDevice::Reset()
+{
+	commands.clear();
+	memset(counts, 0, sizeof(counts));
+}
+
+RenderDevice::Handle NullRenderDevice::AddResource(uint32_t size, bool isBuffer)
+{
+	std::lock_guard<std::mutex> lock(resourceMutex);
+
+	Handle handle;
+	if (!freeHandles.empty())
+	{
+		handle = freeHandles.back();
+		freeHandles.pop_back();
+	}
+	else
+	{
+		resources.push_back(Resource());
+		handle = (Handle)resources.size();
+	}
+
+	resources[handle - 1] = { size, true, isBuffer };
+	if (isBuffer)
+	{
+		resourceStats.LiveBuffers++;
+		resourceStats.LiveBufferBytes += size;
+	}
+	else
+	{
+		resourceStats.LiveShaders++;
+	}
+	resourceStats.Created++;
+	return handle;
+}
+
+RenderDevice::Handle NullRenderDevice::CreateBuffer(BufferType, const void*, uint32_t size)
+{
+	return AddResource(size, true);
+}
+
+RenderDevice::Handle NullRenderDevice::CreateShader(ShaderStage, const void*, size_t)
+{
+	return AddResource(0, false);
+}
+
+void NullRenderDevice::Release(Handle resource)
+{
+	std::lock_guard<std::mutex> lock(resourceMutex);
+
+	if (resource == NullHandle || resource > resources.size() || !resources[resource - 1].Live)
+		return;
+
+	Resource& r = resources[resource - 1];
+	if (r.IsBuffer)
+	{
+		resourceStats.LiveBuffers--;
+		resourceStats.LiveBufferBytes -= r.Size;
+	}
+	else
+	{
+		resourceStats.LiveShaders--;
+	}
+	r.Live = false;
+	resourceStats.Released++;
+	freeHandles.push_back(resource);
+}
+
+NullRenderDevice::ResourceStats NullRenderDevice::GetResourceStats()
+{
+	std::lock_guard<std::mutex> lock(resourceMutex);
+	return resourceStats;
+}
+
+void NullRenderDevice::UpdateBuffer(Handle buffer, const void* data, uint32_t size)
+{
+	Record(UpdateBufferCommand, 0, 0, buffer, size, HashBytes(data, size));
+}
+
+void NullRenderDevice::SetTopology(Topology topology)
+{
+	Record(SetTopologyCommand, 0, 0, NullHandle, topology, 0);
+}
+
+void NullRenderDevice::SetVertexBuffer(Handle buffer, uint32_t stride)
+{
+	Record(SetVertexBufferCommand, 0, 0, buffer, stride, 0);
+}
+
+void NullRenderDevice::SetIndexBuffer(Handle buffer)
+{
+	Record(SetIndexBufferCommand, 0, 0, buffer, 0, 0);
+}
+
+void NullRenderDevice::SetShader(ShaderStage stage, Handle shader)
+{
+	Record(SetShaderCommand, stage, 0, shader, 0, 0);
+}
+
+void NullRenderDevice::SetConstantBuffer(ShaderStage stage, uint32_t slot, Handle buffer)
+{
+	Record(SetConstantBufferCommand, stage, slot, buffer, 0, 0);
+}
+
+void NullRenderDevice::SetConstantBufferRange(ShaderStage stage, uint32_t slot, Handle buffer, uint32_t firstConstant, uint32_t constantCount)
+{
+	Record(SetConstantBufferRangeCommand, stage, slot, buffer, firstConstant, constantCount);
+}
+
+void NullRenderDevice::DrawIndexed(uint32_t indexCount, uint32_t firstIndex, int32_t)
+{
+	Record(DrawIndexedCommand, 0, 0, NullHandle, indexCount, firstIndex);
+}
+
+void NullRenderDevice::Clear(const float color[4], float depth)
+{
+	Record(ClearCommand, 0, 0, NullHandle, PackColor(color), PackDepth(depth));
+}
+
+void NullRenderDevice::DrawUI(const ImDrawData* drawData)
+{
+	uint32_t lists = drawData ? (uint32_t)drawData->CmdListsCount : 0;
+	uint32_t vertices = drawData ? (uint32_t)drawData->TotalVtxCount : 0;
+	Record(DrawUICommand, 0, 0, NullHandle, lists, vertices);
+}
+
+void NullRenderDevice::Present(bool vsync)
+{
+	Record(PresentCommand, 0, 0, NullHandle, vsync ? 1 : 0, 0);
+}
+
+const char* NullRenderDevice::GetCommandName(CommandType type)
+{
+	return type < CommandTypeCount ? commandNames[type] : "Unknown";
+}
+
+// --------------------------------------------------------
+// Writes the recorded commands as text
+//
+// path - File to create
+//
+// Returns false if the file couldn't be written
+// --------------------------------------------------------
+bool NullRenderDevice::WriteText(const char* path) const
+{
+	std::ofstream out(path);
+	if (!out)
+		return false;
+
+	for (const Command& c : commands)
+	{
+		out << GetCommandName(c.Type) << " stage=" << (unsigned int)c.Stage << " slot=" << c.Slot
+			<< " handle=" << c.Resource << " a=" << c.A << " b=" << c.B << "\n";
+	}
+	return (bool)out;
+}
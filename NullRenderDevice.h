@@ -0,0 +1,121 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include "RenderDevice.h"
+
+// --------------------------------------------------------
+// RenderDevice that draws nothing and remembers everything
+//
+// Every call made from the drawing thread is appended to a
+// flat list of 16-byte commands, which tests and benchmarks
+// can count, walk or dump as text.  Resources get real
+// handles and are tracked, but own no memory beyond that.
+// --------------------------------------------------------
+class NullRenderDevice : public RenderDevice
+{
+public:
+	enum CommandType : uint8_t
+	{
+		UpdateBufferCommand,
+		SetTopologyCommand,
+		SetVertexBufferCommand,
+		SetIndexBufferCommand,
+		SetShaderCommand,
+		SetConstantBufferCommand,
+		SetConstantBufferRangeCommand,
+		DrawIndexedCommand,
+		ClearCommand,
+		DrawUICommand,
+		PresentCommand,
+		CommandTypeCount
+	};
+
+	// What each field means depends on the type:
+	//  UpdateBuffer           - Handle, A = size, B = hash of the data
+	//  SetTopology            - A = topology
+	//  SetVertexBuffer        - Handle, A = stride
+	//  SetIndexBuffer         - Handle
+	//  SetShader              - Stage, Handle
+	//  SetConstantBuffer      - Stage, Slot, Handle
+	//  SetConstantBufferRange - Stage, Slot, Handle, A = first, B = count
+	//  DrawIndexed            - A = index count, B = first index
+	//                           (the base vertex is always 0)
+	//  Clear                  - A = RGBA8 color, B = 24 bit depth
+	//  DrawUI                 - A = command lists, B = vertices
+	//  Present                - A = vsync
+	struct Command
+	{
+		CommandType Type;
+		uint8_t Stage;
+		uint16_t Slot;
+		Handle Resource;
+		uint32_t A;
+		uint32_t B;
+	};
+
+	struct ResourceStats
+	{
+		uint32_t LiveBuffers;
+		uint32_t LiveShaders;
+		uint64_t LiveBufferBytes;
+		uint32_t Created;		// Since construction
+		uint32_t Released;
+	};
+
+	NullRenderDevice();
+
+	Handle CreateBuffer(BufferType type, const void* data, uint32_t size) override;
+	Handle CreateShader(ShaderStage stage, const void* bytecode, size_t size) override;
+	void Release(Handle resource) override;
+
+	void UpdateBuffer(Handle buffer, const void* data, uint32_t size) override;
+	void SetTopology(Topology topology) override;
+	void SetVertexBuffer(Handle buffer, uint32_t stride) override;
+	void SetIndexBuffer(Handle buffer) override;
+	void SetShader(ShaderStage stage, Handle shader) override;
+	void SetConstantBuffer(ShaderStage stage, uint32_t slot, Handle buffer) override;
+	void SetConstantBufferRange(ShaderStage stage, uint32_t slot, Handle buffer, uint32_t firstConstant, uint32_t constantCount) override;
+	void DrawIndexed(uint32_t indexCount, uint32_t firstIndex, int32_t baseVertex) override;
+
+	void Clear(const float color[4], float depth) override;
+	void DrawUI(const ImDrawData* drawData) override;
+	void Present(bool vsync) override;
+
+	// Off to only count commands, e.g. for long benchmark runs
+	void SetRecording(bool record) { recording = record; }
+
+	// Commands since the last Reset()
+	const std::vector<Command>& GetCommands() const { return commands; }
+	uint64_t GetCount(CommandType type) const { return counts[type]; }
+	void Reset();
+
+	ResourceStats GetResourceStats();
+
+	static const char* GetCommandName(CommandType type);
+
+	// One command per line, in order
+	bool WriteText(const char* path) const;
+
+private:
+	Handle AddResource(uint32_t size, bool isBuffer);
+	void Record(CommandType type, uint8_t stage, uint32_t slot, Handle resource, uint32_t a, uint32_t b);
+
+	// Recording happens on the drawing thread only
+	std::vector<Command> commands;
+	uint64_t counts[CommandTypeCount];
+	bool recording;
+
+	// Resources may come and go from any thread
+	struct Resource
+	{
+		uint32_t Size;
+		bool Live;
+		bool IsBuffer;
+	};
+
+	std::mutex resourceMutex;
+	std::vector<Resource> resources;	// Handle - 1
+	std::vector<Handle> freeHandles;
+	ResourceStats resourceStats;
+};
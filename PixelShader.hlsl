@@ -1,10 +1,8 @@
 #include "ShaderIncludes.hlsli"
 
-//Data from the constant buffer
-cbuffer ExternalData : register(b0)
+//Data that changes once per frame
+cbuffer PerFrame : register(b0)
 {
-	float4 colorTint;
-	float roughness;
 	float3 cameraPos;
 	float3 ambient;
 	Light Light1;
@@ -14,6 +12,13 @@ cbuffer ExternalData : register(b0)
 	Light PointLight2;
 }
 
+//Data that changes when the material changes
+cbuffer PerMaterial : register(b1)
+{
+	float4 colorTint;
+	float roughness;
+}
+
 // --------------------------------------------------------
 // The entry point (main method) for our pixel shader
 // 
@@ -0,0 +1,392 @@
+#include "Profiler.h"
+#include "ImGui/imgui.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <float.h>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define PROFILER_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILER_RDTSC 1
+#endif
+
+namespace Profiler
+{
+	// Annonymous namespace to hold variables
+	// only accessible in this file
+	namespace
+	{
+		// Must be a power of two.  Plenty for one frame's zones on one thread.
+		constexpr uint64_t RingCapacity = 16384;
+
+		// Frames kept for the UI and export (about 5 seconds at 60fps)
+		constexpr unsigned int HistoryFrames = 300;
+
+		// Start and End are raw ticks, converted when collected
+		struct Event
+		{
+			const char* Name;
+			int64_t Start;
+			int64_t End;
+			uint32_t Depth;
+		};
+
+		// One per thread that has ever recorded a zone
+		struct ThreadBuffer
+		{
+			Event Events[RingCapacity];
+			std::atomic<uint64_t> Written{ 0 };	// Only the owner writes this...
+			std::atomic<uint64_t> Read{ 0 };	// ...and only EndFrame() this
+			std::atomic<unsigned int> Dropped{ 0 };
+			uint32_t Depth = 0;
+			std::string Name;					// Guarded by registryMutex
+		};
+
+		// A zone once it's been collected, in nanoseconds since Initialize()
+		struct CapturedEvent
+		{
+			const char* Name;
+			int64_t Start;
+			int64_t End;
+			uint16_t Depth;
+			uint16_t Thread;
+		};
+
+		struct Frame
+		{
+			int64_t Start;
+			int64_t End;
+			std::vector<CapturedEvent> Events;
+		};
+
+		std::mutex registryMutex;
+		std::vector<std::unique_ptr<ThreadBuffer>> threads;
+		thread_local ThreadBuffer* localBuffer = 0;
+
+		// Main thread only
+		Frame history[HistoryFrames];
+		unsigned int newestFrame = 0;
+		unsigned int keptFrames = 0;
+		int64_t lastFrameEnd = 0;
+		int64_t startTicks = 0;
+		double nanosecondsPerTick = 1.0;
+		bool paused = false;
+		std::string exportStatus;
+		Stats stats = {};
+
+		int64_t SteadyNanoseconds()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		// The time stamp counter is several times cheaper to read than
+		// the OS clock and runs at a constant rate on any recent x64 CPU
+		int64_t ReadTicks()
+		{
+#if PROFILER_RDTSC
+			return (int64_t)__rdtsc();
+#else
+			return SteadyNanoseconds();
+#endif
+		}
+
+		int64_t TicksToNanoseconds(int64_t ticks)
+		{
+			return (int64_t)((ticks - startTicks) * nanosecondsPerTick);
+		}
+
+		ThreadBuffer* RegisterThread()
+		{
+			std::lock_guard<std::mutex> lock(registryMutex);
+			threads.push_back(std::make_unique<ThreadBuffer>());
+			localBuffer = threads.back().get();
+			localBuffer->Name = "Thread " + std::to_string(threads.size() - 1);
+			return localBuffer;
+		}
+
+		// Skips anything not yet collected, e.g. overhead measurements
+		void Discard(ThreadBuffer* buffer)
+		{
+			buffer->Read.store(buffer->Written.load(std::memory_order_acquire), std::memory_order_release);
+		}
+
+		void WriteEscaped(std::ofstream& out, const char* text)
+		{
+			for (; *text; text++)
+			{
+				if (*text == '"' || *text == '\\')
+					out << '\\';
+				out << *text;
+			}
+		}
+
+		// Stable, distinct colors per zone name
+		ImU32 ZoneColor(const char* name)
+		{
+			uint32_t hash = 2166136261u;
+			for (const char* c = name; *c; c++)
+				hash = (hash ^ (uint8_t)*c) * 16777619u;
+			return IM_COL32(90 + hash % 120, 90 + (hash >> 8) % 120, 90 + (hash >> 16) % 120, 255);
+		}
+	}
+}
+
+int64_t Profiler::BeginZone()
+{
+	ThreadBuffer* buffer = localBuffer ? localBuffer : RegisterThread();
+	buffer->Depth++;
+	return ReadTicks();
+}
+
+void Profiler::EndZone(const char* name, int64_t start)
+{
+	int64_t end = ReadTicks();
+	ThreadBuffer* buffer = localBuffer;
+	buffer->Depth--;
+
+	uint64_t written = buffer->Written.load(std::memory_order_relaxed);
+	if (written - buffer->Read.load(std::memory_order_acquire) >= RingCapacity)
+	{
+		buffer->Dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	Event& e = buffer->Events[written & (RingCapacity - 1)];
+	e.Name = name;
+	e.Start = start;
+	e.End = end;
+	e.Depth = buffer->Depth;
+	buffer->Written.store(written + 1, std::memory_order_release);
+}
+
+// --------------------------------------------------------
+// Sets up the profiler on the main thread, works out the
+// tick rate and measures what an empty zone costs
+// --------------------------------------------------------
+void Profiler::Initialize()
+{
+	SetThreadName("Main");
+
+#if PROFILER_RDTSC
+	// Ticks against the OS clock over a short wait
+	int64_t ticks = ReadTicks();
+	int64_t nanoseconds = SteadyNanoseconds();
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	nanosecondsPerTick = (double)(SteadyNanoseconds() - nanoseconds) / (double)(ReadTicks() - ticks);
+#endif
+	startTicks = ReadTicks();
+	lastFrameEnd = 0;
+
+	// Best of several rounds, since the first ones warm caches
+	constexpr int Rounds = 20;
+	constexpr int ZonesPerRound = 1000;
+	double best = DBL_MAX;
+	for (int r = 0; r < Rounds; r++)
+	{
+		int64_t start = ReadTicks();
+		for (int i = 0; i < ZonesPerRound; i++)
+		{
+			PROFILE_SCOPE("Profiler overhead");
+		}
+		best = std::min(best, (ReadTicks() - start) * nanosecondsPerTick / ZonesPerRound);
+		Discard(localBuffer);
+	}
+	stats.ZoneNanoseconds = best;
+}
+
+// --------------------------------------------------------
+// Forgets every frame.  Other threads must have stopped
+// recording by now, since their rings are freed.
+// --------------------------------------------------------
+void Profiler::ShutDown()
+{
+	std::lock_guard<std::mutex> lock(registryMutex);
+	threads.clear();
+	localBuffer = 0;
+	for (Frame& frame : history)
+		frame.Events.clear();
+	keptFrames = 0;
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+	ThreadBuffer* buffer = localBuffer ? localBuffer : RegisterThread();
+	std::lock_guard<std::mutex> lock(registryMutex);
+	buffer->Name = name;
+}
+
+// --------------------------------------------------------
+// Moves every thread's finished zones into this frame's
+// history.  Zones still open (e.g. on the render thread)
+// show up in whichever frame they close in.
+// --------------------------------------------------------
+void Profiler::EndFrame()
+{
+	int64_t now = TicksToNanoseconds(ReadTicks());
+	stats.FrameMilliseconds = (now - lastFrameEnd) / 1000000.0;
+
+	// While paused the rings are still emptied, just not kept
+	if (!paused)
+	{
+		newestFrame = (newestFrame + 1) % HistoryFrames;
+		keptFrames = std::min(keptFrames + 1, HistoryFrames);
+		history[newestFrame].Start = lastFrameEnd;
+		history[newestFrame].End = now;
+		history[newestFrame].Events.clear();
+	}
+	Frame& frame = history[newestFrame];
+	lastFrameEnd = now;
+
+	unsigned int zones = 0;
+	unsigned int dropped = 0;
+	std::lock_guard<std::mutex> lock(registryMutex);
+	for (size_t t = 0; t < threads.size(); t++)
+	{
+		ThreadBuffer& buffer = *threads[t];
+		uint64_t read = buffer.Read.load(std::memory_order_relaxed);
+		uint64_t written = buffer.Written.load(std::memory_order_acquire);
+		for (uint64_t i = read; i < written && !paused; i++)
+		{
+			const Event& e = buffer.Events[i & (RingCapacity - 1)];
+			frame.Events.push_back({ e.Name, TicksToNanoseconds(e.Start), TicksToNanoseconds(e.End), (uint16_t)e.Depth, (uint16_t)t });
+		}
+		buffer.Read.store(written, std::memory_order_release);
+
+		zones += (unsigned int)(written - read);
+		dropped += buffer.Dropped.load(std::memory_order_relaxed);
+	}
+	stats.Zones = zones;
+	stats.Dropped = dropped;
+}
+
+// --------------------------------------------------------
+// Writes every kept frame as Chrome trace events
+//
+// path - File to create
+//
+// Returns false if the file couldn't be written
+// --------------------------------------------------------
+bool Profiler::WriteChromeTrace(const char* path)
+{
+	std::ofstream out(path);
+	if (!out)
+		return false;
+
+	out << std::fixed << std::setprecision(3);
+	out << "{\"traceEvents\":[\n";
+
+	// Thread names first so viewers label the lanes
+	bool first = true;
+	{
+		std::lock_guard<std::mutex> lock(registryMutex);
+		for (size_t t = 0; t < threads.size(); t++)
+		{
+			out << (first ? "" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":" << t << ",\"args\":{\"name\":\"";
+			WriteEscaped(out, threads[t]->Name.c_str());
+			out << "\"}}";
+			first = false;
+		}
+	}
+
+	// Oldest frame first, times in microseconds
+	for (unsigned int f = 0; f < keptFrames; f++)
+	{
+		const Frame& frame = history[(newestFrame + HistoryFrames - keptFrames + 1 + f) % HistoryFrames];
+		for (const CapturedEvent& e : frame.Events)
+		{
+			out << (first ? "" : ",\n") << "{\"ph\":\"X\",\"name\":\"";
+			WriteEscaped(out, e.Name);
+			out << "\",\"pid\":0,\"tid\":" << e.Thread
+				<< ",\"ts\":" << e.Start / 1000.0
+				<< ",\"dur\":" << (e.End - e.Start) / 1000.0 << "}";
+			first = false;
+		}
+	}
+
+	out << "\n]}\n";
+	return (bool)out;
+}
+
+Profiler::Stats Profiler::GetStats()
+{
+	return stats;
+}
+
+// --------------------------------------------------------
+// Shows the newest frame as one flame graph per thread,
+// nested zones stacked below the zone they ran in
+// --------------------------------------------------------
+void Profiler::BuildUI()
+{
+	ImGui::Begin("Profiler");
+
+	ImGui::Text("Frame: %.3f ms, %u zones, %u dropped", stats.FrameMilliseconds, stats.Zones, stats.Dropped);
+	ImGui::Text("Zone overhead: %.1f ns", stats.ZoneNanoseconds);
+	ImGui::Checkbox("Pause", &paused);
+	ImGui::SameLine();
+	if (ImGui::Button("Save Chrome trace"))
+		exportStatus = WriteChromeTrace("profile.json") ? "Saved profile.json" : "Couldn't write profile.json";
+	if (!exportStatus.empty())
+	{
+		ImGui::SameLine();
+		ImGui::TextUnformatted(exportStatus.c_str());
+	}
+
+	if (keptFrames == 0)
+	{
+		ImGui::End();
+		return;
+	}
+
+	const Frame& frame = history[newestFrame];
+	float width = ImGui::GetContentRegionAvail().x;
+	float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+	double scale = width / (double)std::max<int64_t>(frame.End - frame.Start, 1);
+	ImDrawList* drawList = ImGui::GetWindowDrawList();
+
+	std::lock_guard<std::mutex> lock(registryMutex);
+	for (size_t t = 0; t < threads.size(); t++)
+	{
+		int rows = 0;
+		for (const CapturedEvent& e : frame.Events)
+			if (e.Thread == t)
+				rows = std::max(rows, e.Depth + 1);
+		if (rows == 0)
+			continue;
+
+		ImGui::TextUnformatted(threads[t]->Name.c_str());
+		ImVec2 origin = ImGui::GetCursorScreenPos();
+		for (const CapturedEvent& e : frame.Events)
+		{
+			if (e.Thread != t)
+				continue;
+
+			// Zones that straddle the frame edges are clipped to it
+			float x0 = (float)(std::max<int64_t>(e.Start - frame.Start, 0) * scale);
+			float x1 = (float)(std::min<int64_t>(e.End - frame.Start, frame.End - frame.Start) * scale);
+			ImVec2 min(origin.x + x0, origin.y + e.Depth * rowHeight);
+			ImVec2 max(origin.x + std::max(x1, x0 + 1.0f), min.y + rowHeight - 1.0f);
+			drawList->AddRectFilled(min, max, ZoneColor(e.Name));
+
+			if (ImGui::CalcTextSize(e.Name).x < max.x - min.x)
+				drawList->AddText(min, IM_COL32_BLACK, e.Name);
+
+			if (ImGui::IsMouseHoveringRect(min, max))
+				ImGui::SetTooltip("%s\n%.3f ms", e.Name, (e.End - e.Start) / 1000000.0);
+		}
+		ImGui::Dummy(ImVec2(width, rows * rowHeight));
+	}
+
+	ImGui::End();
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdint.h>
+
+// Set to 0 to compile every PROFILE_SCOPE away
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+#define PROFILER_CONCAT_INNER(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_INNER(a, b)
+
+// Times the rest of the enclosing scope.  The name is kept as a
+// pointer, so it must outlive the profiler (string literals do).
+#if PROFILER_ENABLED
+#define PROFILE_SCOPE(name) Profiler::Zone PROFILER_CONCAT(profileZone, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name)
+#endif
+
+// --------------------------------------------------------
+// Hierarchical CPU profiler
+//
+// Zones are timed with the CPU time stamp counter (converted
+// to nanoseconds when collected) and written, once each as
+// they close, to a ring buffer owned by the thread that ran
+// them.  Only that thread writes to its ring and only the
+// main thread reads from it (in EndFrame()), so recording
+// never locks.  A full ring drops zones rather than waiting.
+//
+// The last few hundred frames are kept for a flame graph in
+// ImGui and for export as Chrome trace events, which open in
+// chrome://tracing or https://ui.perfetto.dev.
+// --------------------------------------------------------
+namespace Profiler
+{
+	struct Stats
+	{
+		double FrameMilliseconds;		// Between the last two EndFrame() calls
+		unsigned int Zones;				// Recorded during the last frame
+		unsigned int Dropped;			// Lost to full rings since Initialize()
+		double ZoneNanoseconds;			// Measured cost of one empty zone
+	};
+
+	// Names the calling thread and measures the zone overhead
+	void Initialize();
+	void ShutDown();
+
+	// Shown instead of "Thread N" in the UI and traces
+	void SetThreadName(const char* name);
+
+	// Main thread, once per frame: collects every thread's zones
+	void EndFrame();
+
+	// Every kept frame as Chrome trace-event JSON
+	bool WriteChromeTrace(const char* path);
+
+	Stats GetStats();
+
+	// Flame graph of the last frame, plus export
+	void BuildUI();
+
+	// Use PROFILE_SCOPE instead of calling these directly
+	int64_t BeginZone();
+	void EndZone(const char* name, int64_t start);
+
+	class Zone
+	{
+	public:
+		explicit Zone(const char* name) : name(name), start(BeginZone()) {}
+		~Zone() { EndZone(name, start); }
+		Zone(const Zone&) = delete;
+		Zone& operator=(const Zone&) = delete;
+
+	private:
+		const char* name;
+		int64_t start;
+	};
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct ImDrawData;
+
+// --------------------------------------------------------
+// The small slice of a graphics API the renderer needs
+//
+// Buffers, shaders and constant buffers are created through
+// this and referred to by handle, and every per-frame call
+// (state, binds, draws, present) goes through it too, so the
+// render path doesn't care what's underneath.
+// D3D11RenderDevice does the real drawing; NullRenderDevice
+// records each call instead, for measuring the CPU side and
+// checking what was submitted without a GPU.
+//
+// Textures, samplers and input layouts are still made with
+// Direct3D directly - D3D11RenderDevice can turn handles back
+// into native objects for code that needs them.
+// --------------------------------------------------------
+class RenderDevice
+{
+public:
+	// 0 is never a valid resource
+	typedef uint32_t Handle;
+	static constexpr Handle NullHandle = 0;
+
+	enum BufferType : uint8_t
+	{
+		VertexBuffer,
+		IndexBuffer,		// 32-bit indices
+		ConstantBuffer,		// Updated with UpdateBuffer()
+	};
+
+	enum ShaderStage : uint8_t
+	{
+		VertexStage,
+		PixelStage,
+		DomainStage,
+		HullStage,
+		GeometryStage,
+		ComputeStage,
+		ShaderStageCount
+	};
+
+	enum Topology : uint8_t
+	{
+		TriangleList,
+		TriangleStrip,
+		LineList,
+		PointList,
+	};
+
+	virtual ~RenderDevice() = default;
+
+	// The device everything draws with.  Set once at startup and
+	// left alone while anything could be drawing.
+	static inline RenderDevice* Active = 0;
+
+	// Resources - may be called from any thread
+	// - data may be null for constant buffers, which are filled later
+	virtual Handle CreateBuffer(BufferType type, const void* data, uint32_t size) = 0;
+	virtual Handle CreateShader(ShaderStage stage, const void* bytecode, size_t size) = 0;
+	virtual void Release(Handle resource) = 0;
+
+	// Everything else - only from the thread that draws
+	virtual void UpdateBuffer(Handle buffer, const void* data, uint32_t size) = 0;
+	virtual void SetTopology(Topology topology) = 0;
+	virtual void SetVertexBuffer(Handle buffer, uint32_t stride) = 0;
+	virtual void SetIndexBuffer(Handle buffer) = 0;
+	virtual void SetShader(ShaderStage stage, Handle shader) = 0;
+	virtual void SetConstantBuffer(ShaderStage stage, uint32_t slot, Handle buffer) = 0;
+
+	// Binds part of a larger constant buffer, in 16-byte constants
+	virtual void SetConstantBufferRange(ShaderStage stage, uint32_t slot, Handle buffer, uint32_t firstConstant, uint32_t constantCount) = 0;
+
+	virtual void DrawIndexed(uint32_t indexCount, uint32_t firstIndex, int32_t baseVertex) = 0;
+
+	// Frame - clear the back and depth buffers, draw the UI, show the result
+	virtual void Clear(const float color[4], float depth) = 0;
+	virtual void DrawUI(const ImDrawData* drawData) = 0;
+	virtual void Present(bool vsync) = 0;
+};
@@ -0,0 +1,156 @@
+#include "RenderQueue.h"
+#include "JobSystem.h"
+#include "MatrixBatch.h"
+#include <algorithm>
+#include <chrono>
+#include <float.h>
+#include <string.h>
+
+using namespace DirectX;
+
+namespace
+{
+	// Objects per job - enough that each one does real work
+	constexpr uint32_t ObjectsPerBatch = 512;
+
+	// Bits of the sort key, highest first
+	constexpr int MaterialShift = 48;
+	constexpr int MeshShift = 32;
+
+	double MillisecondsSince(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+}
+
+// --------------------------------------------------------
+// Culls and sorts the objects for this frame
+//
+// objects    - Everything that could be drawn
+// count      - How many objects there are
+// view       - The camera's view matrix
+// projection - The camera's projection matrix
+//
+// Transforms must already be interpolated for this frame,
+// since the render world matrices are what get drawn.
+// --------------------------------------------------------
+void RenderQueue::Build(
+	const Object* objects,
+	uint32_t count,
+	FXMMATRIX view,
+	CXMMATRIX projection)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	worldMatrices.resize(count);
+	worldInvTransposeMatrices.resize(count);
+	wvpMatrices.resize(count);
+
+	// Last frame's lists are in memory about to be reused, so
+	// every list starts again empty rather than cleared
+	buckets.resize(JobSystem::GetThreadCount());
+	for (Bucket& bucket : buckets)
+		bucket.Items = ItemList();
+
+	// Frustum planes straight from the combined matrix's columns (with
+	// D3D's 0-1 depth), as (normal, distance) so inside is positive
+	XMMATRIX viewProj = XMMatrixMultiply(view, projection);
+	XMMATRIX columns = XMMatrixTranspose(viewProj);
+	XMVECTOR planes[6] =
+	{
+		XMVectorAdd(columns.r[3], columns.r[0]),		// Left
+		XMVectorSubtract(columns.r[3], columns.r[0]),	// Right
+		XMVectorAdd(columns.r[3], columns.r[1]),		// Bottom
+		XMVectorSubtract(columns.r[3], columns.r[1]),	// Top
+		columns.r[2],									// Near
+		XMVectorSubtract(columns.r[3], columns.r[2]),	// Far
+	};
+
+	// Projected size = radius * cot(fov / 2) / depth, as a fraction of screen height
+	XMFLOAT4X4 proj;
+	XMStoreFloat4x4(&proj, projection);
+	float lodScale = proj._22 * 0.5f;
+
+	JobSystem::ParallelFor(count, ObjectsPerBatch, [&](uint32_t begin, uint32_t end)
+	{
+		unsigned int thread = JobSystem::GetThreadIndex();
+		Bucket& bucket = buckets[thread < buckets.size() ? thread : 0];
+
+		for (uint32_t i = begin; i < end; i++)
+		{
+			const Object& o = objects[i];
+			worldMatrices[i] = TransformSystem::GetRenderWorldMatrix(o.Transform);
+			worldInvTransposeMatrices[i] = TransformSystem::GetRenderWorldInverseTransposeMatrix(o.Transform);
+
+			// World-space box: the center moves like a point, and each
+			// world axis picks up the absolute contribution of every local one
+			const XMFLOAT3& localCenter = o.BoundsCenter;
+			const XMFLOAT3& localExtents = o.BoundsExtents;
+			XMMATRIX world = XMLoadFloat4x4A(&worldMatrices[i]);
+			XMVECTOR center = XMVector3TransformCoord(XMLoadFloat3(&localCenter), world);
+			XMVECTOR extents = XMVectorAdd(XMVectorAdd(
+				XMVectorScale(XMVectorAbs(world.r[0]), localExtents.x),
+				XMVectorScale(XMVectorAbs(world.r[1]), localExtents.y)),
+				XMVectorScale(XMVectorAbs(world.r[2]), localExtents.z));
+			center = XMVectorSetW(center, 1.0f);
+
+			// Outside if the whole box is behind any one plane
+			bool visible = true;
+			for (int p = 0; p < 6 && visible; p++)
+			{
+				float distance = XMVectorGetX(XMVector4Dot(planes[p], center));
+				float radius = XMVectorGetX(XMVector3Dot(XMVectorAbs(planes[p]), extents));
+				visible = distance + radius >= 0.0f;
+			}
+			if (!visible)
+				continue;
+
+			// Level of detail from how much of the screen the bounds cover
+			float depth = XMVectorGetZ(XMVector3TransformCoord(center, view));
+			float radius = XMVectorGetX(XMVector3Length(extents));
+			float screenSize = depth > 0.0f ? radius * lodScale / depth : FLT_MAX;
+			uint32_t lod = 0;
+			while (lod < sizeof(LodScreenSizes) / sizeof(LodScreenSizes[0]) && screenSize < LodScreenSizes[lod])
+				lod++;
+			if (lod >= o.LodCount)
+				lod = o.LodCount - 1;
+
+			// Positive floats sort the same as their bits
+			float clampedDepth = depth > 0.0f ? depth : 0.0f;
+			uint32_t depthBits;
+			memcpy(&depthBits, &clampedDepth, sizeof(depthBits));
+
+			Item item;
+			item.SortKey =
+				((uint64_t)(o.MaterialId & 0xFFFF) << MaterialShift) |
+				((uint64_t)(o.MeshIds[lod] & 0xFFFF) << MeshShift) |
+				depthBits;
+			item.Entity = i;
+			item.Lod = lod;
+			bucket.Items.push_back(item);
+		}
+
+		MatrixBatch::ComputeWorldViewProjection(&worldMatrices[begin], &wvpMatrices[begin], end - begin, viewProj);
+	});
+
+	stats.Entities = count;
+	stats.CullMilliseconds = MillisecondsSince(start);
+	start = std::chrono::high_resolution_clock::now();
+
+	size_t visible = 0;
+	for (Bucket& bucket : buckets)
+		visible += bucket.Items.size();
+	items = ItemList();
+	items.reserve(visible);
+	for (Bucket& bucket : buckets)
+		items.insert(items.end(), bucket.Items.begin(), bucket.Items.end());
+
+	std::sort(items.begin(), items.end(), [](const Item& a, const Item& b)
+	{
+		// Entity index breaks ties so the order never depends on threads
+		return a.SortKey != b.SortKey ? a.SortKey < b.SortKey : a.Entity < b.Entity;
+	});
+
+	stats.Visible = (unsigned int)items.size();
+	stats.SortMilliseconds = MillisecondsSince(start);
+}
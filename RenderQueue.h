@@ -0,0 +1,90 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <stdint.h>
+#include <vector>
+#include "FrameAllocator.h"
+#include "TransformSystem.h"
+
+// --------------------------------------------------------
+// Builds the list of things to draw each frame
+//
+// Every object's render matrices are gathered, its mesh
+// bounds moved into world space, tested against the camera
+// frustum, given a level of detail and a sort key, all as one
+// parallel pass over ranges of objects.  Each thread appends
+// what it finds visible to its own bucket, so nothing is
+// locked; the buckets are merged and sorted at the end.
+// Buckets and the sorted list live in frame memory (see
+// FrameAllocator.h), so building them never touches the heap.
+//
+// Objects are plain data (a transform, bounds and ids), so
+// this runs without a graphics device.
+// --------------------------------------------------------
+class RenderQueue
+{
+public:
+	// Most levels of detail an object can have
+	static constexpr uint32_t MaxLods = 4;
+
+	// What the queue needs to know about one drawable thing
+	struct Object
+	{
+		TransformSystem::Handle Transform;
+		DirectX::XMFLOAT3 BoundsCenter;		// Local space, of the full detail mesh
+		DirectX::XMFLOAT3 BoundsExtents;
+		uint32_t MaterialId;
+		uint32_t LodCount;					// At least 1
+		uint32_t MeshIds[MaxLods];
+	};
+
+	struct Item
+	{
+		uint64_t SortKey;	// Material, then mesh, then front to back
+		uint32_t Entity;	// Index into the objects given to Build()
+		uint32_t Lod;
+	};
+	typedef FrameAllocator::Vector<Item> ItemList;
+
+	struct Stats
+	{
+		unsigned int Entities;
+		unsigned int Visible;
+		double CullMilliseconds;	// Gather, bounds, culling, LOD and keys
+		double SortMilliseconds;	// Merging buckets and sorting
+	};
+
+	void Build(
+		const Object* objects,
+		uint32_t count,
+		DirectX::FXMMATRIX view,
+		DirectX::CXMMATRIX projection);
+
+	// Sorted visible items from the last Build(), valid until the
+	// end of the frame after it
+	const ItemList& GetItems() const { return items; }
+
+	// Per-object arrays from the last Build(), indexed like the objects
+	const DirectX::XMFLOAT4X4A& GetWorldMatrix(uint32_t entity) const { return worldMatrices[entity]; }
+	const DirectX::XMFLOAT4X4A& GetWorldInverseTransposeMatrix(uint32_t entity) const { return worldInvTransposeMatrices[entity]; }
+	const DirectX::XMFLOAT4X4A& GetWorldViewProjectionMatrix(uint32_t entity) const { return wvpMatrices[entity]; }
+
+	Stats GetStats() const { return stats; }
+
+	// Screen height fractions below which each lower level of detail kicks in
+	static constexpr float LodScreenSizes[] = { 0.25f, 0.08f, 0.02f };
+
+private:
+	// One per thread, padded so neighbours don't share cache lines
+	struct alignas(64) Bucket
+	{
+		ItemList Items;
+	};
+
+	std::vector<DirectX::XMFLOAT4X4A> worldMatrices;
+	std::vector<DirectX::XMFLOAT4X4A> worldInvTransposeMatrices;
+	std::vector<DirectX::XMFLOAT4X4A> wvpMatrices;
+	std::vector<Bucket> buckets;
+	ItemList items;
+	Stats stats = {};
+};
@@ -0,0 +1,182 @@
+#include "RenderStats.h"
+#include "ImGui/imgui.h"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <string>
+
+namespace RenderStats
+{
+	// Annonymous namespace to hold variables
+	// only accessible in this file
+	namespace
+	{
+		const char* names[CounterCount] =
+		{
+			"Draw calls",
+			"Triangles",
+			"Shader binds",
+			"Buffer binds",
+			"Constant buffer uploads",
+			"Constant buffer bytes",
+			"UI draw calls",
+		};
+
+		// Column headers for the CSV, matching names
+		const char* columns[CounterCount] =
+		{
+			"draw_calls",
+			"triangles",
+			"shader_binds",
+			"buffer_binds",
+			"cb_uploads",
+			"cb_bytes",
+			"ui_draw_calls",
+		};
+
+		// The frame being counted
+		std::atomic<uint64_t> current[CounterCount] = {};
+
+		// Finished frames, guarded by historyMutex
+		std::mutex historyMutex;
+		Frame history[HistoryFrames] = {};
+		unsigned int next = 0;
+		unsigned int count = 0;
+		uint64_t totalFrames = 0;
+		uint64_t sums[CounterCount] = {};	// Of everything in the ring
+		std::chrono::steady_clock::time_point lastEnd = std::chrono::steady_clock::now();
+
+		// Main thread only
+		std::string exportStatus;
+	}
+}
+
+void RenderStats::Add(Counter counter, uint64_t amount)
+{
+	current[counter].fetch_add(amount, std::memory_order_relaxed);
+}
+
+// --------------------------------------------------------
+// Moves this frame's totals into the history and starts
+// counting the next one from zero
+// --------------------------------------------------------
+void RenderStats::EndFrame()
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+	Frame frame;
+	frame.Milliseconds = std::chrono::duration<float, std::milli>(now - lastEnd).count();
+	for (int c = 0; c < CounterCount; c++)
+		frame.Values[c] = current[c].exchange(0, std::memory_order_relaxed);
+
+	std::lock_guard<std::mutex> lock(historyMutex);
+	lastEnd = now;
+	for (int c = 0; c < CounterCount; c++)
+		sums[c] += frame.Values[c] - (count == HistoryFrames ? history[next].Values[c] : 0);
+	history[next] = frame;
+	next = (next + 1) % HistoryFrames;
+	if (count < HistoryFrames)
+		count++;
+	totalFrames++;
+}
+
+RenderStats::Frame RenderStats::GetLastFrame()
+{
+	std::lock_guard<std::mutex> lock(historyMutex);
+	if (count == 0)
+		return Frame{};
+	return history[(next + HistoryFrames - 1) % HistoryFrames];
+}
+
+const char* RenderStats::GetName(Counter counter)
+{
+	return names[counter];
+}
+
+// --------------------------------------------------------
+// Writes the kept frames as CSV
+//
+// path - File to create
+//
+// Returns false if the file couldn't be written
+// --------------------------------------------------------
+bool RenderStats::WriteCsv(const char* path)
+{
+	std::ofstream out(path);
+	if (!out)
+		return false;
+
+	out << "frame,milliseconds";
+	for (int c = 0; c < CounterCount; c++)
+		out << "," << columns[c];
+	out << "\n";
+
+	std::lock_guard<std::mutex> lock(historyMutex);
+	unsigned int first = count == HistoryFrames ? next : 0;
+	uint64_t frameNumber = totalFrames - count;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const Frame& frame = history[(first + i) % HistoryFrames];
+		out << frameNumber + i << "," << frame.Milliseconds;
+		for (int c = 0; c < CounterCount; c++)
+			out << "," << frame.Values[c];
+		out << "\n";
+	}
+	return (bool)out;
+}
+
+// --------------------------------------------------------
+// Overlay in the top right corner
+// --------------------------------------------------------
+void RenderStats::BuildUI()
+{
+	// Last frame and the average of everything kept
+	Frame last = {};
+	double averages[CounterCount] = {};
+	{
+		std::lock_guard<std::mutex> lock(historyMutex);
+		if (count > 0)
+			last = history[(next + HistoryFrames - 1) % HistoryFrames];
+		for (int c = 0; c < CounterCount && count > 0; c++)
+			averages[c] = (double)sums[c] / count;
+	}
+
+	const float padding = 10.0f;
+	ImGuiIO& io = ImGui::GetIO();
+	ImGui::SetNextWindowPos(ImVec2(io.DisplaySize.x - padding, padding), ImGuiCond_Always, ImVec2(1.0f, 0.0f));
+	ImGui::SetNextWindowBgAlpha(0.35f);
+	ImGui::Begin("Render Stats", 0,
+		ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings |
+		ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav | ImGuiWindowFlags_NoMove);
+
+	ImGui::Text("Render frame: %.2f ms", last.Milliseconds);
+	if (ImGui::BeginTable("RenderStatsTable", 3))
+	{
+		ImGui::TableSetupColumn("Counter");
+		ImGui::TableSetupColumn("Last");
+		ImGui::TableSetupColumn("Average");
+		ImGui::TableHeadersRow();
+		for (int c = 0; c < CounterCount; c++)
+		{
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(names[c]);
+			ImGui::TableNextColumn();
+			ImGui::Text("%llu", (unsigned long long)last.Values[c]);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.1f", averages[c]);
+		}
+		ImGui::EndTable();
+	}
+
+	if (ImGui::Button("Save CSV"))
+		exportStatus = WriteCsv("renderstats.csv") ? "Saved renderstats.csv" : "Couldn't write renderstats.csv";
+	if (!exportStatus.empty())
+	{
+		ImGui::SameLine();
+		ImGui::TextUnformatted(exportStatus.c_str());
+	}
+
+	ImGui::End();
+}
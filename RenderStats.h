@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+
+// --------------------------------------------------------
+// Per-frame rendering counters
+//
+// Whatever issues GPU work (meshes, shaders, the ImGui
+// backend) adds to these as it goes, and the end of each
+// rendered frame moves the totals into a history ring.
+// This is the baseline to compare render changes against.
+//
+// Counting is a relaxed atomic add, so it's safe from any
+// thread, though only the render thread normally counts.
+// --------------------------------------------------------
+namespace RenderStats
+{
+	enum Counter
+	{
+		DrawCalls,
+		Triangles,
+		ShaderBinds,
+		BufferBinds,				// Vertex, index and constant buffers
+		ConstantBufferUploads,
+		ConstantBufferBytes,
+		UIDrawCalls,				// Included in DrawCalls too
+		CounterCount
+	};
+
+	// Frames kept in the ring
+	constexpr unsigned int HistoryFrames = 1024;
+
+	struct Frame
+	{
+		float Milliseconds;			// Since the previous EndFrame()
+		uint64_t Values[CounterCount];
+	};
+
+	void Add(Counter counter, uint64_t amount = 1);
+
+	// Call once the frame's GPU work is all issued
+	void EndFrame();
+
+	Frame GetLastFrame();
+	const char* GetName(Counter counter);
+
+	// Frame time and every counter, oldest frame first
+	bool WriteCsv(const char* path);
+
+	// Small overlay with the last frame and recent averages
+	void BuildUI();
+}
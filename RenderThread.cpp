@@ -0,0 +1,218 @@
+#include "RenderThread.h"
+#include "AllocationTracker.h"
+#include "Profiler.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// --------------------------------------------------------
+// Frees the copied ImGui draw lists
+// --------------------------------------------------------
+FrameSnapshot::~FrameSnapshot()
+{
+	ClearUI();
+}
+
+// --------------------------------------------------------
+// Copies ImGui's draw data, since ImGui reuses its own lists
+// as soon as the next frame starts.  Only call this (and
+// ClearUI) from the thread running ImGui.
+// --------------------------------------------------------
+void FrameSnapshot::CopyUI(ImDrawData* drawData)
+{
+	ClearUI();
+	UI = *drawData;
+	for (int i = 0; i < UI.CmdLists.Size; i++)
+		UI.CmdLists[i] = drawData->CmdLists[i]->CloneOutput();
+}
+
+void FrameSnapshot::ClearUI()
+{
+	for (int i = 0; i < UI.CmdLists.Size; i++)
+		IM_DELETE(UI.CmdLists[i]);
+	UI.CmdLists.clear();
+	UI.CmdListsCount = 0;
+	UI.Valid = false;
+}
+
+namespace RenderThread
+{
+	// Annonymous namespace to hold variables
+	// only accessible in this file
+	namespace
+	{
+		typedef std::chrono::steady_clock Clock;
+
+		// How quickly the averages follow new frames
+		constexpr double Smoothing = 0.05;
+
+		constexpr int NoFrame = -1;
+
+		FrameSnapshot snapshots[3];
+		int writeIndex = 0;				// Game thread's
+		int readyIndex = NoFrame;		// Waiting for the render thread
+		int readIndex = 2;				// Render thread's
+		bool rendering = false;
+		bool running = false;
+		bool threaded = false;
+
+		RenderFunction renderFunction = 0;
+		std::thread thread;
+		std::mutex mutex;
+		std::condition_variable frameReady;	// Render thread waits on this
+		std::condition_variable frameTaken;	// Game thread waits on this
+
+		Stats stats = {};
+		Clock::time_point lastSubmit;
+
+		double Milliseconds(Clock::duration d)
+		{
+			return std::chrono::duration<double, std::milli>(d).count();
+		}
+
+		void Accumulate(double& average, double sample)
+		{
+			average += (sample - average) * Smoothing;
+		}
+
+		void Render(const FrameSnapshot& snapshot)
+		{
+			Clock::time_point start = Clock::now();
+			{
+				ALLOCATION_TAG("Render");
+				renderFunction(snapshot);
+			}
+			double elapsed = Milliseconds(Clock::now() - start);
+
+			std::lock_guard<std::mutex> lock(mutex);
+			Accumulate(stats.RenderMilliseconds, elapsed);
+		}
+
+		void RenderMain()
+		{
+			Profiler::SetThreadName("Render");
+			while (true)
+			{
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					frameReady.wait(lock, [] { return readyIndex != NoFrame || !running; });
+					if (readyIndex == NoFrame)
+						return;
+
+					readIndex = readyIndex;
+					readyIndex = NoFrame;
+					rendering = true;
+				}
+				frameTaken.notify_all();
+
+				Render(snapshots[readIndex]);
+
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					rendering = false;
+				}
+				frameTaken.notify_all();
+			}
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Starts drawing submitted frames
+//
+// render      - Draws one snapshot (called on the render thread)
+// runThreaded - False to draw inline in Submit() instead, which
+//               is useful for comparing timings
+// --------------------------------------------------------
+void RenderThread::Start(RenderFunction render, bool runThreaded)
+{
+	renderFunction = render;
+	threaded = runThreaded;
+	running = true;
+	stats = {};
+	stats.Threaded = runThreaded;
+	lastSubmit = Clock::now();
+
+	if (threaded)
+		thread = std::thread(RenderMain);
+}
+
+// --------------------------------------------------------
+// Draws anything still pending, then stops the thread
+// --------------------------------------------------------
+void RenderThread::Stop()
+{
+	if (!running)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = false;
+	}
+	frameReady.notify_all();
+
+	if (thread.joinable())
+		thread.join();
+
+	for (FrameSnapshot& snapshot : snapshots)
+		snapshot.ClearUI();
+}
+
+FrameSnapshot& RenderThread::BeginFrame()
+{
+	return snapshots[writeIndex];
+}
+
+// --------------------------------------------------------
+// Hands the snapshot from BeginFrame() to the render thread
+// and moves the game thread on to a free one
+// --------------------------------------------------------
+void RenderThread::Submit()
+{
+	Clock::time_point start = Clock::now();
+
+	if (!threaded)
+	{
+		Render(snapshots[writeIndex]);
+	}
+	else
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+
+		// The last frame hasn't been picked up, so we're a frame ahead
+		frameTaken.wait(lock, [] { return readyIndex == NoFrame; });
+
+		readyIndex = writeIndex;
+		writeIndex = 3 - readyIndex - readIndex;
+		lock.unlock();
+		frameReady.notify_one();
+	}
+
+	// Time in here is waiting (threaded) or rendering (inline),
+	// and everything else since the last Submit() is game work
+	Clock::time_point end = Clock::now();
+	double submit = Milliseconds(end - start);
+	double frame = Milliseconds(end - lastSubmit);
+	lastSubmit = end;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	Accumulate(stats.WaitMilliseconds, threaded ? submit : 0.0);
+	Accumulate(stats.FrameMilliseconds, frame);
+	Accumulate(stats.GameMilliseconds, frame - submit);
+}
+
+void RenderThread::Flush()
+{
+	if (!threaded)
+		return;
+
+	std::unique_lock<std::mutex> lock(mutex);
+	frameTaken.wait(lock, [] { return readyIndex == NoFrame && !rendering; });
+}
+
+RenderThread::Stats RenderThread::GetStats()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
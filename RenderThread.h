@@ -0,0 +1,99 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+#include "ImGui/imgui.h"
+#include "Lights.h"
+
+class Mesh;
+class Material;
+class SimpleVertexShader;
+class SimplePixelShader;
+
+// One visible object, with everything copied that the game
+// thread might change while the frame is being drawn
+struct DrawCommand
+{
+	DirectX::XMFLOAT4X4A World;
+	DirectX::XMFLOAT4X4A WorldInvTranspose;
+	DirectX::XMFLOAT4X4A WorldViewProjection;
+	Mesh* Geometry;
+	const Material* Source;				// Only compared, to spot material changes
+	SimpleVertexShader* VertexShader;
+	SimplePixelShader* PixelShader;
+	DirectX::XMFLOAT4 ColorTint;
+	float Roughness;
+};
+
+// --------------------------------------------------------
+// Everything needed to draw one frame, produced by the game
+// thread and never changed once handed to the render thread
+//
+// Meshes, materials and shaders are referenced, not copied,
+// so they must live until the render thread is stopped.
+// --------------------------------------------------------
+struct FrameSnapshot
+{
+	float ClearColor[4];
+	float ScreenWidth;
+	float ScreenHeight;
+	DirectX::XMFLOAT3 CameraPosition;
+	DirectX::XMFLOAT3 AmbientColor;
+	Light Light1;
+	Light Light2;
+	Light Light3;
+	Light PointLight1;
+	Light PointLight2;
+
+	std::vector<DrawCommand> Draws;	// Already sorted
+
+	// Private copies of this frame's ImGui draw lists
+	ImDrawData UI;
+
+	FrameSnapshot() = default;
+	~FrameSnapshot();
+	FrameSnapshot(const FrameSnapshot&) = delete;
+	FrameSnapshot& operator=(const FrameSnapshot&) = delete;
+
+	void CopyUI(ImDrawData* drawData);
+	void ClearUI();
+};
+
+// --------------------------------------------------------
+// Draws frames on a dedicated thread
+//
+// Three snapshots rotate between the game thread (filling one),
+// the hand-off slot and the render thread (drawing one), so the
+// two threads only ever meet for a moment at Submit().  The game
+// thread waits there if the render thread hasn't picked up the
+// last frame yet, which keeps it at most one frame ahead.
+//
+// When not threaded, Submit() just draws the frame inline.
+// --------------------------------------------------------
+namespace RenderThread
+{
+	typedef void (*RenderFunction)(const FrameSnapshot& snapshot);
+
+	// Averages over recent frames, in milliseconds
+	struct Stats
+	{
+		bool Threaded;
+		double FrameMilliseconds;	// Between consecutive Submit() calls
+		double GameMilliseconds;	// Game thread time per frame, not counting waits
+		double RenderMilliseconds;	// Render function time per frame
+		double WaitMilliseconds;	// Game thread blocked in Submit()
+	};
+
+	void Start(RenderFunction render, bool threaded);
+	void Stop();
+
+	// Game thread: the snapshot to fill for the next frame, then hand it over
+	FrameSnapshot& BeginFrame();
+	void Submit();
+
+	// Blocks until every submitted frame has been drawn.  Required
+	// before touching anything the render thread uses (e.g. resizing).
+	void Flush();
+
+	Stats GetStats();
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "ResourcePool.h"
+
+class Mesh;
+class Material;
+class SimpleVertexShader;
+class SimplePixelShader;
+
+// What entities and materials refer to resources by (see
+// Resources.h).  Declared apart from the classes so code that
+// only stores handles needn't include them.
+typedef ResourcePool<Mesh>::Handle MeshHandle;
+typedef ResourcePool<Material>::Handle MaterialHandle;
+typedef ResourcePool<SimpleVertexShader>::Handle VertexShaderHandle;
+typedef ResourcePool<SimplePixelShader>::Handle PixelShaderHandle;
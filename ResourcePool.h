@@ -0,0 +1,246 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+// --------------------------------------------------------
+// Owns every object of one type and hands out 32-bit handles
+// to them instead of pointers
+//
+// A handle is a slot index plus the slot's generation, which
+// goes up each time the slot's object is released - so a
+// handle to something released looks up as null rather than
+// as whatever reuses the slot.  Objects sit in place in fixed
+// chunks of slots that never move, so lookups take no lock
+// and touch no reference counts, while Create() and Release()
+// on other threads lock only to claim or return slots.
+//
+// Lifetime is explicit: an object lives until Release(), and
+// even then is only destroyed a few EndFrame() calls later,
+// since the render thread may still be drawing a frame that
+// was given its raw pointer.
+// --------------------------------------------------------
+template<typename T>
+class ResourcePool
+{
+public:
+	static constexpr uint32_t IndexBits = 20;
+	static constexpr uint32_t IndexMask = (1u << IndexBits) - 1;
+	static constexpr uint32_t GenerationMask = (1u << (32 - IndexBits)) - 1;
+	static constexpr uint32_t ChunkSize = 256;
+	static constexpr uint32_t MaxChunks = (IndexMask + 1) / ChunkSize;
+	static constexpr uint32_t NoSlot = 0xFFFFFFFF;
+
+	// EndFrame() calls between Release() and the destructor
+	static constexpr uint32_t DestroyDelay = 3;
+
+	// Only converts to and from handles into pools of T.
+	// Generations start at 1, so 0 is never a live handle.
+	struct Handle
+	{
+		uint32_t Value = 0;
+
+		bool IsNull() const { return Value == 0; }
+		bool operator==(Handle other) const { return Value == other.Value; }
+		bool operator!=(Handle other) const { return Value != other.Value; }
+	};
+
+	struct Stats
+	{
+		uint32_t Live;			// Created and not yet released
+		uint32_t Pending;		// Released, waiting to be destroyed
+		uint32_t Slots;			// Ever used, live or not
+	};
+
+	ResourcePool() = default;
+	~ResourcePool()
+	{
+		Clear();
+		for (std::atomic<Chunk*>& chunk : chunks)
+			delete chunk.load(std::memory_order_relaxed);
+	}
+
+	ResourcePool(const ResourcePool&) = delete;
+	ResourcePool& operator=(const ResourcePool&) = delete;
+
+	// Constructs a T from the arguments.  The constructor runs
+	// outside the lock, so loads on several threads overlap.
+	// A null handle, with nothing constructed, if all 2^20
+	// slots hold live or pending objects.
+	template<typename... Args>
+	Handle Create(Args&&... args)
+	{
+		uint32_t index = ClaimSlot();
+		if (index == NoSlot)
+			return Handle();
+
+		Slot& slot = GetSlot(index);
+		new (slot.Storage) T(std::forward<Args>(args)...);
+
+		slot.LiveGeneration.store(slot.Generation, std::memory_order_release);
+		return MakeHandle(index, slot.Generation);
+	}
+
+	// The object, or null for a null, released or foreign handle
+	T* Get(Handle handle) const
+	{
+		uint32_t index = handle.Value & IndexMask;
+		Chunk* chunk = chunks[index / ChunkSize].load(std::memory_order_acquire);
+		if (!chunk || handle.IsNull())
+			return 0;
+
+		Slot& slot = chunk->Slots[index % ChunkSize];
+		if (slot.LiveGeneration.load(std::memory_order_acquire) != handle.Value >> IndexBits)
+			return 0;
+		return (T*)slot.Storage;
+	}
+
+	// Invalidates the handle now and destroys the object once
+	// no frame in flight can be using it.  Stale handles are ignored.
+	void Release(Handle handle)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!Get(handle))
+			return;
+
+		uint32_t index = handle.Value & IndexMask;
+		Kill(GetSlot(index));
+		pending.push_back({ index, DestroyDelay });
+	}
+
+	// Once per frame: destroys whatever was released long enough ago
+	void EndFrame()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		size_t kept = 0;
+		for (size_t i = 0; i < pending.size(); i++)
+		{
+			if (--pending[i].FramesLeft > 0)
+				pending[kept++] = pending[i];
+			else
+				Destroy(pending[i].Index);
+		}
+		pending.resize(kept);
+	}
+
+	// Destroys everything at once, live or pending.  Nothing may
+	// be drawing with any of it.
+	void Clear()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (uint32_t index = 0; index < slotCount; index++)
+		{
+			Slot& slot = GetSlot(index);
+			if (slot.LiveGeneration.load(std::memory_order_relaxed) != 0)
+			{
+				Kill(slot);
+				Destroy(index);
+			}
+		}
+		for (const PendingSlot& p : pending)
+			Destroy(p.Index);
+		pending.clear();
+	}
+
+	Stats GetStats()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		Stats stats;
+		stats.Pending = (uint32_t)pending.size();
+		stats.Slots = slotCount;
+		stats.Live = slotCount - (uint32_t)freeSlots.size() - stats.Pending;
+		return stats;
+	}
+
+private:
+	struct Slot
+	{
+		alignas(T) unsigned char Storage[sizeof(T)];
+
+		// Generation while the object is live, 0 otherwise, so a
+		// lookup is one load and compare
+		std::atomic<uint32_t> LiveGeneration;
+
+		// What the next object made here will have.  Only changed
+		// with the lock held, or by the thread that claimed the slot.
+		uint32_t Generation;
+	};
+
+	struct Chunk
+	{
+		Slot Slots[ChunkSize];
+	};
+
+	struct PendingSlot
+	{
+		uint32_t Index;
+		uint32_t FramesLeft;
+	};
+
+	static Handle MakeHandle(uint32_t index, uint32_t generation)
+	{
+		Handle handle;
+		handle.Value = (generation << IndexBits) | index;
+		return handle;
+	}
+
+	// With the lock held: stops lookups finding the object, and
+	// moves the slot on to its next generation
+	static void Kill(Slot& slot)
+	{
+		slot.LiveGeneration.store(0, std::memory_order_release);
+		slot.Generation = (slot.Generation + 1) & GenerationMask;
+		if (slot.Generation == 0)
+			slot.Generation = 1;
+	}
+
+	Slot& GetSlot(uint32_t index) const
+	{
+		return chunks[index / ChunkSize].load(std::memory_order_acquire)->Slots[index % ChunkSize];
+	}
+
+	// A free slot, or a new one (with a new chunk when needed),
+	// or NoSlot once a handle couldn't name another
+	uint32_t ClaimSlot()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!freeSlots.empty())
+		{
+			uint32_t index = freeSlots.back();
+			freeSlots.pop_back();
+			return index;
+		}
+		if (slotCount > IndexMask)
+			return NoSlot;
+
+		uint32_t index = slotCount++;
+		if (index % ChunkSize == 0)
+		{
+			Chunk* chunk = new Chunk();
+			for (Slot& slot : chunk->Slots)
+			{
+				slot.LiveGeneration.store(0, std::memory_order_relaxed);
+				slot.Generation = 1;
+			}
+			chunks[index / ChunkSize].store(chunk, std::memory_order_release);
+		}
+		return index;
+	}
+
+	// With the lock held
+	void Destroy(uint32_t index)
+	{
+		((T*)GetSlot(index).Storage)->~T();
+		freeSlots.push_back(index);
+	}
+
+	std::mutex mutex;
+	std::atomic<Chunk*> chunks[MaxChunks] = {};
+	uint32_t slotCount = 0;
+	std::vector<uint32_t> freeSlots;
+	std::vector<PendingSlot> pending;
+};
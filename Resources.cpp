@@ -0,0 +1,39 @@
+#include "Resources.h"
+#include "ImGui/imgui.h"
+
+namespace
+{
+	template<typename T>
+	void PoolText(const char* name, ResourcePool<T>& pool)
+	{
+		typename ResourcePool<T>::Stats stats = pool.GetStats();
+		ImGui::BulletText("%s : %u live, %u waiting to be destroyed, %u slots", name, stats.Live, stats.Pending, stats.Slots);
+	}
+}
+
+void Resources::EndFrame()
+{
+	Meshes.EndFrame();
+	Materials.EndFrame();
+	VertexShaders.EndFrame();
+	PixelShaders.EndFrame();
+}
+
+// --------------------------------------------------------
+// Materials go first, then what they refer to
+// --------------------------------------------------------
+void Resources::Clear()
+{
+	Materials.Clear();
+	Meshes.Clear();
+	VertexShaders.Clear();
+	PixelShaders.Clear();
+}
+
+void Resources::BuildUI()
+{
+	PoolText("Meshes", Meshes);
+	PoolText("Materials", Materials);
+	PoolText("Vertex shaders", VertexShaders);
+	PoolText("Pixel shaders", PixelShaders);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Material.h"
+#include "Mesh.h"
+#include "ResourcePool.h"
+#include "SimpleShader.h"
+
+// --------------------------------------------------------
+// Every mesh, material and shader the game has loaded
+//
+// Entities and materials hold 32-bit handles into these
+// pools rather than shared pointers, and look objects up
+// when they need them.  Nothing is freed by dropping the
+// last reference: whoever made a resource releases it, and
+// it's destroyed once the render thread can no longer be
+// drawing with it.
+// --------------------------------------------------------
+namespace Resources
+{
+	// --- GLOBAL VARS ---
+
+	inline ResourcePool<Mesh> Meshes;
+	inline ResourcePool<Material> Materials;
+	inline ResourcePool<SimpleVertexShader> VertexShaders;
+	inline ResourcePool<SimplePixelShader> PixelShaders;
+
+	// --- FUNCTIONS ---
+
+	// Main thread, once per frame: destroys what was released
+	// a few frames ago
+	void EndFrame();
+
+	// Destroys everything, before the device goes.  Nothing may
+	// be drawing.
+	void Clear();
+
+	// Live, pending and slot counts of each pool, as lines in
+	// whichever ImGui window is open
+	void BuildUI();
+}
@@ -0,0 +1,140 @@
+#include "RingArena.h"
+
+// --------------------------------------------------------
+// Creates the arena
+//
+// capacity  - Total bytes managed (rounded down to the alignment)
+// alignment - Alignment of every block, must be a power of two
+// --------------------------------------------------------
+RingArena::RingArena(uint32_t capacity, uint32_t alignment)
+{
+	// Fall back to byte alignment if we were given garbage
+	if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+		alignment = 1;
+
+	this->alignment = alignment;
+	this->capacity = capacity & ~(alignment - 1);
+
+	head = 0;
+	tail = 0;
+	used = 0;
+
+	frameFence = 0;
+	frameBytes = 0;
+
+	allocationCount = 0;
+	failedCount = 0;
+	wastedBytes = 0;
+}
+
+RingArena::~RingArena()
+{
+}
+
+// --------------------------------------------------------
+// Starts a new frame.  Everything allocated until EndFrame()
+// is released together once this fence value is retired,
+// along with anything allocated since the last EndFrame(),
+// outside of any frame.
+// --------------------------------------------------------
+void RingArena::BeginFrame(uint64_t fenceValue)
+{
+	frameFence = fenceValue;
+}
+
+// --------------------------------------------------------
+// Closes the current frame and remembers where it ended
+// --------------------------------------------------------
+void RingArena::EndFrame()
+{
+	FrameMarker marker = {};
+	marker.Fence = frameFence;
+	marker.End = head;
+	marker.Bytes = frameBytes;
+	frames.push_back(marker);
+
+	frameBytes = 0;
+}
+
+// --------------------------------------------------------
+// Releases every closed frame whose fence is less than or
+// equal to the given (completed) fence value
+// --------------------------------------------------------
+void RingArena::Retire(uint64_t completedFenceValue)
+{
+	while (!frames.empty() && frames.front().Fence <= completedFenceValue)
+	{
+		tail = frames.front().End;
+		used -= frames.front().Bytes;
+		frames.pop_front();
+	}
+}
+
+// --------------------------------------------------------
+// Gets the fence of the oldest frame that still holds
+// memory, or zero if nothing is in flight
+// --------------------------------------------------------
+uint64_t RingArena::GetOldestFenceInFlight()
+{
+	return frames.empty() ? 0 : frames.front().Fence;
+}
+
+// --------------------------------------------------------
+// Sub-allocates an aligned block from the ring
+//
+// size - Bytes requested (rounded up to the alignment)
+//
+// Returns the block's offset, or InvalidOffset on failure
+// --------------------------------------------------------
+uint32_t RingArena::Allocate(uint32_t size)
+{
+	uint32_t alignedSize = AlignUp(size > 0 ? size : 1, alignment);
+
+	// Can't possibly fit?
+	if (alignedSize > capacity || used + alignedSize > capacity)
+	{
+		failedCount++;
+		return InvalidOffset;
+	}
+
+	uint32_t offset = InvalidOffset;
+	uint32_t waste = 0;
+
+	if (used == 0 || head > tail)
+	{
+		// Free space is [head, capacity) followed by [0, tail)
+		if (capacity - head >= alignedSize)
+		{
+			offset = head;
+		}
+		else if (used == 0 || tail >= alignedSize)
+		{
+			// Wrap around, the leftover bytes at the end are lost
+			// until this frame retires
+			waste = capacity - head;
+			offset = 0;
+		}
+	}
+	else if (tail - head >= alignedSize)
+	{
+		// Free space is the single gap [head, tail)
+		offset = head;
+	}
+
+	if (offset == InvalidOffset || used + waste + alignedSize > capacity)
+	{
+		failedCount++;
+		return InvalidOffset;
+	}
+
+	head = offset + alignedSize;
+	if (head == capacity)
+		head = 0;
+
+	used += waste + alignedSize;
+	frameBytes += waste + alignedSize;
+
+	allocationCount++;
+	wastedBytes += waste;
+	return offset;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+// --------------------------------------------------------
+// A CPU-side ring allocator that linearly sub-allocates
+// aligned blocks out of a fixed range of bytes.
+//
+// - Allocations made between BeginFrame() and EndFrame()
+//   belong to that frame and are tagged with its fence value
+//   (as do any made between frames, with the next one's)
+// - Space is only reclaimed once Retire() is told that the
+//   frame's fence has completed (i.e. the GPU is done with it)
+// - When the end of the range is reached the arena wraps back
+//   to the start, skipping the unusable tail bytes
+//
+// The arena knows nothing about the memory it manages; it only
+// hands out offsets.  See ConstantUploadArena for the D3D side.
+// --------------------------------------------------------
+class RingArena
+{
+public:
+	static const uint32_t InvalidOffset = 0xFFFFFFFF;
+
+	RingArena(uint32_t capacity, uint32_t alignment = 256);
+	~RingArena();
+
+	// Frame fencing
+	void BeginFrame(uint64_t fenceValue);
+	void EndFrame();
+	void Retire(uint64_t completedFenceValue);
+
+	// Returns the offset of an aligned block of at least
+	// "size" bytes, or InvalidOffset if there is no room
+	uint32_t Allocate(uint32_t size);
+
+	//getters
+	uint32_t GetCapacity() { return capacity; }
+	uint32_t GetAlignment() { return alignment; }
+	uint32_t GetBytesInUse() { return used; }
+	uint32_t GetFrameBytes() { return frameBytes; }
+	uint32_t GetFramesInFlight() { return (uint32_t)frames.size(); }
+	uint64_t GetOldestFenceInFlight();
+	uint64_t GetAllocationCount() { return allocationCount; }
+	uint64_t GetFailedAllocationCount() { return failedCount; }
+	uint64_t GetWastedBytes() { return wastedBytes; }
+
+	// Rounds size up to the next multiple of a power-of-two alignment
+	static uint32_t AlignUp(uint32_t size, uint32_t alignment) { return (size + alignment - 1) & ~(alignment - 1); }
+
+private:
+	// Marks where a closed frame ended so its bytes can be
+	// given back once its fence completes
+	struct FrameMarker
+	{
+		uint64_t Fence;
+		uint32_t End;
+		uint32_t Bytes;
+	};
+
+	uint32_t capacity;
+	uint32_t alignment;
+
+	// Ring state - head is the next free byte, tail is the
+	// start of the oldest block still in use
+	uint32_t head;
+	uint32_t tail;
+	uint32_t used;
+
+	// Current frame
+	uint64_t frameFence;
+	uint32_t frameBytes;
+	std::deque<FrameMarker> frames;
+
+	// Statistics
+	uint64_t allocationCount;
+	uint64_t failedCount;
+	uint64_t wastedBytes;
+};
@@ -5,6 +5,12 @@
 #define LIGHT_TYPE_SPOT 2
 #define MAX_SPECULAR_EXPONENT 256.0f
 
+// Constant buffers are split by how often they change, and
+// every shader uses the same registers for each frequency:
+//  - b0 : PerFrame    (camera, lights, screen size)
+//  - b1 : PerMaterial (color tint, roughness)
+//  - b2 : PerObject   (world, inverse transpose and world-view-projection)
+
 // Struct representing a single vertex worth of data
 // - This should match the vertex definition in our C++ code
 // - By "match", I mean the size, order and number of members
@@ -0,0 +1,277 @@
+#include "ShaderReflectionCache.h"
+#include <fstream>
+#include <iterator>
+
+// File layout: magic, version, bytecode hash, then each list as
+// a count followed by its entries.  All integers are little endian
+// and strings are a length followed by their characters.
+#define REFLECTION_CACHE_MAGIC 0x4C464552 // "REFL"
+#define REFLECTION_CACHE_VERSION 1
+
+// Anonymous namespace to hold helpers
+// only accessible in this file
+namespace
+{
+	// --- Writing ---
+
+	void WriteU32(std::vector<unsigned char>& bytes, uint32_t value)
+	{
+		for (int i = 0; i < 4; i++)
+			bytes.push_back((unsigned char)(value >> (i * 8)));
+	}
+
+	void WriteU64(std::vector<unsigned char>& bytes, uint64_t value)
+	{
+		for (int i = 0; i < 8; i++)
+			bytes.push_back((unsigned char)(value >> (i * 8)));
+	}
+
+	void WriteString(std::vector<unsigned char>& bytes, const std::string& str)
+	{
+		WriteU32(bytes, (uint32_t)str.size());
+		bytes.insert(bytes.end(), str.begin(), str.end());
+	}
+
+	void WriteResources(std::vector<unsigned char>& bytes, const std::vector<ReflectedResource>& resources)
+	{
+		WriteU32(bytes, (uint32_t)resources.size());
+		for (const ReflectedResource& r : resources)
+		{
+			WriteString(bytes, r.Name);
+			WriteU32(bytes, r.BindIndex);
+		}
+	}
+
+	// --- Reading ---
+
+	// Bounds-checked cursor over the raw bytes.  Any read past
+	// the end marks the reader as failed and returns zeros.
+	struct Reader
+	{
+		const unsigned char* Bytes;
+		size_t Size;
+		size_t Position;
+		bool Failed;
+
+		bool Has(size_t count)
+		{
+			if (Failed || Size - Position < count)
+				Failed = true;
+			return !Failed;
+		}
+
+		uint32_t U32()
+		{
+			if (!Has(4)) return 0;
+			uint32_t value = 0;
+			for (int i = 0; i < 4; i++)
+				value |= (uint32_t)Bytes[Position++] << (i * 8);
+			return value;
+		}
+
+		uint64_t U64()
+		{
+			if (!Has(8)) return 0;
+			uint64_t value = 0;
+			for (int i = 0; i < 8; i++)
+				value |= (uint64_t)Bytes[Position++] << (i * 8);
+			return value;
+		}
+
+		std::string String()
+		{
+			uint32_t length = U32();
+			if (!Has(length)) return std::string();
+			std::string str((const char*)Bytes + Position, length);
+			Position += length;
+			return str;
+		}
+
+		// Reads a list count, rejecting counts that could not
+		// possibly fit in the remaining bytes
+		uint32_t Count(size_t minEntrySize)
+		{
+			uint32_t count = U32();
+			if (!Failed && (Size - Position) / minEntrySize < count)
+				Failed = true;
+			return Failed ? 0 : count;
+		}
+	};
+
+	void ReadResources(Reader& reader, std::vector<ReflectedResource>& resources)
+	{
+		uint32_t count = reader.Count(8);
+		resources.resize(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			resources[i].Name = reader.String();
+			resources[i].BindIndex = reader.U32();
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Hashes shader bytecode with 64-bit FNV-1a
+// --------------------------------------------------------
+uint64_t ShaderReflectionCache::HashBytecode(const void* bytecode, size_t size)
+{
+	const unsigned char* bytes = (const unsigned char*)bytecode;
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+// --------------------------------------------------------
+// Writes reflection data to a byte array
+//
+// data         - The reflection results to save
+// bytecodeHash - Hash of the shader the results came from
+// bytes        - Array the data is appended to
+// --------------------------------------------------------
+void ShaderReflectionCache::Serialize(const ShaderReflectionData& data, uint64_t bytecodeHash, std::vector<unsigned char>& bytes)
+{
+	WriteU32(bytes, REFLECTION_CACHE_MAGIC);
+	WriteU32(bytes, REFLECTION_CACHE_VERSION);
+	WriteU64(bytes, bytecodeHash);
+
+	WriteU32(bytes, (uint32_t)data.ConstantBuffers.size());
+	for (const ReflectedConstantBuffer& cb : data.ConstantBuffers)
+	{
+		WriteString(bytes, cb.Name);
+		WriteU32(bytes, cb.Type);
+		WriteU32(bytes, cb.Size);
+		WriteU32(bytes, cb.BindIndex);
+
+		WriteU32(bytes, (uint32_t)cb.Variables.size());
+		for (const ReflectedVariable& v : cb.Variables)
+		{
+			WriteString(bytes, v.Name);
+			WriteU32(bytes, v.ByteOffset);
+			WriteU32(bytes, v.Size);
+		}
+	}
+
+	WriteResources(bytes, data.ShaderResourceViews);
+	WriteResources(bytes, data.Samplers);
+
+	WriteU32(bytes, (uint32_t)data.InputParameters.size());
+	for (const ReflectedInputParameter& p : data.InputParameters)
+	{
+		WriteString(bytes, p.SemanticName);
+		WriteU32(bytes, p.SemanticIndex);
+		WriteU32(bytes, p.Mask);
+		WriteU32(bytes, p.ComponentType);
+	}
+}
+
+// --------------------------------------------------------
+// Reads reflection data back from a byte array
+//
+// bytes        - The serialized data
+// size         - Number of bytes available
+// bytecodeHash - Hash of the shader we want results for
+// data         - Receives the results
+//
+// Returns false if the data is malformed, from another version
+// or belongs to different bytecode
+// --------------------------------------------------------
+bool ShaderReflectionCache::Deserialize(const unsigned char* bytes, size_t size, uint64_t bytecodeHash, ShaderReflectionData& data)
+{
+	Reader reader = { bytes, size, 0, false };
+
+	if (reader.U32() != REFLECTION_CACHE_MAGIC ||
+		reader.U32() != REFLECTION_CACHE_VERSION ||
+		reader.U64() != bytecodeHash)
+		return false;
+
+	ShaderReflectionData result;
+
+	uint32_t bufferCount = reader.Count(20);
+	result.ConstantBuffers.resize(bufferCount);
+	for (uint32_t b = 0; b < bufferCount; b++)
+	{
+		ReflectedConstantBuffer& cb = result.ConstantBuffers[b];
+		cb.Name = reader.String();
+		cb.Type = reader.U32();
+		cb.Size = reader.U32();
+		cb.BindIndex = reader.U32();
+
+		uint32_t varCount = reader.Count(12);
+		cb.Variables.resize(varCount);
+		for (uint32_t v = 0; v < varCount; v++)
+		{
+			cb.Variables[v].Name = reader.String();
+			cb.Variables[v].ByteOffset = reader.U32();
+			cb.Variables[v].Size = reader.U32();
+		}
+	}
+
+	ReadResources(reader, result.ShaderResourceViews);
+	ReadResources(reader, result.Samplers);
+
+	uint32_t inputCount = reader.Count(16);
+	result.InputParameters.resize(inputCount);
+	for (uint32_t i = 0; i < inputCount; i++)
+	{
+		ReflectedInputParameter& p = result.InputParameters[i];
+		p.SemanticName = reader.String();
+		p.SemanticIndex = reader.U32();
+		p.Mask = reader.U32();
+		p.ComponentType = reader.U32();
+	}
+
+	// Everything must have been read, and nothing left over
+	if (reader.Failed || reader.Position != size)
+		return false;
+
+	data = std::move(result);
+	return true;
+}
+
+// --------------------------------------------------------
+// Gets the sidecar file path for a compiled shader file
+// (i.e. "VertexShader.cso" -> "VertexShader.cso.refl")
+// --------------------------------------------------------
+std::filesystem::path ShaderReflectionCache::SidecarPath(const std::filesystem::path& shaderFile)
+{
+	std::filesystem::path sidecar = shaderFile;
+	sidecar += ".refl";
+	return sidecar;
+}
+
+// --------------------------------------------------------
+// Loads reflection data from a sidecar file, if the file
+// exists and matches the given bytecode hash
+// --------------------------------------------------------
+bool ShaderReflectionCache::Load(const std::filesystem::path& file, uint64_t bytecodeHash, ShaderReflectionData& data)
+{
+	std::ifstream in(file, std::ios::binary);
+	if (!in.is_open())
+		return false;
+
+	std::vector<unsigned char> bytes(
+		(std::istreambuf_iterator<char>(in)),
+		std::istreambuf_iterator<char>());
+
+	return Deserialize(bytes.data(), bytes.size(), bytecodeHash, data);
+}
+
+// --------------------------------------------------------
+// Saves reflection data to a sidecar file
+// --------------------------------------------------------
+bool ShaderReflectionCache::Save(const std::filesystem::path& file, uint64_t bytecodeHash, const ShaderReflectionData& data)
+{
+	std::vector<unsigned char> bytes;
+	Serialize(data, bytecodeHash, bytes);
+
+	std::ofstream out(file, std::ios::binary | std::ios::trunc);
+	if (!out.is_open())
+		return false;
+
+	out.write((const char*)bytes.data(), bytes.size());
+	return out.good();
+}
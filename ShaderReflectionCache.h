@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// Plain copies of the shader reflection results SimpleShader
+// needs.  These hold no D3D types, so they can be saved to
+// and loaded from disk on any platform.
+// --------------------------------------------------------
+struct ReflectedVariable
+{
+	std::string Name;
+	uint32_t ByteOffset = 0;
+	uint32_t Size = 0;
+};
+
+struct ReflectedConstantBuffer
+{
+	std::string Name;
+	uint32_t Type = 0;		// A D3D_CBUFFER_TYPE
+	uint32_t Size = 0;
+	uint32_t BindIndex = 0;
+	std::vector<ReflectedVariable> Variables;
+};
+
+// An SRV or sampler binding
+struct ReflectedResource
+{
+	std::string Name;
+	uint32_t BindIndex = 0;
+};
+
+// One element of a shader's input signature
+struct ReflectedInputParameter
+{
+	std::string SemanticName;
+	uint32_t SemanticIndex = 0;
+	uint32_t Mask = 0;
+	uint32_t ComponentType = 0;	// A D3D_REGISTER_COMPONENT_TYPE
+};
+
+struct ShaderReflectionData
+{
+	std::vector<ReflectedConstantBuffer> ConstantBuffers;
+	std::vector<ReflectedResource> ShaderResourceViews;
+	std::vector<ReflectedResource> Samplers;
+	std::vector<ReflectedInputParameter> InputParameters;
+};
+
+// --------------------------------------------------------
+// Reads and writes ShaderReflectionData as a compact binary
+// sidecar file, keyed by a hash of the shader's bytecode so
+// a recompiled shader never picks up stale results
+// --------------------------------------------------------
+namespace ShaderReflectionCache
+{
+	uint64_t HashBytecode(const void* bytecode, size_t size);
+
+	// In-memory round trip
+	void Serialize(const ShaderReflectionData& data, uint64_t bytecodeHash, std::vector<unsigned char>& bytes);
+	bool Deserialize(const unsigned char* bytes, size_t size, uint64_t bytecodeHash, ShaderReflectionData& data);
+
+	// Sidecar files
+	std::filesystem::path SidecarPath(const std::filesystem::path& shaderFile);
+	bool Load(const std::filesystem::path& file, uint64_t bytecodeHash, ShaderReflectionData& data);
+	bool Save(const std::filesystem::path& file, uint64_t bytecodeHash, const ShaderReflectionData& data);
+}
@@ -10,6 +10,11 @@
 #include <unordered_map>
 #include <vector>
 #include <string>
+#include <memory>
+
+#include "ConstantUploadArena.h"
+#include "RenderDevice.h"
+#include "ShaderReflectionCache.h"
 
 
 // --------------------------------------------------------
@@ -34,9 +39,16 @@ struct SimpleConstantBuffer
 	D3D_CBUFFER_TYPE Type = D3D_CBUFFER_TYPE::D3D11_CT_CBUFFER;
 	unsigned int Size = 0;
 	unsigned int BindIndex = 0;
-	Microsoft::WRL::ComPtr<ID3D11Buffer> ConstantBuffer = 0;
+	RenderDevice::Handle Buffer = RenderDevice::NullHandle;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> ConstantBuffer = 0;	// Buffer's native object
 	unsigned char* LocalDataBuffer = 0;
 	std::vector<SimpleShaderVariable> Variables;
+
+	// Where the most recent copy of this buffer lives when
+	// the shared upload arena is in use
+	bool InUploadArena = false;
+	unsigned int ArenaFirstConstant = 0;
+	unsigned int ArenaNumConstants = 0;
 };
 
 // --------------------------------------------------------
@@ -68,51 +80,52 @@ public:
 
 	// Simple helpers
 	bool IsShaderValid() { return shaderValid; }
+	bool IsReflectionCached() { return reflectionFromCache; }
 
 	// Activating the shader and copying data
 	void SetShader();
 	void CopyAllBufferData();
 	void CopyBufferData(unsigned int index);
-	void CopyBufferData(std::string bufferName);
+	void CopyBufferData(const std::string& bufferName);
 
 	// Sets arbitrary shader data
-	bool SetData(std::string name, const void* data, unsigned int size);
-
-	bool SetInt(std::string name, int data);
-	bool SetFloat(std::string name, float data);
-	bool SetFloat2(std::string name, const float data[2]);
-	bool SetFloat2(std::string name, const DirectX::XMFLOAT2 data);
-	bool SetFloat3(std::string name, const float data[3]);
-	bool SetFloat3(std::string name, const DirectX::XMFLOAT3 data);
-	bool SetFloat4(std::string name, const float data[4]);
-	bool SetFloat4(std::string name, const DirectX::XMFLOAT4 data);
-	bool SetMatrix4x4(std::string name, const float data[16]);
-	bool SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 data);
+	bool SetData(const std::string& name, const void* data, unsigned int size);
+
+	bool SetInt(const std::string& name, int data);
+	bool SetFloat(const std::string& name, float data);
+	bool SetFloat2(const std::string& name, const float data[2]);
+	bool SetFloat2(const std::string& name, const DirectX::XMFLOAT2 data);
+	bool SetFloat3(const std::string& name, const float data[3]);
+	bool SetFloat3(const std::string& name, const DirectX::XMFLOAT3 data);
+	bool SetFloat4(const std::string& name, const float data[4]);
+	bool SetFloat4(const std::string& name, const DirectX::XMFLOAT4 data);
+	bool SetMatrix4x4(const std::string& name, const float data[16]);
+	bool SetMatrix4x4(const std::string& name, const DirectX::XMFLOAT4X4 data);
 
 	// Setting shader resources
-	virtual bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv) = 0;
-	virtual bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState) = 0;
+	virtual bool SetShaderResourceView(const std::string& name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv) = 0;
+	virtual bool SetSamplerState(const std::string& name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState) = 0;
 
 	// Simple resource checking
-	bool HasVariable(std::string name);
-	bool HasShaderResourceView(std::string name);
-	bool HasSamplerState(std::string name);
+	bool HasVariable(const std::string& name);
+	bool HasShaderResourceView(const std::string& name);
+	bool HasSamplerState(const std::string& name);
 
 	// Getting data about variables and resources
-	const SimpleShaderVariable* GetVariableInfo(std::string name);
+	const SimpleShaderVariable* GetVariableInfo(const std::string& name);
 	
-	const SimpleSRV* GetShaderResourceViewInfo(std::string name);
+	const SimpleSRV* GetShaderResourceViewInfo(const std::string& name);
 	const SimpleSRV* GetShaderResourceViewInfo(unsigned int index);
 	size_t GetShaderResourceViewCount() { return textureTable.size(); }
 	
-	const SimpleSampler* GetSamplerInfo(std::string name);
+	const SimpleSampler* GetSamplerInfo(const std::string& name);
 	const SimpleSampler* GetSamplerInfo(unsigned int index);
 	size_t GetSamplerCount() { return samplerTable.size(); }
 
 	// Get data about constant buffers
 	unsigned int GetBufferCount();
 	unsigned int GetBufferSize(unsigned int index);
-	const SimpleConstantBuffer* GetBufferInfo(std::string name);
+	const SimpleConstantBuffer* GetBufferInfo(const std::string& name);
 	const SimpleConstantBuffer* GetBufferInfo(unsigned int index);
 	
 	// Misc getters
@@ -122,9 +135,20 @@ public:
 	static bool ReportErrors;
 	static bool ReportWarnings;
 
+	// Optional shared arena that all constant buffer copies are
+	// sub-allocated from.  When null (or unsupported), each shader
+	// uses its own constant buffers as before.
+	static std::shared_ptr<ConstantUploadArena> UploadArena;
+
+	// Save reflection results next to each compiled shader
+	// (as "<file>.cso.refl") and reuse them on later runs
+	static bool UseReflectionCache;
+
 protected:
 	
 	bool shaderValid;
+	bool reflectionFromCache;
+	ShaderReflectionData reflection;
 	Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob;
 	Microsoft::WRL::ComPtr<ID3D11Device> device;
 	Microsoft::WRL::ComPtr<ID3D11DeviceContext> deviceContext;
@@ -143,16 +167,24 @@ protected:
 
 	// Initialization method
 	bool LoadShaderFile(LPCWSTR shaderFile);
+	static void ReflectShaderBlob(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob, ShaderReflectionData& data);
 
 	// Pure virtual functions for dealing with shader types
 	virtual bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob) = 0;
 	virtual void SetShaderAndCBs() = 0;
+	virtual void SetConstantBuffer(SimpleConstantBuffer* cb) = 0;
 
 	virtual void CleanUp();
 
+	// Helper for copying a local data buffer to the GPU
+	void UploadBufferData(SimpleConstantBuffer* cb);
+
+	// Helper for the stages' SetConstantBuffer()
+	void BindConstantBuffer(RenderDevice::ShaderStage stage, SimpleConstantBuffer* cb);
+
 	// Helpers for finding data by name
-	SimpleShaderVariable* FindVariable(std::string name, int size);
-	SimpleConstantBuffer* FindConstantBuffer(std::string name);
+	SimpleShaderVariable* FindVariable(const std::string& name, int size);
+	SimpleConstantBuffer* FindConstantBuffer(const std::string& name);
 
 	// Error logging
 	void Log(std::string message, WORD color);
@@ -174,19 +206,20 @@ public:
 	SimpleVertexShader( Microsoft::WRL::ComPtr<ID3D11Device> device,  Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, LPCWSTR shaderFile);
 	SimpleVertexShader( Microsoft::WRL::ComPtr<ID3D11Device> device,  Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, LPCWSTR shaderFile, Microsoft::WRL::ComPtr<ID3D11InputLayout> inputLayout, bool perInstanceCompatible);
 	~SimpleVertexShader();
-	Microsoft::WRL::ComPtr<ID3D11VertexShader> GetDirectXShader() { return shader; }
+	RenderDevice::Handle GetShaderHandle() { return shader; }
 	Microsoft::WRL::ComPtr<ID3D11InputLayout> GetInputLayout() { return inputLayout; }
 	bool GetPerInstanceCompatible() { return perInstanceCompatible; }
 
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
+	bool SetShaderResourceView(const std::string& name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
+	bool SetSamplerState(const std::string& name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
 
 protected:
 	bool perInstanceCompatible;
 	 Microsoft::WRL::ComPtr<ID3D11InputLayout> inputLayout;
-	 Microsoft::WRL::ComPtr<ID3D11VertexShader> shader;
+	RenderDevice::Handle shader = RenderDevice::NullHandle;
 	bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
 	void SetShaderAndCBs();
+	void SetConstantBuffer(SimpleConstantBuffer* cb);
 	void CleanUp();
 };
 
@@ -199,15 +232,16 @@ class SimplePixelShader : public ISimpleShader
 public:
 	SimplePixelShader(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, LPCWSTR shaderFile);
 	~SimplePixelShader();
-	Microsoft::WRL::ComPtr<ID3D11PixelShader> GetDirectXShader() { return shader; }
+	RenderDevice::Handle GetShaderHandle() { return shader; }
 
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
+	bool SetShaderResourceView(const std::string& name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
+	bool SetSamplerState(const std::string& name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
 
 protected:
-	Microsoft::WRL::ComPtr<ID3D11PixelShader> shader;
+	RenderDevice::Handle shader = RenderDevice::NullHandle;
 	bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
 	void SetShaderAndCBs();
+	void SetConstantBuffer(SimpleConstantBuffer* cb);
 	void CleanUp();
 };
 
@@ -221,13 +255,14 @@ public:
 	~SimpleDomainShader();
 	Microsoft::WRL::ComPtr<ID3D11DomainShader> GetDirectXShader() { return shader; }
 
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
+	bool SetShaderResourceView(const std::string& name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
+	bool SetSamplerState(const std::string& name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
 
 protected:
 	Microsoft::WRL::ComPtr<ID3D11DomainShader> shader;
 	bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
 	void SetShaderAndCBs();
+	void SetConstantBuffer(SimpleConstantBuffer* cb);
 	void CleanUp();
 };
 
@@ -241,13 +276,14 @@ public:
 	~SimpleHullShader();
 	Microsoft::WRL::ComPtr<ID3D11HullShader> GetDirectXShader() { return shader; }
 
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
+	bool SetShaderResourceView(const std::string& name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
+	bool SetSamplerState(const std::string& name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
 
 protected:
 	Microsoft::WRL::ComPtr<ID3D11HullShader> shader;
 	bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
 	void SetShaderAndCBs();
+	void SetConstantBuffer(SimpleConstantBuffer* cb);
 	void CleanUp();
 };
 
@@ -261,8 +297,8 @@ public:
 	~SimpleGeometryShader();
 	Microsoft::WRL::ComPtr<ID3D11GeometryShader> GetDirectXShader() { return shader; }
 
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
+	bool SetShaderResourceView(const std::string& name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
+	bool SetSamplerState(const std::string& name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
 
 	bool CreateCompatibleStreamOutBuffer(Microsoft::WRL::ComPtr<ID3D11Buffer> buffer, int vertexCount);
 
@@ -280,6 +316,7 @@ protected:
 	bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
 	bool CreateShaderWithStreamOut(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
 	void SetShaderAndCBs();
+	void SetConstantBuffer(SimpleConstantBuffer* cb);
 	void CleanUp();
 
 	// Helpers
@@ -300,13 +337,13 @@ public:
 	void DispatchByGroups(unsigned int groupsX, unsigned int groupsY, unsigned int groupsZ);
 	void DispatchByThreads(unsigned int threadsX, unsigned int threadsY, unsigned int threadsZ);
 
-	bool HasUnorderedAccessView(std::string name);
+	bool HasUnorderedAccessView(const std::string& name);
 
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
-	bool SetUnorderedAccessView(std::string name, Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> uav, unsigned int appendConsumeOffset = -1);
+	bool SetShaderResourceView(const std::string& name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
+	bool SetSamplerState(const std::string& name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
+	bool SetUnorderedAccessView(const std::string& name, Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> uav, unsigned int appendConsumeOffset = -1);
 
-	int GetUnorderedAccessViewIndex(std::string name);
+	int GetUnorderedAccessViewIndex(const std::string& name);
 
 protected:
 	Microsoft::WRL::ComPtr<ID3D11ComputeShader> shader;
@@ -319,5 +356,6 @@ protected:
 
 	bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
 	void SetShaderAndCBs();
+	void SetConstantBuffer(SimpleConstantBuffer* cb);
 	void CleanUp();
 };
\ No newline at end of file
@@ -0,0 +1,216 @@
+#include "Startup.h"
+#include "JobSystem.h"
+#include "ImGui/imgui.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <stdio.h>
+
+namespace Startup
+{
+	// Annonymous namespace to hold variables
+	// only accessible in this file
+	namespace
+	{
+		std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+		std::mutex entryMutex;
+		std::vector<Entry> entries;
+		double finishedAt = -1;
+		std::string exportStatus;
+
+		// Phases open on this thread
+		thread_local unsigned int openPhases = 0;
+
+		double Now()
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - origin).count();
+		}
+
+		// Threads outside the job system (and the main thread before
+		// it starts) are all shown as the main thread
+		unsigned int CurrentThread()
+		{
+			unsigned int index = JobSystem::GetThreadIndex();
+			return index == ~0u ? 0 : index;
+		}
+
+		// Same idea as the profiler's zone colors
+		ImU32 PhaseColor(const std::string& name)
+		{
+			uint32_t hash = 2166136261u;
+			for (char c : name)
+				hash = (hash ^ (uint8_t)c) * 16777619u;
+			return IM_COL32(90 + hash % 120, 90 + (hash >> 8) % 120, 90 + (hash >> 16) % 120, 255);
+		}
+	}
+}
+
+void Startup::Initialize()
+{
+	std::lock_guard<std::mutex> lock(entryMutex);
+	origin = std::chrono::steady_clock::now();
+	entries.clear();
+	finishedAt = -1;
+}
+
+// --------------------------------------------------------
+// Stops the clock and prints the main thread's outer two
+// levels of phases, then the longest step that has nothing
+// nested in it - with loads in parallel, the phase around
+// them should take not much more than that
+// --------------------------------------------------------
+void Startup::Finish()
+{
+	std::lock_guard<std::mutex> lock(entryMutex);
+	finishedAt = Now();
+
+	// Finished order puts children first, so sort by start
+	std::vector<Entry> ordered = entries;
+	std::stable_sort(ordered.begin(), ordered.end(),
+		[](const Entry& a, const Entry& b) { return a.Start < b.Start; });
+
+	printf("Startup: %.1f ms\n", finishedAt);
+	const Entry* longestLeaf = 0;
+	for (const Entry& e : ordered)
+	{
+		if (e.Thread == 0 && e.Depth <= 1)
+			printf("  %*s%-*s %8.1f ms  (at %.1f)\n", e.Depth * 2, "", 28 - e.Depth * 2, e.Name.c_str(), e.End - e.Start, e.Start);
+
+		// Phases with nothing nested inside them
+		bool leaf = true;
+		for (const Entry& other : ordered)
+			if (other.Thread == e.Thread && other.Depth == e.Depth + 1 && other.Start >= e.Start && other.End <= e.End)
+				leaf = false;
+		if (leaf && (e.Thread != 0 || e.Depth > 0) && (!longestLeaf || e.End - e.Start > longestLeaf->End - longestLeaf->Start))
+			longestLeaf = &e;
+	}
+
+	if (longestLeaf)
+		printf("  Longest single step: %s, %.1f ms\n", longestLeaf->Name.c_str(), longestLeaf->End - longestLeaf->Start);
+}
+
+std::vector<Startup::Entry> Startup::GetEntries()
+{
+	std::lock_guard<std::mutex> lock(entryMutex);
+	return entries;
+}
+
+double Startup::GetTotalMilliseconds()
+{
+	std::lock_guard<std::mutex> lock(entryMutex);
+	return finishedAt >= 0 ? finishedAt : Now();
+}
+
+Startup::Phase::Phase(const char* name)
+	: name(name)
+{
+	depth = openPhases++;
+	start = Now();
+}
+
+Startup::Phase::~Phase()
+{
+	double end = Now();
+	openPhases--;
+
+	std::lock_guard<std::mutex> lock(entryMutex);
+	entries.push_back({ name, CurrentThread(), depth, start, end });
+}
+
+// --------------------------------------------------------
+// Writes the timeline as Chrome trace events
+//
+// path - File to create
+//
+// Returns false if the file couldn't be written
+// --------------------------------------------------------
+bool Startup::WriteChromeTrace(const char* path)
+{
+	std::ofstream out(path);
+	if (!out)
+		return false;
+
+	out << std::fixed << std::setprecision(3);
+	out << "{\"traceEvents\":[\n";
+
+	// Times in microseconds; phase names are our own literals,
+	// so nothing needs escaping
+	std::lock_guard<std::mutex> lock(entryMutex);
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		const Entry& e = entries[i];
+		out << (i == 0 ? "" : ",\n") << "{\"ph\":\"X\",\"name\":\"" << e.Name
+			<< "\",\"pid\":0,\"tid\":" << e.Thread
+			<< ",\"ts\":" << e.Start * 1000.0
+			<< ",\"dur\":" << (e.End - e.Start) * 1000.0 << "}";
+	}
+
+	out << "\n]}\n";
+	return (bool)out;
+}
+
+// --------------------------------------------------------
+// One lane per thread, nested phases below their parents,
+// all on the same scale from Initialize() to Finish()
+// --------------------------------------------------------
+void Startup::BuildUI()
+{
+	std::vector<Entry> timeline = GetEntries();
+	double total = GetTotalMilliseconds();
+
+	ImGui::Begin("Startup");
+
+	ImGui::Text("Startup: %.1f ms, %zu phases", total, timeline.size());
+	if (ImGui::Button("Save Chrome trace"))
+		exportStatus = WriteChromeTrace("startup.json") ? "Saved startup.json" : "Couldn't write startup.json";
+	if (!exportStatus.empty())
+	{
+		ImGui::SameLine();
+		ImGui::TextUnformatted(exportStatus.c_str());
+	}
+
+	float width = ImGui::GetContentRegionAvail().x;
+	float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+	double scale = width / std::max(total, 0.001);
+	ImDrawList* drawList = ImGui::GetWindowDrawList();
+
+	unsigned int threadCount = 0;
+	for (const Entry& e : timeline)
+		threadCount = std::max(threadCount, e.Thread + 1);
+
+	for (unsigned int t = 0; t < threadCount; t++)
+	{
+		unsigned int rows = 0;
+		for (const Entry& e : timeline)
+			if (e.Thread == t)
+				rows = std::max(rows, e.Depth + 1);
+		if (rows == 0)
+			continue;
+
+		if (t == 0)
+			ImGui::TextUnformatted("Main thread");
+		else
+			ImGui::Text("Worker %u", t);
+		ImVec2 origin = ImGui::GetCursorScreenPos();
+		for (const Entry& e : timeline)
+		{
+			if (e.Thread != t)
+				continue;
+
+			ImVec2 min(origin.x + (float)(e.Start * scale), origin.y + e.Depth * rowHeight);
+			ImVec2 max(std::max(origin.x + (float)(e.End * scale), min.x + 1.0f), min.y + rowHeight - 1.0f);
+			drawList->AddRectFilled(min, max, PhaseColor(e.Name));
+
+			if (ImGui::CalcTextSize(e.Name.c_str()).x < max.x - min.x)
+				drawList->AddText(min, IM_COL32_BLACK, e.Name.c_str());
+
+			if (ImGui::IsMouseHoveringRect(min, max))
+				ImGui::SetTooltip("%s\n%.3f ms (at %.3f ms)", e.Name.c_str(), e.End - e.Start, e.Start);
+		}
+		ImGui::Dummy(ImVec2(width, rows * rowHeight));
+	}
+
+	ImGui::End();
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// Timeline of everything that happens before the first frame
+//
+// Each phase of startup (window, device, shaders, meshes...)
+// is wrapped in a Startup::Phase, from whichever thread runs
+// it, and recorded with its start and end relative to
+// Initialize().  Phases nest like profiler zones, so the
+// report shows both what took the time and what overlapped.
+//
+// Recording takes a lock, which is fine for a few dozen
+// phases but not for anything per-frame - use PROFILE_SCOPE
+// for those.
+// --------------------------------------------------------
+namespace Startup
+{
+	struct Entry
+	{
+		std::string Name;
+		unsigned int Thread;	// JobSystem thread index, 0 before it starts
+		unsigned int Depth;		// Phases open on the same thread around this one
+		double Start;			// Milliseconds since Initialize()
+		double End;
+	};
+
+	// Very first thing in the program
+	void Initialize();
+
+	// Closes the timeline and prints a summary to the console
+	void Finish();
+
+	// Every phase, in the order they finished
+	std::vector<Entry> GetEntries();
+
+	// Initialize() to Finish() (or to now, if not finished)
+	double GetTotalMilliseconds();
+
+	// The timeline as Chrome trace events (see Profiler.h)
+	bool WriteChromeTrace(const char* path);
+
+	// Timeline per thread, longest phases and export
+	void BuildUI();
+
+	// Times the rest of the enclosing scope as one phase
+	class Phase
+	{
+	public:
+		explicit Phase(const char* name);
+		~Phase();
+		Phase(const Phase&) = delete;
+		Phase& operator=(const Phase&) = delete;
+
+	private:
+		const char* name;
+		unsigned int depth;
+		double start;
+	};
+}
@@ -1,184 +1,233 @@
 #include "Transform.h"
 
-//destructor
+//constructor - grabs a fresh identity transform from the system
+Transform::Transform()
+{
+	handle = TransformSystem::Create(this);
+}
+
+//destructor - gives it back, children stay where they are in the world
 Transform::~Transform()
 {
+	TransformSystem::Release(handle);
 }
 
 //Sets position of transform
 void Transform::SetPosition(float x, float y, float z)
 {
-	position.x = x;
-	position.y = y;
-	position.z = z;
+	TransformSystem::SetPosition(handle, DirectX::XMFLOAT3(x, y, z));
 }
 
 void Transform::SetPosition(DirectX::XMFLOAT3 position)
 {
-	this->position.x = position.x;
-	this->position.y = position.y;
-	this->position.z = position.z;
+	TransformSystem::SetPosition(handle, position);
 }
 
 void Transform::SetRotation(float pitch, float yaw, float roll)
 {
-	rotation.x = pitch;
-	rotation.y = yaw;
-	rotation.z = roll;
+	TransformSystem::SetPitchYawRoll(handle, DirectX::XMFLOAT3(pitch, yaw, roll));
 }
 
 void Transform::SetRotation(DirectX::XMFLOAT3 rotation)
 {
-	this->rotation.x = rotation.x;
-	this->rotation.y = rotation.y;
-	this->rotation.z = rotation.z;
+	TransformSystem::SetPitchYawRoll(handle, rotation);
+}
+
+void Transform::SetRotation(DirectX::XMFLOAT4 quaternion)
+{
+	TransformSystem::SetRotation(handle, quaternion);
 }
 
 void Transform::SetScale(float x, float y, float z)
 {
-	scale.x = x;
-	scale.y = y;
-	scale.z = z;
+	TransformSystem::SetScale(handle, DirectX::XMFLOAT3(x, y, z));
 }
 
 void Transform::SetScale(DirectX::XMFLOAT3 scale)
 {
-	this->scale.x = scale.x;
-	this->scale.y = scale.y;
-	this->scale.z = scale.z;
+	TransformSystem::SetScale(handle, scale);
 }
 
 DirectX::XMFLOAT3 Transform::GetPosition()
 {
-	return position;
+	return TransformSystem::GetPosition(handle);
 }
 
 DirectX::XMFLOAT3 Transform::GetPitchYawRoll()
 {
-	return rotation;
+	return TransformSystem::GetPitchYawRoll(handle);
+}
+
+DirectX::XMFLOAT4 Transform::GetRotation()
+{
+	return TransformSystem::GetRotation(handle);
 }
 
 DirectX::XMFLOAT3 Transform::GetScale()
 {
-	return scale;
+	return TransformSystem::GetScale(handle);
 }
 
+//the system only rebuilds matrices if something changed since the last time
 DirectX::XMFLOAT4X4 Transform::GetWorldMatrix()
 {
-	RecalculateWorldMatrix();
-	return world;
+	return TransformSystem::GetWorldMatrix(handle);
 }
 
 DirectX::XMFLOAT4X4 Transform::GetWorldInverseTransposeMatrix()
 {
-	return worldInverseTranspose;
+	return TransformSystem::GetWorldInverseTransposeMatrix(handle);
+}
+
+unsigned int Transform::GetVersion()
+{
+	return TransformSystem::GetVersion(handle);
+}
+
+TransformSystem::Handle Transform::GetHandle()
+{
+	return handle;
 }
 
+//attaches this transform to a new parent (or makes it a root if null)
+//keepWorldPosition - adjusts the local values so the object doesn't move
+//returns false if the new parent is this transform or one of its children
+bool Transform::SetParent(Transform* newParent, bool keepWorldPosition)
+{
+	TransformSystem::Handle parentHandle = newParent ? newParent->handle : TransformSystem::InvalidHandle;
+	return TransformSystem::SetParent(handle, parentHandle, keepWorldPosition);
+}
+
+Transform* Transform::GetParent()
+{
+	TransformSystem::Handle parentHandle = TransformSystem::GetParent(handle);
+	if (parentHandle == TransformSystem::InvalidHandle)
+		return nullptr;
+	return TransformSystem::GetOwner(parentHandle);
+}
+
+Transform* Transform::GetChild(unsigned int index)
+{
+	TransformSystem::Handle childHandle = TransformSystem::GetChild(handle, index);
+	if (childHandle == TransformSystem::InvalidHandle)
+		return nullptr;
+	return TransformSystem::GetOwner(childHandle);
+}
+
+unsigned int Transform::GetChildCount()
+{
+	return TransformSystem::GetChildCount(handle);
+}
+
+//true if other is somewhere below this transform
+bool Transform::IsAncestorOf(Transform* other)
+{
+	if (!other)
+		return false;
+
+	TransformSystem::Handle h = TransformSystem::GetParent(other->handle);
+	for (; h != TransformSystem::InvalidHandle; h = TransformSystem::GetParent(h))
+	{
+		if (h == handle)
+			return true;
+	}
+	return false;
+}
+
+//the system keeps these up to date whenever the rotation changes
 DirectX::XMFLOAT3 Transform::GetRight()
 {
-	//rotate the world's right vector by transform's rotation
-	DirectX::XMVECTOR rightVector = DirectX::XMVector3Rotate(DirectX::XMVECTOR{ 1,0,0 }, DirectX::XMQuaternionRotationRollPitchYaw(rotation.x, rotation.y, rotation.z));
-	//convert to float3 and return
-	DirectX::XMFLOAT3 rightFloat3{ DirectX::XMVectorGetX(rightVector), DirectX::XMVectorGetY(rightVector), DirectX::XMVectorGetZ(rightVector) };
-	return rightFloat3;
+	return TransformSystem::GetRight(handle);
 }
 
 DirectX::XMFLOAT3 Transform::GetUp()
 {
-	//rotate the world's up vector by transform's rotation
-	DirectX::XMVECTOR upVector = DirectX::XMVector3Rotate(DirectX::XMVECTOR{ 0,1,0 }, DirectX::XMQuaternionRotationRollPitchYaw(rotation.x, rotation.y, rotation.z));
-	//convert to float3 and return
-	DirectX::XMFLOAT3 upFloat3{ DirectX::XMVectorGetX(upVector), DirectX::XMVectorGetY(upVector), DirectX::XMVectorGetZ(upVector) };
-	return upFloat3;
+	return TransformSystem::GetUp(handle);
 }
 
 DirectX::XMFLOAT3 Transform::GetForward()
 {
-	//rotate the world's forward vector by transform's rotation
-	DirectX::XMVECTOR forwardVector = DirectX::XMVector3Rotate(DirectX::XMVECTOR{ 0,0,1 }, DirectX::XMQuaternionRotationRollPitchYaw(rotation.x, rotation.y, rotation.z));
-	//convert to float3 and return
-	DirectX::XMFLOAT3 forwardFloat3{ DirectX::XMVectorGetX(forwardVector), DirectX::XMVectorGetY(forwardVector), DirectX::XMVectorGetZ(forwardVector) };
-	return forwardFloat3;
+	return TransformSystem::GetForward(handle);
 }
 
 void Transform::MoveAbsolute(float x, float y, float z)
 {
+	DirectX::XMFLOAT3 position = GetPosition();
 	position.x += x;
 	position.y += y;
 	position.z += z;
+	SetPosition(position);
 }
 
 void Transform::MoveAbsolute(DirectX::XMFLOAT3 offset)
 {
-	position.x += offset.x;
-	position.y += offset.y;
-	position.z += offset.z;
+	MoveAbsolute(offset.x, offset.y, offset.z);
 }
 
 void Transform::Rotate(float pitch, float yaw, float roll)
 {
+	DirectX::XMFLOAT3 rotation = GetPitchYawRoll();
 	rotation.x += pitch;
 	rotation.y += yaw;
 	rotation.z += roll;
+	SetRotation(rotation);
 }
 
 void Transform::Rotate(DirectX::XMFLOAT3 rotation)
 {
-	this->rotation.x += rotation.x;
-	this->rotation.y += rotation.y;
-	this->rotation.z += rotation.z;
+	Rotate(rotation.x, rotation.y, rotation.z);
+}
+
+void Transform::Rotate(DirectX::XMFLOAT4 quaternion)
+{
+	//multiplying current * delta does current first, then delta
+	DirectX::XMFLOAT4 current = GetRotation();
+	DirectX::XMFLOAT4 result;
+	DirectX::XMStoreFloat4(&result, DirectX::XMQuaternionMultiply(DirectX::XMLoadFloat4(&current), DirectX::XMLoadFloat4(&quaternion)));
+	SetRotation(result);
+}
+
+void Transform::Slerp(DirectX::XMFLOAT4 target, float t)
+{
+	DirectX::XMFLOAT4 current = GetRotation();
+	DirectX::XMFLOAT4 result;
+	DirectX::XMStoreFloat4(&result, DirectX::XMQuaternionSlerp(DirectX::XMLoadFloat4(&current), DirectX::XMLoadFloat4(&target), t));
+	SetRotation(result);
 }
 
 void Transform::Scale(float x, float y, float z)
 {
+	DirectX::XMFLOAT3 scale = GetScale();
 	scale.x *= x;
 	scale.y *= y;
 	scale.z *= z;
+	SetScale(scale);
 }
 
 void Transform::Scale(DirectX::XMFLOAT3 scale)
 {
-	this->scale.x *= scale.x;
-	this->scale.y *= scale.y;
-	this->scale.z *= scale.z;
+	Scale(scale.x, scale.y, scale.z);
 }
 
 void Transform::MoveRelative(float x, float y, float z)
 {
-	//convert to vectors
-	DirectX::XMVECTOR movementVector{ x,y,z };
-	DirectX::XMVECTOR currentRotation = DirectX::XMQuaternionRotationRollPitchYaw(rotation.x, rotation.y, rotation.z);
-	//rotate the vector
-	DirectX::XMVECTOR direction = DirectX::XMVector3Rotate(movementVector, currentRotation);
-	//add it's values to position
-	position.x += DirectX::XMVectorGetX(direction);
-	position.y += DirectX::XMVectorGetY(direction);
-	position.z += DirectX::XMVectorGetZ(direction);
+	//move along our own axes instead of rotating the offset
+	DirectX::XMFLOAT3 right = GetRight();
+	DirectX::XMFLOAT3 up = GetUp();
+	DirectX::XMFLOAT3 forward = GetForward();
+	MoveAbsolute(
+		right.x * x + up.x * y + forward.x * z,
+		right.y * x + up.y * y + forward.y * z,
+		right.z * x + up.z * y + forward.z * z);
 }
 
 void Transform::MoveRelative(DirectX::XMFLOAT3 offset)
 {
-	//convert to vectors
-	DirectX::XMVECTOR movementVector = { offset.x,offset.y,offset.z };
-	DirectX::XMVECTOR currentRotation = DirectX::XMQuaternionRotationRollPitchYaw(rotation.x, rotation.y, rotation.z);
-	//rotate the vector
-		DirectX::XMVECTOR direction = DirectX::XMVector3Rotate(movementVector, currentRotation);
-	//add it's values to position
-	position.x += DirectX::XMVectorGetX(direction);
-	position.y += DirectX::XMVectorGetY(direction);
-	position.z += DirectX::XMVectorGetZ(direction);
+	MoveRelative(offset.x, offset.y, offset.z);
 }
 
+//brings the matrices of every changed transform up to date
 void Transform::RecalculateWorldMatrix()
 {
-
-	//make the world matrix out of scaling, rotation, and translation
-	DirectX::XMMATRIX worldM = ((DirectX::XMMatrixScaling(scale.x, scale.y, scale.z) * 
-		DirectX::XMMatrixRotationRollPitchYaw(rotation.x, rotation.y, rotation.z)) * 
-		DirectX::XMMatrixTranslation(position.x, position.y, position.z));
-
-	//store it and its inverse transpose
-	XMStoreFloat4x4(&world, worldM);
-	XMStoreFloat4x4(&worldInverseTranspose,
-		XMMatrixInverse(0, XMMatrixTranspose(worldM)));
+	TransformSystem::Update();
 }
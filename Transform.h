@@ -1,45 +1,58 @@
 #pragma once
 
 #include <DirectXMath.h>
+#include "TransformSystem.h"
 
 class Transform
 {
 public:
 
-	//constructor(s)
-	Transform() { //initializes values
-		position.x = 0; position.y = 0; position.z = 0;
-		rotation.x = 0; rotation.y = 0; rotation.z = 0;
-		scale.x = 1; scale.y = 1; scale.z = 1;
-
-		DirectX::XMStoreFloat4x4(&world, DirectX::XMMatrixIdentity());
-		DirectX::XMStoreFloat4x4(&worldInverseTranspose, DirectX::XMMatrixIdentity());
-	}
+	//constructor(s) - the actual data lives in the TransformSystem,
+	//this is just a handle to it
+	Transform();
 	~Transform();
 
+	//a copy would share the same handle, so copying one makes no sense
+	Transform(const Transform&) = delete;
+	Transform& operator=(const Transform&) = delete;
+
 	//setters
 	void SetPosition(float x, float y, float z);
 	void SetPosition(DirectX::XMFLOAT3 position);
 	void SetRotation(float pitch, float yaw, float roll);
-	void SetRotation(DirectX::XMFLOAT3 rotation); // XMFLOAT4 for quaternion
+	void SetRotation(DirectX::XMFLOAT3 rotation);
+	void SetRotation(DirectX::XMFLOAT4 quaternion);
 	void SetScale(float x, float y, float z);
 	void SetScale(DirectX::XMFLOAT3 scale);
 
 	//getters
 	DirectX::XMFLOAT3 GetPosition();
-	DirectX::XMFLOAT3 GetPitchYawRoll(); // XMFLOAT4 GetRotation() for quaternion
+	DirectX::XMFLOAT3 GetPitchYawRoll(); // worked out from the quaternion if one was set
+	DirectX::XMFLOAT4 GetRotation();
 	DirectX::XMFLOAT3 GetScale();
 	DirectX::XMFLOAT4X4 GetWorldMatrix();
 	DirectX::XMFLOAT4X4 GetWorldInverseTransposeMatrix();
-	DirectX::XMFLOAT3 GetRight();
+	DirectX::XMFLOAT3 GetRight(); // axes are cached, so these are cheap
 	DirectX::XMFLOAT3 GetUp();
 	DirectX::XMFLOAT3 GetForward();
+	unsigned int GetVersion(); // changes every time the transform does
+	TransformSystem::Handle GetHandle();
+
+	//hierarchy - position/rotation/scale are relative to the parent,
+	//the world matrix includes every parent above this one
+	bool SetParent(Transform* newParent, bool keepWorldPosition = false);
+	Transform* GetParent();
+	Transform* GetChild(unsigned int index);
+	unsigned int GetChildCount();
+	bool IsAncestorOf(Transform* other);
 
 	//transformers
 	void MoveAbsolute(float x, float y, float z);
 	void MoveAbsolute(DirectX::XMFLOAT3 offset);
 	void Rotate(float pitch, float yaw, float roll);
 	void Rotate(DirectX::XMFLOAT3 rotation);
+	void Rotate(DirectX::XMFLOAT4 quaternion); // applied after the current rotation
+	void Slerp(DirectX::XMFLOAT4 target, float t); // turns t of the way toward target
 	void Scale(float x, float y, float z);
 	void Scale(DirectX::XMFLOAT3 scale);
 
@@ -52,13 +65,7 @@ public:
 
 
 private:
-	//raw transform data
-	DirectX::XMFLOAT3 position;
-	DirectX::XMFLOAT3 rotation;
-	DirectX::XMFLOAT3 scale;
-
-	//4x4 matrices
-	DirectX::XMFLOAT4X4 world;
-	DirectX::XMFLOAT4X4 worldInverseTranspose;
+	//position, rotation, scale and matrices are all in the system
+	TransformSystem::Handle handle;
 };
 
@@ -0,0 +1,1095 @@
+#include "TransformSystem.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <atomic>
+#include <math.h>
+#include <random>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <xmmintrin.h>
+#define TRANSFORM_PREFETCH(address) _mm_prefetch((const char*)(address), _MM_HINT_T0)
+#else
+#define TRANSFORM_PREFETCH(address) ((void)0)
+#endif
+
+using namespace DirectX;
+
+namespace TransformSystem
+{
+	// Annonymous namespace to hold variables
+	// only accessible in this file
+	namespace
+	{
+		constexpr uint32_t InvalidIndex = 0xFFFFFFFF;
+
+		// Scales this close to zero can't be inverted analytically
+		constexpr float DegenerateScale = 1e-12f;
+
+		// Smallest ranges worth handing to another thread
+		constexpr uint32_t ParallelGroups = 64;		// Groups of four local matrices
+		constexpr uint32_t ParallelMatrices = 256;	// World / render matrices
+
+		// Per-transform data in dense (breadth-first) order.  The
+		// float arrays and everything the SIMD pass reads are padded
+		// to a multiple of four so it never needs a scalar tail.
+		std::vector<float> posX, posY, posZ;
+		std::vector<float> rotX, rotY, rotZ, rotW;
+		std::vector<float> sclX, sclY, sclZ;
+		std::vector<uint8_t> dirty;					// Local values changed since the last update
+		std::vector<uint8_t> degenerate;			// Local scale too small for the analytic inverse
+		std::vector<XMFLOAT4X4A> localMatrices;
+		std::vector<XMFLOAT4X4A> localInvTransposeMatrices;
+
+		// Local values as of the start of the current simulation step
+		std::vector<float> prevPosX, prevPosY, prevPosZ;
+		std::vector<float> prevRotX, prevRotY, prevRotZ, prevRotW;
+		std::vector<float> prevSclX, prevSclY, prevSclZ;
+		std::vector<uint8_t> moved;					// Changed since the current step started
+
+		std::vector<XMFLOAT3> eulers;				// Pitch/yaw/roll as set, or worked out from a quaternion
+		std::vector<XMFLOAT3> rights, ups, forwards;	// Rotated axes, refreshed with the rotation
+		std::vector<XMFLOAT4X4A> worldMatrices;
+		std::vector<XMFLOAT4X4A> worldInvTransposeMatrices;
+		std::vector<unsigned int> versions;
+		std::vector<uint8_t> generalInverse;		// This or a parent is degenerate, so use XMMatrixInverse
+		std::vector<uint32_t> parents;				// Dense index of the parent, or InvalidIndex
+		std::vector<uint32_t> childCounts;
+		std::vector<uint32_t> firstChildren;		// Children are contiguous once sorted
+		std::vector<Transform*> owners;
+
+		// Matrices blended between the previous and current step, only
+		// valid where blended is set (everything else uses the world matrices)
+		std::vector<XMFLOAT4X4A> renderMatrices;
+		std::vector<XMFLOAT4X4A> renderInvTransposeMatrices;
+		std::vector<uint8_t> blended;
+
+		// Handle <-> dense index mapping
+		std::vector<Handle> denseToHandle;			// InvalidHandle marks a released transform
+		std::vector<uint32_t> handleToDense;
+		std::vector<Handle> freeHandles;
+
+		uint32_t count = 0;							// Dense entries, including released ones
+		uint32_t releasedCount = 0;
+		bool orderDirty = false;
+		Stats stats = {};
+
+		// Dense indices where each level of the hierarchy starts.  Every
+		// transform's parent is in an earlier level, so everything within
+		// one level can be composed in parallel.
+		std::vector<uint32_t> levelStarts = { 0 };
+
+		// Dense indices with dirty, moved or blended set, so updates
+		// cost what changed rather than everything after it.  Released
+		// entries can linger in the first two until the next re-sort.
+		std::vector<uint32_t> dirtyList;
+		std::vector<uint32_t> movedList;
+		std::vector<uint32_t> blendedList;
+
+		// Scratch for walking the changed subtrees, kept between
+		// frames so an update doesn't allocate
+		std::vector<uint32_t> dirtyGroups;
+		std::vector<uint32_t> walkRoots;
+		std::vector<uint32_t> walkLevel;
+		std::vector<uint32_t> walkChildren;
+
+		uint32_t PadToFour(uint32_t n) { return (n + 3) & ~3u; }
+
+		// Grows or shrinks the padded arrays, filling new lanes with identity
+		void ResizePadded(uint32_t n)
+		{
+			uint32_t padded = PadToFour(n);
+			posX.resize(padded, 0.0f); posY.resize(padded, 0.0f); posZ.resize(padded, 0.0f);
+			rotX.resize(padded, 0.0f); rotY.resize(padded, 0.0f); rotZ.resize(padded, 0.0f); rotW.resize(padded, 1.0f);
+			sclX.resize(padded, 1.0f); sclY.resize(padded, 1.0f); sclZ.resize(padded, 1.0f);
+			prevPosX.resize(padded, 0.0f); prevPosY.resize(padded, 0.0f); prevPosZ.resize(padded, 0.0f);
+			prevRotX.resize(padded, 0.0f); prevRotY.resize(padded, 0.0f); prevRotZ.resize(padded, 0.0f); prevRotW.resize(padded, 1.0f);
+			prevSclX.resize(padded, 1.0f); prevSclY.resize(padded, 1.0f); prevSclZ.resize(padded, 1.0f);
+			dirty.resize(padded, 0);
+			degenerate.resize(padded, 0);
+			localMatrices.resize(padded);
+			localInvTransposeMatrices.resize(padded);
+		}
+
+		void MarkDirty(uint32_t index)
+		{
+			if (!dirty[index])
+				dirtyList.push_back(index);
+			dirty[index] = 1;
+			versions[index]++;
+
+			if (!moved[index])
+				movedList.push_back(index);
+			moved[index] = 1;
+		}
+
+		// Makes the previous step's values match the current ones
+		void CopyToPrevious(uint32_t index)
+		{
+			prevPosX[index] = posX[index]; prevPosY[index] = posY[index]; prevPosZ[index] = posZ[index];
+			prevRotX[index] = rotX[index]; prevRotY[index] = rotY[index]; prevRotZ[index] = rotZ[index]; prevRotW[index] = rotW[index];
+			prevSclX[index] = sclX[index]; prevSclY[index] = sclY[index]; prevSclZ[index] = sclZ[index];
+		}
+
+		// Sparse updates jump around the arrays, so they ask for what
+		// the transform a few places ahead needs while working on this one
+		constexpr uint32_t PrefetchAhead = 8;
+
+		// Builds a scale * rotation * translation matrix and its
+		// inverse transpose for a single transform, the same way the
+		// SIMD pass does.  Returns false if the scale is degenerate.
+		bool BuildLocalMatrix(FXMVECTOR quaternion, const XMFLOAT3& position, const XMFLOAT3& scale, XMMATRIX& local, XMMATRIX& localInvTranspose)
+		{
+			XMMATRIX rot = XMMatrixRotationQuaternion(quaternion);
+			XMVECTOR t = XMVectorSet(position.x, position.y, position.z, 1.0f);
+			float s[3] = { scale.x, scale.y, scale.z };
+
+			bool valid = true;
+			for (int r = 0; r < 3; r++)
+			{
+				local.r[r] = XMVectorScale(rot.r[r], s[r]);
+				if (fabsf(s[r]) < DegenerateScale)
+				{
+					valid = false;
+					continue;
+				}
+
+				// Row / scale, with -(t . row) / scale in w
+				float rs = 1.0f / s[r];
+				float d = -XMVectorGetX(XMVector3Dot(t, rot.r[r])) * rs;
+				localInvTranspose.r[r] = XMVectorSetW(XMVectorScale(rot.r[r], rs), d);
+			}
+			local.r[3] = t;
+			localInvTranspose.r[3] = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+			return valid;
+		}
+
+		// The rows of the rotation matrix are the rotated axes, which
+		// is cheaper than rotating three vectors by the quaternion
+		void UpdateBasis(uint32_t index, FXMVECTOR q)
+		{
+			XMMATRIX rot = XMMatrixRotationQuaternion(q);
+			XMStoreFloat3(&rights[index], rot.r[0]);
+			XMStoreFloat3(&ups[index], rot.r[1]);
+			XMStoreFloat3(&forwards[index], rot.r[2]);
+		}
+
+		void SetRotationFromEuler(uint32_t index)
+		{
+			XMVECTOR qv = XMQuaternionRotationRollPitchYaw(eulers[index].x, eulers[index].y, eulers[index].z);
+			XMFLOAT4 q;
+			XMStoreFloat4(&q, qv);
+			rotX[index] = q.x; rotY[index] = q.y; rotZ[index] = q.z; rotW[index] = q.w;
+			UpdateBasis(index, qv);
+		}
+
+		// Stores a quaternion and works out matching pitch/yaw/roll
+		void SetRotationFromQuaternion(uint32_t index, FXMVECTOR quaternion)
+		{
+			XMVECTOR qv = XMQuaternionNormalize(quaternion);
+			XMFLOAT4 q;
+			XMStoreFloat4(&q, qv);
+			rotX[index] = q.x; rotY[index] = q.y; rotZ[index] = q.z; rotW[index] = q.w;
+			UpdateBasis(index, qv);
+
+			// Pull the angles out of the rotation, which is roll * pitch * yaw
+			XMFLOAT4X4 rot;
+			XMStoreFloat4x4(&rot, XMMatrixRotationQuaternion(qv));
+			float sinPitch = -rot._32;
+			if (sinPitch > 1.0f) sinPitch = 1.0f;
+			if (sinPitch < -1.0f) sinPitch = -1.0f;
+			eulers[index].x = asinf(sinPitch);
+			eulers[index].y = atan2f(rot._31, rot._33);
+			eulers[index].z = atan2f(rot._12, rot._22);
+		}
+
+		// Splits a matrix back into position, rotation and scale
+		void SetLocalFromMatrix(uint32_t index, FXMMATRIX matrix)
+		{
+			XMVECTOR s, r, t;
+			XMMatrixDecompose(&s, &r, &t, matrix);
+
+			XMFLOAT3 scale, position;
+			XMStoreFloat3(&scale, s);
+			XMStoreFloat3(&position, t);
+			posX[index] = position.x; posY[index] = position.y; posZ[index] = position.z;
+			sclX[index] = scale.x; sclY[index] = scale.y; sclZ[index] = scale.z;
+			SetRotationFromQuaternion(index, r);
+
+			MarkDirty(index);
+		}
+
+		// Builds the local scale * rotation * translation matrices of
+		// four consecutive transforms at once, along with their
+		// inverse transposes.  Each vector holds the same component
+		// of four different transforms.
+		//
+		// For local = S * R * T the inverse transpose needs no general
+		// inverse: its 3x3 part is S^-1 * R (the rotation rows divided
+		// by the scale) and its last column is -(t . row) / scale.
+		void BuildLocalMatrices4(uint32_t first)
+		{
+			XMVECTOR x = XMLoadFloat4((const XMFLOAT4*)&rotX[first]);
+			XMVECTOR y = XMLoadFloat4((const XMFLOAT4*)&rotY[first]);
+			XMVECTOR z = XMLoadFloat4((const XMFLOAT4*)&rotZ[first]);
+			XMVECTOR w = XMLoadFloat4((const XMFLOAT4*)&rotW[first]);
+			XMVECTOR sx = XMLoadFloat4((const XMFLOAT4*)&sclX[first]);
+			XMVECTOR sy = XMLoadFloat4((const XMFLOAT4*)&sclY[first]);
+			XMVECTOR sz = XMLoadFloat4((const XMFLOAT4*)&sclZ[first]);
+			XMVECTOR px = XMLoadFloat4((const XMFLOAT4*)&posX[first]);
+			XMVECTOR py = XMLoadFloat4((const XMFLOAT4*)&posY[first]);
+			XMVECTOR pz = XMLoadFloat4((const XMFLOAT4*)&posZ[first]);
+
+			XMVECTOR one = XMVectorSplatOne();
+			XMVECTOR two = XMVectorAdd(one, one);
+			XMVECTOR zero = XMVectorZero();
+
+			// Quaternion to rotation matrix, same layout as XMMatrixRotationQuaternion()
+			XMVECTOR xx = XMVectorMultiply(x, x), yy = XMVectorMultiply(y, y), zz = XMVectorMultiply(z, z);
+			XMVECTOR xy = XMVectorMultiply(x, y), xz = XMVectorMultiply(x, z), yz = XMVectorMultiply(y, z);
+			XMVECTOR xw = XMVectorMultiply(x, w), yw = XMVectorMultiply(y, w), zw = XMVectorMultiply(z, w);
+
+			XMVECTOR m00 = XMVectorNegativeMultiplySubtract(two, XMVectorAdd(yy, zz), one);
+			XMVECTOR m01 = XMVectorMultiply(two, XMVectorAdd(xy, zw));
+			XMVECTOR m02 = XMVectorMultiply(two, XMVectorSubtract(xz, yw));
+			XMVECTOR m10 = XMVectorMultiply(two, XMVectorSubtract(xy, zw));
+			XMVECTOR m11 = XMVectorNegativeMultiplySubtract(two, XMVectorAdd(xx, zz), one);
+			XMVECTOR m12 = XMVectorMultiply(two, XMVectorAdd(yz, xw));
+			XMVECTOR m20 = XMVectorMultiply(two, XMVectorAdd(xz, yw));
+			XMVECTOR m21 = XMVectorMultiply(two, XMVectorSubtract(yz, xw));
+			XMVECTOR m22 = XMVectorNegativeMultiplySubtract(two, XMVectorAdd(xx, yy), one);
+
+			// Scale each row, then transpose so each vector becomes
+			// one row of one transform's matrix
+			XMMATRIX row0 = XMMatrixTranspose(XMMATRIX(
+				XMVectorMultiply(m00, sx), XMVectorMultiply(m01, sx), XMVectorMultiply(m02, sx), zero));
+			XMMATRIX row1 = XMMatrixTranspose(XMMATRIX(
+				XMVectorMultiply(m10, sy), XMVectorMultiply(m11, sy), XMVectorMultiply(m12, sy), zero));
+			XMMATRIX row2 = XMMatrixTranspose(XMMATRIX(
+				XMVectorMultiply(m20, sz), XMVectorMultiply(m21, sz), XMVectorMultiply(m22, sz), zero));
+			XMMATRIX row3 = XMMatrixTranspose(XMMATRIX(px, py, pz, one));
+
+			// Same rotation rows divided by scale, translation dotted with each row
+			XMVECTOR rsx = XMVectorReciprocal(sx);
+			XMVECTOR rsy = XMVectorReciprocal(sy);
+			XMVECTOR rsz = XMVectorReciprocal(sz);
+			XMVECTOR dot0 = XMVectorMultiplyAdd(pz, m02, XMVectorMultiplyAdd(py, m01, XMVectorMultiply(px, m00)));
+			XMVECTOR dot1 = XMVectorMultiplyAdd(pz, m12, XMVectorMultiplyAdd(py, m11, XMVectorMultiply(px, m10)));
+			XMVECTOR dot2 = XMVectorMultiplyAdd(pz, m22, XMVectorMultiplyAdd(py, m21, XMVectorMultiply(px, m20)));
+			XMMATRIX invRow0 = XMMatrixTranspose(XMMATRIX(
+				XMVectorMultiply(m00, rsx), XMVectorMultiply(m01, rsx), XMVectorMultiply(m02, rsx), XMVectorNegate(XMVectorMultiply(dot0, rsx))));
+			XMMATRIX invRow1 = XMMatrixTranspose(XMMATRIX(
+				XMVectorMultiply(m10, rsy), XMVectorMultiply(m11, rsy), XMVectorMultiply(m12, rsy), XMVectorNegate(XMVectorMultiply(dot1, rsy))));
+			XMMATRIX invRow2 = XMMatrixTranspose(XMMATRIX(
+				XMVectorMultiply(m20, rsz), XMVectorMultiply(m21, rsz), XMVectorMultiply(m22, rsz), XMVectorNegate(XMVectorMultiply(dot2, rsz))));
+			XMVECTOR invRow3 = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+
+			// Lanes with a (near) zero scale get the general inverse later
+			XMVECTOR epsilon = XMVectorReplicate(DegenerateScale);
+			XMVECTOR bad = XMVectorOrInt(
+				XMVectorOrInt(XMVectorLess(XMVectorAbs(sx), epsilon), XMVectorLess(XMVectorAbs(sy), epsilon)),
+				XMVectorLess(XMVectorAbs(sz), epsilon));
+			XMUINT4 badLanes;
+			XMStoreUInt4(&badLanes, bad);
+			uint32_t badLane[4] = { badLanes.x, badLanes.y, badLanes.z, badLanes.w };
+
+			for (int i = 0; i < 4; i++)
+			{
+				XMMATRIX local(row0.r[i], row1.r[i], row2.r[i], row3.r[i]);
+				XMMATRIX localInvTranspose(invRow0.r[i], invRow1.r[i], invRow2.r[i], invRow3);
+				XMStoreFloat4x4A(&localMatrices[first + i], local);
+				XMStoreFloat4x4A(&localInvTransposeMatrices[first + i], localInvTranspose);
+				degenerate[first + i] = badLane[i] != 0;
+			}
+		}
+
+		// Moves every array into a new order given by newToOld
+		template <typename T>
+		void Permute(std::vector<T>& data, const std::vector<uint32_t>& newToOld, size_t finalSize)
+		{
+			std::vector<T> sorted(finalSize);
+			for (size_t n = 0; n < newToOld.size(); n++)
+				sorted[n] = data[newToOld[n]];
+			data.swap(sorted);
+		}
+
+		// Sorts everything breadth-first (children of each transform
+		// end up contiguous) and drops released transforms.  Only
+		// runs after structural changes.
+		void Reorder()
+		{
+			// Bucket live transforms by parent, keeping their current order
+			std::vector<uint32_t> childStart(count + 1, 0);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				if (denseToHandle[i] != InvalidHandle && parents[i] != InvalidIndex)
+					childStart[parents[i] + 1]++;
+			}
+			for (uint32_t i = 0; i < count; i++)
+				childStart[i + 1] += childStart[i];
+
+			std::vector<uint32_t> childList(childStart[count]);
+			std::vector<uint32_t> fill(childStart.begin(), childStart.end() - 1);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				if (denseToHandle[i] != InvalidHandle && parents[i] != InvalidIndex)
+					childList[fill[parents[i]]++] = i;
+			}
+
+			// Breadth-first walk: roots first, then each transform's
+			// children are appended as it is reached
+			std::vector<uint32_t> newToOld;
+			newToOld.reserve(count - releasedCount);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				if (denseToHandle[i] != InvalidHandle && parents[i] == InvalidIndex)
+					newToOld.push_back(i);
+			}
+
+			std::vector<uint32_t> newFirstChild(count - releasedCount);
+			for (uint32_t n = 0; n < newToOld.size(); n++)
+			{
+				uint32_t o = newToOld[n];
+				newFirstChild[n] = (uint32_t)newToOld.size();
+				for (uint32_t c = childStart[o]; c < childStart[o + 1]; c++)
+					newToOld.push_back(childList[c]);
+			}
+
+			std::vector<uint32_t> oldToNew(count, InvalidIndex);
+			for (uint32_t n = 0; n < newToOld.size(); n++)
+				oldToNew[newToOld[n]] = n;
+
+			uint32_t newCount = (uint32_t)newToOld.size();
+			uint32_t padded = PadToFour(newCount);
+
+			Permute(posX, newToOld, padded); Permute(posY, newToOld, padded); Permute(posZ, newToOld, padded);
+			Permute(rotX, newToOld, padded); Permute(rotY, newToOld, padded); Permute(rotZ, newToOld, padded); Permute(rotW, newToOld, padded);
+			Permute(sclX, newToOld, padded); Permute(sclY, newToOld, padded); Permute(sclZ, newToOld, padded);
+			Permute(prevPosX, newToOld, padded); Permute(prevPosY, newToOld, padded); Permute(prevPosZ, newToOld, padded);
+			Permute(prevRotX, newToOld, padded); Permute(prevRotY, newToOld, padded); Permute(prevRotZ, newToOld, padded); Permute(prevRotW, newToOld, padded);
+			Permute(prevSclX, newToOld, padded); Permute(prevSclY, newToOld, padded); Permute(prevSclZ, newToOld, padded);
+			Permute(dirty, newToOld, padded);
+			Permute(degenerate, newToOld, padded);
+			Permute(localMatrices, newToOld, padded);
+			Permute(localInvTransposeMatrices, newToOld, padded);
+
+			Permute(eulers, newToOld, newCount);
+			Permute(rights, newToOld, newCount);
+			Permute(ups, newToOld, newCount);
+			Permute(forwards, newToOld, newCount);
+			Permute(worldMatrices, newToOld, newCount);
+			Permute(worldInvTransposeMatrices, newToOld, newCount);
+			Permute(versions, newToOld, newCount);
+			Permute(generalInverse, newToOld, newCount);
+			Permute(moved, newToOld, newCount);
+			Permute(parents, newToOld, newCount);
+			Permute(childCounts, newToOld, newCount);
+			Permute(owners, newToOld, newCount);
+			Permute(denseToHandle, newToOld, newCount);
+			firstChildren.swap(newFirstChild);
+
+			// Indices all changed, so the blended matrices go too
+			renderMatrices.resize(newCount);
+			renderInvTransposeMatrices.resize(newCount);
+			blended.assign(newCount, 0);
+			blendedList.clear();
+
+			dirtyList.clear();
+			movedList.clear();
+			levelStarts.assign(1, 0);
+			for (uint32_t n = 0; n < newCount; n++)
+			{
+				if (parents[n] != InvalidIndex)
+				{
+					parents[n] = oldToNew[parents[n]];
+
+					// Breadth-first, so a parent in the current level means a new one
+					if (parents[n] >= levelStarts.back())
+						levelStarts.push_back(n);
+				}
+				handleToDense[denseToHandle[n]] = n;
+				if (dirty[n])
+					dirtyList.push_back(n);
+				if (moved[n])
+					movedList.push_back(n);
+			}
+
+			count = newCount;
+			releasedCount = 0;
+			orderDirty = false;
+			stats.Reorders++;
+		}
+
+		// Builds the world matrices of the given transforms, which are
+		// either dirty or have a parent that was just rebuilt.  Their
+		// parents are already up to date.  Returns the number of
+		// matrices rebuilt.
+		uint32_t UpdateWorld(const uint32_t* indices, uint32_t n)
+		{
+			uint32_t updated = 0;
+			for (uint32_t k = 0; k < n; k++)
+			{
+				if (k + PrefetchAhead < n)
+				{
+					uint32_t ahead = indices[k + PrefetchAhead];
+					TRANSFORM_PREFETCH(&localMatrices[ahead]);
+					TRANSFORM_PREFETCH(&localInvTransposeMatrices[ahead]);
+					TRANSFORM_PREFETCH(&worldMatrices[ahead]);
+					TRANSFORM_PREFETCH(&worldInvTransposeMatrices[ahead]);
+				}
+
+				uint32_t i = indices[k];
+				if (denseToHandle[i] == InvalidHandle)
+					continue;
+				uint32_t p = parents[i];
+
+				// Inverse transposes compose the same way as the matrices:
+				// invT(local * parent) = invT(local) * invT(parent)
+				XMMATRIX world = XMLoadFloat4x4A(&localMatrices[i]);
+				XMMATRIX worldInvTranspose = XMLoadFloat4x4A(&localInvTransposeMatrices[i]);
+				if (p != InvalidIndex)
+				{
+					world = world * XMLoadFloat4x4A(&worldMatrices[p]);
+					worldInvTranspose = worldInvTranspose * XMLoadFloat4x4A(&worldInvTransposeMatrices[p]);
+				}
+
+				// Zero scale anywhere up the chain poisons the fast path
+				generalInverse[i] = degenerate[i] || (p != InvalidIndex && generalInverse[p]);
+				if (generalInverse[i])
+					worldInvTranspose = XMMatrixInverse(0, XMMatrixTranspose(world));
+
+				XMStoreFloat4x4A(&worldMatrices[i], world);
+				XMStoreFloat4x4A(&worldInvTransposeMatrices[i], worldInvTranspose);
+
+				// Moving with a parent is a change too
+				if (!dirty[i])
+					versions[i]++;
+
+				dirty[i] = 0;
+				updated++;
+			}
+			return updated;
+		}
+
+		// Blends the render matrices of the given transforms, which
+		// either moved or have a parent that was just blended.  Their
+		// parents are already done.  Returns the number of matrices
+		// blended.
+		uint32_t InterpolateWorld(const uint32_t* indices, uint32_t n, float alpha)
+		{
+			uint32_t interpolated = 0;
+			for (uint32_t k = 0; k < n; k++)
+			{
+				if (k + PrefetchAhead < n)
+				{
+					uint32_t ahead = indices[k + PrefetchAhead];
+					TRANSFORM_PREFETCH(&localMatrices[ahead]);
+					TRANSFORM_PREFETCH(&localInvTransposeMatrices[ahead]);
+					TRANSFORM_PREFETCH(&renderMatrices[ahead]);
+					TRANSFORM_PREFETCH(&renderInvTransposeMatrices[ahead]);
+				}
+
+				uint32_t i = indices[k];
+				uint32_t p = parents[i];
+				bool parentBlended = p != InvalidIndex && blended[p];
+				blended[i] = (moved[i] || parentBlended) && denseToHandle[i] != InvalidHandle;
+				if (!blended[i])
+					continue;
+
+				XMMATRIX local, localInvTranspose;
+				bool valid = true;
+				if (moved[i])
+				{
+					XMVECTOR q = XMQuaternionSlerp(
+						XMVectorSet(prevRotX[i], prevRotY[i], prevRotZ[i], prevRotW[i]),
+						XMVectorSet(rotX[i], rotY[i], rotZ[i], rotW[i]), alpha);
+					XMFLOAT3 position(
+						prevPosX[i] + (posX[i] - prevPosX[i]) * alpha,
+						prevPosY[i] + (posY[i] - prevPosY[i]) * alpha,
+						prevPosZ[i] + (posZ[i] - prevPosZ[i]) * alpha);
+					XMFLOAT3 scale(
+						prevSclX[i] + (sclX[i] - prevSclX[i]) * alpha,
+						prevSclY[i] + (sclY[i] - prevSclY[i]) * alpha,
+						prevSclZ[i] + (sclZ[i] - prevSclZ[i]) * alpha);
+					valid = BuildLocalMatrix(q, position, scale, local, localInvTranspose);
+				}
+				else
+				{
+					local = XMLoadFloat4x4A(&localMatrices[i]);
+					localInvTranspose = XMLoadFloat4x4A(&localInvTransposeMatrices[i]);
+					valid = !degenerate[i];
+				}
+
+				XMMATRIX world = local;
+				XMMATRIX worldInvTranspose = localInvTranspose;
+				if (p != InvalidIndex)
+				{
+					const XMFLOAT4X4A& parentWorld = parentBlended ? renderMatrices[p] : worldMatrices[p];
+					const XMFLOAT4X4A& parentInvTranspose = parentBlended ? renderInvTransposeMatrices[p] : worldInvTransposeMatrices[p];
+					world = world * XMLoadFloat4x4A(&parentWorld);
+					worldInvTranspose = worldInvTranspose * XMLoadFloat4x4A(&parentInvTranspose);
+				}
+
+				if (!valid || generalInverse[i])
+					worldInvTranspose = XMMatrixInverse(0, XMMatrixTranspose(world));
+
+				XMStoreFloat4x4A(&renderMatrices[i], world);
+				XMStoreFloat4x4A(&renderInvTransposeMatrices[i], worldInvTranspose);
+				interpolated++;
+			}
+			return interpolated;
+		}
+
+		// Calls body(indices, n) in parallel over walkRoots and
+		// everything below them, finishing each level of the hierarchy
+		// before the next.  walkRoots must be sorted.  Only the roots
+		// and their children are visited, so clean levels and clean
+		// parts of a level cost nothing.  Everything visited is added
+		// to visited, if given.
+		template <typename Body>
+		void ForEachChangedLevel(const Body& body, std::vector<uint32_t>* visited)
+		{
+			size_t nextRoot = 0;
+			size_t level = 0;
+			walkChildren.clear();
+			while (!walkChildren.empty() || nextRoot < walkRoots.size())
+			{
+				// Nothing carried down from the last level, so skip
+				// straight to the level of the next root
+				if (walkChildren.empty())
+					level = (size_t)(std::upper_bound(levelStarts.begin(), levelStarts.end(), walkRoots[nextRoot]) - levelStarts.begin()) - 1;
+				uint32_t levelEnd = level + 1 < levelStarts.size() ? levelStarts[level + 1] : count;
+
+				// Both lists are sorted, and a root can also be a child
+				// of something rebuilt in the last level
+				walkLevel.clear();
+				size_t c = 0;
+				while (c < walkChildren.size() || (nextRoot < walkRoots.size() && walkRoots[nextRoot] < levelEnd))
+				{
+					bool takeRoot = nextRoot < walkRoots.size() && walkRoots[nextRoot] < levelEnd &&
+						(c == walkChildren.size() || walkRoots[nextRoot] <= walkChildren[c]);
+					if (!takeRoot)
+						walkLevel.push_back(walkChildren[c++]);
+					else
+					{
+						if (c < walkChildren.size() && walkChildren[c] == walkRoots[nextRoot])
+							c++;
+						walkLevel.push_back(walkRoots[nextRoot++]);
+					}
+				}
+
+				const uint32_t* indices = walkLevel.data();
+				JobSystem::ParallelFor((uint32_t)walkLevel.size(), ParallelMatrices, [&](uint32_t begin, uint32_t end)
+				{
+					body(indices + begin, end - begin);
+				});
+				if (visited)
+					visited->insert(visited->end(), walkLevel.begin(), walkLevel.end());
+
+				// Breadth-first, so the child ranges come out sorted too
+				walkChildren.clear();
+				for (uint32_t i : walkLevel)
+				{
+					for (uint32_t child = firstChildren[i]; child < firstChildren[i] + childCounts[i]; child++)
+						walkChildren.push_back(child);
+				}
+				level++;
+			}
+		}
+
+		// Sorts list into walkRoots.  Anything released since it was
+		// listed is skipped by the walk's body, and has no children.
+		void GatherRoots(const std::vector<uint32_t>& list)
+		{
+			walkRoots.assign(list.begin(), list.end());
+			std::sort(walkRoots.begin(), walkRoots.end());
+		}
+
+		void UpdateIfNeeded()
+		{
+			if (orderDirty || !dirtyList.empty())
+				Update();
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Creates a new root transform with identity values
+//
+// owner - The Transform object using this handle, if any
+// --------------------------------------------------------
+TransformSystem::Handle TransformSystem::Create(Transform* owner)
+{
+	Handle handle;
+	if (!freeHandles.empty())
+	{
+		handle = freeHandles.back();
+		freeHandles.pop_back();
+	}
+	else
+	{
+		handle = (Handle)handleToDense.size();
+		handleToDense.push_back(InvalidIndex);
+	}
+
+	// New roots go on the end.  That isn't strictly breadth-first,
+	// but parents still come before children and no child ranges
+	// move, so there is no need to re-sort.
+	uint32_t index = count++;
+	handleToDense[handle] = index;
+	ResizePadded(count);
+	posX[index] = 0.0f; posY[index] = 0.0f; posZ[index] = 0.0f;
+	rotX[index] = 0.0f; rotY[index] = 0.0f; rotZ[index] = 0.0f; rotW[index] = 1.0f;
+	sclX[index] = 1.0f; sclY[index] = 1.0f; sclZ[index] = 1.0f;
+	moved.push_back(0);
+	CopyToPrevious(index);
+
+	eulers.push_back(XMFLOAT3(0, 0, 0));
+	rights.push_back(XMFLOAT3(1, 0, 0));
+	ups.push_back(XMFLOAT3(0, 1, 0));
+	forwards.push_back(XMFLOAT3(0, 0, 1));
+	worldMatrices.push_back(XMFLOAT4X4A());
+	worldInvTransposeMatrices.push_back(XMFLOAT4X4A());
+	versions.push_back(0);
+	generalInverse.push_back(0);
+	parents.push_back(InvalidIndex);
+	childCounts.push_back(0);
+	firstChildren.push_back(0);
+	owners.push_back(owner);
+	denseToHandle.push_back(handle);
+	renderMatrices.push_back(XMFLOAT4X4A());
+	renderInvTransposeMatrices.push_back(XMFLOAT4X4A());
+	blended.push_back(0);
+
+	MarkDirty(index);
+	return handle;
+}
+
+// --------------------------------------------------------
+// Releases a transform.  Its children become roots, staying
+// where they are in the world.
+// --------------------------------------------------------
+void TransformSystem::Release(Handle node)
+{
+	uint32_t index = handleToDense[node];
+	if (index == InvalidIndex)
+		return;
+
+	if (childCounts[index] > 0)
+	{
+		// Need current world matrices and contiguous children
+		UpdateIfNeeded();
+		index = handleToDense[node];
+
+		for (uint32_t c = firstChildren[index]; c < firstChildren[index] + childCounts[index]; c++)
+		{
+			parents[c] = InvalidIndex;
+			SetLocalFromMatrix(c, XMLoadFloat4x4A(&worldMatrices[c]));
+			CopyToPrevious(c);
+		}
+		childCounts[index] = 0;
+		orderDirty = true;
+	}
+
+	// Leaves a gap in the parent's child range
+	if (parents[index] != InvalidIndex)
+	{
+		childCounts[parents[index]]--;
+		orderDirty = true;
+	}
+
+	handleToDense[node] = InvalidIndex;
+	denseToHandle[index] = InvalidHandle;
+	owners[index] = nullptr;
+	dirty[index] = 0;
+	freeHandles.push_back(node);
+	releasedCount++;
+
+	// Released entries are compacted away on the next re-sort,
+	// which can wait until something else needs one
+	if (releasedCount > count / 2)
+		orderDirty = true;
+}
+
+void TransformSystem::Reserve(size_t n)
+{
+	uint32_t padded = PadToFour((uint32_t)n);
+	posX.reserve(padded); posY.reserve(padded); posZ.reserve(padded);
+	rotX.reserve(padded); rotY.reserve(padded); rotZ.reserve(padded); rotW.reserve(padded);
+	sclX.reserve(padded); sclY.reserve(padded); sclZ.reserve(padded);
+	prevPosX.reserve(padded); prevPosY.reserve(padded); prevPosZ.reserve(padded);
+	prevRotX.reserve(padded); prevRotY.reserve(padded); prevRotZ.reserve(padded); prevRotW.reserve(padded);
+	prevSclX.reserve(padded); prevSclY.reserve(padded); prevSclZ.reserve(padded);
+	dirty.reserve(padded);
+	degenerate.reserve(padded);
+	localMatrices.reserve(padded);
+	localInvTransposeMatrices.reserve(padded);
+
+	eulers.reserve(n);
+	rights.reserve(n);
+	ups.reserve(n);
+	forwards.reserve(n);
+	worldMatrices.reserve(n);
+	worldInvTransposeMatrices.reserve(n);
+	versions.reserve(n);
+	dirtyList.reserve(n);
+	movedList.reserve(n);
+	blendedList.reserve(n);
+	moved.reserve(n);
+	renderMatrices.reserve(n);
+	renderInvTransposeMatrices.reserve(n);
+	blended.reserve(n);
+	generalInverse.reserve(n);
+	parents.reserve(n);
+	childCounts.reserve(n);
+	firstChildren.reserve(n);
+	owners.reserve(n);
+	denseToHandle.reserve(n);
+	handleToDense.reserve(n);
+}
+
+// --------------------------------------------------------
+// Attaches a transform to a new parent (or makes it a root)
+//
+// node              - The transform to move
+// parent            - Its new parent, or InvalidHandle
+// keepWorldPosition - Adjust the local values so it doesn't move
+//
+// Returns false if the parent is the node or one of its children
+// --------------------------------------------------------
+bool TransformSystem::SetParent(Handle node, Handle parent, bool keepWorldPosition)
+{
+	uint32_t index = handleToDense[node];
+	uint32_t parentIndex = parent == InvalidHandle ? InvalidIndex : handleToDense[parent];
+
+	for (uint32_t p = parentIndex; p != InvalidIndex; p = parents[p])
+	{
+		if (p == index)
+			return false;
+	}
+
+	if (parents[index] == parentIndex)
+		return true;
+
+	if (keepWorldPosition)
+	{
+		// new local = current world * inverse of the new parent's world
+		UpdateIfNeeded();
+		index = handleToDense[node];
+		parentIndex = parent == InvalidHandle ? InvalidIndex : handleToDense[parent];
+
+		XMMATRIX local = XMLoadFloat4x4A(&worldMatrices[index]);
+		if (parentIndex != InvalidIndex)
+			local = local * XMMatrixInverse(0, XMLoadFloat4x4A(&worldMatrices[parentIndex]));
+		SetLocalFromMatrix(index, local);
+
+		// Don't blend between values from two different parent spaces
+		CopyToPrevious(index);
+	}
+
+	if (parents[index] != InvalidIndex)
+		childCounts[parents[index]]--;
+	if (parentIndex != InvalidIndex)
+		childCounts[parentIndex]++;
+
+	parents[index] = parentIndex;
+	orderDirty = true;
+	MarkDirty(index);
+	return true;
+}
+
+TransformSystem::Handle TransformSystem::GetParent(Handle node)
+{
+	uint32_t parentIndex = parents[handleToDense[node]];
+	return parentIndex == InvalidIndex ? InvalidHandle : denseToHandle[parentIndex];
+}
+
+unsigned int TransformSystem::GetChildCount(Handle node)
+{
+	return childCounts[handleToDense[node]];
+}
+
+TransformSystem::Handle TransformSystem::GetChild(Handle node, unsigned int index)
+{
+	if (orderDirty)
+		Reorder();
+
+	uint32_t dense = handleToDense[node];
+	if (index >= childCounts[dense])
+		return InvalidHandle;
+	return denseToHandle[firstChildren[dense] + index];
+}
+
+Transform* TransformSystem::GetOwner(Handle node)
+{
+	return owners[handleToDense[node]];
+}
+
+// --------------------------------------------------------
+// Local value setters and getters
+// --------------------------------------------------------
+void TransformSystem::SetPosition(Handle node, const XMFLOAT3& position)
+{
+	uint32_t index = handleToDense[node];
+	posX[index] = position.x;
+	posY[index] = position.y;
+	posZ[index] = position.z;
+	MarkDirty(index);
+}
+
+void TransformSystem::SetPitchYawRoll(Handle node, const XMFLOAT3& pitchYawRoll)
+{
+	uint32_t index = handleToDense[node];
+	eulers[index] = pitchYawRoll;
+	SetRotationFromEuler(index);
+	MarkDirty(index);
+}
+
+void TransformSystem::SetRotation(Handle node, const XMFLOAT4& quaternion)
+{
+	uint32_t index = handleToDense[node];
+	SetRotationFromQuaternion(index, XMLoadFloat4(&quaternion));
+	MarkDirty(index);
+}
+
+void TransformSystem::SetScale(Handle node, const XMFLOAT3& scale)
+{
+	uint32_t index = handleToDense[node];
+	sclX[index] = scale.x;
+	sclY[index] = scale.y;
+	sclZ[index] = scale.z;
+	MarkDirty(index);
+}
+
+XMFLOAT3 TransformSystem::GetPosition(Handle node)
+{
+	uint32_t index = handleToDense[node];
+	return XMFLOAT3(posX[index], posY[index], posZ[index]);
+}
+
+XMFLOAT3 TransformSystem::GetPitchYawRoll(Handle node)
+{
+	return eulers[handleToDense[node]];
+}
+
+XMFLOAT4 TransformSystem::GetRotation(Handle node)
+{
+	uint32_t index = handleToDense[node];
+	return XMFLOAT4(rotX[index], rotY[index], rotZ[index], rotW[index]);
+}
+
+XMFLOAT3 TransformSystem::GetScale(Handle node)
+{
+	uint32_t index = handleToDense[node];
+	return XMFLOAT3(sclX[index], sclY[index], sclZ[index]);
+}
+
+XMFLOAT3 TransformSystem::GetRight(Handle node) { return rights[handleToDense[node]]; }
+XMFLOAT3 TransformSystem::GetUp(Handle node) { return ups[handleToDense[node]]; }
+XMFLOAT3 TransformSystem::GetForward(Handle node) { return forwards[handleToDense[node]]; }
+
+// --------------------------------------------------------
+// Rebuilds the matrices of every transform that changed,
+// along with everything below them
+// --------------------------------------------------------
+void TransformSystem::Update()
+{
+	if (orderDirty)
+		Reorder();
+
+	stats.LastUpdateCount = 0;
+	GatherRoots(dirtyList);
+	dirtyList.clear();
+	if (walkRoots.empty())
+		return;
+
+	// Local matrices, four transforms at a time, for just the
+	// groups of four with something dirty in them.  The roots are
+	// sorted, so each group's first dirty entry builds it.
+	dirtyGroups.clear();
+	for (uint32_t i : walkRoots)
+	{
+		if (dirtyGroups.empty() || dirtyGroups.back() != (i & ~3u))
+			dirtyGroups.push_back(i & ~3u);
+	}
+	const uint32_t* groups = dirtyGroups.data();
+	JobSystem::ParallelFor((uint32_t)dirtyGroups.size(), ParallelGroups, [groups](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t g = begin; g < end; g++)
+		{
+			if (g + PrefetchAhead < end)
+			{
+				uint32_t ahead = groups[g + PrefetchAhead];
+				TRANSFORM_PREFETCH(&posX[ahead]); TRANSFORM_PREFETCH(&posY[ahead]); TRANSFORM_PREFETCH(&posZ[ahead]);
+				TRANSFORM_PREFETCH(&rotX[ahead]); TRANSFORM_PREFETCH(&rotY[ahead]); TRANSFORM_PREFETCH(&rotZ[ahead]); TRANSFORM_PREFETCH(&rotW[ahead]);
+				TRANSFORM_PREFETCH(&sclX[ahead]); TRANSFORM_PREFETCH(&sclY[ahead]); TRANSFORM_PREFETCH(&sclZ[ahead]);
+			}
+			BuildLocalMatrices4(groups[g]);
+		}
+	});
+
+	// World matrices one level at a time, down from each dirty transform
+	std::atomic<uint32_t> rebuiltCount{ 0 };
+	ForEachChangedLevel([&](const uint32_t* indices, uint32_t n)
+	{
+		rebuiltCount.fetch_add(UpdateWorld(indices, n), std::memory_order_relaxed);
+	}, nullptr);
+
+	stats.LastUpdateCount = rebuiltCount.load();
+}
+
+bool TransformSystem::HasPendingChanges()
+{
+	return orderDirty || !dirtyList.empty();
+}
+
+const XMFLOAT4X4A& TransformSystem::GetWorldMatrix(Handle node)
+{
+	UpdateIfNeeded();
+	return worldMatrices[handleToDense[node]];
+}
+
+const XMFLOAT4X4A& TransformSystem::GetWorldInverseTransposeMatrix(Handle node)
+{
+	UpdateIfNeeded();
+	return worldInvTransposeMatrices[handleToDense[node]];
+}
+
+// --------------------------------------------------------
+// Gets a number that changes whenever the transform's world
+// matrix does, including when one of its parents moves
+// --------------------------------------------------------
+unsigned int TransformSystem::GetVersion(Handle node)
+{
+	UpdateIfNeeded();
+	return versions[handleToDense[node]];
+}
+
+// --------------------------------------------------------
+// Starts a fixed simulation step by remembering the current
+// local values of everything that moved during the last one
+// --------------------------------------------------------
+void TransformSystem::BeginStep()
+{
+	if (orderDirty)
+		Reorder();
+
+	for (uint32_t i : movedList)
+	{
+		CopyToPrevious(i);
+		moved[i] = 0;
+	}
+	movedList.clear();
+}
+
+// --------------------------------------------------------
+// Blends everything that moved during the current step
+// between its previous and current values
+//
+// alpha - How far between the previous (0) and current (1)
+//         step the frame being rendered is
+//
+// Transforms that didn't move, and have no parent that moved,
+// just use their world matrices.
+// --------------------------------------------------------
+void TransformSystem::Interpolate(float alpha)
+{
+	Update();
+
+	// Anything blended last time goes back to its world matrix
+	// unless it's blended again below
+	for (uint32_t i : blendedList)
+		blended[i] = 0;
+	blendedList.clear();
+
+	GatherRoots(movedList);
+	std::atomic<uint32_t> interpolated{ 0 };
+	ForEachChangedLevel([&](const uint32_t* indices, uint32_t n)
+	{
+		interpolated.fetch_add(InterpolateWorld(indices, n, alpha), std::memory_order_relaxed);
+	}, &blendedList);
+	stats.Interpolated = interpolated.load();
+}
+
+const XMFLOAT4X4A& TransformSystem::GetRenderWorldMatrix(Handle node)
+{
+	uint32_t index = handleToDense[node];
+	return blended[index] ? renderMatrices[index] : worldMatrices[index];
+}
+
+const XMFLOAT4X4A& TransformSystem::GetRenderWorldInverseTransposeMatrix(Handle node)
+{
+	uint32_t index = handleToDense[node];
+	return blended[index] ? renderInvTransposeMatrices[index] : worldInvTransposeMatrices[index];
+}
+
+TransformSystem::Stats TransformSystem::GetStats()
+{
+	Stats current = stats;
+	current.Count = count - releasedCount;
+	return current;
+}
+
+// --------------------------------------------------------
+// Checks the analytic inverse transposes against the general
+// XMMatrixInverse() on a randomized hierarchy
+//
+// samples - Number of temporary transforms to create
+//
+// Returns the largest error found, relative to each matrix's
+// largest element.  The temporary transforms are released.
+// --------------------------------------------------------
+float TransformSystem::ValidateInverseTranspose(unsigned int samples)
+{
+	std::mt19937 rng(samples);
+	std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+	std::uniform_real_distribution<float> angle(-XM_PI, XM_PI);
+	std::uniform_real_distribution<float> scale(0.1f, 4.0f);
+
+	std::vector<Handle> handles;
+	for (unsigned int i = 0; i < samples; i++)
+	{
+		Handle h = Create(nullptr);
+		SetPosition(h, XMFLOAT3(position(rng), position(rng), position(rng)));
+		SetPitchYawRoll(h, XMFLOAT3(angle(rng), angle(rng), angle(rng)));
+
+		// Mostly positive, some mirrored, some non-uniform
+		XMFLOAT3 s(scale(rng), scale(rng), scale(rng));
+		if (rng() % 8 == 0) s.x = -s.x;
+		if (rng() % 2 == 0) s.y = s.z = s.x;
+		SetScale(h, s);
+
+		// Short chains so errors don't just measure float precision
+		if (i > 0 && rng() % 3 != 0 && GetParent(handles[i - 1]) == InvalidHandle)
+			SetParent(h, handles[i - 1], false);
+		handles.push_back(h);
+	}
+
+	Update();
+
+	float maxError = 0.0f;
+	for (Handle h : handles)
+	{
+		XMFLOAT4X4 expected;
+		XMStoreFloat4x4(&expected, XMMatrixInverse(0, XMMatrixTranspose(XMLoadFloat4x4A(&GetWorldMatrix(h)))));
+		const XMFLOAT4X4A& actual = GetWorldInverseTransposeMatrix(h);
+
+		float largest = 1.0f;
+		float worst = 0.0f;
+		for (int r = 0; r < 4; r++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				largest = fmaxf(largest, fabsf(expected.m[r][c]));
+				worst = fmaxf(worst, fabsf(expected.m[r][c] - actual.m[r][c]));
+			}
+		}
+		maxError = fmaxf(maxError, worst / largest);
+	}
+
+	// Children first, so nothing needs re-rooting
+	for (size_t i = handles.size(); i > 0; i--)
+		Release(handles[i - 1]);
+
+	return maxError;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <stdint.h>
+
+class Transform;
+
+// --------------------------------------------------------
+// Owns the data behind every Transform
+//
+// Positions, rotations (quaternions) and scales are kept in
+// separate tightly packed float arrays, addressed through
+// stable handles, and sorted breadth-first so parents always
+// come before their children.  Update() rebuilds the local
+// matrices of dirty transforms four at a time with SIMD, then
+// composes world and inverse-transpose matrices one hierarchy
+// level at a time over only the subtrees that changed.  Both
+// passes are split across the JobSystem's threads.  Inverse
+// transposes are built analytically from the rotation and
+// reciprocal scale, falling back to a general inverse only
+// for (near) zero scales.
+//
+// Transform is a thin handle over this, so most code never
+// needs to call in here directly.
+// --------------------------------------------------------
+namespace TransformSystem
+{
+	typedef uint32_t Handle;
+	constexpr Handle InvalidHandle = 0xFFFFFFFF;
+
+	struct Stats
+	{
+		unsigned int Count;				// Live transforms
+		unsigned int LastUpdateCount;	// World matrices rebuilt by the last Update()
+		unsigned int Reorders;			// Times the arrays were re-sorted after structural changes
+		unsigned int Interpolated;		// Render matrices blended by the last Interpolate()
+	};
+
+	// Lifetime - owner may be null for transforms without a Transform object
+	Handle Create(Transform* owner);
+	void Release(Handle node);
+	void Reserve(size_t count);
+
+	// Hierarchy
+	bool SetParent(Handle node, Handle parent, bool keepWorldPosition);
+	Handle GetParent(Handle node);
+	unsigned int GetChildCount(Handle node);
+	Handle GetChild(Handle node, unsigned int index);
+	Transform* GetOwner(Handle node);
+
+	// Local values, relative to the parent
+	void SetPosition(Handle node, const DirectX::XMFLOAT3& position);
+	void SetPitchYawRoll(Handle node, const DirectX::XMFLOAT3& pitchYawRoll);
+	void SetRotation(Handle node, const DirectX::XMFLOAT4& quaternion);
+	void SetScale(Handle node, const DirectX::XMFLOAT3& scale);
+	DirectX::XMFLOAT3 GetPosition(Handle node);
+	DirectX::XMFLOAT3 GetPitchYawRoll(Handle node);
+	DirectX::XMFLOAT4 GetRotation(Handle node);
+	DirectX::XMFLOAT3 GetScale(Handle node);
+
+	// Local axes, cached whenever the rotation changes
+	DirectX::XMFLOAT3 GetRight(Handle node);
+	DirectX::XMFLOAT3 GetUp(Handle node);
+	DirectX::XMFLOAT3 GetForward(Handle node);
+
+	// Rebuilds the matrices of everything that changed.  The getters
+	// below call this themselves if there are pending changes.
+	void Update();
+	bool HasPendingChanges();
+	const DirectX::XMFLOAT4X4A& GetWorldMatrix(Handle node);
+	const DirectX::XMFLOAT4X4A& GetWorldInverseTransposeMatrix(Handle node);
+	unsigned int GetVersion(Handle node);
+
+	// Fixed-step support.  BeginStep() saves the current values as the
+	// "previous" state at the start of each simulation step, and
+	// Interpolate() blends the two for the frame being rendered.
+	// The render getters are valid until the next Update() or Interpolate().
+	void BeginStep();
+	void Interpolate(float alpha);
+	const DirectX::XMFLOAT4X4A& GetRenderWorldMatrix(Handle node);
+	const DirectX::XMFLOAT4X4A& GetRenderWorldInverseTransposeMatrix(Handle node);
+
+	Stats GetStats();
+
+	// Check of the fast inverse-transpose path for the tests, returns the max relative error
+	float ValidateInverseTranspose(unsigned int samples);
+}
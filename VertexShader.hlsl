@@ -1,12 +1,12 @@
 #include "ShaderIncludes.hlsli"
 
-//Data from the constant buffer
-cbuffer ExternalData : register(b0)
+//Data that changes for every object drawn
+// - wvp is world * view * projection, precomputed on the CPU
+cbuffer PerObject : register(b2)
 {
 	float4x4 world;
 	float4x4 worldInvTranspose;
-	float4x4 view;
-	float4x4 projection;
+	float4x4 wvp;
 }
 
 // --------------------------------------------------------
@@ -21,8 +21,7 @@ VertexToPixel main( VertexShaderInput input )
 	// Set up output struct
 	VertexToPixel output;
 
-	// Multiply the three matrices together first
-	matrix wvp = mul(projection, mul(view, world));
+	// World, view and projection arrive already combined
 	output.screenPosition = mul(wvp, float4(input.localPosition, 1.0f));
 	//do the same for world position
 	output.worldPosition = mul(world, float4(input.localPosition, 1)).xyz;
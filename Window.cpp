@@ -2,6 +2,7 @@
 #include "Window.h"
 #include "Graphics.h"
 #include "Input.h"
+#include "RenderThread.h"
 #include <sstream>
 // Include ImGui's Win32 backend and forward declare the window handler function
 // Note: This CANNOT be inside a namespace!
@@ -296,7 +297,9 @@ LRESULT Window::ProcessMessage(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lPara
 		windowWidth = LOWORD(lParam);
 		windowHeight = HIWORD(lParam);
 
-		// Let other systems know
+		// Let other systems know, once the render
+		// thread is done with the current buffers
+		RenderThread::Flush();
 		Graphics::ResizeBuffers(windowWidth, windowHeight);
 		if(onResize)
 			onResize();
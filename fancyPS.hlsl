@@ -1,7 +1,7 @@
 #include "ShaderIncludes.hlsli"
 
-//Data from the constant buffer
-cbuffer ExternalData : register(b0)
+//Data that changes once per frame
+cbuffer PerFrame : register(b0)
 {
 	float screenWidth;
 	float screenHeight;
@@ -1,7 +1,7 @@
 #include "ShaderIncludes.hlsli"
 
-//Data from the constant buffer
-cbuffer ExternalData : register(b0)
+//Data that changes when the material changes
+cbuffer PerMaterial : register(b1)
 {
 	float4 colorTint;
 }